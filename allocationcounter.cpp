@@ -0,0 +1,106 @@
+// 替换分配函数统计每个线程的分配次数。不放进核心库：库不能替换进程的分配器，
+// 只由可执行文件链接（基准程序，或打开CMake选项QTBACKTESTER_COUNT_ALLOCATIONS的界面和命令行）。
+// glibc上替换malloc一族：Qt容器经QArrayData直接调用malloc，operator new统计不到；可执行文件中的
+// malloc覆盖libc的，Qt等共享库里的调用也会经过这里，释放仍由libc的free完成。
+// 其他平台和地址消毒器（自带malloc）下只替换operator new
+#include "profiler.h"
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+// 定义在profiler.cpp
+#ifdef __GLIBC__
+extern __attribute__((tls_model("initial-exec"))) thread_local qint64 profiler_thread_allocations;
+#else
+extern thread_local qint64 profiler_thread_allocations;
+#endif
+
+#if defined(__GLIBC__) && !defined(__SANITIZE_ADDRESS__)
+
+extern "C" {
+
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *p, size_t size);
+
+void *malloc(size_t size) {
+  ++profiler_thread_allocations;
+  return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) {
+  ++profiler_thread_allocations;
+  return __libc_calloc(count, size);
+}
+
+void *realloc(void *p, size_t size) {
+  // 原地缩小同样计入：调用方无法区分，热路径上本就不该出现
+  ++profiler_thread_allocations;
+  return __libc_realloc(p, size);
+}
+
+} // extern "C"
+
+namespace {
+
+// operator new经malloc分配，已经计入
+[[maybe_unused]] const bool registered =
+    (Profiler::setAllocationCounting(Profiler::AllocationCounting::Malloc), true);
+
+} // namespace
+
+#else
+
+void *operator new(std::size_t size) {
+  ++profiler_thread_allocations;
+  if (void *p = std::malloc(size ? size : 1))
+    return p;
+  throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size) {
+  return ::operator new(size);
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+  ++profiler_thread_allocations;
+  return std::malloc(size ? size : 1);
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &tag) noexcept {
+  return ::operator new(size, tag);
+}
+
+void operator delete(void *p) noexcept {
+  std::free(p);
+}
+
+void operator delete[](void *p) noexcept {
+  std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept {
+  std::free(p);
+}
+
+void operator delete[](void *p, std::size_t) noexcept {
+  std::free(p);
+}
+
+void operator delete(void *p, const std::nothrow_t &) noexcept {
+  std::free(p);
+}
+
+void operator delete[](void *p, const std::nothrow_t &) noexcept {
+  std::free(p);
+}
+
+namespace {
+
+[[maybe_unused]] const bool registered =
+    (Profiler::setAllocationCounting(Profiler::AllocationCounting::OperatorNew), true);
+
+} // namespace
+
+#endif
@@ -0,0 +1,61 @@
+#include "backtestarena.h"
+
+#include <cstring>
+#include <type_traits>
+
+static_assert(std::is_trivially_copyable_v<TradeSignal>, "成交记录按字节复制");
+static_assert(alignof(TradeSignal) >= alignof(double), "权益曲线紧跟在成交记录之后");
+
+BacktestArena::BacktestArena()
+    : bytes_(0)
+    , signals_(nullptr)
+    , equity_(nullptr)
+    , signal_count_(0)
+    , signal_capacity_(0)
+    , equity_count_(0)
+    , equity_capacity_(0) {}
+
+BacktestArena &BacktestArena::local() {
+  // 线程池的工作线程各有一个，随线程退出释放
+  thread_local BacktestArena arena;
+  return arena;
+}
+
+void BacktestArena::reserve(qsizetype trades, qsizetype equity) {
+  trades = qMin(trades, kMaxReservedSignals);
+  if (trades <= signal_capacity_ && equity <= equity_capacity_) {
+    // 够用时一般不动，交替回测大小不同的数据时不会反复分配。但一次大数据回测之后只跑小回测
+    // （如不记录明细的参数扫描）时，多出的内存会一直挂在线程上，此时缩回到本次所需
+    const qsizetype needed = trades * qsizetype(sizeof(TradeSignal)) + equity * qsizetype(sizeof(double));
+    if (bytes_ <= kRetainedBytes || bytes_ <= needed * kShrinkFactor)
+      return;
+    signal_capacity_ = trades;
+    equity_capacity_ = equity;
+  } else {
+    signal_capacity_ = qMax(trades, signal_capacity_);
+    equity_capacity_ = qMax(equity, equity_capacity_);
+  }
+  bytes_ = signal_capacity_ * qsizetype(sizeof(TradeSignal)) + equity_capacity_ * qsizetype(sizeof(double));
+  buffer_.reset(bytes_ > 0 ? new char[bytes_] : nullptr);
+  signals_ = reinterpret_cast<TradeSignal *>(buffer_.get());
+  equity_ = reinterpret_cast<double *>(signals_ + signal_capacity_);
+  reset();
+}
+
+void BacktestArena::grow(qsizetype trades, qsizetype equity) {
+  std::unique_ptr<char[]> old_buffer = std::move(buffer_);
+  const TradeSignal *old_signals = signals_;
+  const double *old_equity = equity_;
+  const qsizetype signal_count = signal_count_;
+  const qsizetype equity_count = equity_count_;
+  signal_capacity_ = trades;
+  equity_capacity_ = equity;
+  bytes_ = signal_capacity_ * qsizetype(sizeof(TradeSignal)) + equity_capacity_ * qsizetype(sizeof(double));
+  buffer_.reset(new char[bytes_]);
+  signals_ = reinterpret_cast<TradeSignal *>(buffer_.get());
+  equity_ = reinterpret_cast<double *>(signals_ + signal_capacity_);
+  if (signal_count > 0)
+    std::memcpy(signals_, old_signals, size_t(signal_count) * sizeof(TradeSignal));
+  if (equity_count > 0)
+    std::memcpy(equity_, old_equity, size_t(equity_count) * sizeof(double));
+}
@@ -0,0 +1,67 @@
+#ifndef BACKTESTARENA_H
+#define BACKTESTARENA_H
+
+#include "klinedata.h"
+
+#include <QtGlobal>
+
+#include <memory>
+
+// 一次回测的运行状态（成交记录和权益曲线）所用的内存：两段放在同一块预先分配的缓冲区里。
+// reserve按K线数一次确定容量，够用时不再分配，远大于所需时缩回；reset只把长度清零，O(1)。
+// 同一线程上连续回测（参数扫描、滚动优化）复用线程局部的arena，热身之后逐K线循环和
+// 两次回测之间都没有堆分配
+class BacktestArena {
+public:
+  // 逐K线撮合时每根最多成交一次，成交记录按K线数预留；超过此数时按需扩容，避免超大数据占用过多内存
+  static constexpr qsizetype kMaxReservedSignals = 1 << 20;
+  // 容量超过本次所需的kShrinkFactor倍且超过kRetainedBytes时，reserve把缓冲区缩回到所需大小
+  static constexpr qsizetype kShrinkFactor = 4;
+  static constexpr qsizetype kRetainedBytes = 1 << 20;
+
+  BacktestArena();
+
+  BacktestArena(const BacktestArena&) = delete;
+  BacktestArena& operator=(const BacktestArena&) = delete;
+
+  // 当前线程的arena，BacktestEngine::run等同步回测共用
+  static BacktestArena& local();
+
+  // 保证至少能放下trades条成交和equity个权益点；重新分配（不足或缩回）时已有内容丢弃
+  void reserve(qsizetype trades, qsizetype equity);
+  void reset() {
+    signal_count_ = 0;
+    equity_count_ = 0;
+  }
+
+  void appendSignal(const TradeSignal& signal) {
+    if (Q_UNLIKELY(signal_count_ == signal_capacity_))
+      grow(signal_capacity_ * 2 + 16, equity_capacity_);
+    signals_[signal_count_++] = signal;
+  }
+  void appendEquity(double equity) {
+    if (Q_UNLIKELY(equity_count_ == equity_capacity_))
+      grow(signal_capacity_, equity_capacity_ * 2 + 16);
+    equity_[equity_count_++] = equity;
+  }
+
+  const TradeSignal* tradeSignals() const { return signals_; }
+  qsizetype signalCount() const { return signal_count_; }
+  const double* equity() const { return equity_; }
+  qsizetype equityCount() const { return equity_count_; }
+  qsizetype bytes() const { return bytes_; } // 缓冲区的总字节数
+
+private:
+  void grow(qsizetype trades, qsizetype equity); // 保留已有内容，只在预留不足时发生
+
+  std::unique_ptr<char[]> buffer_;
+  qsizetype bytes_;
+  TradeSignal* signals_;
+  double* equity_;
+  qsizetype signal_count_;
+  qsizetype signal_capacity_;
+  qsizetype equity_count_;
+  qsizetype equity_capacity_;
+};
+
+#endif // BACKTESTARENA_H
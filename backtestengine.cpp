@@ -0,0 +1,106 @@
+#include "backtestengine.h"
+
+#include <algorithm>
+
+BacktestEngine::BacktestEngine(const BacktestConfig &config, BacktestArena *arena)
+    : config_(config)
+    , cash_(config.initial_capital)
+    , position_(0.0)
+    , entry_cost_(0.0)
+    , equity_(config.initial_capital)
+    , peak_equity_(config.initial_capital)
+    , max_drawdown_(0.0)
+    , total_trades_(0)
+    , winning_trades_(0)
+    , arena_(arena ? arena : &own_arena_) {}
+
+void BacktestEngine::reset(qsizetype expected_bars) {
+  cash_ = config_.initial_capital;
+  position_ = 0.0;
+  entry_cost_ = 0.0;
+  equity_ = config_.initial_capital;
+  peak_equity_ = config_.initial_capital;
+  max_drawdown_ = 0.0;
+  total_trades_ = 0;
+  winning_trades_ = 0;
+  // 每根K线最多成交一次，按K线数预留后循环中不会扩容；已有足够容量时不分配，只清零长度
+  arena_->reserve(config_.record_trades ? expected_bars : 0, config_.record_equity_curve ? expected_bars : 0);
+  arena_->reset();
+}
+
+BacktestResult BacktestEngine::finish() {
+  BacktestResult result;
+  result.initial_capital = config_.initial_capital;
+  result.final_capital = equity_;
+  result.total_trades = total_trades_;
+  result.winning_trades = winning_trades_;
+  result.win_rate = total_trades_ > 0 ? double(winning_trades_) / total_trades_ : 0.0;
+  result.max_drawdown = max_drawdown_;
+  // arena会被下一次回测复用，结果中保存副本
+  if (arena_->equityCount() > 0)
+    result.equity_curve = QVector<double>(arena_->equity(), arena_->equity() + arena_->equityCount());
+  if (arena_->signalCount() > 0) {
+    result.trade_signals = QVector<TradeSignal>(arena_->tradeSignals(),
+                                                arena_->tradeSignals() + arena_->signalCount());
+  }
+  return result;
+}
+
+void BacktestEngine::buyAt(qint64 timestamp, double price) {
+  if (price <= 0.0 || cash_ <= 0.0)
+    return;
+  // 全部现金买入，手续费从现金中扣除
+  position_ = cash_ / (price * (1.0 + config_.commission));
+  entry_cost_ = cash_;
+  cash_ = 0.0;
+  if (config_.record_trades)
+    arena_->appendSignal({timestamp, price, SignalType::Buy});
+}
+
+void BacktestEngine::sellAt(qint64 timestamp, double price) {
+  double proceeds = position_ * price * (1.0 - config_.commission);
+  cash_ += proceeds;
+  position_ = 0.0;
+  total_trades_++;
+  if (proceeds > entry_cost_)
+    winning_trades_++;
+  if (config_.record_trades)
+    arena_->appendSignal({timestamp, price, SignalType::Sell});
+}
+
+void BacktestEngine::analyzeExcursions(BacktestResult &result,
+                                       const KLineData *bars,
+                                       qsizetype count,
+                                       const RangeIndex &index) {
+  result.max_adverse_excursion = 0.0;
+  result.max_favorable_excursion = 0.0;
+  if (count == 0 || index.size() != count)
+    return;
+  // 信号只记录时间戳，按时间戳二分找回K线下标
+  auto barIndex = [bars, count](qint64 timestamp) {
+    const KLineData *it = std::lower_bound(bars,
+                                           bars + count,
+                                           timestamp,
+                                           [](const KLineData &bar, qint64 value) {
+                                             return bar.timestamp < value;
+                                           });
+    return qMin<qsizetype>(it - bars, count - 1);
+  };
+  const QVector<TradeSignal> &trades = result.trade_signals;
+  for (qsizetype i = 0; i < trades.size(); i++) {
+    const TradeSignal &entry = trades[i];
+    if (entry.type != SignalType::Buy || entry.price <= 0.0)
+      continue;
+    // 按收盘价成交，开仓K线的高低点发生在成交之前，从下一根算起
+    const qsizetype first = barIndex(entry.timestamp) + 1;
+    qsizetype last = count - 1;
+    if (i + 1 < trades.size() && trades[i + 1].type == SignalType::Sell)
+      last = barIndex(trades[i + 1].timestamp);
+    if (first > last)
+      continue;
+    const double adverse = (entry.price - index.min(first, last)) / entry.price;
+    const double favorable = (index.max(first, last) - entry.price) / entry.price;
+    result.max_adverse_excursion = qMax(result.max_adverse_excursion, adverse);
+    result.max_favorable_excursion = qMax(result.max_favorable_excursion, favorable);
+  }
+}
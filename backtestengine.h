@@ -0,0 +1,151 @@
+#ifndef BACKTESTENGINE_H
+#define BACKTESTENGINE_H
+
+#include "backtestarena.h"
+#include "baraction.h"
+#include "klinedata.h"
+#include "profiler.h"
+#include "rangeindex.h"
+
+#include <QVector>
+
+struct BacktestConfig {
+  double initial_capital = 10000.0;
+  double commission = 0.001; // 按成交额收取的手续费比例
+  double slippage = 0.0001;  // 成交价相对收盘价的不利偏移比例
+  bool record_equity_curve = true; // 参数扫描等只需要统计指标的场景可关闭
+  bool record_trades = true;       // 同上，关闭后结果中没有成交记录，finish也不再分配
+};
+
+struct BacktestResult {
+  double initial_capital = 0.0;
+  double final_capital = 0.0; // 未平仓部分按最后收盘价计值
+  int total_trades = 0;       // 已平仓的完整交易次数
+  int winning_trades = 0;
+  double win_rate = 0.0;     // 0~1
+  double max_drawdown = 0.0; // 0~1
+  // 持仓期间相对开仓价的最大不利/有利波动（所有交易中最大的一笔），0~1，由analyzeExcursions填写
+  double max_adverse_excursion = 0.0;
+  double max_favorable_excursion = 0.0;
+  QVector<double> equity_curve;
+  QVector<TradeSignal> trade_signals;
+  // 逐K线循环期间本线程的堆分配次数，由run填写，预留充足时为0；口径见Profiler::allocationCount
+  qint64 loop_allocations = 0;
+};
+
+// 单向做多、全仓进出的事件驱动回测：策略在每根K线收盘时给出动作，按收盘价加滑点成交。
+// 成交记录和权益曲线写在BacktestArena中，reset时按K线数量预留，逐K线处理过程不做堆分配；
+// finish时才复制到结果中
+class BacktestEngine {
+public:
+  // arena为空时使用引擎自己的；传入的arena须比引擎活得久，且同一时间只供一个引擎使用
+  explicit BacktestEngine(const BacktestConfig& config, BacktestArena* arena = nullptr);
+
+  BacktestEngine(const BacktestEngine&) = delete;
+  BacktestEngine& operator=(const BacktestEngine&) = delete;
+
+  void reset(qsizetype expected_bars);
+  inline void onBar(const KLineData& bar, BarAction action);
+  BacktestResult finish();
+
+  // 由外部撮合模型决定成交价时使用：按给定价格全仓买入/全部卖出（价格已含滑点），
+  // 之后用markToMarket按收盘价更新权益和回撤
+  void buyAt(qint64 timestamp, double price);
+  void sellAt(qint64 timestamp, double price);
+  inline void markToMarket(double price);
+  double cash() const { return cash_; }
+  double position() const { return position_; }
+
+  // Strategy需提供 BarAction onBar(const KLineData&)，以模板实例化使调用可内联。
+  // 使用当前线程的BacktestArena，同一线程上的连续回测复用同一块内存
+  template<typename Strategy>
+  static BacktestResult run(const BacktestConfig& config,
+                            const KLineData* bars,
+                            qsizetype count,
+                            Strategy& strategy);
+
+  // 分块输入：Stream需提供 const QVector<KLineData>* next()，返回nullptr表示结束。
+  // 只保留策略和引擎的滚动状态，不记录权益曲线；成交记录按config.record_trades，
+  // 关闭时内存与数据量无关，开启时随成交笔数增长
+  template<typename Stream, typename Strategy>
+  static BacktestResult runBlocks(const BacktestConfig& config, Stream& stream, Strategy& strategy);
+
+  // 用区间最值索引计算每笔持仓期间（开仓的下一根到平仓那根）的最低价/最高价，每笔交易O(1)，
+  // 未平仓的按持有到最后一根计算
+  static void analyzeExcursions(BacktestResult& result,
+                                const KLineData* bars,
+                                qsizetype count,
+                                const RangeIndex& index);
+
+private:
+  BacktestConfig config_;
+  double cash_;
+  double position_;   // 持仓数量
+  double entry_cost_; // 开仓时付出的总资金（含手续费）
+  double equity_;
+  double peak_equity_;
+  double max_drawdown_;
+  int total_trades_;
+  int winning_trades_;
+  BacktestArena own_arena_;
+  BacktestArena* arena_;
+};
+
+inline void BacktestEngine::onBar(const KLineData& bar, BarAction action) {
+  if (action == BarAction::Buy && position_ == 0.0) {
+    buyAt(bar.timestamp, bar.close * (1.0 + config_.slippage));
+  } else if (action == BarAction::Sell && position_ > 0.0) {
+    sellAt(bar.timestamp, bar.close * (1.0 - config_.slippage));
+  }
+  markToMarket(bar.close);
+}
+
+inline void BacktestEngine::markToMarket(double price) {
+  equity_ = cash_ + position_ * price;
+  if (equity_ > peak_equity_) {
+    peak_equity_ = equity_;
+  } else if (peak_equity_ > 0.0) {
+    double drawdown = (peak_equity_ - equity_) / peak_equity_;
+    if (drawdown > max_drawdown_)
+      max_drawdown_ = drawdown;
+  }
+  if (config_.record_equity_curve)
+    arena_->appendEquity(equity_);
+}
+
+template<typename Strategy>
+BacktestResult BacktestEngine::run(const BacktestConfig& config,
+                                   const KLineData* bars,
+                                   qsizetype count,
+                                   Strategy& strategy) {
+  BacktestEngine engine(config, &BacktestArena::local());
+  engine.reset(count);
+  const qint64 allocations = Profiler::allocationCount();
+  for (qsizetype i = 0; i < count; i++) {
+    engine.onBar(bars[i], strategy.onBar(bars[i]));
+  }
+  const qint64 loop_allocations = Profiler::allocationCount() - allocations;
+  BacktestResult result = engine.finish();
+  result.loop_allocations = loop_allocations;
+  return result;
+}
+
+template<typename Stream, typename Strategy>
+BacktestResult BacktestEngine::runBlocks(const BacktestConfig& config,
+                                         Stream& stream,
+                                         Strategy& strategy) {
+  BacktestConfig stream_config = config;
+  stream_config.record_equity_curve = false;
+  BacktestEngine engine(stream_config, &BacktestArena::local());
+  engine.reset(0);
+  while (const QVector<KLineData>* block = stream.next()) {
+    const KLineData* bars = block->constData();
+    const qsizetype count = block->size();
+    for (qsizetype i = 0; i < count; i++) {
+      engine.onBar(bars[i], strategy.onBar(bars[i]));
+    }
+  }
+  return engine.finish();
+}
+
+#endif // BACKTESTENGINE_H
@@ -0,0 +1,194 @@
+#include "backtestsession.h"
+
+#include "builtinstrategies.h"
+#include "datasetinfo.h"
+#include "klineloader.h"
+#include "profiler.h"
+
+#include <QDebug>
+#include <QFileInfo>
+
+#include <limits>
+
+bool BacktestSession::load(const QString &file_path,
+                           const std::atomic<bool> *cancelled,
+                           const std::function<void(int)> &progress,
+                           qint64 max_level_msecs) {
+  ProfileScope scope("session.load");
+  clear();
+  file_path_ = file_path;
+  auto stopped = [cancelled] { return cancelled && cancelled->load(std::memory_order_relaxed); };
+  // CSV未变化时直接映射列式缓存，跳过文本解析。金字塔和引擎使用K线结构体数组，
+  // 仍要把各列整体复制成bars_，内存和耗时与K线数成正比，缓存省下的只是解析
+  bool loaded = false;
+  if (cache_.open(file_path)) {
+    ProfileScope cache_scope("cache.read");
+    cache_.toKLineData(bars_);
+    loaded = !bars_.isEmpty();
+  }
+  if (!loaded) {
+    // 解析占进度的前80%，剩下的给缓存和金字塔
+    std::function<void(int)> parse_progress;
+    if (progress)
+      parse_progress = [&progress](int permille) { progress(permille * 8 / 10); };
+    if (!KLineLoader::loadCsv(file_path, bars_, cancelled, parse_progress) || stopped()) {
+      clear();
+      return false;
+    }
+    ProfileScope cache_scope("cache.write");
+    if (!KLineCache::write(file_path, bars_)) {
+      qDebug() << "写入缓存失败:" << KLineCache::cachePath(file_path);
+    } else {
+      cache_.open(file_path);
+    }
+  }
+  if (progress)
+    progress(850);
+  // 加载时一次性建好多周期金字塔（含各层的区间最值索引）
+  {
+    ProfileScope pyramid_scope("pyramid.build");
+    pyramid_.build(bars_, cancelled, max_level_msecs);
+  }
+  if (stopped()) {
+    clear();
+    return false;
+  }
+  if (progress)
+    progress(1000);
+  Profiler::counter("session.bars", double(bars_.size()));
+  return true;
+}
+
+bool BacktestSession::loadPreview(const QString &file_path, qsizetype count) {
+  ProfileScope scope("session.preview");
+  clear();
+  file_path_ = file_path;
+  // 有缓存时直接取映射中的末尾几列，否则只读CSV的最后一段
+  KLineCache cache;
+  if (cache.open(file_path)) {
+    cache.toKLineData(cache.columns().size - count, count, bars_);
+  } else if (!KLineLoader::loadCsvLast(file_path, count, bars_)) {
+    clear();
+    return false;
+  }
+  if (bars_.isEmpty()) {
+    clear();
+    return false;
+  }
+  pyramid_.build(bars_);
+  preview_ = true;
+  return true;
+}
+
+qsizetype BacktestSession::append(qint64 offset) {
+  ProfileScope scope("session.append");
+  // 只解析追加的那段文本，已有数据保持不动
+  const qsizetype first_new = bars_.size();
+  qint64 last_timestamp = first_new > 0 ? bars_.last().timestamp
+                                        : std::numeric_limits<qint64>::min();
+  QVector<KLineData> tail;
+  if (!KLineLoader::loadCsvTail(file_path_, offset, tail))
+    return -1;
+  for (const KLineData &d : std::as_const(tail)) {
+    if (d.timestamp <= last_timestamp)
+      continue; // 保持严格升序，不需要重新排序
+    bars_.append(d);
+    last_timestamp = d.timestamp;
+  }
+  if (bars_.size() == first_new)
+    return 0;
+
+  // 映射中的缓存不能改写，先关闭，追加后重新映射
+  cache_.close();
+  if (!KLineCache::append(file_path_, offset, bars_, first_new))
+    qDebug() << "更新缓存失败:" << KLineCache::cachePath(file_path_);
+  cache_.open(file_path_);
+  // 各周期只重算最后一个桶之后的部分
+  pyramid_.append(bars_, first_new);
+  return bars_.size() - first_new;
+}
+
+void BacktestSession::clear() {
+  cache_.close();
+  bars_.clear();
+  pyramid_.clear();
+  file_path_.clear();
+  preview_ = false;
+}
+
+std::shared_ptr<IndicatorCache> BacktestSession::indicators(int level) const {
+  if (level < pyramid_.levelCount())
+    return pyramid_.level(level).indicators();
+  return std::make_shared<IndicatorCache>(bars_);
+}
+
+void BacktestSession::sendBars(StrategyWorker *worker, int level) const {
+  // 只有原始周期有列式缓存可供Python直接映射，其他周期发送列数据
+  bool use_cache = level == 0 && cache_.isOpen();
+  worker->setBars(level < pyramid_.levelCount() ? pyramid_.bars(level) : bars_,
+                  use_cache ? KLineCache::cachePath(file_path_) : QString());
+}
+
+BacktestResult BacktestSession::runMaCross(int level,
+                                           const BacktestConfig &config,
+                                           int fast_period,
+                                           int slow_period) const {
+  ProfileScope scope("backtest.maCross");
+  const QVector<KLineData> &bars = pyramid_.bars(level);
+  return analyze(level, ::runMaCross(config, bars, *indicators(level), fast_period, slow_period));
+}
+
+BacktestResult BacktestSession::replaySignals(int level,
+                                              const BacktestConfig &config,
+                                              const StrategySignals &result) const {
+  ProfileScope scope("backtest.replay");
+  SignalReplay replay(result.bar_index.constData(), result.side.constData(), result.side.size());
+  const QVector<KLineData> &bars = pyramid_.bars(level);
+  return analyze(level, BacktestEngine::run(config, bars.constData(), bars.size(), replay));
+}
+
+BacktestResult BacktestSession::runPlugin(int level,
+                                          const BacktestConfig &config,
+                                          const StrategyPlugin &plugin) const {
+  ProfileScope scope("backtest.plugin");
+  const QVector<KLineData> &bars = pyramid_.bars(level);
+  QVector<qint8> actions;
+  plugin.generate(bars.constData(), bars.size(), actions);
+  ActionReplay replay(actions.constData());
+  return analyze(level, BacktestEngine::run(config, bars.constData(), bars.size(), replay));
+}
+
+BacktestResult BacktestSession::analyze(int level, BacktestResult result) const {
+  const KLinePyramid::Level &data = pyramid_.level(level);
+  BacktestEngine::analyzeExcursions(result, data.bars.constData(), data.bars.size(), data.index);
+  return result;
+}
+
+bool BacktestSession::makeUpdateRequest(const QString &file_path,
+                                        const QDateTime &end_time,
+                                        DownloadRequest &request,
+                                        QString &error) {
+  DatasetInfo info;
+  if (!DatasetInfo::load(file_path, info)) {
+    error = QString("缺少数据来源信息(%1)，请重新下载该数据")
+                .arg(QFileInfo(DatasetInfo::infoPath(file_path)).fileName());
+    return false;
+  }
+  qint64 last_timestamp = 0;
+  if (!KLineLoader::readLastTimestamp(file_path, last_timestamp)) {
+    error = "无法读取数据文件的最后一根K线";
+    return false;
+  }
+  // 从最后一根K线的下一根开始，只下载缺少的部分
+  const qint64 step = BatchDownloader::timeframeMsecs(info.timeframe);
+  request.exchange = info.exchange;
+  request.symbol = info.symbol;
+  request.timeframe = info.timeframe;
+  request.start_time = QDateTime::fromMSecsSinceEpoch(last_timestamp + step);
+  request.end_time = end_time;
+  request.output_path = file_path;
+  // 设置该环境变量后改从本地模拟服务下载（scripts/mockohlcvserver.py）
+  request.mock_server = qEnvironmentVariable("QTBACKTESTER_MOCK_SERVER");
+  request.append_offset = QFileInfo(file_path).size();
+  return true;
+}
@@ -0,0 +1,66 @@
+#ifndef BACKTESTSESSION_H
+#define BACKTESTSESSION_H
+
+#include "backtestengine.h"
+#include "batchdownloader.h"
+#include "klinecache.h"
+#include "klinedata.h"
+#include "klinepyramid.h"
+#include "strategyplugin.h"
+#include "strategyworker.h"
+
+#include <QString>
+#include <QVector>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+
+// 一个数据文件的回测会话：加载K线（CSV未变化时映射列式缓存）、维护多周期金字塔，
+// 并在指定周期上撮合内置策略或外部策略的信号。只依赖Qt::Core，界面和命令行共用
+class BacktestSession {
+public:
+  // 可在后台线程调用：cancelled置位后尽快返回false，progress为千分比，在调用线程中回调。
+  // max_level_msecs含义同KLinePyramid::build，默认建全部周期
+  bool load(const QString& file_path,
+            const std::atomic<bool>* cancelled = nullptr,
+            const std::function<void(int)>& progress = {},
+            qint64 max_level_msecs = -1);
+  // 只取最后count根K线建预览会话，供完整加载完成前先画图；不读写缓存，不能用于回测
+  bool loadPreview(const QString& file_path, qsizetype count);
+  // 文件从offset处起追加了新数据后，只解析新增部分并同步缓存和金字塔，返回新增的K线数，失败返回-1
+  qsizetype append(qint64 offset);
+  void clear();
+
+  const QString& filePath() const { return file_path_; }
+  bool isEmpty() const { return bars_.isEmpty(); }
+  bool isPreview() const { return preview_; }
+  const QVector<KLineData>& bars() const { return bars_; }
+  const KLinePyramid& pyramid() const { return pyramid_; }
+  std::shared_ptr<IndicatorCache> indicators(int level) const;
+  // 交给Python策略进程的数据：原始周期有缓存时直接映射缓存文件
+  void sendBars(StrategyWorker* worker, int level) const;
+
+  // 以下回测结果都已计算持仓期间的最大不利/有利波动
+  BacktestResult runMaCross(int level, const BacktestConfig& config, int fast_period, int slow_period) const;
+  BacktestResult replaySignals(int level, const BacktestConfig& config, const StrategySignals& result) const;
+  BacktestResult runPlugin(int level, const BacktestConfig& config, const StrategyPlugin& plugin) const;
+
+  // 按数据来源信息构造增量更新请求：从最后一根K线的下一根下载到end_time。
+  // 已是最新时返回true且request.start_time晚于end_time
+  static bool makeUpdateRequest(const QString& file_path,
+                                const QDateTime& end_time,
+                                DownloadRequest& request,
+                                QString& error);
+
+private:
+  BacktestResult analyze(int level, BacktestResult result) const;
+
+  QString file_path_;
+  KLineCache cache_; // 当前数据文件的列式缓存映射
+  QVector<KLineData> bars_;
+  KLinePyramid pyramid_; // bars_的多周期聚合，第0层即bars_
+  bool preview_ = false;  // bars_只是文件末尾的一段
+};
+
+#endif // BACKTESTSESSION_H
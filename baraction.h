@@ -0,0 +1,7 @@
+#ifndef BARACTION_H
+#define BARACTION_H
+
+// 策略对一根K线给出的动作。单独放在这里，策略插件只包含nativestrategy.h时不会带进回测引擎
+enum class BarAction { Hold, Buy, Sell };
+
+#endif // BARACTION_H
@@ -0,0 +1,98 @@
+#include "baraggregator.h"
+#include "klinepyramid.h"
+#include "tickstore.h"
+
+BarAggregator::BarAggregator(Mode mode, double size)
+    : mode_(mode)
+    , size_(size)
+    , interval_ms_(mode == Mode::Time ? qMax<qint64>(1, qint64(size)) : 1)
+    , bar_{}
+    , filled_(0.0)
+    , open_(false)
+    , full_(false) {}
+
+bool BarAggregator::parse(const QString &text, Mode &mode, double &size, QString &error) {
+  const qsizetype colon = text.indexOf(':');
+  const QString kind = text.left(colon).trimmed().toLower();
+  const QString value = colon < 0 ? QString() : text.mid(colon + 1).trimmed();
+  if (kind == "time") {
+    qint64 msecs = 0;
+    if (!KLinePyramid::parseInterval(value, msecs)) {
+      error = "无效的K线周期: " + value;
+      return false;
+    }
+    mode = Mode::Time;
+    size = double(msecs);
+    return true;
+  }
+  if (kind != "volume" && kind != "dollar") {
+    error = "K线类型须为time、volume或dollar: " + text;
+    return false;
+  }
+  bool ok = false;
+  size = value.toDouble(&ok);
+  if (!ok || size <= 0.0) {
+    error = "无效的K线阈值: " + value;
+    return false;
+  }
+  mode = kind == "volume" ? Mode::Volume : Mode::Dollar;
+  return true;
+}
+
+bool BarAggregator::flush(KLineData &out) {
+  if (!open_)
+    return false;
+  out = bar_;
+  open_ = false;
+  return true;
+}
+
+void BarAggregator::reset() {
+  open_ = false;
+  full_ = false;
+  filled_ = 0.0;
+}
+
+TickBarStream::TickBarStream(TickReader &reader, const BarAggregator &aggregator)
+    : reader_(reader)
+    , aggregator_(aggregator)
+    , block_(nullptr)
+    , position_(0)
+    , ticks_(0)
+    , finished_(false) {
+  aggregator_.reset();
+  bars_.reserve(kBlockBars);
+}
+
+const QVector<KLineData> *TickBarStream::next() {
+  if (finished_)
+    return nullptr;
+  bars_.clear();
+  KLineData bar;
+  // 凑满一块K线或逐笔数据读完为止，逐笔块读到一半时记下位置，下次接着读
+  while (bars_.size() < kBlockBars) {
+    if (!block_ || position_ == block_->size()) {
+      block_ = reader_.next();
+      position_ = 0;
+      if (!block_) {
+        if (aggregator_.flush(bar))
+          bars_.append(bar);
+        finished_ = true;
+        break;
+      }
+    }
+    const TickData *ticks = block_->constData();
+    const qsizetype count = block_->size();
+    const qsizetype first = position_;
+    while (position_ < count && bars_.size() < kBlockBars) {
+      if (aggregator_.add(ticks[position_++], bar))
+        bars_.append(bar);
+    }
+    ticks_ += position_ - first;
+  }
+  return bars_.isEmpty() ? nullptr : &bars_;
+}
+
+bool TickBarStream::hasError() const {
+  return reader_.hasError();
+}
@@ -0,0 +1,105 @@
+#ifndef BARAGGREGATOR_H
+#define BARAGGREGATOR_H
+
+#include "klinedata.h"
+#include "tickdata.h"
+
+#include <QString>
+#include <QVector>
+
+class TickReader;
+
+// 把按时间升序的逐笔成交流式合成K线：
+//   时间K线：按UTC对齐的固定周期分桶，没有成交的周期不产生K线；
+//   成交量K线：累计成交量达到size时收盘；
+//   成交额K线：累计price*amount达到size时收盘。
+// 越过阈值的那一笔整笔计入当前K线，不拆分。K线时间戳为第一笔成交的时间（时间K线为桶起点）。
+// 一根K线只有在下一笔成交到来时才确认收盘，因此add返回的总是当前这笔之前的K线
+class BarAggregator {
+public:
+  enum class Mode { Time, Volume, Dollar };
+
+  BarAggregator(Mode mode, double size);
+
+  // 解析 "time:1m"、"volume:50"、"dollar:1e6" 这类描述，时间周期支持s/m/h/d
+  static bool parse(const QString& text, Mode& mode, double& size, QString& error);
+
+  // 返回true时out为刚确认收盘的K线，tick已计入下一根
+  inline bool add(const TickData& tick, KLineData& out);
+  // 数据结束时取出最后一根未确认的K线
+  bool flush(KLineData& out);
+  void reset();
+
+  Mode mode() const { return mode_; }
+  double size() const { return size_; }
+
+private:
+  inline void start(const TickData& tick);
+
+  Mode mode_;
+  double size_;
+  qint64 interval_ms_; // 时间K线的周期
+  KLineData bar_;
+  double filled_; // 成交量/成交额K线已累计的量
+  bool open_;     // bar_中有未确认的K线
+  bool full_;     // 成交量/成交额已达到阈值，等待下一笔确认
+};
+
+inline void BarAggregator::start(const TickData& tick) {
+  if (mode_ == Mode::Time) {
+    const qint64 rem = tick.timestamp % interval_ms_;
+    bar_.timestamp = tick.timestamp - (rem < 0 ? rem + interval_ms_ : rem);
+  } else {
+    bar_.timestamp = tick.timestamp;
+  }
+  bar_.open = bar_.high = bar_.low = bar_.close = tick.price;
+  bar_.volume = 0.0;
+  filled_ = 0.0;
+  full_ = false;
+  open_ = true;
+}
+
+inline bool BarAggregator::add(const TickData& tick, KLineData& out) {
+  bool closed = false;
+  if (!open_) {
+    start(tick);
+  } else if (mode_ == Mode::Time ? tick.timestamp >= bar_.timestamp + interval_ms_ : full_) {
+    out = bar_;
+    closed = true;
+    start(tick);
+  }
+  if (tick.price > bar_.high)
+    bar_.high = tick.price;
+  if (tick.price < bar_.low)
+    bar_.low = tick.price;
+  bar_.close = tick.price;
+  bar_.volume += tick.amount;
+  if (mode_ != Mode::Time) {
+    filled_ += mode_ == Mode::Volume ? tick.amount : tick.amount * tick.price;
+    full_ = filled_ >= size_;
+  }
+  return closed;
+}
+
+// 从逐笔数据文件按需合成K线的分块流，接口与KLineStream相同，可直接交给BacktestEngine::runBlocks
+class TickBarStream {
+public:
+  static constexpr int kBlockBars = 4096;
+
+  TickBarStream(TickReader& reader, const BarAggregator& aggregator);
+
+  const QVector<KLineData>* next();
+  bool hasError() const;
+  qint64 ticks() const { return ticks_; } // 已读出的逐笔数
+
+private:
+  TickReader& reader_;
+  BarAggregator aggregator_;
+  QVector<KLineData> bars_;
+  const QVector<TickData>* block_; // 当前逐笔块及其中下一笔的位置
+  qsizetype position_;
+  qint64 ticks_;
+  bool finished_;
+};
+
+#endif // BARAGGREGATOR_H
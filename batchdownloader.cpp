@@ -0,0 +1,344 @@
+#include "batchdownloader.h"
+#include "datasetinfo.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QFileInfo>
+#include <QFile>
+#include <QMap>
+#include <QSaveFile>
+#include <QTemporaryDir>
+#include <QThread>
+#include <QTimer>
+
+#include <limits>
+
+namespace {
+
+// 与scripts/downloaddata.py中的退出码保持一致
+constexpr int kExitRateLimited = 75; // 避开2：argparse的用法错误和找不到脚本都返回2，不应退避重试
+constexpr int kExitNoData = 76;
+
+constexpr int kDefaultConcurrency = 4;
+constexpr int kMaxAttempts = 5;
+constexpr int kMinLaunchIntervalMs = 200; // 相邻两次请求的最小间隔
+constexpr int kMaxBackoffMs = 30000;
+
+} // namespace
+
+BatchDownloader::BatchDownloader(QObject *parent)
+    : QObject(parent)
+    , launch_timer_(new QTimer(this))
+    , merge_thread_(nullptr)
+    , merge_cancelled_(false)
+    , next_launch_ms_(0)
+    , backoff_ms_(0)
+    , max_concurrency_(kDefaultConcurrency)
+    , finished_windows_(0)
+    , total_bars_(0)
+    , active_(false) {
+  launch_timer_->setSingleShot(true);
+  connect(launch_timer_, &QTimer::timeout, this, &BatchDownloader::launchWindows);
+}
+
+BatchDownloader::~BatchDownloader() {
+  for (QProcess *process : std::as_const(processes_)) {
+    process->disconnect(this);
+    process->kill();
+    process->waitForFinished(1000);
+  }
+  if (merge_thread_) {
+    merge_cancelled_ = true;
+    merge_thread_->wait();
+    delete merge_thread_; // 排队中的收尾回调随this一起丢弃，由这里释放
+  }
+}
+
+qint64 BatchDownloader::timeframeMsecs(const QString &timeframe) {
+  static const QMap<QString, qint64> seconds
+      = {{"1m", 60}, {"5m", 300}, {"15m", 900}, {"1h", 3600}, {"4h", 14400}, {"1d", 86400}};
+  return seconds.value(timeframe, 86400) * 1000;
+}
+
+bool BatchDownloader::start(const DownloadRequest &request) {
+  if (isRunning())
+    return false;
+  const qint64 step = timeframeMsecs(request.timeframe);
+  const qint64 start_ms = request.start_time.toMSecsSinceEpoch();
+  const qint64 end_ms = request.end_time.toMSecsSinceEpoch();
+  if (end_ms < start_ms)
+    return false;
+  temp_dir_ = std::make_unique<QTemporaryDir>();
+  if (!temp_dir_->isValid())
+    return false;
+
+  request_ = request;
+  windows_.clear();
+  queue_.clear();
+  const qint64 total_bars = (end_ms - start_ms) / step + 1;
+  for (qint64 offset = 0; offset < total_bars; offset += kWindowBars) {
+    Window window;
+    window.since_ms = start_ms + offset * step;
+    window.bars = int(qMin<qint64>(kWindowBars, total_bars - offset));
+    window.path = temp_dir_->filePath(QString("window_%1.csv").arg(windows_.size()));
+    queue_.append(int(windows_.size()));
+    windows_.append(window);
+  }
+  finished_windows_ = 0;
+  total_bars_ = total_bars;
+  backoff_ms_ = 0;
+  next_launch_ms_ = 0;
+  active_ = true;
+  clock_.start();
+  emit progress(0, total_bars_);
+  launchWindows();
+  return true;
+}
+
+void BatchDownloader::cancel() {
+  if (merge_thread_) {
+    merge_cancelled_ = true; // 拼接线程结束后报告取消
+    return;
+  }
+  if (!active_)
+    return;
+  finish(false, "下载已取消", 0);
+}
+
+void BatchDownloader::launchWindows() {
+  if (!active_)
+    return;
+  while (!queue_.isEmpty() && processes_.size() < max_concurrency_) {
+    qint64 now = clock_.elapsed();
+    if (now < next_launch_ms_) {
+      launch_timer_->start(int(next_launch_ms_ - now));
+      return;
+    }
+    startWindow(queue_.takeFirst());
+    next_launch_ms_ = now + qMax(kMinLaunchIntervalMs, backoff_ms_);
+  }
+}
+
+void BatchDownloader::startWindow(int index) {
+  Window &window = windows_[index];
+  window.attempts++;
+  window.fetched = 0;
+  QDir appDir(QCoreApplication::applicationDirPath());
+  QStringList args;
+  args << appDir.absoluteFilePath("scripts/downloaddata.py") << "--exchange" << request_.exchange
+       << "--symbol" << request_.symbol << "--timeframe" << request_.timeframe << "--since-ms"
+       << QString::number(window.since_ms) << "--limit" << QString::number(window.bars)
+       << "--output" << window.path << "--proxy" << request_.proxy << "--skip-proxy-test";
+  if (!request_.mock_server.isEmpty())
+    args << "--mock-server" << request_.mock_server;
+
+  auto *process = new QProcess(this);
+  processes_.append(process);
+  connect(process, &QProcess::readyReadStandardOutput, this, [this, index, process] {
+    onWindowOutput(index, process);
+  });
+  connect(process,
+          &QProcess::finished,
+          this,
+          [this, index, process](int exit_code, QProcess::ExitStatus status) {
+            onWindowFinished(index, process, exit_code, status);
+          });
+  // 找不到python时不会有finished信号，按一次失败的尝试处理
+  connect(process, &QProcess::errorOccurred, this, [this, index, process](QProcess::ProcessError error) {
+    if (error == QProcess::FailedToStart)
+      onWindowFinished(index, process, -1, QProcess::CrashExit);
+  });
+  process->start("python", args);
+}
+
+void BatchDownloader::onWindowOutput(int index, QProcess *process) {
+  bool changed = false;
+  while (process->canReadLine()) {
+    QByteArray line = process->readLine().trimmed();
+    if (!line.startsWith("PROGRESS "))
+      continue;
+    bool ok = false;
+    int fetched = line.mid(9).toInt(&ok);
+    if (ok) {
+      windows_[index].fetched = qBound(0, fetched, windows_[index].bars);
+      changed = true;
+    }
+  }
+  if (changed)
+    emitProgress();
+}
+
+void BatchDownloader::emitProgress() {
+  qint64 fetched = 0;
+  for (const Window &window : std::as_const(windows_))
+    fetched += window.fetched;
+  emit progress(fetched, total_bars_);
+}
+
+void BatchDownloader::onWindowFinished(int index,
+                                       QProcess *process,
+                                       int exit_code,
+                                       QProcess::ExitStatus status) {
+  processes_.removeOne(process);
+  process->deleteLater();
+  if (!active_)
+    return;
+  Window &window = windows_[index];
+  bool ok = status == QProcess::NormalExit && (exit_code == 0 || exit_code == kExitNoData);
+  if (ok) {
+    window.has_data = exit_code == 0;
+    window.fetched = window.bars; // 空窗口或末尾不足的窗口也计为完成
+    backoff_ms_ /= 2;
+    finished_windows_++;
+    emitProgress();
+  } else if (window.attempts >= kMaxAttempts) {
+    QString error = QString::fromLocal8Bit(process->readAllStandardError()).trimmed();
+    if (error.isEmpty())
+      error = process->errorString();
+    finish(false, QString("第%1批下载失败: %2").arg(index + 1).arg(error), 0);
+    return;
+  } else {
+    // 限频时指数退避，其他错误（如网络抖动）稍等后重试
+    if (exit_code == kExitRateLimited)
+      backoff_ms_ = qMin(kMaxBackoffMs, qMax(1000, backoff_ms_ * 2));
+    next_launch_ms_ = clock_.elapsed() + qMax(kMinLaunchIntervalMs, backoff_ms_);
+    window.fetched = 0;
+    queue_.prepend(index);
+    emitProgress();
+  }
+
+  if (finished_windows_ == windows_.size()) {
+    startMerge();
+    return;
+  }
+  launchWindows();
+}
+
+void BatchDownloader::startMerge() {
+  // 大文件拼接可能耗时数百毫秒，放到后台线程，完成后回到界面线程收尾
+  active_ = false;
+  merge_cancelled_ = false;
+  merge_thread_ = QThread::create([this] {
+    qint64 rows = 0;
+    QString error;
+    bool ok = mergeWindows(rows, error);
+    QMetaObject::invokeMethod(
+        this,
+        [this, ok, rows, error] {
+          merge_thread_->wait();
+          delete merge_thread_;
+          merge_thread_ = nullptr;
+          if (merge_cancelled_)
+            finish(false, "下载已取消", 0);
+          else
+            finish(ok, error, ok ? rows : 0);
+        },
+        Qt::QueuedConnection);
+  });
+  merge_thread_->start();
+}
+
+bool BatchDownloader::mergeWindows(qint64 &rows, QString &error) {
+  const bool append = request_.append_offset >= 0;
+  QSaveFile save_file(request_.output_path);
+  QFile append_file(request_.output_path);
+  QFileDevice &output = append ? static_cast<QFileDevice &>(append_file) : save_file;
+  if (append) {
+    // 增量更新：文件在排队期间被改动过则放弃，避免追加到错误的位置
+    if (!append_file.open(QIODevice::ReadWrite) || append_file.size() != request_.append_offset) {
+      error = "数据文件已被修改，请重新更新: " + request_.output_path;
+      return false;
+    }
+    append_file.seek(request_.append_offset);
+  } else {
+    QDir().mkpath(QFileInfo(request_.output_path).absolutePath());
+    if (!save_file.open(QIODevice::WriteOnly)) {
+      error = "无法写入输出文件: " + request_.output_path;
+      return false;
+    }
+  }
+  auto abort = [&](const QString &message) {
+    if (append)
+      append_file.resize(request_.append_offset); // 丢弃写了一半的数据
+    else
+      save_file.cancelWriting();
+    error = message;
+    return false;
+  };
+
+  const qint64 end_ms = request_.end_time.toMSecsSinceEpoch();
+  // 追加时只接受起始时间之后的K线，已有数据不会重复写入
+  qint64 last_timestamp = append ? request_.start_time.toMSecsSinceEpoch() - 1
+                                 : std::numeric_limits<qint64>::min();
+  bool header_written = append;
+  bool need_newline = false;
+  if (append && request_.append_offset > 0) {
+    // 原文件最后一行没有换行时先补上
+    append_file.seek(request_.append_offset - 1);
+    need_newline = !append_file.read(1).endsWith('\n');
+  }
+  rows = 0;
+  // 窗口按时间顺序排列，只保留严格递增的时间戳，重叠部分自然去重
+  for (const Window &window : std::as_const(windows_)) {
+    if (!window.has_data)
+      continue;
+    QFile file(window.path);
+    if (!file.open(QIODevice::ReadOnly))
+      return abort("无法读取临时文件: " + window.path);
+    QByteArray header = file.readLine();
+    if (!header_written) {
+      output.write(header);
+      header_written = true;
+    }
+    while (!file.atEnd()) {
+      if (merge_cancelled_)
+        return abort("下载已取消");
+      QByteArray line = file.readLine();
+      qsizetype comma = line.indexOf(',');
+      if (comma <= 0)
+        continue;
+      bool ok = false;
+      qint64 timestamp = line.left(comma).toLongLong(&ok);
+      if (!ok || timestamp <= last_timestamp || timestamp > end_ms)
+        continue;
+      if (!line.endsWith('\n'))
+        line.append('\n');
+      if (need_newline) {
+        output.write("\n", 1);
+        need_newline = false;
+      }
+      if (output.write(line) != line.size())
+        return abort("无法写入输出文件: " + request_.output_path);
+      last_timestamp = timestamp;
+      rows++;
+    }
+  }
+  if (append) {
+    if (!append_file.flush())
+      return abort("无法写入输出文件: " + request_.output_path);
+    return true; // 已是最新时rows为0，不算失败
+  }
+  if (rows == 0)
+    return abort("没有获取到数据");
+  if (!save_file.commit()) {
+    error = "无法写入输出文件: " + request_.output_path;
+    return false;
+  }
+  DatasetInfo info{request_.exchange, request_.symbol, request_.timeframe};
+  info.save(request_.output_path);
+  return true;
+}
+
+void BatchDownloader::finish(bool success, const QString &message, qint64 rows) {
+  active_ = false;
+  launch_timer_->stop();
+  queue_.clear();
+  for (QProcess *process : std::as_const(processes_)) {
+    process->disconnect(this);
+    process->kill();
+    process->deleteLater();
+  }
+  processes_.clear();
+  temp_dir_.reset();
+  emit finished(success, message, rows);
+}
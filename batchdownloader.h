@@ -0,0 +1,93 @@
+#ifndef BATCHDOWNLOADER_H
+#define BATCHDOWNLOADER_H
+
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QList>
+#include <QObject>
+#include <QProcess>
+#include <QString>
+#include <QVector>
+
+#include <atomic>
+#include <memory>
+
+class QTemporaryDir;
+class QThread;
+class QTimer;
+
+struct DownloadRequest {
+  QString exchange;
+  QString symbol;
+  QString timeframe;
+  QDateTime start_time;
+  QDateTime end_time;
+  QString output_path;
+  QString proxy = "http://127.0.0.1:7890";
+  QString mock_server; // 非空时从本地模拟服务下载，用于离线测试
+  qint64 append_offset = -1; // >=0 时为增量更新：新数据追加到output_path末尾，值为追加前的文件大小
+};
+
+// 分批下载：把时间范围切成交易所单次请求大小的窗口，限定并发数同时下载，
+// 被限频时退避重试，全部完成后在后台线程按时间顺序拼接并去重写入输出文件。
+// 全程由信号驱动，不阻塞界面线程
+
+class BatchDownloader : public QObject {
+  Q_OBJECT
+
+public:
+  static constexpr int kWindowBars = 1000; // 交易所单次请求的K线上限
+
+  explicit BatchDownloader(QObject* parent = nullptr);
+  ~BatchDownloader();
+
+  static qint64 timeframeMsecs(const QString& timeframe);
+
+  void setMaxConcurrency(int count) { max_concurrency_ = qMax(1, count); }
+  bool isRunning() const { return active_ || merge_thread_; }
+  bool start(const DownloadRequest& request);
+  void cancel();
+
+signals:
+  void progress(qint64 fetched_bars, qint64 total_bars); // 解析脚本输出的PROGRESS行，逐步更新
+  void finished(bool success, const QString& message, qint64 rows);
+
+private slots:
+  void launchWindows();
+
+private:
+  struct Window {
+    qint64 since_ms = 0;
+    int bars = 0;
+    QString path;
+    int fetched = 0; // 脚本已报告获取的K线数
+    int attempts = 0;
+    bool has_data = false;
+  };
+
+  void startWindow(int index);
+  void onWindowOutput(int index, QProcess* process);
+  void onWindowFinished(int index, QProcess* process, int exit_code, QProcess::ExitStatus status);
+  void emitProgress();
+  void startMerge();
+  bool mergeWindows(qint64& rows, QString& error); // 在后台线程执行
+  void finish(bool success, const QString& message, qint64 rows);
+
+  DownloadRequest request_;
+  QVector<Window> windows_;
+  QList<int> queue_; // 等待启动的窗口下标
+  QList<QProcess*> processes_;
+  std::unique_ptr<QTemporaryDir> temp_dir_;
+  QTimer* launch_timer_;
+  QThread* merge_thread_;
+  std::atomic<bool> merge_cancelled_;
+  QElapsedTimer clock_;
+  qint64 next_launch_ms_; // 限频：下一个窗口最早的启动时间
+  int backoff_ms_;
+  int max_concurrency_;
+  int finished_windows_;
+  qint64 total_bars_;
+  bool active_;
+};
+
+#endif // BATCHDOWNLOADER_H
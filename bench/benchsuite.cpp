@@ -0,0 +1,686 @@
+#include "backtestengine.h"
+#include "baraggregator.h"
+#include "builtinstrategies.h"
+#include "indicatorcache.h"
+#include "indicators.h"
+#include "klinecache.h"
+#include "klineloader.h"
+#include "klinepyramid.h"
+#include "klinestream.h"
+#include "livefeed.h"
+#include "montecarlo.h"
+#include "nativestrategy.h"
+#include "profiler.h"
+#include "rangeindex.h"
+#include "spscring.h"
+#include "syntheticdata.h"
+#include "tickbacktest.h"
+#include "tickstore.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRegularExpression>
+#include <QSysInfo>
+#include <QTemporaryDir>
+#include <QTextStream>
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <random>
+#include <thread>
+
+namespace {
+
+constexpr int kSchemaVersion = 1;
+constexpr int kIndicatorPeriod = 20;
+constexpr int kRangeQueries = 1000000;
+constexpr int kTicksPerBar = 4;
+constexpr double kVolumeBarSize = 400.0; // 约合成数据4根K线的成交量
+constexpr qint64 kMonteCarloSimulations = 1000;
+constexpr int kSweepRuns = 100;
+constexpr qint64 kRingItems = 1000000; // 无锁队列检验推入的条数，远大于容量，反复绕回
+constexpr int kExitUsage = 2;
+constexpr int kExitRegression = 3;
+
+// 与strategies/macross.cpp插件相同的编译期参数
+struct NativeMaCrossParams {
+  static constexpr int kFast = 10;
+  static constexpr int kSlow = 30;
+};
+using NativeMaCross = CrossoverStrategy<NativeMaCrossParams, Sma>;
+
+// 防止被测结果被编译器当作无用计算删掉
+volatile double g_sink = 0.0;
+
+struct Benchmark {
+  QString name;
+  QString group;  // micro：单个内核；macro：用户可感知的完整流程
+  qint64 items;   // 每次运行处理的条目数，用于换算吞吐
+  std::function<void()> prepare; // 每次计时前执行，不计入耗时，可为空
+  std::function<void()> run;
+};
+
+struct Measurement {
+  QString name;
+  QString group;
+  qint64 items = 0;
+  qint64 min_ns = 0;
+  qint64 median_ns = 0;
+  qint64 mean_ns = 0;
+  qint64 max_ns = 0;
+  qint64 allocations = 0; // 最后一次运行中当前线程的堆分配次数，其他线程上的不计；口径见system.allocations
+};
+
+bool writeTicks(const QString &path, const QVector<TickData> &ticks) {
+  TickWriter writer;
+  if (writer.open(path)) {
+    for (const TickData &tick : ticks)
+      writer.append(tick);
+  }
+  return writer.commit();
+}
+
+// 逐笔存储按块把价格和数量换成decimals位小数的整数：读回的值与原值之差不超过10^-decimals，
+// 数值大到超出double的整数精度时再放宽几个最小单位；时间戳和买卖方向须完全相同
+bool readTicksBack(const QString &path,
+                   const QVector<TickData> &expected,
+                   int price_decimals,
+                   int amount_decimals) {
+  auto close_enough = [](double actual, double wanted, int decimals) {
+    const double tolerance = std::pow(10.0, -decimals)
+                             + 4.0 * std::numeric_limits<double>::epsilon() * std::abs(wanted);
+    return std::abs(actual - wanted) <= tolerance;
+  };
+  TickReader reader;
+  if (!reader.open(path) || reader.count() != expected.size())
+    return false;
+  qsizetype i = 0;
+  while (const QVector<TickData> *block = reader.next()) {
+    for (const TickData &tick : *block) {
+      if (i >= expected.size())
+        return false;
+      const TickData &wanted = expected[i++];
+      if (tick.timestamp != wanted.timestamp || tick.taker_buy != wanted.taker_buy
+          || !close_enough(tick.price, wanted.price, price_decimals)
+          || !close_enough(tick.amount, wanted.amount, amount_decimals)) {
+        return false;
+      }
+    }
+  }
+  return !reader.hasError() && i == expected.size();
+}
+
+// 编码的边界：同一毫秒多笔、价格下跌（负差值）、时间跳跃（长变长整数）、
+// 小数位超过上限的价格（按8位存）、大到须减少小数位的数量
+QVector<TickData> edgeCaseTicks() {
+  QVector<TickData> ticks;
+  qint64 timestamp = 1577836800000;
+  double price = 7200.0;
+  for (int i = 0; i < 3000; i++) {
+    if (i % 7 != 0)
+      timestamp += i % 50 == 0 ? 86400000LL * 400 : i % 3;
+    price += i % 5 == 0 ? -1.0 / 3.0 : 0.01 * (i % 11);
+    const double amount = i == 1500 ? 2e10 + 0.5 : 1.0 / (1 + i % 13);
+    ticks.append({timestamp, price, amount, i % 2 == 0});
+  }
+  return ticks;
+}
+
+// 无锁队列：先在单线程里检验满/空的判断，再由两个线程推入远多于容量的递增序号，
+// 消费者须按顺序一个不少地取到，且队列中的数量从不超过容量
+bool checkSpscRing() {
+  SpscRing<qint64> small(3); // 容量取整为4
+  qint64 value = 0;
+  for (int round = 0; round < 3; round++) {
+    for (qint64 i = 0; i < small.capacity(); i++) {
+      if (!small.tryPush(round * 10 + i))
+        return false;
+    }
+    if (small.tryPush(-1))
+      return false;
+    for (qint64 i = 0; i < small.capacity(); i++) {
+      if (!small.tryPop(value) || value != round * 10 + i)
+        return false;
+    }
+    if (small.tryPop(value))
+      return false;
+    // 错开一格，下一轮从缓冲区中间开始绕回
+    if (!small.tryPush(-2) || !small.tryPop(value) || value != -2)
+      return false;
+  }
+
+  SpscRing<qint64> ring(64);
+  std::atomic<bool> overfull{false};
+  std::thread producer([&] {
+    for (qint64 i = 0; i < kRingItems; i++) {
+      while (!ring.tryPush(i))
+        std::this_thread::yield();
+      if (ring.size() > ring.capacity())
+        overfull = true;
+    }
+  });
+  qint64 expected = 0;
+  bool ordered = true;
+  while (expected < kRingItems) {
+    if (!ring.tryPop(value)) {
+      std::this_thread::yield();
+      continue;
+    }
+    ordered = ordered && value == expected;
+    expected++;
+  }
+  producer.join();
+  return ordered && !overfull && !ring.tryPop(value) && ring.size() == 0;
+}
+
+// 等待模拟完成，返回总收益的中位数
+double runMonteCarlo(const QVector<KLineData> &bars,
+                     const QVector<TradeSignal> &trade_signals,
+                     MonteCarloSpec::Method method) {
+  MonteCarloSpec spec;
+  spec.method = method;
+  spec.simulations = kMonteCarloSimulations;
+  MonteCarlo monte_carlo;
+  double median = 0.0;
+  QEventLoop loop;
+  QObject::connect(&monte_carlo, &MonteCarlo::finished, &loop, [&](const MonteCarloResult &result, qint64) {
+    median = result.total_return.median;
+    loop.quit();
+  });
+  if (!monte_carlo.start(bars, trade_signals, spec))
+    return 0.0;
+  loop.exec();
+  return median;
+}
+
+Measurement measure(const Benchmark &bench, int repeats) {
+  // 先空跑一次，页缓存、指令缓存和惰性初始化都在这里完成
+  if (bench.prepare)
+    bench.prepare();
+  bench.run();
+  Measurement m;
+  QVector<qint64> samples;
+  samples.reserve(repeats);
+  for (int i = 0; i < repeats; i++) {
+    if (bench.prepare)
+      bench.prepare();
+    const qint64 allocations = Profiler::allocationCount();
+    QElapsedTimer timer;
+    timer.start();
+    bench.run();
+    samples.append(qMax<qint64>(timer.nsecsElapsed(), 1));
+    m.allocations = Profiler::allocationCount() - allocations;
+  }
+  std::sort(samples.begin(), samples.end());
+  m.name = bench.name;
+  m.group = bench.group;
+  m.items = bench.items;
+  m.min_ns = samples.first();
+  m.max_ns = samples.last();
+  m.median_ns = samples[samples.size() / 2];
+  qint64 total = 0;
+  for (qint64 sample : samples)
+    total += sample;
+  m.mean_ns = total / samples.size();
+  return m;
+}
+
+QJsonObject toJson(const Measurement &m) {
+  QJsonObject object;
+  object["name"] = m.name;
+  object["group"] = m.group;
+  object["items"] = m.items;
+  object["min_ns"] = m.min_ns;
+  object["median_ns"] = m.median_ns;
+  object["mean_ns"] = m.mean_ns;
+  object["max_ns"] = m.max_ns;
+  object["items_per_second"] = m.items / (m.median_ns / 1e9);
+  object["allocations"] = m.allocations;
+  return object;
+}
+
+// 与基线逐项比较中位数，慢于基线threshold以上的记为退化，返回退化的项数
+int compareWithBaseline(const QVector<Measurement> &results,
+                        qint64 bars,
+                        const QJsonObject &baseline,
+                        double threshold,
+                        QTextStream &out) {
+  QHash<QString, qint64> previous;
+  for (const QJsonValue &value : baseline["benchmarks"].toArray()) {
+    const QJsonObject object = value.toObject();
+    previous[object["name"].toString()] = object["median_ns"].toInteger();
+  }
+  if (baseline["config"].toObject()["bars"].toInteger() != bars)
+    out << "注意: 基线的数据规模与本次不同，比值仅供参考\n";
+  int regressions = 0;
+  for (const Measurement &m : results) {
+    const qint64 old_ns = previous.value(m.name, 0);
+    if (old_ns <= 0) {
+      out << QString("%1 %2\n").arg(m.name, -24).arg("基线中没有");
+      continue;
+    }
+    const double ratio = double(m.median_ns) / old_ns;
+    const bool regressed = ratio > 1.0 + threshold;
+    regressions += regressed ? 1 : 0;
+    out << QString("%1 %2 -> %3 ms  %4x%5\n")
+               .arg(m.name, -24)
+               .arg(old_ns / 1e6, 10, 'f', 3)
+               .arg(m.median_ns / 1e6, 10, 'f', 3)
+               .arg(ratio, 6, 'f', 2)
+               .arg(regressed ? "  退化" : "");
+  }
+  return regressions;
+}
+
+const char *allocationCountingName() {
+  switch (Profiler::allocationCounting()) {
+  case Profiler::AllocationCounting::Malloc:
+    return "malloc";
+  case Profiler::AllocationCounting::OperatorNew:
+    return "operator new";
+  case Profiler::AllocationCounting::None:
+    break;
+  }
+  return "none";
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  QCoreApplication app(argc, argv);
+  QCoreApplication::setApplicationName("qtbacktester_bench");
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription(
+      "性能基准：在确定性的合成数据上测量CSV解析、排序、图表数据构建、区间查询、指标和回测，"
+      "结果以JSON输出，可与之前提交的结果比较");
+  parser.addHelpOption();
+  QCommandLineOption bars_option("bars", "合成K线数量", "n", "1000000");
+  QCommandLineOption timeframe_option("timeframe", "合成K线周期，如 1m、15m、1h", "interval", "1m");
+  QCommandLineOption seed_option("seed", "随机种子", "n", "42");
+  QCommandLineOption repeats_option("repeats", "每项计时次数，取中位数", "n", "5");
+  QCommandLineOption filter_option("filter", "只运行名称匹配该正则的项", "regex");
+  QCommandLineOption list_option("list", "列出所有基准项后退出");
+  QCommandLineOption json_option("json", "把结果写入JSON文件，\"-\"为标准输出", "file");
+  QCommandLineOption baseline_option("baseline", "与之前保存的JSON结果比较", "file");
+  QCommandLineOption threshold_option("threshold",
+                                      "中位数慢于基线该比例时视为退化，退出码为3",
+                                      "ratio",
+                                      "0.1");
+  QCommandLineOption generate_option("generate", "只把合成数据写成CSV文件后退出", "file");
+  parser.addOptions({bars_option,
+                     timeframe_option,
+                     seed_option,
+                     repeats_option,
+                     filter_option,
+                     list_option,
+                     json_option,
+                     baseline_option,
+                     threshold_option,
+                     generate_option});
+  parser.process(app);
+
+  QTextStream err(stderr);
+  SyntheticSpec spec;
+  spec.bars = parser.value(bars_option).toLongLong();
+  spec.seed = parser.value(seed_option).toULongLong();
+  const int repeats = parser.value(repeats_option).toInt();
+  bool threshold_ok = false;
+  const double threshold = parser.value(threshold_option).toDouble(&threshold_ok);
+  if (spec.bars <= kIndicatorPeriod || repeats <= 0 || !threshold_ok || threshold < 0.0
+      || !KLinePyramid::parseInterval(parser.value(timeframe_option), spec.interval_ms)) {
+    err << "参数无效，见 --help\n";
+    return kExitUsage;
+  }
+  const QRegularExpression filter(parser.value(filter_option));
+  if (!filter.isValid()) {
+    err << "无效的正则: " << filter.errorString() << "\n";
+    return kExitUsage;
+  }
+
+  const QVector<KLineData> bars = SyntheticData::generate(spec);
+  if (parser.isSet(generate_option)) {
+    if (!SyntheticData::writeCsv(parser.value(generate_option), bars)) {
+      err << "无法写入文件: " << parser.value(generate_option) << "\n";
+      return 1;
+    }
+    return 0;
+  }
+
+  QTemporaryDir dir;
+  const QString csv_path = dir.filePath("synthetic.csv");
+  const QByteArray csv = SyntheticData::toCsv(bars);
+  QVector<KLineData> shuffled = bars;
+  SyntheticData::shuffle(shuffled, spec.seed);
+  if (!SyntheticData::writeCsv(csv_path, bars) || !KLineCache::write(csv_path, bars)) {
+    err << "无法写入临时数据: " << csv_path << "\n";
+    return 1;
+  }
+
+  const QVector<TickData> ticks = SyntheticData::generateTicks(bars, kTicksPerBar, spec.seed);
+  const qsizetype tick_count = ticks.size();
+  const QString tick_path = dir.filePath("synthetic.qtk");
+  if (!writeTicks(tick_path, ticks)) {
+    err << "无法写入临时数据: " << tick_path << "\n";
+    return 1;
+  }
+  if (!checkSpscRing()) {
+    err << "无锁队列取出的顺序或数量与推入的不一致\n";
+    return 1;
+  }
+
+  // 合成逐笔的价格取到0.01、数量取到0.00001；边界数据在一块之内，小数位分别为8和7
+  const QString edge_path = dir.filePath("edge.qtk");
+  const QVector<TickData> edge_ticks = edgeCaseTicks();
+  if (!readTicksBack(tick_path, ticks, 2, 5) || !writeTicks(edge_path, edge_ticks)
+      || !readTicksBack(edge_path, edge_ticks, 8, 7)) {
+    err << "逐笔存储读回的数据与写入的不一致\n";
+    return 1;
+  }
+
+  IndicatorCache columns(bars);
+  const double *high = columns.high();
+  const double *low = columns.low();
+  const double *close = columns.close();
+  const double *volume = columns.volume();
+  const qsizetype count = bars.size();
+
+  RangeIndex range_index;
+  range_index.build(bars);
+  // 查询窗口长度覆盖图表可见数量的常见范围
+  QVector<QPair<qsizetype, qsizetype>> windows;
+  windows.reserve(kRangeQueries);
+  std::mt19937_64 rng(spec.seed);
+  for (int i = 0; i < kRangeQueries; i++) {
+    const qsizetype length = 1 + qsizetype(rng() % quint64(qMin<qsizetype>(count, 2000)));
+    const qsizetype first = qsizetype(rng() % quint64(count - length + 1));
+    windows.append({first, first + length - 1});
+  }
+
+  BacktestConfig config;
+  auto indicators = std::make_shared<IndicatorCache>(bars);
+  const QVector<TradeSignal> trade_signals = runMaCross(config, bars, *indicators, 10, 30).trade_signals;
+  const qsizetype trade_count = MonteCarlo::tradeReturns(trade_signals, config).size();
+  QVector<KLineData> sort_buffer;
+  QVector<KLineData> output;
+
+  const QVector<Benchmark> benchmarks = {
+      {"csv.parse", "micro", count, nullptr,
+       [&] {
+         KLineLoader::parseCsv(csv.constData(), csv.constData() + csv.size(), output);
+         g_sink = g_sink + output.size();
+       }},
+      {"csv.sort.shuffled", "micro", count, [&] { sort_buffer = shuffled; },
+       [&] {
+         std::sort(sort_buffer.begin(), sort_buffer.end(), [](const KLineData &a, const KLineData &b) {
+           return a.timestamp < b.timestamp;
+         });
+         g_sink = g_sink + sort_buffer.first().close;
+       }},
+      {"pyramid.aggregate.1h", "micro", count, nullptr,
+       [&] {
+         KLinePyramid::aggregate(bars.constData(), count, 3600000, output);
+         g_sink = g_sink + output.size();
+       }},
+      {"range.build", "micro", count, nullptr,
+       [&] {
+         RangeIndex index;
+         index.build(bars);
+         g_sink = g_sink + index.size();
+       }},
+      // 实时模式逐根追加K线时的增量建表
+      {"range.append", "micro", count, nullptr,
+       [&] {
+         RangeIndex index;
+         for (const KLineData &bar : bars)
+           index.append(bar);
+         g_sink = g_sink + index.size();
+       }},
+      {"range.query", "micro", kRangeQueries, nullptr,
+       [&] {
+         double sum = 0.0;
+         for (const auto &window : windows)
+           sum += range_index.max(window.first, window.second) - range_index.min(window.first, window.second);
+         g_sink = g_sink + sum;
+       }},
+      {"indicator.sma", "micro", count, nullptr,
+       [&] { g_sink = g_sink + Indicators::sma(close, count, kIndicatorPeriod).last(); }},
+      {"indicator.ema", "micro", count, nullptr,
+       [&] { g_sink = g_sink + Indicators::ema(close, count, kIndicatorPeriod).last(); }},
+      {"indicator.rsi", "micro", count, nullptr,
+       [&] { g_sink = g_sink + Indicators::rsi(close, count, kIndicatorPeriod).last(); }},
+      {"indicator.atr", "micro", count, nullptr,
+       [&] { g_sink = g_sink + Indicators::atr(high, low, close, count, kIndicatorPeriod).last(); }},
+      {"indicator.bollinger", "micro", count, nullptr,
+       [&] {
+         g_sink = g_sink + Indicators::bollinger(close, count, kIndicatorPeriod, 2.0).upper.last();
+       }},
+      {"indicator.vwap", "micro", count, nullptr,
+       [&] {
+         g_sink = g_sink + Indicators::vwap(high, low, close, volume, count, kIndicatorPeriod).last();
+       }},
+      {"tick.encode", "micro", tick_count, nullptr,
+       [&] {
+         TickWriter writer;
+         if (!writer.open(dir.filePath("encode.qtk")))
+           return;
+         for (const TickData &tick : ticks)
+           writer.append(tick);
+         g_sink = g_sink + (writer.commit() ? 1 : 0);
+       }},
+      {"tick.decode", "micro", tick_count, nullptr,
+       [&] {
+         TickReader reader;
+         if (!reader.open(tick_path))
+           return;
+         double sum = 0.0;
+         while (const QVector<TickData> *block = reader.next())
+           sum += block->last().price;
+         g_sink = g_sink + sum;
+       }},
+      {"tick.aggregate.volume", "micro", tick_count, nullptr,
+       [&] {
+         BarAggregator aggregator(BarAggregator::Mode::Volume, kVolumeBarSize);
+         KLineData bar;
+         double sum = 0.0;
+         for (const TickData &tick : ticks) {
+           if (aggregator.add(tick, bar))
+             sum += bar.close;
+         }
+         g_sink = g_sink + sum;
+       }},
+      {"csv.load", "macro", count, nullptr,
+       [&] {
+         KLineLoader::loadCsv(csv_path, output);
+         g_sink = g_sink + output.size();
+       }},
+      {"cache.open", "macro", count, nullptr,
+       [&] {
+         KLineCache cache;
+         if (cache.open(csv_path))
+           cache.toKLineData(output);
+         g_sink = g_sink + output.size();
+       }},
+      // 加载后、图表显示前的数据准备：逐层合并周期并为每层建区间最值索引
+      {"chart.build", "macro", count, nullptr,
+       [&] {
+         KLinePyramid pyramid;
+         pyramid.build(bars);
+         g_sink = g_sink + pyramid.levelCount();
+       }},
+      {"backtest.maCross", "macro", count, nullptr,
+       [&] {
+         MovingAverageCross strategy(10, 30);
+         g_sink = g_sink + BacktestEngine::run(config, bars.constData(), count, strategy).final_capital;
+       }},
+      {"backtest.native", "macro", count, nullptr,
+       [&] {
+         NativeMaCross strategy;
+         g_sink = g_sink + BacktestEngine::run(config, bars.constData(), count, strategy).final_capital;
+       }},
+      // C++插件的流程：先一次生成逐K线动作，再由引擎回放撮合
+      {"backtest.plugin", "macro", count, nullptr,
+       [&] {
+         QVector<qint8> actions(count);
+         generateActions<NativeMaCross>(bars.constData(), count, actions.data());
+         ActionReplay replay(actions.constData());
+         g_sink = g_sink + BacktestEngine::run(config, bars.constData(), count, replay).final_capital;
+       }},
+      {"backtest.precomputed", "macro", count, nullptr,
+       [&] { g_sink = g_sink + runMaCross(config, bars, *indicators, 10, 30).final_capital; }},
+      // 参数扫描的单线程形态：连续回测复用线程局部的arena，只统计指标时每次回测都不分配
+      {"backtest.sweep", "macro", kSweepRuns * count, nullptr,
+       [&] {
+         BacktestConfig sweep_config = config;
+         sweep_config.record_equity_curve = false;
+         sweep_config.record_trades = false;
+         for (int run = 0; run < kSweepRuns; run++)
+           g_sink = g_sink + runMaCross(sweep_config, bars, *indicators, 5 + run % 10, 30).final_capital;
+       }},
+      {"backtest.stream", "macro", count, nullptr,
+       [&] {
+         KLineStream stream;
+         if (!stream.open(csv_path))
+           return;
+         MovingAverageCross strategy(10, 30);
+         BacktestConfig stream_config = config;
+         stream_config.record_equity_curve = false;
+         stream_config.record_trades = false;
+         g_sink = g_sink + BacktestEngine::runBlocks(stream_config, stream, strategy).final_capital;
+       }},
+      // 实时模式满速回放：K线经两个无锁队列穿过行情线程和引擎线程，逐根增量计算均线并撮合
+      {"live.replay", "macro", count, nullptr,
+       [&] {
+         LiveFeedConfig live_config;
+         live_config.file_path = csv_path;
+         LiveFeed feed(live_config);
+         QString error;
+         if (!feed.start(nullptr, error))
+           return;
+         QVector<LiveUpdate> updates;
+         double sum = 0.0;
+         for (;;) {
+           const bool finished = feed.isFinished();
+           if (feed.takeUpdates(updates) > 0)
+             sum += updates.last().equity;
+           else if (finished)
+             break;
+           else
+             std::this_thread::yield();
+         }
+         g_sink = g_sink + sum;
+       }},
+      // 读逐笔文件、合成1小时K线并逐笔撮合，单次顺序扫描
+      {"backtest.ticks", "macro", tick_count, nullptr,
+       [&] {
+         TickReader reader;
+         if (!reader.open(tick_path))
+           return;
+         MovingAverageCross strategy(10, 30);
+         const BarAggregator aggregator(BarAggregator::Mode::Time, 3600000.0);
+         g_sink = g_sink + TickBacktest::run(config, TickFillConfig(), reader, aggregator, strategy)
+                               .backtest.final_capital;
+       }},
+      // 蒙特卡洛：吞吐按所有模拟的总步数（交易数或K线数乘以模拟次数）计
+      {"montecarlo.trades", "macro", kMonteCarloSimulations * trade_count, nullptr,
+       [&] {
+         g_sink = g_sink + runMonteCarlo(bars, trade_signals, MonteCarloSpec::Method::TradeResample);
+       }},
+      {"montecarlo.blocks", "macro", kMonteCarloSimulations * count, nullptr,
+       [&] {
+         g_sink = g_sink + runMonteCarlo(bars, trade_signals, MonteCarloSpec::Method::BlockBootstrap);
+       }},
+  };
+
+  if (parser.isSet(list_option)) {
+    QTextStream out(stdout);
+    for (const Benchmark &bench : benchmarks)
+      out << bench.group << "\t" << bench.name << "\n";
+    return 0;
+  }
+
+  err << QString("合成数据: %1 根 %2 K线，种子 %3，指令集 %4，分配统计 %5\n")
+             .arg(spec.bars)
+             .arg(parser.value(timeframe_option))
+             .arg(spec.seed)
+             .arg(Indicators::isaName(Indicators::activeIsa()))
+             .arg(allocationCountingName());
+  QVector<Measurement> results;
+  for (const Benchmark &bench : benchmarks) {
+    if (!filter.match(bench.name).hasMatch())
+      continue;
+    const Measurement m = measure(bench, repeats);
+    results.append(m);
+    err << QString("%1 %2 ms  %3 百万/秒  分配 %4 次\n")
+               .arg(m.name, -24)
+               .arg(m.median_ns / 1e6, 10, 'f', 3)
+               .arg(m.items / (m.median_ns / 1e9) / 1e6, 8, 'f', 2)
+               .arg(m.allocations);
+    err.flush();
+  }
+  if (results.isEmpty()) {
+    err << "没有匹配的基准项\n";
+    return kExitUsage;
+  }
+
+  QJsonObject root;
+  root["schema"] = kSchemaVersion;
+  root["suite"] = QCoreApplication::applicationName();
+  root["date"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+  QJsonObject system;
+  system["cpu"] = QSysInfo::currentCpuArchitecture();
+  system["os"] = QSysInfo::prettyProductName();
+  system["qt"] = qVersion();
+  system["isa"] = Indicators::isaName(Indicators::activeIsa());
+  system["threads"] = int(std::thread::hardware_concurrency());
+  system["allocations"] = allocationCountingName();
+  root["system"] = system;
+  QJsonObject config_json;
+  config_json["bars"] = spec.bars;
+  config_json["interval_ms"] = spec.interval_ms;
+  config_json["seed"] = qint64(spec.seed);
+  config_json["repeats"] = repeats;
+  root["config"] = config_json;
+  QJsonArray items;
+  for (const Measurement &m : results)
+    items.append(toJson(m));
+  root["benchmarks"] = items;
+  const QByteArray json = QJsonDocument(root).toJson();
+
+  if (parser.isSet(json_option)) {
+    const QString path = parser.value(json_option);
+    QFile file(path);
+    const bool opened = path == "-" ? file.open(stdout, QIODevice::WriteOnly)
+                                    : file.open(QIODevice::WriteOnly);
+    if (!opened || file.write(json) != json.size()) {
+      err << "无法写入文件: " << path << "\n";
+      return 1;
+    }
+  }
+
+  if (parser.isSet(baseline_option)) {
+    QFile file(parser.value(baseline_option));
+    QJsonParseError parse_error;
+    const QJsonDocument baseline = file.open(QIODevice::ReadOnly)
+                                       ? QJsonDocument::fromJson(file.readAll(), &parse_error)
+                                       : QJsonDocument();
+    if (!baseline.isObject()) {
+      err << "无法读取基线: " << parser.value(baseline_option) << "\n";
+      return 1;
+    }
+    err << QString("与基线比较（中位数，阈值 %1%）:\n").arg(threshold * 100.0, 0, 'f', 0);
+    if (compareWithBaseline(results, spec.bars, baseline.object(), threshold, err) > 0)
+      return kExitRegression;
+  }
+  return 0;
+}
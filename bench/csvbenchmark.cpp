@@ -0,0 +1,221 @@
+#include "builtinstrategies.h"
+#include "klinecache.h"
+#include "klineloader.h"
+#include "klinestream.h"
+#include "syntheticdata.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QStringList>
+#include <QTemporaryDir>
+#include <QTextStream>
+
+#include <algorithm>
+
+namespace {
+
+constexpr qint64 kAppendedRows = 1000; // 小于缓存每列的空位，走原地追加
+
+// 旧版loadKLineData的实现，作为对照组
+bool loadCsvTextStream(const QString &filePath, QVector<KLineData> &out) {
+  QFile file(filePath);
+  if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+    return false;
+  QTextStream in(&file);
+  out.clear();
+  QString header = in.readLine();
+  if (!header.contains("timestamp"))
+    return false;
+  while (!in.atEnd()) {
+    QString line = in.readLine();
+    if (line.trimmed().isEmpty())
+      continue;
+    QStringList f = line.split(',');
+    if (f.size() < 6)
+      continue;
+    KLineData d;
+    bool ok;
+    d.timestamp = f[0].toLongLong(&ok);
+    if (!ok)
+      continue;
+    d.open = f[1].toDouble();
+    d.high = f[2].toDouble();
+    d.low = f[3].toDouble();
+    d.close = f[4].toDouble();
+    d.volume = f[5].toDouble();
+    out.append(d);
+  }
+  std::sort(out.begin(), out.end(), [](auto &a, auto &b) { return a.timestamp < b.timestamp; });
+  return !out.isEmpty();
+}
+
+// CSV末尾追加数据行后同步缓存，重新映射的结果应与解析整个新CSV的相同；
+// 空位足够时缓存文件大小不变，说明走的是原地追加而不是整体重写
+bool checkCacheAppend(const QString &filePath, const QVector<KLineData> &bars) {
+  SyntheticSpec spec;
+  spec.bars = kAppendedRows;
+  spec.seed = 7;
+  spec.start_time = bars.last().timestamp + spec.interval_ms;
+  const QVector<KLineData> appended = SyntheticData::generate(spec);
+  QByteArray rows = SyntheticData::toCsv(appended);
+  rows.remove(0, rows.indexOf('\n') + 1); // 去掉表头
+
+  const qint64 previousSize = QFileInfo(filePath).size();
+  const qint64 cacheSize = QFileInfo(KLineCache::cachePath(filePath)).size();
+  QFile file(filePath);
+  if (!file.open(QIODevice::Append) || file.write(rows) != rows.size())
+    return false;
+  file.close();
+  // 与BacktestSession::append相同，新增部分按CSV中的文本解析，而不是用生成时未取整的值
+  QVector<KLineData> all = bars;
+  if (!KLineLoader::loadCsvTail(filePath, previousSize, all)
+      || all.size() != bars.size() + kAppendedRows
+      || !KLineCache::append(filePath, previousSize, all, bars.size())
+      || QFileInfo(KLineCache::cachePath(filePath)).size() != cacheSize) {
+    return false;
+  }
+
+  if (!file.open(QIODevice::ReadOnly))
+    return false;
+  const QByteArray csv = file.readAll();
+  QVector<KLineData> parsed;
+  QVector<KLineData> cached;
+  KLineCache cache;
+  if (!KLineLoader::parseCsv(csv.constData(), csv.constData() + csv.size(), parsed)
+      || !cache.open(filePath)) {
+    return false;
+  }
+  cache.toKLineData(cached);
+  if (cached.size() != parsed.size())
+    return false;
+  for (qsizetype i = 0; i < parsed.size(); i++) {
+    const KLineData &a = cached[i];
+    const KLineData &b = parsed[i];
+    if (a.timestamp != b.timestamp || a.open != b.open || a.high != b.high || a.low != b.low
+        || a.close != b.close || a.volume != b.volume) {
+      return false;
+    }
+  }
+  return true;
+}
+
+template<typename Fn>
+double timeLoad(Fn &&fn, const QString &filePath, QVector<KLineData> &out) {
+  QElapsedTimer timer;
+  timer.start();
+  if (!fn(filePath, out))
+    return -1.0;
+  return timer.nsecsElapsed() / 1e6;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  QCoreApplication app(argc, argv);
+  const QStringList args = app.arguments();
+  qint64 rows = args.size() > 1 ? args[1].toLongLong() : 5000000;
+  if (rows <= 0)
+    rows = 5000000;
+
+  QTemporaryDir dir;
+  QString filePath = dir.filePath("bench_1m.csv");
+  qInfo() << "生成" << rows << "行测试数据:" << filePath;
+  SyntheticSpec spec;
+  spec.bars = rows;
+  if (!SyntheticData::writeCsv(filePath, SyntheticData::generate(spec))) {
+    qCritical() << "生成测试数据失败";
+    return 1;
+  }
+
+  QVector<KLineData> legacy;
+  QVector<KLineData> fast;
+  double legacyMs = timeLoad(loadCsvTextStream, filePath, legacy);
+  double fastMs = timeLoad(
+      [](const QString &path, QVector<KLineData> &out) { return KLineLoader::loadCsv(path, out); },
+      filePath,
+      fast);
+  if (legacyMs < 0 || fastMs < 0) {
+    qCritical() << "加载失败";
+    return 1;
+  }
+
+  // 首次加载后写出列式缓存，再测一次直接映射缓存的重开耗时
+  if (!KLineCache::write(filePath, fast)) {
+    qCritical() << "写入缓存失败";
+    return 1;
+  }
+  QVector<KLineData> cached;
+  double cacheMs = timeLoad(
+      [](const QString &path, QVector<KLineData> &out) {
+        KLineCache cache;
+        if (!cache.open(path))
+          return false;
+        cache.toKLineData(out);
+        return true;
+      },
+      filePath,
+      cached);
+
+  bool same = legacy.size() == fast.size() && cached.size() == fast.size();
+  for (qsizetype i = 0; same && i < fast.size(); i++) {
+    same = legacy[i].timestamp == fast[i].timestamp && legacy[i].close == fast[i].close
+           && legacy[i].volume == fast[i].volume && cached[i].high == fast[i].high;
+  }
+
+  // 整体读入后回测 vs 分块流式回测，两者都从CSV开始计时
+  BacktestConfig config;
+  config.record_equity_curve = false;
+  config.record_trades = false; // 只比较统计指标，流式回测的内存与数据量无关
+  QElapsedTimer timer;
+  timer.start();
+  QVector<KLineData> loaded;
+  KLineLoader::loadCsv(filePath, loaded);
+  MovingAverageCross memoryStrategy(10, 30);
+  BacktestResult memoryResult
+      = BacktestEngine::run(config, loaded.constData(), loaded.size(), memoryStrategy);
+  double memoryMs = timer.nsecsElapsed() / 1e6;
+  loaded = QVector<KLineData>();
+  timer.restart();
+  KLineStream stream;
+  if (!stream.open(filePath)) {
+    qCritical() << "流式读取失败";
+    return 1;
+  }
+  MovingAverageCross streamStrategy(10, 30);
+  BacktestResult streamResult = BacktestEngine::runBlocks(config, stream, streamStrategy);
+  double streamMs = timer.nsecsElapsed() / 1e6;
+  same = same && !stream.hasError() && streamResult.final_capital == memoryResult.final_capital
+         && streamResult.total_trades == memoryResult.total_trades;
+
+  // 放在最后：会改动CSV和缓存
+  const bool appendOk = checkCacheAppend(filePath, fast);
+  same = same && appendOk;
+
+  qInfo().noquote() << QString("QTextStream: %1 ms (%2 行/秒)")
+                           .arg(legacyMs, 0, 'f', 1)
+                           .arg(legacy.size() / (legacyMs / 1000.0), 0, 'f', 0);
+  qInfo().noquote() << QString("from_chars : %1 ms (%2 行/秒)")
+                           .arg(fastMs, 0, 'f', 1)
+                           .arg(fast.size() / (fastMs / 1000.0), 0, 'f', 0);
+  qInfo().noquote() << QString("列式缓存   : %1 ms (%2 行/秒)")
+                           .arg(cacheMs, 0, 'f', 1)
+                           .arg(cached.size() / (cacheMs / 1000.0), 0, 'f', 0);
+  qInfo().noquote() << QString("读入+回测  : %1 ms (%2 行/秒)")
+                           .arg(memoryMs, 0, 'f', 1)
+                           .arg(fast.size() / (memoryMs / 1000.0), 0, 'f', 0);
+  qInfo().noquote() << QString("流式回测   : %1 ms (%2 行/秒，块大小 %3 MB)")
+                           .arg(streamMs, 0, 'f', 1)
+                           .arg(fast.size() / (streamMs / 1000.0), 0, 'f', 0)
+                           .arg(KLineStream::kDefaultBlockBytes >> 20);
+  qInfo().noquote() << QString("缓存原地追加%1行后与解析CSV一致: %2")
+                           .arg(kAppendedRows)
+                           .arg(appendOk ? "是" : "否");
+  qInfo().noquote() << QString("加速比: %1x, 结果一致: %2")
+                           .arg(legacyMs / fastMs, 0, 'f', 1)
+                           .arg(same ? "是" : "否");
+  return same ? 0 : 1;
+}
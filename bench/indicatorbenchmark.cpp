@@ -0,0 +1,297 @@
+#include "indicatorcache.h"
+#include "indicators.h"
+#include "klinedata.h"
+#include "klinepyramid.h"
+#include "syntheticdata.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QStringList>
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <random>
+
+namespace {
+
+constexpr int kPeriod = 20;
+constexpr int kRepeats = 5;
+constexpr qsizetype kIncrementalBars = 3000; // 逐根追加检验用的K线数，覆盖两天以上，各周期都有多个桶
+constexpr int kRangeSamples = 2000;
+constexpr double kDriftPerBar = 0.2;
+constexpr double kDriftTolerance = 1e-12; // 整段前缀和时约为1e-10
+
+// 对照组：直接在K线结构体数组上逐根、逐窗口求和
+QVector<double> naiveSma(const QVector<KLineData> &bars, int period) {
+  QVector<double> out(bars.size(), std::nan(""));
+  for (qsizetype i = period - 1; i < bars.size(); i++) {
+    double sum = 0.0;
+    for (qsizetype j = i - period + 1; j <= i; j++)
+      sum += bars[j].close;
+    out[i] = sum / period;
+  }
+  return out;
+}
+
+// with_mean为false时只输出带宽 upper - middle，即2倍标准差，单独检验方差的精度
+QVector<double> naiveBollinger(const QVector<KLineData> &bars, int period, bool with_mean) {
+  QVector<double> out(bars.size(), std::nan(""));
+  for (qsizetype i = period - 1; i < bars.size(); i++) {
+    double sum = 0.0;
+    for (qsizetype j = i - period + 1; j <= i; j++)
+      sum += bars[j].close;
+    double mean = sum / period;
+    double var = 0.0;
+    for (qsizetype j = i - period + 1; j <= i; j++)
+      var += (bars[j].close - mean) * (bars[j].close - mean);
+    out[i] = (with_mean ? mean : 0.0) + 2.0 * std::sqrt(var / period);
+  }
+  return out;
+}
+
+QVector<double> naiveVwap(const QVector<KLineData> &bars, int period) {
+  QVector<double> out(bars.size(), std::nan(""));
+  for (qsizetype i = period - 1; i < bars.size(); i++) {
+    double num = 0.0;
+    double den = 0.0;
+    for (qsizetype j = i - period + 1; j <= i; j++) {
+      num += (bars[j].high + bars[j].low + bars[j].close) / 3.0 * bars[j].volume;
+      den += bars[j].volume;
+    }
+    out[i] = num / den;
+  }
+  return out;
+}
+
+QVector<double> naiveAtr(const QVector<KLineData> &bars, int period) {
+  QVector<double> out(bars.size(), std::nan(""));
+  double avg = 0.0;
+  for (qsizetype i = 0; i < bars.size(); i++) {
+    double range = bars[i].high - bars[i].low;
+    if (i > 0) {
+      range = std::max({range,
+                        std::abs(bars[i].high - bars[i - 1].close),
+                        std::abs(bars[i].low - bars[i - 1].close)});
+    }
+    if (i < period) {
+      avg += range / period;
+      if (i == period - 1)
+        out[i] = avg;
+      continue;
+    }
+    avg = (avg * (period - 1) + range) / period;
+    out[i] = avg;
+  }
+  return out;
+}
+
+double maxRelativeError(const QVector<double> &a, const QVector<double> &b) {
+  double error = 0.0;
+  for (qsizetype i = 0; i < a.size(); i++) {
+    if (std::isnan(a[i]) || std::isnan(b[i])) {
+      if (std::isnan(a[i]) != std::isnan(b[i]))
+        return std::numeric_limits<double>::infinity();
+      continue;
+    }
+    error = std::max(error, std::abs(a[i] - b[i]) / std::max(1.0, std::abs(b[i])));
+  }
+  return error;
+}
+
+bool sameBar(const KLineData &a, const KLineData &b) {
+  return a.timestamp == b.timestamp && a.open == b.open && a.high == b.high && a.low == b.low
+         && a.close == b.close && a.volume == b.volume;
+}
+
+// 增量更新的金字塔与对同一批K线整体build的结果比较：各层K线逐根相同，区间最值抽样查询相同
+bool samePyramid(const KLinePyramid &actual, const QVector<KLineData> &base, std::mt19937_64 &rng) {
+  KLinePyramid expected;
+  expected.build(base);
+  if (actual.levelCount() != expected.levelCount())
+    return false;
+  for (int i = 0; i < expected.levelCount(); i++) {
+    const KLinePyramid::Level &a = actual.level(i);
+    const KLinePyramid::Level &e = expected.level(i);
+    if (a.name != e.name || a.bars.size() != e.bars.size() || a.index.size() != e.index.size())
+      return false;
+    for (qsizetype j = 0; j < e.bars.size(); j++) {
+      if (!sameBar(a.bars[j], e.bars[j]))
+        return false;
+    }
+    const qsizetype count = e.index.size();
+    for (int k = 0; k < kRangeSamples && count > 0; k++) {
+      qsizetype first = qsizetype(rng() % quint64(count));
+      qsizetype last = qsizetype(rng() % quint64(count));
+      if (first > last)
+        std::swap(first, last);
+      if (a.index.min(first, last) != e.index.min(first, last)
+          || a.index.max(first, last) != e.index.max(first, last)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// 实时更新的路径：K线逐根追加，每隔几根先以未收盘的样子到达，之后被改写为完整的K线。
+// 在最后一桶尚不完整的几个位置与整体重建比较
+bool checkIncrementalPyramid(const QVector<KLineData> &bars) {
+  const qsizetype count = qMin(kIncrementalBars, bars.size());
+  std::mt19937_64 rng(7);
+  QVector<KLineData> base;
+  KLinePyramid pyramid;
+  for (qsizetype i = 0; i < count; i++) {
+    const KLineData &bar = bars[i];
+    if (i % 3 == 0) {
+      KLineData partial = bar;
+      partial.high = std::max(bar.open, (bar.open + bar.high) / 2.0);
+      partial.low = std::min(bar.open, (bar.open + bar.low) / 2.0);
+      partial.close = bar.open;
+      partial.volume = bar.volume / 2.0;
+      base.append(partial);
+      pyramid.append(base, base.size() - 1);
+      base.last() = bar;
+    } else {
+      base.append(bar);
+    }
+    pyramid.append(base, base.size() - 1);
+    if ((i + 1) % 997 == 0 && !samePyramid(pyramid, base, rng))
+      return false;
+  }
+  return samePyramid(pyramid, base, rng);
+}
+
+// 重复kRepeats次取最快的一次，返回每秒处理的K线数
+double barsPerSecond(qsizetype rows, const std::function<void()> &fn) {
+  qint64 best = std::numeric_limits<qint64>::max();
+  for (int i = 0; i < kRepeats; i++) {
+    QElapsedTimer timer;
+    timer.start();
+    fn();
+    best = std::min(best, timer.nsecsElapsed());
+  }
+  return rows / (std::max<qint64>(best, 1) / 1e9);
+}
+
+void report(const QString &name, double throughput, double baseline, double error) {
+  qInfo().noquote() << QString("%1 %2 百万K线/秒  %3x  误差 %4")
+                           .arg(name, -22)
+                           .arg(throughput / 1e6, 8, 'f', 1)
+                           .arg(throughput / baseline, 6, 'f', 1)
+                           .arg(error, 0, 'g', 2);
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  QCoreApplication app(argc, argv);
+  const QStringList args = app.arguments();
+  qint64 rows = args.size() > 1 ? args[1].toLongLong() : 5000000;
+  if (rows <= kPeriod)
+    rows = 5000000;
+
+  qInfo() << "生成" << rows << "根K线，窗口" << kPeriod << "，CPU指令集:"
+          << Indicators::isaName(Indicators::detectedIsa());
+  SyntheticSpec spec;
+  spec.bars = rows;
+  const QVector<KLineData> bars = SyntheticData::generate(spec);
+  IndicatorCache columns(bars); // 只借用其中拆好的列
+  const double *high = columns.high();
+  const double *low = columns.low();
+  const double *close = columns.close();
+  const double *volume = columns.volume();
+
+  // 长期单边漂移的序列（默认的500万根时末尾价格约为起点的百倍）：整段前缀和相减的误差随漂移增长，
+  // 两条均线接近时会让参数扫描与逐K线回测在不同的K线上判定交叉
+  QVector<KLineData> drifting = bars;
+  for (qsizetype i = 0; i < rows; i++) {
+    const double drift = i * kDriftPerBar;
+    drifting[i].open += drift;
+    drifting[i].high += drift;
+    drifting[i].low += drift;
+    drifting[i].close += drift;
+  }
+  IndicatorCache drifting_columns(drifting);
+
+  struct Case {
+    QString name;
+    std::function<QVector<double>()> naive;
+    std::function<QVector<double>()> fast;
+    double tolerance = 1e-6; // 最大相对误差
+  };
+  const QVector<Case> cases = {
+      {"SMA", [&] { return naiveSma(bars, kPeriod); },
+       [&] { return Indicators::sma(close, rows, kPeriod); }},
+      {"SMA漂移", [&] { return naiveSma(drifting, kPeriod); },
+       [&] { return Indicators::sma(drifting_columns.close(), rows, kPeriod); }, kDriftTolerance},
+      {"Bollinger", [&] { return naiveBollinger(bars, kPeriod, true); },
+       [&] { return Indicators::bollinger(close, rows, kPeriod, 2.0).upper; }},
+      // 上轨中标准差被均值掩盖，带宽单独比较
+      {"Bollinger带宽", [&] { return naiveBollinger(bars, kPeriod, false); },
+       [&] {
+         Indicators::Bands bands = Indicators::bollinger(close, rows, kPeriod, 2.0);
+         QVector<double> width(rows);
+         for (qsizetype i = 0; i < rows; i++)
+           width[i] = bands.upper[i] - bands.middle[i];
+         return width;
+       }},
+      {"VWAP", [&] { return naiveVwap(bars, kPeriod); },
+       [&] { return Indicators::vwap(high, low, close, volume, rows, kPeriod); }},
+      {"VWAP漂移", [&] { return naiveVwap(drifting, kPeriod); },
+       [&] {
+         return Indicators::vwap(drifting_columns.high(),
+                                 drifting_columns.low(),
+                                 drifting_columns.close(),
+                                 drifting_columns.volume(),
+                                 rows,
+                                 kPeriod);
+       },
+       kDriftTolerance},
+      {"ATR", [&] { return naiveAtr(bars, kPeriod); },
+       [&] { return Indicators::atr(high, low, close, rows, kPeriod); }},
+  };
+
+  QVector<Indicators::Isa> isas = {Indicators::Isa::Scalar};
+  if (Indicators::detectedIsa() >= Indicators::Isa::Avx2)
+    isas.append(Indicators::Isa::Avx2);
+  if (Indicators::detectedIsa() >= Indicators::Isa::Avx512)
+    isas.append(Indicators::Isa::Avx512);
+
+  bool ok = true;
+  for (const Case &c : cases) {
+    QVector<double> expected;
+    double baseline = barsPerSecond(rows, [&] { expected = c.naive(); });
+    report(QString("%1 朴素循环").arg(c.name), baseline, baseline, 0.0);
+    for (Indicators::Isa isa : isas) {
+      Indicators::setActiveIsa(isa);
+      QVector<double> actual;
+      double throughput = barsPerSecond(rows, [&] { actual = c.fast(); });
+      double error = maxRelativeError(actual, expected);
+      ok = ok && error < c.tolerance;
+      report(QString("%1 %2").arg(c.name, Indicators::isaName(isa)), throughput, baseline, error);
+    }
+  }
+
+  const bool incremental = checkIncrementalPyramid(bars);
+  qInfo().noquote() << QString("金字塔逐根追加与整体重建一致: %1").arg(incremental ? "是" : "否");
+  ok = ok && incremental;
+
+  // 参数扫描的场景：同一组均线被反复请求，命中缓存后只剩查表
+  Indicators::setActiveIsa(Indicators::detectedIsa());
+  IndicatorCache cache(bars);
+  QElapsedTimer timer;
+  timer.start();
+  for (int round = 0; round < 10; round++) {
+    for (int period = 5; period <= 60; period += 5)
+      cache.sma(period);
+  }
+  qInfo().noquote() << QString("缓存: 10轮 x 12个周期耗时 %1 ms，命中 %2，计算 %3")
+                           .arg(timer.nsecsElapsed() / 1e6, 0, 'f', 1)
+                           .arg(cache.hits())
+                           .arg(cache.misses());
+  qInfo().noquote() << QString("结果一致: %1").arg(ok ? "是" : "否");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,149 @@
+#include "syntheticdata.h"
+
+#include <QFile>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+namespace {
+
+constexpr char kCsvHeader[] = "timestamp,open,high,low,close,volume,datetime\n";
+constexpr qsizetype kWriteChunkBytes = 4 << 20;
+
+// [0, 1)均匀分布，取高53位
+double uniform(std::mt19937_64 &rng) {
+  return (rng() >> 11) * 0x1.0p-53;
+}
+
+// 4个均匀分布之和（Irwin-Hall）归一化成近似标准正态，只有加减乘，各平台结果一致
+double normal(std::mt19937_64 &rng) {
+  constexpr double kSqrt3 = 1.7320508075688772;
+  return (uniform(rng) + uniform(rng) + uniform(rng) + uniform(rng) - 2.0) * kSqrt3;
+}
+
+// 把UTC毫秒时间写成"yyyy-MM-dd HH:mm:ss"，按公历推算，逐行调用QDateTime太慢
+int formatDateTime(qint64 msecs, char *out) {
+  qint64 secs = msecs / 1000;
+  qint64 days = secs / 86400;
+  qint64 rem = secs % 86400;
+  if (rem < 0) {
+    rem += 86400;
+    days--;
+  }
+  // 公历日期与1970-01-01以来天数的换算，见 Howard Hinnant 的 civil_from_days
+  days += 719468;
+  const qint64 era = (days >= 0 ? days : days - 146096) / 146097;
+  const qint64 doe = days - era * 146097;
+  const qint64 yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  const qint64 doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  const qint64 mp = (5 * doy + 2) / 153;
+  const qint64 day = doy - (153 * mp + 2) / 5 + 1;
+  const qint64 month = mp < 10 ? mp + 3 : mp - 9;
+  const qint64 year = yoe + era * 400 + (month <= 2);
+  return std::snprintf(out,
+                       20,
+                       "%04lld-%02lld-%02lld %02lld:%02lld:%02lld",
+                       static_cast<long long>(year),
+                       static_cast<long long>(month),
+                       static_cast<long long>(day),
+                       static_cast<long long>(rem / 3600),
+                       static_cast<long long>(rem / 60 % 60),
+                       static_cast<long long>(rem % 60));
+}
+
+void appendCsvRow(QByteArray &out, const KLineData &bar) {
+  char line[192];
+  char datetime[20];
+  formatDateTime(bar.timestamp, datetime);
+  const int n = std::snprintf(line,
+                              sizeof(line),
+                              "%lld,%.2f,%.2f,%.2f,%.2f,%.5f,%s\n",
+                              static_cast<long long>(bar.timestamp),
+                              bar.open,
+                              bar.high,
+                              bar.low,
+                              bar.close,
+                              bar.volume,
+                              datetime);
+  out.append(line, n);
+}
+
+} // namespace
+
+QVector<KLineData> SyntheticData::generate(const SyntheticSpec &spec) {
+  QVector<KLineData> bars(qMax<qint64>(spec.bars, 0));
+  std::mt19937_64 rng(spec.seed);
+  double price = spec.start_price;
+  for (qsizetype i = 0; i < bars.size(); i++) {
+    KLineData &bar = bars[i];
+    bar.timestamp = spec.start_time + i * spec.interval_ms;
+    bar.open = price;
+    bar.close = price * (1.0 + spec.volatility * normal(rng));
+    // 影线长度最多约两个标准差
+    bar.high = std::max(bar.open, bar.close) * (1.0 + 2.0 * spec.volatility * uniform(rng));
+    bar.low = std::min(bar.open, bar.close) * (1.0 - 2.0 * spec.volatility * uniform(rng));
+    bar.volume = 1.0 + 199.0 * uniform(rng);
+    price = bar.close;
+  }
+  return bars;
+}
+
+QVector<TickData> SyntheticData::generateTicks(const QVector<KLineData> &bars, int per_bar,
+                                               quint64 seed) {
+  per_bar = qMax(per_bar, 1);
+  QVector<TickData> ticks;
+  ticks.reserve(bars.size() * per_bar);
+  std::mt19937_64 rng(seed);
+  for (qsizetype i = 0; i < bars.size(); i++) {
+    const KLineData &bar = bars[i];
+    const qint64 span = i + 1 < bars.size() ? bars[i + 1].timestamp - bar.timestamp : 60000;
+    for (int j = 0; j < per_bar; j++) {
+      const double t = per_bar > 1 ? double(j) / (per_bar - 1) : 1.0;
+      const double mid = bar.open + (bar.close - bar.open) * t;
+      const double wobble = (bar.high - bar.low) * 0.25 * normal(rng);
+      TickData tick;
+      tick.timestamp = bar.timestamp + span * j / per_bar;
+      tick.price = std::round(qBound(bar.low, mid + wobble, bar.high) * 100.0) / 100.0;
+      tick.amount = (std::round(bar.volume / per_bar * 2.0 * uniform(rng) * 1e5) + 1.0) / 1e5;
+      tick.taker_buy = (rng() & 1) != 0;
+      ticks.append(tick);
+    }
+  }
+  return ticks;
+}
+
+QByteArray SyntheticData::toCsv(const QVector<KLineData> &bars) {
+  QByteArray csv = kCsvHeader;
+  csv.reserve(csv.size() + bars.size() * 96);
+  for (const KLineData &bar : bars)
+    appendCsvRow(csv, bar);
+  return csv;
+}
+
+bool SyntheticData::writeCsv(const QString &file_path, const QVector<KLineData> &bars) {
+  QFile file(file_path);
+  if (!file.open(QIODevice::WriteOnly))
+    return false;
+  // 分段写出，上千万行时不必先在内存里拼出整个文件
+  QByteArray chunk = kCsvHeader;
+  for (const KLineData &bar : bars) {
+    appendCsvRow(chunk, bar);
+    if (chunk.size() >= kWriteChunkBytes) {
+      if (file.write(chunk) != chunk.size())
+        return false;
+      chunk.clear();
+    }
+  }
+  return file.write(chunk) == chunk.size();
+}
+
+void SyntheticData::shuffle(QVector<KLineData> &bars, quint64 seed) {
+  // Fisher-Yates，std::shuffle的抽取方式由标准库实现决定，这里自己写保证可复现
+  std::mt19937_64 rng(seed);
+  for (qsizetype i = bars.size() - 1; i > 0; i--) {
+    const qsizetype j = qsizetype(rng() % quint64(i + 1));
+    std::swap(bars[i], bars[j]);
+  }
+}
@@ -0,0 +1,36 @@
+#ifndef SYNTHETICDATA_H
+#define SYNTHETICDATA_H
+
+#include "klinedata.h"
+#include "tickdata.h"
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+// 基准测试用的合成K线：收盘价按对数正态随机游走，影线和成交量随机。
+// 随机数由mt19937_64的原始输出自行换算，不经过标准库的分布类，
+// 同一组参数在不同编译器和平台上生成的数据逐位相同，结果可以跨提交比较
+struct SyntheticSpec {
+  qint64 bars = 1000000;
+  qint64 interval_ms = 60000;
+  qint64 start_time = 1577836800000; // 2020-01-01 UTC
+  quint64 seed = 42;
+  double start_price = 7200.0;
+  double volatility = 0.0008; // 每根K线收益率的标准差
+};
+
+class SyntheticData {
+public:
+  static QVector<KLineData> generate(const SyntheticSpec& spec);
+  // 把每根K线拆成per_bar笔等间隔的逐笔成交：价格在开盘到收盘之间游走并夹在高低点内，
+  // 按0.01取整，数量合计约等于K线成交量，按0.00001取整
+  static QVector<TickData> generateTicks(const QVector<KLineData>& bars, int per_bar, quint64 seed);
+  // 与downloaddata.py输出相同格式的CSV文本（含表头和datetime列）
+  static QByteArray toCsv(const QVector<KLineData>& bars);
+  static bool writeCsv(const QString& file_path, const QVector<KLineData>& bars);
+  // 按seed确定性打乱，用于排序基准
+  static void shuffle(QVector<KLineData>& bars, quint64 seed);
+};
+
+#endif // SYNTHETICDATA_H
@@ -0,0 +1,175 @@
+#ifndef BUILTINSTRATEGIES_H
+#define BUILTINSTRATEGIES_H
+
+#include "backtestengine.h"
+#include "indicatorcache.h"
+
+#include <vector>
+
+// 策略下拉框中内置策略的标识，与Python策略文件路径区分
+inline constexpr char kMaCrossStrategyId[] = "builtin:ma_cross";
+
+// 固定窗口的滑动均值，缓冲区在构造时一次分配
+class RollingMean {
+public:
+  explicit RollingMean(int period)
+      : values_(qMax(1, period), 0.0)
+      , sum_(0.0)
+      , next_(0)
+      , count_(0) {}
+
+  void push(double value) {
+    sum_ += value - values_[next_];
+    values_[next_] = value;
+    next_ = next_ + 1 == int(values_.size()) ? 0 : next_ + 1;
+    if (count_ < int(values_.size()))
+      count_++;
+  }
+  bool ready() const { return count_ == int(values_.size()); }
+  double value() const { return sum_ / values_.size(); }
+
+private:
+  std::vector<double> values_;
+  double sum_;
+  int next_;
+  int count_;
+};
+
+// 均线交叉：快线上穿慢线买入，下穿卖出
+class MovingAverageCross {
+public:
+  MovingAverageCross(int fast_period, int slow_period)
+      : fast_(fast_period)
+      , slow_(slow_period)
+      , prev_diff_(0.0)
+      , has_prev_(false) {}
+
+  BarAction onBar(const KLineData& bar) {
+    fast_.push(bar.close);
+    slow_.push(bar.close);
+    if (!fast_.ready() || !slow_.ready())
+      return BarAction::Hold;
+    double diff = fast_.value() - slow_.value();
+    BarAction action = BarAction::Hold;
+    if (has_prev_) {
+      if (prev_diff_ <= 0.0 && diff > 0.0)
+        action = BarAction::Buy;
+      else if (prev_diff_ >= 0.0 && diff < 0.0)
+        action = BarAction::Sell;
+    }
+    prev_diff_ = diff;
+    has_prev_ = true;
+    return action;
+  }
+
+private:
+  RollingMean fast_;
+  RollingMean slow_;
+  double prev_diff_;
+  bool has_prev_;
+};
+
+// 与MovingAverageCross规则相同，均线取自IndicatorCache预先算好的列。
+// 参数扫描中同一周期的均线被许多组合共用，每次回测只剩比较。
+// first_bar>0时从整列的中间开始回测（样本内外分段），之前的K线只用于均线预热
+class PrecomputedMaCross {
+public:
+  PrecomputedMaCross(const double* fast, const double* slow, int warmup, qsizetype first_bar = 0)
+      : fast_(fast)
+      , slow_(slow)
+      , warmup_(warmup)
+      , bar_(first_bar)
+      , prev_diff_(first_bar >= warmup ? fast[first_bar - 1] - slow[first_bar - 1] : 0.0) {}
+
+  BarAction onBar(const KLineData&) {
+    const qsizetype i = bar_++;
+    if (i < warmup_ - 1)
+      return BarAction::Hold;
+    double diff = fast_[i] - slow_[i];
+    BarAction action = BarAction::Hold;
+    if (i >= warmup_) {
+      if (prev_diff_ <= 0.0 && diff > 0.0)
+        action = BarAction::Buy;
+      else if (prev_diff_ >= 0.0 && diff < 0.0)
+        action = BarAction::Sell;
+    }
+    prev_diff_ = diff;
+    return action;
+  }
+
+private:
+  const double* fast_;
+  const double* slow_;
+  qsizetype warmup_; // 两条均线都有值所需的K线数，即较长的周期
+  qsizetype bar_;
+  double prev_diff_;
+};
+
+// 用指标缓存中的SMA运行均线交叉回测，主界面、参数扫描和滚动优化共用，保证结果一致。
+// 只回测[first, first + count)，count<0表示到末尾
+inline BacktestResult runMaCross(const BacktestConfig& config,
+                                 const QVector<KLineData>& bars,
+                                 IndicatorCache& indicators,
+                                 int fast_period,
+                                 int slow_period,
+                                 qsizetype first = 0,
+                                 qsizetype count = -1) {
+  if (count < 0)
+    count = bars.size() - first;
+  IndicatorCache::Series fast = indicators.sma(fast_period);
+  IndicatorCache::Series slow = indicators.sma(slow_period);
+  PrecomputedMaCross strategy(fast->constData(),
+                              slow->constData(),
+                              qMax(fast_period, slow_period),
+                              first);
+  return BacktestEngine::run(config, bars.constData() + first, count, strategy);
+}
+
+// 按K线下标回放外部（如Python策略进程）算好的信号
+class SignalReplay {
+public:
+  SignalReplay(const qint64* bar_index, const qint8* side, qsizetype count)
+      : bar_index_(bar_index)
+      , side_(side)
+      , count_(count)
+      , next_(0)
+      , bar_(0) {}
+
+  BarAction onBar(const KLineData&) {
+    BarAction action = BarAction::Hold;
+    while (next_ < count_ && bar_index_[next_] < bar_)
+      next_++;
+    if (next_ < count_ && bar_index_[next_] == bar_) {
+      action = side_[next_] > 0 ? BarAction::Buy : BarAction::Sell;
+      next_++;
+    }
+    bar_++;
+    return action;
+  }
+
+private:
+  const qint64* bar_index_;
+  const qint8* side_;
+  qsizetype count_;
+  qsizetype next_;
+  qint64 bar_;
+};
+
+// 回放逐K线的动作数组（C++插件策略的输出）：1买入、-1卖出、0持有
+class ActionReplay {
+public:
+  explicit ActionReplay(const qint8* actions)
+      : actions_(actions)
+      , bar_(0) {}
+
+  BarAction onBar(const KLineData&) {
+    const qint8 side = actions_[bar_++];
+    return side > 0 ? BarAction::Buy : side < 0 ? BarAction::Sell : BarAction::Hold;
+  }
+
+private:
+  const qint8* actions_;
+  qsizetype bar_;
+};
+
+#endif // BUILTINSTRATEGIES_H
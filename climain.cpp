@@ -0,0 +1,1043 @@
+// qtbacktester_cli：无界面的命令行回测，只依赖Qt::Core，供服务器批量运行
+#include "backtestsession.h"
+#include "batchdownloader.h"
+#include "builtinstrategies.h"
+#include "datasetcatalog.h"
+#include "klinestream.h"
+#include "livefeed.h"
+#include "montecarlo.h"
+#include "parametersweep.h"
+#include "portfoliobacktest.h"
+#include "profiler.h"
+#include "strategyplugin.h"
+#include "strategyworker.h"
+#include "tickbacktest.h"
+#include "tickstore.h"
+#include "walkforward.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QScopeGuard>
+#include <QTextStream>
+
+namespace {
+
+// 退出码
+constexpr int kExitOk = 0;
+constexpr int kExitUsage = 1;
+constexpr int kExitData = 2;
+constexpr int kExitStrategy = 3;
+
+constexpr char kMaCrossName[] = "ma_cross";
+
+int fail(int code, const QString &message) {
+  QTextStream(stderr) << "错误: " << message << Qt::endl;
+  return code;
+}
+
+// "10" 为单个取值，"5:20:5" 为闭区间 [5, 20]、步长5
+bool parseRange(const QString &text, SweepRange &range) {
+  const QStringList parts = text.split(':');
+  if (parts.size() != 1 && parts.size() != 3)
+    return false;
+  bool ok = false;
+  range.from = parts[0].toDouble(&ok);
+  if (!ok)
+    return false;
+  range.to = range.from;
+  range.step = 0.0;
+  if (parts.size() == 3) {
+    bool to_ok = false;
+    bool step_ok = false;
+    range.to = parts[1].toDouble(&to_ok);
+    range.step = parts[2].toDouble(&step_ok);
+    ok = to_ok && step_ok && range.step > 0.0 && range.to >= range.from;
+  }
+  return ok;
+}
+
+bool isSingle(const SweepRange &range) {
+  return range.values().size() == 1;
+}
+
+// 增量更新数据文件并等待完成，已是最新时直接返回
+bool updateDataset(const QString &file_path, QString &error) {
+  DownloadRequest request;
+  if (!BacktestSession::makeUpdateRequest(file_path, QDateTime::currentDateTime(), request, error))
+    return false;
+  if (request.start_time > request.end_time)
+    return true;
+  BatchDownloader downloader;
+  QEventLoop loop;
+  bool success = false;
+  QObject::connect(&downloader,
+                   &BatchDownloader::finished,
+                   &loop,
+                   [&](bool ok, const QString &message, qint64) {
+                     success = ok;
+                     error = message;
+                     loop.quit();
+                   });
+  if (!downloader.start(request)) {
+    error = "无法启动下载";
+    return false;
+  }
+  loop.exec();
+  return success;
+}
+
+// 运行Python策略并等待信号返回
+bool runPythonStrategy(const BacktestSession &session,
+                       int level,
+                       const QString &strategy_path,
+                       StrategySignals &result,
+                       QString &error) {
+  StrategyWorker worker;
+  if (!worker.start()) {
+    error = "无法启动Python策略进程，请检查Python和numpy是否已安装";
+    return false;
+  }
+  session.sendBars(&worker, level);
+  QEventLoop loop;
+  bool success = false;
+  QObject::connect(&worker, &StrategyWorker::finished, &loop, [&](const StrategySignals &strategy_signals) {
+    result = strategy_signals;
+    success = true;
+    loop.quit();
+  });
+  QObject::connect(&worker, &StrategyWorker::failed, &loop, [&](const QString &message) {
+    error = "策略运行失败: " + message;
+    loop.quit();
+  });
+  if (!worker.run(strategy_path)) {
+    error = "无法运行策略: " + strategy_path;
+    return false;
+  }
+  loop.exec();
+  return success;
+}
+
+// 扫描结果和单次回测共用同一组列
+QJsonObject resultObject(const SweepResult &result) {
+  QJsonObject object;
+  object["fast"] = result.fast_period;
+  object["slow"] = result.slow_period;
+  object["initial_capital"] = result.config.initial_capital;
+  object["commission"] = result.config.commission;
+  object["slippage"] = result.config.slippage;
+  object["final_capital"] = result.final_capital;
+  object["total_return"] = result.total_return;
+  object["total_trades"] = result.total_trades;
+  object["win_rate"] = result.win_rate;
+  object["max_drawdown"] = result.max_drawdown;
+  return object;
+}
+
+QString csvHeader() {
+  return "fast,slow,initial_capital,commission,slippage,final_capital,total_return,total_trades,"
+         "win_rate,max_drawdown\n";
+}
+
+QString csvRow(const SweepResult &result) {
+  return QString("%1,%2,%3,%4,%5,%6,%7,%8,%9,%10\n")
+      .arg(result.fast_period)
+      .arg(result.slow_period)
+      .arg(result.config.initial_capital, 0, 'g', 17)
+      .arg(result.config.commission, 0, 'g', 17)
+      .arg(result.config.slippage, 0, 'g', 17)
+      .arg(result.final_capital, 0, 'f', 6)
+      .arg(result.total_return, 0, 'g', 17)
+      .arg(result.total_trades)
+      .arg(result.win_rate, 0, 'g', 17)
+      .arg(result.max_drawdown, 0, 'g', 17);
+}
+
+SweepResult toSweepResult(const BacktestResult &backtest,
+                          const BacktestConfig &config,
+                          int fast_period,
+                          int slow_period) {
+  SweepResult result;
+  result.fast_period = fast_period;
+  result.slow_period = slow_period;
+  result.config = config;
+  result.final_capital = backtest.final_capital;
+  result.total_return = backtest.final_capital / config.initial_capital - 1.0;
+  result.total_trades = backtest.total_trades;
+  result.win_rate = backtest.win_rate;
+  result.max_drawdown = backtest.max_drawdown;
+  return result;
+}
+
+int writeOutput(const QString &output_path, const QByteArray &output) {
+  if (output_path.isEmpty()) {
+    QFile out;
+    if (!out.open(stdout, QIODevice::WriteOnly))
+      return fail(kExitData, "无法写入标准输出");
+    out.write(output);
+    return kExitOk;
+  }
+  QFile out(output_path);
+  if (!out.open(QIODevice::WriteOnly) || out.write(output) != output.size())
+    return fail(kExitData, "无法写入输出文件: " + output_path);
+  return kExitOk;
+}
+
+// 多个--data时为组合回测：所有品种共用资金，每个品种各运行一份均线交叉
+int runPortfolio(const QStringList &data_paths,
+                 const SweepSpec &spec,
+                 const QString &format,
+                 const QString &output_path) {
+  PortfolioConfig config;
+  config.base.initial_capital = spec.initial_capital.from;
+  config.base.commission = spec.commission.from;
+  config.base.slippage = spec.slippage.from;
+  config.fast_period = int(spec.fast_period.from);
+  config.slow_period = int(spec.slow_period.from);
+
+  QElapsedTimer timer;
+  timer.start();
+  PortfolioBacktest portfolio;
+  QString error;
+  if (!portfolio.open(data_paths, error))
+    return fail(kExitData, error);
+  const qint64 load_ms = timer.restart();
+  const PortfolioResult result = portfolio.run(config);
+  const qint64 run_ms = timer.elapsed();
+
+  QByteArray output;
+  if (format == "csv") {
+    QString text = "symbol,bars,total_trades,winning_trades,realized_pnl\n";
+    for (const PortfolioSymbolResult &symbol : result.symbols) {
+      text += QString("%1,%2,%3,%4,%5\n")
+                  .arg(symbol.name)
+                  .arg(symbol.bars)
+                  .arg(symbol.total_trades)
+                  .arg(symbol.winning_trades)
+                  .arg(symbol.realized_pnl, 0, 'f', 6);
+    }
+    output = text.toUtf8();
+  } else {
+    QJsonObject root;
+    QJsonArray datasets;
+    for (const QString &path : data_paths)
+      datasets.append(QFileInfo(path).absoluteFilePath());
+    root["datasets"] = datasets;
+    root["strategy"] = kMaCrossName;
+    root["fast"] = config.fast_period;
+    root["slow"] = config.slow_period;
+    root["load_ms"] = load_ms;
+    root["run_ms"] = run_ms;
+    QJsonObject summary;
+    summary["initial_capital"] = result.initial_capital;
+    summary["final_capital"] = result.final_capital;
+    summary["total_return"] = result.final_capital / result.initial_capital - 1.0;
+    summary["total_trades"] = result.total_trades;
+    summary["win_rate"] = result.win_rate;
+    summary["max_drawdown"] = result.max_drawdown;
+    summary["first_timestamp"] = result.first_timestamp;
+    summary["last_timestamp"] = result.last_timestamp;
+    summary["steps"] = qint64(result.steps);
+    summary["bars"] = qint64(result.total_bars);
+    root["result"] = summary;
+    QJsonArray symbols;
+    for (const PortfolioSymbolResult &symbol : result.symbols) {
+      QJsonObject item;
+      item["symbol"] = symbol.name;
+      item["bars"] = qint64(symbol.bars);
+      item["total_trades"] = symbol.total_trades;
+      item["winning_trades"] = symbol.winning_trades;
+      item["realized_pnl"] = symbol.realized_pnl;
+      symbols.append(item);
+    }
+    root["symbols"] = symbols;
+    output = QJsonDocument(root).toJson(QJsonDocument::Indented);
+  }
+  return writeOutput(output_path, output);
+}
+
+// --walk-forward：每折在样本内扫描均线参数，用最优参数回测随后的样本外区间
+int runWalkForward(const BacktestSession &session,
+                   int level,
+                   WalkForwardSpec spec,
+                   const QString &format,
+                   const QString &output_path) {
+  const KLinePyramid::Level &data = session.pyramid().level(level);
+  if (WalkForward::runCount(data.bars.size(), spec) == 0)
+    return fail(kExitUsage, "没有可用的折或参数组合（样本内需短于数据长度，快线周期需小于慢线周期）");
+  WalkForward walk_forward;
+  WalkForwardResult result;
+  qint64 run_ms = 0;
+  QEventLoop loop;
+  QObject::connect(&walk_forward,
+                   &WalkForward::finished,
+                   &loop,
+                   [&](const WalkForwardResult &finished_result, qint64 elapsed_ms) {
+                     result = finished_result;
+                     run_ms = elapsed_ms;
+                     loop.quit();
+                   });
+  if (!walk_forward.start(data.bars, spec, data.indicators()))
+    return fail(kExitUsage, "无法开始滚动优化");
+  loop.exec();
+
+  QByteArray output;
+  if (format == "csv") {
+    QString text = "in_sample_begin,out_of_sample_begin,out_of_sample_end,fast,slow,in_sample_return,"
+                   "out_of_sample_return,out_of_sample_trades,out_of_sample_drawdown\n";
+    for (const WalkForwardFold &fold : std::as_const(result.folds)) {
+      text += QString("%1,%2,%3,%4,%5,%6,%7,%8,%9\n")
+                  .arg(data.bars[fold.in_sample_begin].timestamp)
+                  .arg(data.bars[fold.out_of_sample_begin].timestamp)
+                  .arg(data.bars[fold.out_of_sample_end - 1].timestamp)
+                  .arg(fold.fast_period)
+                  .arg(fold.slow_period)
+                  .arg(fold.in_sample_return, 0, 'g', 17)
+                  .arg(fold.out_of_sample_return, 0, 'g', 17)
+                  .arg(fold.out_of_sample_trades)
+                  .arg(fold.out_of_sample_drawdown, 0, 'g', 17);
+    }
+    output = text.toUtf8();
+  } else {
+    QJsonObject root;
+    root["dataset"] = QFileInfo(session.filePath()).absoluteFilePath();
+    root["strategy"] = kMaCrossName;
+    root["timeframe"] = data.name;
+    root["bars"] = qint64(data.bars.size());
+    root["in_sample_bars"] = qint64(spec.in_sample_bars);
+    root["out_of_sample_bars"] = qint64(spec.out_of_sample_bars);
+    root["anchored"] = spec.anchored;
+    root["runs"] = qint64(result.runs);
+    root["run_ms"] = run_ms;
+    QJsonObject summary;
+    summary["initial_capital"] = result.initial_capital;
+    summary["final_capital"] = result.final_capital;
+    summary["total_return"] = result.final_capital / result.initial_capital - 1.0;
+    summary["total_trades"] = result.total_trades;
+    summary["max_drawdown"] = result.max_drawdown;
+    root["result"] = summary;
+    QJsonArray folds;
+    for (const WalkForwardFold &fold : std::as_const(result.folds)) {
+      QJsonObject item;
+      item["in_sample_begin"] = data.bars[fold.in_sample_begin].timestamp;
+      item["out_of_sample_begin"] = data.bars[fold.out_of_sample_begin].timestamp;
+      item["out_of_sample_end"] = data.bars[fold.out_of_sample_end - 1].timestamp;
+      item["fast"] = fold.fast_period;
+      item["slow"] = fold.slow_period;
+      item["in_sample_return"] = fold.in_sample_return;
+      item["out_of_sample_return"] = fold.out_of_sample_return;
+      item["out_of_sample_trades"] = fold.out_of_sample_trades;
+      item["out_of_sample_drawdown"] = fold.out_of_sample_drawdown;
+      folds.append(item);
+    }
+    root["folds"] = folds;
+    output = QJsonDocument(root).toJson(QJsonDocument::Indented);
+  }
+  return writeOutput(output_path, output);
+}
+
+// --monte-carlo：对单次回测的交易或逐K线收益重抽样，输出收益、回撤和胜率的分布
+int runMonteCarlo(const QString &data_path,
+                  const QString &strategy,
+                  const KLinePyramid::Level &data,
+                  const SweepResult &backtest,
+                  const QVector<TradeSignal> &trade_signals,
+                  const MonteCarloSpec &spec,
+                  const QString &format,
+                  const QString &output_path) {
+  const bool trades = spec.method == MonteCarloSpec::Method::TradeResample;
+  MonteCarlo monte_carlo;
+  MonteCarloResult result;
+  qint64 run_ms = 0;
+  QEventLoop loop;
+  QObject::connect(&monte_carlo,
+                   &MonteCarlo::finished,
+                   &loop,
+                   [&](const MonteCarloResult &finished_result, qint64 elapsed_ms) {
+                     result = finished_result;
+                     run_ms = elapsed_ms;
+                     loop.quit();
+                   });
+  if (!monte_carlo.start(data.bars, trade_signals, spec))
+    return fail(kExitUsage, trades ? "回测中没有已平仓的交易，可改用 --mc-method blocks" : "无法开始蒙特卡洛模拟");
+  loop.exec();
+
+  struct Metric {
+    const char *name;
+    double original;
+    const MonteCarloDistribution *distribution;
+  };
+  QVector<Metric> metrics = {{"total_return", result.original_return, &result.total_return},
+                             {"max_drawdown", result.original_drawdown, &result.max_drawdown}};
+  if (trades)
+    metrics.append({"win_rate", result.original_win_rate, &result.win_rate});
+
+  QByteArray output;
+  if (format == "csv") {
+    QString text = "metric,original,mean,median,lower,upper,min,max\n";
+    for (const Metric &metric : std::as_const(metrics)) {
+      text += QString("%1,%2,%3,%4,%5,%6,%7,%8\n")
+                  .arg(metric.name)
+                  .arg(metric.original, 0, 'g', 17)
+                  .arg(metric.distribution->mean, 0, 'g', 17)
+                  .arg(metric.distribution->median, 0, 'g', 17)
+                  .arg(metric.distribution->lower, 0, 'g', 17)
+                  .arg(metric.distribution->upper, 0, 'g', 17)
+                  .arg(metric.distribution->minimum, 0, 'g', 17)
+                  .arg(metric.distribution->maximum, 0, 'g', 17);
+    }
+    output = text.toUtf8();
+  } else {
+    QJsonObject summary;
+    summary["method"] = trades ? "trades" : "blocks";
+    summary["simulations"] = qint64(result.simulations);
+    summary["samples"] = qint64(result.samples);
+    if (!trades)
+      summary["block_length"] = spec.block_length;
+    summary["seed"] = QString::number(spec.seed);
+    summary["confidence"] = spec.confidence;
+    summary["run_ms"] = run_ms;
+    summary["loss_probability"] = result.loss_probability;
+    summary["worse_drawdown_probability"] = result.worse_drawdown_probability;
+    for (const Metric &metric : std::as_const(metrics)) {
+      QJsonObject item;
+      item["original"] = metric.original;
+      item["mean"] = metric.distribution->mean;
+      item["median"] = metric.distribution->median;
+      item["lower"] = metric.distribution->lower;
+      item["upper"] = metric.distribution->upper;
+      item["min"] = metric.distribution->minimum;
+      item["max"] = metric.distribution->maximum;
+      summary[metric.name] = item;
+    }
+    QJsonObject root;
+    root["dataset"] = QFileInfo(data_path).absoluteFilePath();
+    root["strategy"] = strategy;
+    root["timeframe"] = data.name;
+    root["bars"] = qint64(data.bars.size());
+    QJsonObject backtest_object = resultObject(backtest);
+    if (strategy != kMaCrossName) {
+      backtest_object.remove("fast");
+      backtest_object.remove("slow");
+    }
+    root["result"] = backtest_object;
+    root["monte_carlo"] = summary;
+    output = QJsonDocument(root).toJson(QJsonDocument::Indented);
+  }
+  return writeOutput(output_path, output);
+}
+
+// --stream：分块读取数据文件，边读边回测，不建缓存也不生成多周期，内存与文件大小无关
+int runStream(const QString &data_path,
+              const SweepSpec &spec,
+              const QString &format,
+              const QString &output_path) {
+  BacktestConfig config;
+  config.initial_capital = spec.initial_capital.from;
+  config.commission = spec.commission.from;
+  config.slippage = spec.slippage.from;
+  config.record_trades = false; // --stream不输出成交明细，内存与数据量无关
+  const int fast_period = int(spec.fast_period.from);
+  const int slow_period = int(spec.slow_period.from);
+
+  // 顺带统计K线数，不额外保存任何数据
+  struct CountingStream {
+    KLineStream &stream;
+    qint64 bars = 0;
+    const QVector<KLineData> *next() {
+      const QVector<KLineData> *block = stream.next();
+      if (block)
+        bars += block->size();
+      return block;
+    }
+  };
+
+  QElapsedTimer timer;
+  timer.start();
+  KLineStream stream;
+  if (!stream.open(data_path))
+    return fail(kExitData, stream.errorString());
+  CountingStream counting{stream};
+  MovingAverageCross strategy(fast_period, slow_period);
+  const BacktestResult backtest = BacktestEngine::runBlocks(config, counting, strategy);
+  if (stream.hasError())
+    return fail(kExitData, stream.errorString());
+  if (counting.bars == 0)
+    return fail(kExitData, "加载数据文件失败: " + data_path);
+  const qint64 run_ms = timer.elapsed();
+
+  const SweepResult result = toSweepResult(backtest, config, fast_period, slow_period);
+  QByteArray output;
+  if (format == "csv") {
+    output = (csvHeader() + csvRow(result)).toUtf8();
+  } else {
+    QJsonObject root;
+    root["dataset"] = QFileInfo(data_path).absoluteFilePath();
+    root["strategy"] = kMaCrossName;
+    root["bars"] = counting.bars;
+    root["skipped_rows"] = stream.skippedRows();
+    root["run_ms"] = run_ms;
+    root["result"] = resultObject(result);
+    output = QJsonDocument(root).toJson(QJsonDocument::Indented);
+  }
+  return writeOutput(output_path, output);
+}
+
+// --ticks：在逐笔成交上按需合成K线并逐笔撮合，成交价由订单吃掉的成交决定，不使用--slippage。
+// 数据为CSV时首次转换成同目录下的.qtk，之后CSV未变化就直接读取
+int runTicks(const QString &data_path,
+             const QString &bar_spec,
+             const TickFillConfig &fill,
+             const SweepSpec &spec,
+             const QString &format,
+             const QString &output_path) {
+  BarAggregator::Mode mode;
+  double size = 0.0;
+  QString error;
+  if (!BarAggregator::parse(bar_spec, mode, size, error))
+    return fail(kExitUsage, error);
+  BacktestConfig config;
+  config.initial_capital = spec.initial_capital.from;
+  config.commission = spec.commission.from;
+  config.slippage = 0.0;
+  const int fast_period = int(spec.fast_period.from);
+  const int slow_period = int(spec.slow_period.from);
+
+  QElapsedTimer timer;
+  timer.start();
+  QString store_path = data_path;
+  if (!data_path.endsWith(".qtk")) {
+    store_path = TickWriter::storePath(data_path);
+    if (!TickReader::isUpToDate(store_path, data_path)
+        && !TickWriter::convertCsv(data_path, store_path, error))
+      return fail(kExitData, error);
+  }
+  const qint64 convert_ms = timer.restart();
+  TickReader reader;
+  if (!reader.open(store_path))
+    return fail(kExitData, reader.errorString());
+  MovingAverageCross strategy(fast_period, slow_period);
+  const TickBacktestResult tick_result
+      = TickBacktest::run(config, fill, reader, BarAggregator(mode, size), strategy);
+  if (reader.hasError())
+    return fail(kExitData, reader.errorString());
+  if (tick_result.ticks == 0)
+    return fail(kExitData, "逐笔数据为空: " + data_path);
+  const qint64 run_ms = timer.elapsed();
+
+  const SweepResult result = toSweepResult(tick_result.backtest, config, fast_period, slow_period);
+  QByteArray output;
+  if (format == "csv") {
+    output = (csvHeader() + csvRow(result)).toUtf8();
+  } else {
+    QJsonObject root;
+    root["dataset"] = QFileInfo(data_path).absoluteFilePath();
+    root["strategy"] = kMaCrossName;
+    root["bar_spec"] = bar_spec;
+    root["ticks"] = tick_result.ticks;
+    root["bars"] = tick_result.bars;
+    root["latency_ms"] = fill.latency_ms;
+    root["participation"] = fill.participation;
+    root["filled_orders"] = tick_result.filled_orders;
+    root["unfilled_orders"] = tick_result.unfilled_orders;
+    root["average_slippage"] = tick_result.average_slippage;
+    root["max_slippage"] = tick_result.max_slippage;
+    root["average_fill_ms"] = tick_result.average_fill_ms;
+    root["convert_ms"] = convert_ms;
+    root["run_ms"] = run_ms;
+    root["result"] = resultObject(result);
+    output = QJsonDocument(root).toJson(QJsonDocument::Indented);
+  }
+  return writeOutput(output_path, output);
+}
+
+// --live：从回放的CSV或本地行情服务逐根接收K线，均线和撮合随每根K线增量更新，
+// 数据源结束（或收到--max-bars根）后输出结果和从收到K线到信号撮合完成的延迟分布
+int runLive(const LiveFeedConfig &config, const QString &format, const QString &output_path) {
+  QElapsedTimer timer;
+  timer.start();
+  LiveFeed feed(config);
+  QEventLoop loop;
+  QVector<LiveUpdate> updates;
+  LatencyStats latency;
+  const auto drain = [&] {
+    // 先读结束标志再取结果，结束前的结果一定都能取到
+    const bool finished = feed.isFinished();
+    feed.takeUpdates(updates);
+    for (const LiveUpdate &update : std::as_const(updates))
+      latency.add(update.latency_ns);
+    if (finished)
+      loop.quit();
+  };
+  QString error;
+  if (!feed.start([&] { QMetaObject::invokeMethod(&loop, drain, Qt::QueuedConnection); }, error))
+    return fail(kExitData, error);
+  loop.exec();
+  feed.stop();
+  if (!feed.errorString().isEmpty())
+    return fail(kExitData, feed.errorString());
+  const qint64 run_ms = timer.elapsed();
+
+  const SweepResult result
+      = toSweepResult(feed.finish(), config.backtest, config.fast_period, config.slow_period);
+  QByteArray output;
+  if (format == "csv") {
+    output = (csvHeader() + csvRow(result)).toUtf8();
+  } else {
+    QJsonObject root;
+    root["source"] = config.source == LiveFeedConfig::Source::Replay
+                         ? QFileInfo(config.file_path).absoluteFilePath()
+                         : QString("tcp://%1:%2").arg(config.host).arg(config.port);
+    root["strategy"] = kMaCrossName;
+    root["speed"] = config.speed;
+    root["bars"] = feed.receivedBars();
+    root["skipped_bars"] = feed.skippedBars();
+    root["run_ms"] = run_ms;
+    QJsonObject latency_us;
+    latency_us["average"] = latency.averageNs() / 1000.0;
+    latency_us["p50"] = latency.percentileNs(0.5) / 1000.0;
+    latency_us["p99"] = latency.percentileNs(0.99) / 1000.0;
+    latency_us["max"] = latency.maxNs() / 1000.0;
+    root["latency_us"] = latency_us;
+    root["result"] = resultObject(result);
+    output = QJsonDocument(root).toJson(QJsonDocument::Indented);
+  }
+  return writeOutput(output_path, output);
+}
+
+// 刷新数据目录的索引并列出（或按条件筛选）规范数据集，不打开任何CSV
+int runCatalog(const QString &data_dir,
+               const QString &query_text,
+               const QString &format,
+               const QString &output_path) {
+  DatasetQuery query;
+  QString error;
+  if (!DatasetCatalog::parseQuery(query_text, query, error))
+    return fail(kExitUsage, error);
+  QElapsedTimer timer;
+  timer.start();
+  DatasetCatalog catalog;
+  catalog.open(data_dir);
+  bool changed = false;
+  if (!catalog.refresh(changed, error) || (changed && !catalog.save(error)))
+    return fail(kExitData, error);
+  const qint64 refresh_ms = timer.elapsed();
+  const QVector<DatasetEntry> datasets = catalog.query(query);
+
+  QByteArray output;
+  if (format == "csv") {
+    QString text = "path,exchange,symbol,timeframe,first,last,rows,sources\n";
+    for (const DatasetEntry &entry : datasets) {
+      text += QString("%1,%2,%3,%4,%5,%6,%7,%8\n")
+                  .arg(catalog.filePath(entry), entry.exchange, entry.symbol, entry.timeframe)
+                  .arg(entry.first_timestamp)
+                  .arg(entry.last_timestamp)
+                  .arg(entry.rows)
+                  .arg(entry.sources.join(';'));
+    }
+    output = text.toUtf8();
+  } else {
+    QJsonArray items;
+    for (const DatasetEntry &entry : datasets) {
+      QJsonObject item;
+      item["path"] = catalog.filePath(entry);
+      item["exchange"] = entry.exchange;
+      item["symbol"] = entry.symbol;
+      item["timeframe"] = entry.timeframe;
+      item["first"] = entry.first_timestamp;
+      item["last"] = entry.last_timestamp;
+      item["rows"] = entry.rows;
+      item["sources"] = QJsonArray::fromStringList(entry.sources);
+      items.append(item);
+    }
+    QJsonObject root;
+    root["data_dir"] = data_dir;
+    root["query"] = query_text;
+    root["refresh_ms"] = refresh_ms;
+    root["index_changed"] = changed;
+    root["datasets"] = items;
+    output = QJsonDocument(root).toJson(QJsonDocument::Indented);
+  }
+  return writeOutput(output_path, output);
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  QCoreApplication app(argc, argv);
+  QCoreApplication::setApplicationName("qtbacktester_cli");
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription(
+      "命令行回测。数值参数可写成 from:to:step 的区间，内置均线策略会对所有组合做参数扫描");
+  parser.addHelpOption();
+  QCommandLineOption data_option({"d", "data"}, "K线CSV文件，给出多个时为组合回测", "file");
+  QCommandLineOption strategy_option({"s", "strategy"},
+                                     "策略：ma_cross（内置均线交叉）、Python策略文件或C++策略插件的路径",
+                                     "name",
+                                     kMaCrossName);
+  QCommandLineOption timeframe_option({"t", "timeframe"},
+                                      "回测周期（1m/5m/15m/1h/4h/1d），默认为原始周期",
+                                      "name");
+  QCommandLineOption fast_option("fast", "快线周期", "n", "10");
+  QCommandLineOption slow_option("slow", "慢线周期", "n", "30");
+  QCommandLineOption capital_option("capital", "初始资金", "value", "10000");
+  QCommandLineOption commission_option("commission", "手续费比例", "value", "0.001");
+  QCommandLineOption slippage_option("slippage", "滑点比例", "value", "0.0001");
+  QCommandLineOption format_option({"f", "format"}, "输出格式：json或csv", "format", "json");
+  QCommandLineOption output_option({"o", "output"}, "输出文件，默认为标准输出", "file");
+  QCommandLineOption trades_option("trades", "JSON中附带每笔成交（仅单次回测）");
+  QCommandLineOption update_option("update", "回测前先把数据文件增量更新到最新");
+  QCommandLineOption walk_forward_option("walk-forward",
+                                         "滚动优化：每折样本内与样本外的K线数，如 40000:10000",
+                                         "in:out");
+  QCommandLineOption anchored_option("anchored", "滚动优化时样本内始终从第一根K线开始");
+  QCommandLineOption monte_carlo_option("monte-carlo",
+                                        "蒙特卡洛分析：对单次回测的结果做n次重抽样，输出收益、回撤和胜率的置信区间",
+                                        "n");
+  QCommandLineOption mc_method_option("mc-method",
+                                      "蒙特卡洛抽样方法：trades（逐笔交易有放回重抽）或blocks（逐K线收益的块自助法）",
+                                      "method",
+                                      "trades");
+  QCommandLineOption block_length_option("block-length", "块自助法的块长度（K线数）", "n", "24");
+  QCommandLineOption seed_option("seed", "蒙特卡洛随机种子，相同种子结果相同", "n", "1");
+  QCommandLineOption confidence_option("confidence", "置信区间的置信度", "ratio", "0.95");
+  QCommandLineOption profile_option("profile",
+                                     "记录各阶段耗时，结束时写出Chrome trace JSON（可用Perfetto查看）",
+                                     "file");
+  QCommandLineOption stream_option("stream",
+                                   "分块流式回测，适合超出内存的大文件（仅内置策略单组参数，原始周期）");
+  QCommandLineOption ticks_option("ticks",
+                                  "逐笔回测：--data为逐笔成交CSV或.qtk，按该方式合成K线，"
+                                  "如 time:1m、volume:50、dollar:1e6（仅内置策略单组参数）",
+                                  "bars");
+  QCommandLineOption latency_option("latency", "逐笔回测中信号到开始成交的延迟（毫秒）", "ms", "0");
+  QCommandLineOption participation_option("participation",
+                                          "逐笔回测中每笔成交最多可吃到的比例",
+                                          "ratio",
+                                          "1");
+  QCommandLineOption catalog_option("catalog", "刷新数据目录的索引并列出其中的数据集，不做回测", "dir");
+  QCommandLineOption query_option(
+      "query", "与--catalog一起使用，按\"交易所 品种 周期 时间范围\"筛选，如\"BTC/USDT 1h 2021-2023\"", "text");
+  QCommandLineOption live_option("live",
+                                 "实时模式：回放CSV文件，或连接本地行情服务 tcp://host:port，"
+                                 "逐根K线增量计算内置均线策略（仅单组参数）",
+                                 "source");
+  QCommandLineOption speed_option("speed",
+                                  "实时模式回放CSV的速度（K线时间与实际时间之比），0为不等待",
+                                  "ratio",
+                                  "0");
+  QCommandLineOption max_bars_option("max-bars", "实时模式收到这么多根K线后结束，0为直到数据源结束", "n", "0");
+  parser.addOptions({data_option,
+                     strategy_option,
+                     timeframe_option,
+                     fast_option,
+                     slow_option,
+                     capital_option,
+                     commission_option,
+                     slippage_option,
+                     format_option,
+                     output_option,
+                     trades_option,
+                     update_option,
+                     walk_forward_option,
+                     anchored_option,
+                     monte_carlo_option,
+                     mc_method_option,
+                     block_length_option,
+                     seed_option,
+                     confidence_option,
+                     stream_option,
+                     ticks_option,
+                     latency_option,
+                     participation_option,
+                     catalog_option,
+                     query_option,
+                     live_option,
+                     speed_option,
+                     max_bars_option,
+                     profile_option});
+  parser.process(app);
+  if (parser.isSet(profile_option)) {
+    Profiler::setEnabled(true);
+    Profiler::setThreadName("main");
+  }
+  // 无论从哪个分支返回都写出trace
+  const auto write_trace = qScopeGuard([&] {
+    if (!parser.isSet(profile_option))
+      return;
+    QString trace_error;
+    if (!Profiler::writeChromeTrace(parser.value(profile_option), trace_error))
+      QTextStream(stderr) << trace_error << Qt::endl;
+  });
+
+  const QString format = parser.value(format_option).toLower();
+  if (format != "json" && format != "csv")
+    return fail(kExitUsage, "不支持的输出格式: " + format);
+  if (parser.isSet(catalog_option)) {
+    return runCatalog(parser.value(catalog_option),
+                      parser.value(query_option),
+                      format,
+                      parser.value(output_option));
+  }
+  if (parser.isSet(query_option))
+    return fail(kExitUsage, "--query 需要与 --catalog 一起使用");
+
+  const QStringList data_paths = parser.values(data_option);
+  if (data_paths.isEmpty() && !parser.isSet(live_option))
+    return fail(kExitUsage, "缺少 --data 参数");
+  const QString data_path = data_paths.value(0);
+  SweepSpec spec;
+  if (!parseRange(parser.value(fast_option), spec.fast_period)
+      || !parseRange(parser.value(slow_option), spec.slow_period)
+      || !parseRange(parser.value(capital_option), spec.initial_capital)
+      || !parseRange(parser.value(commission_option), spec.commission)
+      || !parseRange(parser.value(slippage_option), spec.slippage)) {
+    return fail(kExitUsage, "数值参数格式错误，应为数值或 from:to:step");
+  }
+  const QString strategy = parser.value(strategy_option);
+  const bool builtin = strategy == kMaCrossName;
+  const qsizetype combinations = ParameterSweep::combinationCount(spec);
+  if (builtin && combinations == 0)
+    return fail(kExitUsage, "没有有效的参数组合（快线周期需小于慢线周期）");
+  const bool sweep = builtin && combinations > 1;
+  if (!builtin && (!isSingle(spec.initial_capital) || !isSingle(spec.commission)
+                   || !isSingle(spec.slippage))) {
+    return fail(kExitUsage, "Python策略和C++插件不支持参数区间");
+  }
+  // C++策略插件先加载，接口不匹配时在读数据之前报错
+  StrategyPlugin plugin;
+  if (!builtin && StrategyPlugin::isPluginFile(strategy)) {
+    QString plugin_error;
+    if (!plugin.load(strategy, plugin_error))
+      return fail(kExitStrategy, plugin_error);
+  }
+
+  MonteCarloSpec monte_carlo;
+  if (parser.isSet(monte_carlo_option)) {
+    bool simulations_ok = false;
+    bool block_ok = false;
+    bool seed_ok = false;
+    bool confidence_ok = false;
+    const QString method = parser.value(mc_method_option);
+    monte_carlo.method = method == "blocks" ? MonteCarloSpec::Method::BlockBootstrap
+                                            : MonteCarloSpec::Method::TradeResample;
+    monte_carlo.simulations = parser.value(monte_carlo_option).toLongLong(&simulations_ok);
+    monte_carlo.block_length = parser.value(block_length_option).toInt(&block_ok);
+    monte_carlo.seed = parser.value(seed_option).toULongLong(&seed_ok);
+    monte_carlo.confidence = parser.value(confidence_option).toDouble(&confidence_ok);
+    if (sweep || data_paths.size() > 1 || parser.isSet(live_option) || parser.isSet(ticks_option)
+        || parser.isSet(stream_option) || parser.isSet(walk_forward_option)) {
+      return fail(kExitUsage, "蒙特卡洛分析只用于单个数据文件的单次回测");
+    }
+    if ((method != "trades" && method != "blocks") || !simulations_ok || monte_carlo.simulations <= 0
+        || monte_carlo.simulations > MonteCarlo::kMaxSimulations || !block_ok || monte_carlo.block_length <= 0
+        || !seed_ok || !confidence_ok || monte_carlo.confidence <= 0.0 || monte_carlo.confidence >= 1.0) {
+      return fail(kExitUsage,
+                  QString("蒙特卡洛参数错误：次数为1~%1，方法为trades或blocks，块长度为正，置信度在(0, 1)之间")
+                      .arg(MonteCarlo::kMaxSimulations));
+    }
+  }
+
+  if (parser.isSet(live_option)) {
+    LiveFeedConfig live;
+    QString live_error;
+    bool speed_ok = false;
+    bool max_bars_ok = false;
+    live.speed = parser.value(speed_option).toDouble(&speed_ok);
+    live.max_bars = parser.value(max_bars_option).toLongLong(&max_bars_ok);
+    if (!builtin || combinations > 1 || !data_paths.isEmpty() || parser.isSet(timeframe_option)
+        || parser.isSet(ticks_option) || parser.isSet(stream_option) || parser.isSet(update_option)) {
+      return fail(kExitUsage, "实时模式只支持内置均线策略的单组参数，数据来自--live，不使用--data");
+    }
+    if (!speed_ok || live.speed < 0.0 || !max_bars_ok || live.max_bars < 0)
+      return fail(kExitUsage, "回放速度和K线数须不小于0");
+    if (!LiveFeedConfig::parseSource(parser.value(live_option), live, live_error))
+      return fail(kExitUsage, live_error);
+    live.fast_period = int(spec.fast_period.from);
+    live.slow_period = int(spec.slow_period.from);
+    live.backtest.initial_capital = spec.initial_capital.from;
+    live.backtest.commission = spec.commission.from;
+    live.backtest.slippage = spec.slippage.from;
+    return runLive(live, format, parser.value(output_option));
+  }
+  if (parser.isSet(ticks_option)) {
+    TickFillConfig fill;
+    bool latency_ok = false;
+    bool participation_ok = false;
+    fill.latency_ms = parser.value(latency_option).toLongLong(&latency_ok);
+    fill.participation = parser.value(participation_option).toDouble(&participation_ok);
+    if (!builtin || combinations > 1 || data_paths.size() > 1 || parser.isSet(timeframe_option)
+        || parser.isSet(trades_option) || parser.isSet(update_option) || parser.isSet(stream_option)) {
+      return fail(kExitUsage, "逐笔回测只支持单个数据文件和内置均线策略的单组参数");
+    }
+    if (!latency_ok || fill.latency_ms < 0 || !participation_ok || fill.participation <= 0.0
+        || fill.participation > 1.0)
+      return fail(kExitUsage, "延迟须不小于0，吃单比例须在(0, 1]之间");
+    return runTicks(data_path,
+                    parser.value(ticks_option),
+                    fill,
+                    spec,
+                    format,
+                    parser.value(output_option));
+  }
+  QString error;
+  if (parser.isSet(update_option)) {
+    for (const QString &path : data_paths) {
+      if (!updateDataset(path, error))
+        return fail(kExitData, QString("更新数据失败(%1): %2").arg(path, error));
+    }
+  }
+  if (data_paths.size() > 1) {
+    if (!builtin || combinations > 1 || parser.isSet(timeframe_option))
+      return fail(kExitUsage, "组合回测只支持内置均线策略的单组参数，且使用原始周期");
+    return runPortfolio(data_paths, spec, format, parser.value(output_option));
+  }
+  if (parser.isSet(stream_option)) {
+    if (!builtin || combinations > 1 || parser.isSet(timeframe_option) || parser.isSet(trades_option))
+      return fail(kExitUsage, "流式回测只支持内置均线策略的单组参数，且使用原始周期");
+    return runStream(data_path, spec, format, parser.value(output_option));
+  }
+
+
+  QElapsedTimer timer;
+  timer.start();
+  BacktestSession session;
+  // 命令行只在一个周期上回测：原始周期只建第0层，指定周期时建到该周期为止
+  const qint64 max_level_msecs =
+      parser.isSet(timeframe_option) ? KLinePyramid::timeframeMsecs(parser.value(timeframe_option)) : 0;
+  if (!session.load(data_path, nullptr, {}, max_level_msecs) || session.isEmpty())
+    return fail(kExitData, "加载数据文件失败: " + data_path);
+  int level = 0;
+  if (parser.isSet(timeframe_option)) {
+    level = session.pyramid().findLevel(parser.value(timeframe_option));
+    if (level < 0)
+      return fail(kExitUsage, "数据中没有该周期: " + parser.value(timeframe_option));
+  }
+  if (parser.isSet(walk_forward_option)) {
+    const QStringList parts = parser.value(walk_forward_option).split(':');
+    WalkForwardSpec walk_spec;
+    walk_spec.fast_period = spec.fast_period;
+    walk_spec.slow_period = spec.slow_period;
+    walk_spec.config.initial_capital = spec.initial_capital.from;
+    walk_spec.config.commission = spec.commission.from;
+    walk_spec.config.slippage = spec.slippage.from;
+    walk_spec.anchored = parser.isSet(anchored_option);
+    bool in_ok = false;
+    bool out_ok = false;
+    if (parts.size() == 2) {
+      walk_spec.in_sample_bars = parts[0].toLongLong(&in_ok);
+      walk_spec.out_of_sample_bars = parts[1].toLongLong(&out_ok);
+    }
+    if (!builtin || !in_ok || !out_ok || !isSingle(spec.initial_capital)
+        || !isSingle(spec.commission) || !isSingle(spec.slippage)) {
+      return fail(kExitUsage, "滚动优化只支持内置均线策略，参数为 样本内:样本外 的K线数，只扫描均线周期");
+    }
+    return runWalkForward(session, level, walk_spec, format, parser.value(output_option));
+  }
+  const KLinePyramid::Level &data = session.pyramid().level(level);
+  const qint64 load_ms = timer.restart();
+
+  QVector<SweepResult> results;
+  BacktestResult single;
+  if (builtin && sweep) {
+    // 多个参数组合交给线程池并行扫描，结果按到达顺序收集
+    ParameterSweep parameter_sweep;
+    QEventLoop loop;
+    QObject::connect(&parameter_sweep,
+                     &ParameterSweep::resultsReady,
+                     &loop,
+                     [&](const QVector<SweepResult> &batch) { results += batch; });
+    QObject::connect(&parameter_sweep, &ParameterSweep::finished, &loop, [&] { loop.quit(); });
+    if (!parameter_sweep.start(data.bars, spec, data.indicators()))
+      return fail(kExitUsage, "无法开始参数扫描");
+    loop.exec();
+  } else {
+    BacktestConfig config;
+    config.initial_capital = spec.initial_capital.from;
+    config.commission = spec.commission.from;
+    config.slippage = spec.slippage.from;
+    config.record_equity_curve = false;
+    int fast_period = int(spec.fast_period.from);
+    int slow_period = int(spec.slow_period.from);
+    if (builtin) {
+      single = session.runMaCross(level, config, fast_period, slow_period);
+    } else if (plugin.isLoaded()) {
+      single = session.runPlugin(level, config, plugin);
+      fast_period = slow_period = 0;
+    } else {
+      StrategySignals strategy_signals;
+      const QString strategy_path = QFileInfo(strategy).absoluteFilePath();
+      if (!runPythonStrategy(session, level, strategy_path, strategy_signals, error))
+        return fail(kExitStrategy, error);
+      single = session.replaySignals(level, config, strategy_signals);
+      fast_period = slow_period = 0;
+    }
+    results.append(toSweepResult(single, config, fast_period, slow_period));
+    if (parser.isSet(monte_carlo_option)) {
+      monte_carlo.config = config;
+      return runMonteCarlo(data_path,
+                           strategy,
+                           data,
+                           results.first(),
+                           single.trade_signals,
+                           monte_carlo,
+                           format,
+                           parser.value(output_option));
+    }
+  }
+  const qint64 run_ms = timer.elapsed();
+
+  QByteArray output;
+  if (format == "csv") {
+    QString text = csvHeader();
+    for (const SweepResult &result : std::as_const(results))
+      text += csvRow(result);
+    output = text.toUtf8();
+  } else {
+    QJsonObject root;
+    root["dataset"] = QFileInfo(data_path).absoluteFilePath();
+    root["strategy"] = strategy;
+    root["timeframe"] = data.name;
+    root["bars"] = qint64(data.bars.size());
+    root["load_ms"] = load_ms;
+    root["run_ms"] = run_ms;
+    if (sweep) {
+      QJsonArray runs;
+      for (const SweepResult &result : std::as_const(results))
+        runs.append(resultObject(result));
+      root["runs"] = runs;
+    } else {
+      QJsonObject result = resultObject(results.first());
+      result["max_adverse_excursion"] = single.max_adverse_excursion;
+      result["max_favorable_excursion"] = single.max_favorable_excursion;
+      result["loop_allocations"] = single.loop_allocations;
+      if (!builtin) {
+        result.remove("fast");
+        result.remove("slow");
+      }
+      root["result"] = result;
+      if (parser.isSet(trades_option)) {
+        QJsonArray trades;
+        for (const TradeSignal &trade : std::as_const(single.trade_signals)) {
+          QJsonObject item;
+          item["timestamp"] = trade.timestamp;
+          item["price"] = trade.price;
+          item["side"] = trade.type == SignalType::Buy ? "buy" : "sell";
+          trades.append(item);
+        }
+        root["trades"] = trades;
+      }
+    }
+    output = QJsonDocument(root).toJson(QJsonDocument::Indented);
+  }
+
+  return writeOutput(parser.value(output_option), output);
+}
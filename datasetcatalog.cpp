@@ -0,0 +1,473 @@
+#include "datasetcatalog.h"
+
+#include "datasetinfo.h"
+#include "klinecache.h"
+#include "klineloader.h"
+#include "profiler.h"
+
+#include <QDate>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRegularExpression>
+#include <QSaveFile>
+#include <QSet>
+#include <QTimeZone>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+namespace {
+
+constexpr int kIndexVersion = 1;
+constexpr char kStorePrefix[] = "store/";
+constexpr qint64 kScanChunkBytes = 4 << 20;
+
+// 合并存储的文件名：交易所_品种_周期.csv，品种中的'/'和':'换成'_'
+QString storeFileName(const DatasetEntry &entry) {
+  QString name = QString("%1_%2_%3.csv").arg(entry.exchange, entry.symbol, entry.timeframe);
+  name.replace('/', '_');
+  name.replace(':', '_');
+  return kStorePrefix + name;
+}
+
+QJsonObject toJson(const DatasetEntry &entry) {
+  QJsonObject object;
+  object.insert("file", entry.file_name);
+  object.insert("exchange", entry.exchange);
+  object.insert("symbol", entry.symbol);
+  object.insert("timeframe", entry.timeframe);
+  object.insert("first", entry.first_timestamp);
+  object.insert("last", entry.last_timestamp);
+  object.insert("rows", entry.rows);
+  object.insert("size", entry.file_size);
+  object.insert("modified", entry.modified_ms);
+  if (!entry.canonical.isEmpty())
+    object.insert("canonical", entry.canonical);
+  if (!entry.sources.isEmpty())
+    object.insert("sources", QJsonArray::fromStringList(entry.sources));
+  return object;
+}
+
+DatasetEntry fromJson(const QJsonObject &object) {
+  DatasetEntry entry;
+  entry.file_name = object.value("file").toString();
+  entry.exchange = object.value("exchange").toString();
+  entry.symbol = object.value("symbol").toString();
+  entry.timeframe = object.value("timeframe").toString();
+  entry.first_timestamp = object.value("first").toInteger();
+  entry.last_timestamp = object.value("last").toInteger();
+  entry.rows = object.value("rows").toInteger();
+  entry.file_size = object.value("size").toInteger();
+  entry.modified_ms = object.value("modified").toInteger();
+  entry.canonical = object.value("canonical").toString();
+  for (const QJsonValue &source : object.value("sources").toArray())
+    entry.sources.append(source.toString());
+  return entry;
+}
+
+// 行首的时间戳，不是数据行时返回false
+bool lineTimestamp(const QByteArray &line, qint64 &timestamp) {
+  const qsizetype comma = line.indexOf(',');
+  if (comma <= 0)
+    return false;
+  bool ok = false;
+  timestamp = line.left(comma).trimmed().toLongLong(&ok);
+  return ok;
+}
+
+qint64 startOfDay(const QDate &date) {
+  return date.startOfDay(QTimeZone::utc()).toMSecsSinceEpoch();
+}
+
+// "2021"或"2021-03-15"；作为区间终点时取这一年（天）的结束，不含
+bool parseBound(const QString &text, bool end, qint64 &msecs) {
+  static const QRegularExpression kYear("^\\d{4}$");
+  if (kYear.match(text).hasMatch()) {
+    const int year = text.toInt();
+    msecs = startOfDay(QDate(end ? year + 1 : year, 1, 1));
+    return true;
+  }
+  const QDate date = QDate::fromString(text, "yyyy-MM-dd");
+  if (!date.isValid())
+    return false;
+  msecs = startOfDay(end ? date.addDays(1) : date);
+  return true;
+}
+
+bool parseTimeRange(QString text, qint64 &from, qint64 &to) {
+  static const QRegularExpression kYearRange("^\\d{4}-\\d{4}$");
+  text.replace(QChar(0x2013), "..").replace('~', "..");
+  if (kYearRange.match(text).hasMatch())
+    text.replace('-', "..");
+  const QStringList parts = text.split("..");
+  if (parts.size() > 2)
+    return false;
+  return parseBound(parts.first(), false, from) && parseBound(parts.last(), true, to);
+}
+
+} // namespace
+
+QString DatasetEntry::key() const {
+  return exchange.toLower() + '|' + symbol.toUpper() + '|' + timeframe;
+}
+
+QString DatasetCatalog::indexPath(const QString &data_dir) {
+  return QDir(data_dir).filePath("catalog.json");
+}
+
+QString DatasetCatalog::storeDirectory(const QString &data_dir) {
+  return QDir(data_dir).filePath("store");
+}
+
+bool DatasetCatalog::open(const QString &data_dir) {
+  data_dir_ = data_dir;
+  entries_.clear();
+  QFile file(indexPath(data_dir));
+  if (!file.open(QIODevice::ReadOnly))
+    return false;
+  const QJsonObject root = QJsonDocument::fromJson(file.readAll()).object();
+  if (root.value("version").toInt() != kIndexVersion)
+    return false;
+  const QJsonArray datasets = root.value("datasets").toArray();
+  entries_.reserve(datasets.size());
+  for (const QJsonValue &value : datasets)
+    entries_.append(fromJson(value.toObject()));
+  return true;
+}
+
+bool DatasetCatalog::save(QString &error) const {
+  QJsonArray datasets;
+  for (const DatasetEntry &entry : entries_)
+    datasets.append(toJson(entry));
+  QJsonObject root;
+  root.insert("version", kIndexVersion);
+  root.insert("datasets", datasets);
+  QSaveFile file(indexPath(data_dir_));
+  if (!file.open(QIODevice::WriteOnly)) {
+    error = "无法写入数据索引: " + indexPath(data_dir_);
+    return false;
+  }
+  file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+  if (!file.commit()) {
+    error = "无法写入数据索引: " + indexPath(data_dir_);
+    return false;
+  }
+  return true;
+}
+
+bool DatasetCatalog::refresh(bool &changed, QString &error) {
+  ProfileScope scope("catalog.refresh");
+  changed = false;
+  QHash<QString, qsizetype> previous;
+  for (qsizetype i = 0; i < entries_.size(); i++)
+    previous.insert(entries_[i].file_name, i);
+
+  // 大小和修改时间都没变的文件直接沿用索引中的摘要
+  QVector<DatasetEntry> entries;
+  QSet<QString> dirty; // 有原始文件新增或变化、需要重新合并的键
+  auto scan = [&](const QString &directory, const QString &prefix) {
+    const QFileInfoList files = QDir(directory).entryInfoList({"*.csv"}, QDir::Files, QDir::Name);
+    for (const QFileInfo &info : files) {
+      const QString name = prefix + info.fileName();
+      const qsizetype index = previous.value(name, -1);
+      if (index >= 0 && entries_[index].file_size == info.size()
+          && entries_[index].modified_ms == info.lastModified().toMSecsSinceEpoch()) {
+        entries.append(entries_[index]);
+        continue;
+      }
+      DatasetEntry entry;
+      if (!scanFile(info.absoluteFilePath(), entry))
+        continue; // 空文件或不是K线CSV
+      entry.file_name = name;
+      if (prefix.isEmpty() && entry.hasSource())
+        dirty.insert(entry.key());
+      entries.append(entry);
+      changed = true;
+    }
+  };
+  scan(data_dir_, QString());
+  scan(storeDirectory(data_dir_), kStorePrefix);
+  changed = changed || entries.size() != entries_.size(); // 有文件被删除
+  entries_ = entries;
+
+  QHash<QString, QVector<int>> groups;
+  QHash<QString, QString> stores;
+  for (qsizetype i = 0; i < entries_.size(); i++) {
+    DatasetEntry &entry = entries_[i];
+    if (!entry.hasSource())
+      continue;
+    if (entry.isStore())
+      stores.insert(entry.key(), entry.file_name);
+    else
+      groups[entry.key()].append(int(i));
+  }
+  for (auto it = groups.cbegin(); it != groups.cend(); ++it) {
+    const QVector<int> &members = it.value();
+    QString store = stores.value(it.key());
+    // 只有一个文件且还没有合并存储时，文件本身就是规范数据集
+    if (members.size() < 2 && store.isEmpty()) {
+      if (!entries_[members.first()].canonical.isEmpty()) {
+        entries_[members.first()].canonical.clear();
+        changed = true;
+      }
+      continue;
+    }
+    if (store.isEmpty())
+      store = storeFileName(entries_[members.first()]);
+    if (!stores.contains(it.key()) || dirty.contains(it.key())) {
+      if (!mergeKey(store, members, error))
+        return false;
+      changed = true;
+    }
+    QStringList sources;
+    for (int index : members) {
+      if (entries_[index].canonical != store)
+        changed = true;
+      entries_[index].canonical = store;
+      sources.append(entries_[index].file_name);
+    }
+    for (DatasetEntry &entry : entries_) {
+      if (entry.file_name == store && entry.sources != sources) {
+        entry.sources = sources;
+        changed = true;
+      }
+    }
+  }
+  return true;
+}
+
+bool DatasetCatalog::mergeKey(const QString &store_name, const QVector<int> &members, QString &error) {
+  ProfileScope scope("catalog.merge");
+  const QString store_path = QDir(data_dir_).filePath(store_name);
+  // 合并存储本身排在最前面，增量更新追加到它的数据不会丢；其余文件新的优先
+  QVector<int> ordered = members;
+  std::sort(ordered.begin(), ordered.end(), [this](int a, int b) {
+    return entries_[a].modified_ms > entries_[b].modified_ms;
+  });
+  QStringList inputs;
+  if (QFile::exists(store_path))
+    inputs.append(store_path);
+  for (int index : std::as_const(ordered))
+    inputs.append(filePath(entries_[index]));
+  QDir().mkpath(storeDirectory(data_dir_));
+  qint64 rows = 0;
+  if (!mergeCsv(inputs, store_path, rows, error))
+    return false;
+  const DatasetEntry &source = entries_[members.first()];
+  DatasetInfo info{source.exchange, source.symbol, source.timeframe};
+  if (!info.save(store_path)) {
+    error = "无法写入数据来源信息: " + DatasetInfo::infoPath(store_path);
+    return false;
+  }
+  DatasetEntry entry;
+  if (!scanFile(store_path, entry)) {
+    error = "无法读取合并后的数据: " + store_path;
+    return false;
+  }
+  entry.file_name = store_name;
+  for (DatasetEntry &existing : entries_) {
+    if (existing.file_name == store_name) {
+      existing = entry;
+      return true;
+    }
+  }
+  entries_.append(entry);
+  return true;
+}
+
+QVector<DatasetEntry> DatasetCatalog::datasets() const {
+  QVector<DatasetEntry> result;
+  for (const DatasetEntry &entry : entries_) {
+    if (entry.canonical.isEmpty())
+      result.append(entry);
+  }
+  std::stable_sort(result.begin(), result.end(), [](const DatasetEntry &a, const DatasetEntry &b) {
+    return a.modified_ms > b.modified_ms;
+  });
+  return result;
+}
+
+QVector<DatasetEntry> DatasetCatalog::query(const DatasetQuery &query) const {
+  QVector<DatasetEntry> result;
+  for (const DatasetEntry &entry : datasets()) {
+    if (!query.exchange.isEmpty() && entry.exchange.compare(query.exchange, Qt::CaseInsensitive) != 0)
+      continue;
+    if (!query.symbol.isEmpty() && entry.symbol.compare(query.symbol, Qt::CaseInsensitive) != 0)
+      continue;
+    // 周期区分大小写，1M是月线
+    if (!query.timeframe.isEmpty() && entry.timeframe != query.timeframe)
+      continue;
+    if (entry.first_timestamp >= query.to || entry.last_timestamp < query.from)
+      continue;
+    result.append(entry);
+  }
+  return result;
+}
+
+QString DatasetCatalog::filePath(const DatasetEntry &entry) const {
+  return QDir(data_dir_).filePath(entry.file_name);
+}
+
+QString DatasetCatalog::canonicalPath(const QString &file_path) const {
+  const QString name = QDir(data_dir_).relativeFilePath(file_path);
+  for (const DatasetEntry &entry : entries_) {
+    if (entry.file_name == name)
+      return QDir(data_dir_).filePath(entry.canonical.isEmpty() ? entry.file_name : entry.canonical);
+  }
+  return file_path;
+}
+
+bool DatasetCatalog::scanFile(const QString &csv_path, DatasetEntry &entry) {
+  const QFileInfo info(csv_path);
+  if (!info.isFile())
+    return false;
+  entry = DatasetEntry();
+  entry.file_size = info.size();
+  entry.modified_ms = info.lastModified().toMSecsSinceEpoch();
+  DatasetInfo source;
+  if (DatasetInfo::load(csv_path, source)) {
+    entry.exchange = source.exchange;
+    entry.symbol = source.symbol;
+    entry.timeframe = source.timeframe;
+  }
+  // 列式缓存与CSV一致时行数和首尾时间都在映射里，不必读CSV
+  KLineCache cache;
+  if (cache.open(csv_path) && cache.columns().size > 0) {
+    const KLineColumns &columns = cache.columns();
+    entry.rows = columns.size;
+    entry.first_timestamp = columns.timestamp[0];
+    entry.last_timestamp = columns.timestamp[columns.size - 1];
+    return true;
+  }
+  QFile file(csv_path);
+  if (!file.open(QIODevice::ReadOnly) || !file.readLine().contains("timestamp"))
+    return false;
+  QByteArray line;
+  do {
+    if (file.atEnd())
+      return false;
+    line = file.readLine();
+  } while (!lineTimestamp(line, entry.first_timestamp));
+  if (!KLineLoader::readLastTimestamp(csv_path, entry.last_timestamp))
+    return false;
+  // 按块数换行，内存与文件大小无关
+  entry.rows = 1;
+  bool unterminated = false; // 最后一行没有换行结尾
+  while (!file.atEnd()) {
+    const QByteArray chunk = file.read(kScanChunkBytes);
+    if (chunk.isEmpty())
+      break;
+    entry.rows += chunk.count('\n');
+    unterminated = !chunk.endsWith('\n');
+  }
+  if (unterminated)
+    entry.rows++;
+  return true;
+}
+
+bool DatasetCatalog::parseQuery(const QString &text, DatasetQuery &query, QString &error) {
+  static const QRegularExpression kSeparators("[\\s,]+");
+  static const QRegularExpression kTimeframe("^\\d+[smhdwM]$");
+  static const QRegularExpression kTimeRange("^\\d{4}");
+  query = DatasetQuery();
+  for (const QString &token : text.split(kSeparators, Qt::SkipEmptyParts)) {
+    if (token.contains('/')) {
+      query.symbol = token;
+    } else if (kTimeframe.match(token).hasMatch()) {
+      query.timeframe = token;
+    } else if (kTimeRange.match(token).hasMatch()) {
+      if (!parseTimeRange(token, query.from, query.to)) {
+        error = "无法识别的时间范围: " + token;
+        return false;
+      }
+    } else if (query.exchange.isEmpty()) {
+      query.exchange = token;
+    } else {
+      error = "无法识别的查询条件: " + token;
+      return false;
+    }
+  }
+  return true;
+}
+
+bool DatasetCatalog::mergeCsv(const QStringList &inputs, const QString &output, qint64 &rows, QString &error) {
+  struct Input {
+    QFile file;
+    QByteArray line;
+    qint64 timestamp = 0;
+    bool done = false;
+  };
+  // 取下一条数据行，跳过表头和无法解析的行
+  auto advance = [](Input &input) {
+    while (!input.file.atEnd()) {
+      input.line = input.file.readLine();
+      if (lineTimestamp(input.line, input.timestamp)) {
+        if (!input.line.endsWith('\n'))
+          input.line.append('\n');
+        return;
+      }
+    }
+    input.done = true;
+  };
+  rows = 0;
+  std::vector<std::unique_ptr<Input>> readers;
+  QByteArray header;
+  for (const QString &path : inputs) {
+    auto input = std::make_unique<Input>();
+    input->file.setFileName(path);
+    if (!input->file.open(QIODevice::ReadOnly)) {
+      error = "无法读取数据文件: " + path;
+      return false;
+    }
+    const QByteArray first = input->file.readLine();
+    if (header.isEmpty())
+      header = first.endsWith('\n') ? first : first + '\n';
+    advance(*input);
+    readers.push_back(std::move(input));
+  }
+  if (!header.contains("timestamp")) {
+    error = "CSV文件缺少表头";
+    return false;
+  }
+
+  QSaveFile file(output);
+  if (!file.open(QIODevice::WriteOnly)) {
+    error = "无法写入合并的数据: " + output;
+    return false;
+  }
+  file.write(header);
+  // 每次写出各文件当前行中最早的一行，同一时间戳的其他行一并跳过
+  for (;;) {
+    Input *earliest = nullptr;
+    for (const auto &input : readers) {
+      if (!input->done && (!earliest || input->timestamp < earliest->timestamp))
+        earliest = input.get();
+    }
+    if (!earliest)
+      break;
+    const qint64 timestamp = earliest->timestamp;
+    if (file.write(earliest->line) != earliest->line.size()) {
+      file.cancelWriting();
+      error = "无法写入合并的数据: " + output;
+      return false;
+    }
+    rows++;
+    for (const auto &input : readers) {
+      while (!input->done && input->timestamp <= timestamp)
+        advance(*input);
+    }
+  }
+  readers.clear(); // output可能就是输入之一，替换前先关闭
+  if (!file.commit()) {
+    error = "无法写入合并的数据: " + output;
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,76 @@
+#ifndef DATASETCATALOG_H
+#define DATASETCATALOG_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include <limits>
+
+// 数据目录中一个CSV的摘要，全部来自索引，查询时不需要打开CSV
+struct DatasetEntry {
+  QString file_name; // 相对数据目录的路径，合并存储为"store/xxx.csv"
+  QString exchange;  // 来源信息，没有<csv>.json时为空
+  QString symbol;
+  QString timeframe;
+  qint64 first_timestamp = 0;
+  qint64 last_timestamp = 0;
+  qint64 rows = 0;
+  qint64 file_size = 0;   // 与修改时间一起判断文件是否变化
+  qint64 modified_ms = 0;
+  QString canonical;   // 已合并进的规范存储，本身即规范数据集时为空
+  QStringList sources; // 合并存储目前对应的原始文件
+
+  bool hasSource() const { return !exchange.isEmpty() && !symbol.isEmpty() && !timeframe.isEmpty(); }
+  bool isStore() const { return file_name.startsWith(QLatin1String("store/")); }
+  QString key() const; // 交易所|品种|周期，同一键的文件会被合并
+};
+
+// 按来源和时间范围筛选，字段为空表示不限；时间范围与数据集有重叠即匹配
+struct DatasetQuery {
+  QString exchange;
+  QString symbol;
+  QString timeframe;
+  qint64 from = std::numeric_limits<qint64>::min();
+  qint64 to = std::numeric_limits<qint64>::max(); // 不含
+};
+
+// 数据目录的索引(<dir>/catalog.json)：记录每个CSV的来源、时间范围和行数。
+// 刷新时只重新扫描大小或修改时间变化的文件；同一交易所/品种/周期的多个文件
+// 按时间合并去重成store/下的一个规范存储，界面和查询只看规范数据集
+class DatasetCatalog {
+public:
+  static QString indexPath(const QString& data_dir);
+  static QString storeDirectory(const QString& data_dir);
+
+  // 只读索引文件，不访问数据文件；索引不存在或损坏时为空目录
+  bool open(const QString& data_dir);
+  // 对照目录更新索引并合并重复的数据集，changed返回索引是否有变化
+  bool refresh(bool& changed, QString& error);
+  bool save(QString& error) const;
+
+  const QString& dataDirectory() const { return data_dir_; }
+  const QVector<DatasetEntry>& entries() const { return entries_; }
+  // 规范数据集：合并存储、没有重复的文件和缺少来源信息的文件，按修改时间从新到旧
+  QVector<DatasetEntry> datasets() const;
+  QVector<DatasetEntry> query(const DatasetQuery& query) const;
+  QString filePath(const DatasetEntry& entry) const;
+  // file_path所在的规范数据集的完整路径，已被合并时返回合并存储，不在索引中时原样返回
+  QString canonicalPath(const QString& file_path) const;
+
+  // 读取单个CSV的摘要：有最新的列式缓存时直接取，否则只读首尾行并按块数换行
+  static bool scanFile(const QString& csv_path, DatasetEntry& entry);
+  // 解析"binance BTC/USDT 1h 2021-2023"这类查询：含'/'的是品种，形如1h/4h/1d的是周期，
+  // 年份、年份区间或yyyy-MM-dd..yyyy-MM-dd是时间范围，其余视为交易所
+  static bool parseQuery(const QString& text, DatasetQuery& query, QString& error);
+  // 把多个按时间升序的CSV逐行归并到output，时间戳相同时保留inputs中靠前的那一行
+  static bool mergeCsv(const QStringList& inputs, const QString& output, qint64& rows, QString& error);
+
+private:
+  bool mergeKey(const QString& store_name, const QVector<int>& members, QString& error);
+
+  QString data_dir_;
+  QVector<DatasetEntry> entries_;
+};
+
+#endif // DATASETCATALOG_H
@@ -0,0 +1,32 @@
+#include "datasetinfo.h"
+
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+
+QString DatasetInfo::infoPath(const QString &csv_path) {
+  return csv_path + ".json";
+}
+
+bool DatasetInfo::load(const QString &csv_path, DatasetInfo &info) {
+  QFile file(infoPath(csv_path));
+  if (!file.open(QIODevice::ReadOnly))
+    return false;
+  QJsonObject object = QJsonDocument::fromJson(file.readAll()).object();
+  info.exchange = object.value("exchange").toString();
+  info.symbol = object.value("symbol").toString();
+  info.timeframe = object.value("timeframe").toString();
+  return !info.exchange.isEmpty() && !info.symbol.isEmpty() && !info.timeframe.isEmpty();
+}
+
+bool DatasetInfo::save(const QString &csv_path) const {
+  QJsonObject object;
+  object.insert("exchange", exchange);
+  object.insert("symbol", symbol);
+  object.insert("timeframe", timeframe);
+  QSaveFile file(infoPath(csv_path));
+  if (!file.open(QIODevice::WriteOnly))
+    return false;
+  file.write(QJsonDocument(object).toJson());
+  return file.commit();
+}
@@ -0,0 +1,17 @@
+#ifndef DATASETINFO_H
+#define DATASETINFO_H
+
+#include <QString>
+
+// 数据文件的来源信息，保存在CSV旁的<csv>.json中，增量更新时据此续传
+struct DatasetInfo {
+  QString exchange;
+  QString symbol;
+  QString timeframe;
+
+  static QString infoPath(const QString& csv_path);
+  static bool load(const QString& csv_path, DatasetInfo& info);
+  bool save(const QString& csv_path) const;
+};
+
+#endif // DATASETINFO_H
@@ -21,7 +21,8 @@ void DownloadDialog::initializeApplication() {
   // 初始化交易对列表
   ui->symbolComboBox->addItems({"BTC/USDT", "ETH/USDT", "BNB/USDT", "ADA/USDT"});
   // 初始化时间周期
-  ui->timeframeComboBox->addItems({"1d"});
+  ui->timeframeComboBox->addItems({"1m", "5m", "15m", "1h", "4h", "1d"});
+  ui->timeframeComboBox->setCurrentText("1d");
   // 设置默认时间范围（最近一年）
   ui->startDateTimeEdit->setTimeZone(QTimeZone::utc());
   ui->endDateTimeEdit->setTimeZone(QTimeZone::utc());
@@ -0,0 +1,101 @@
+#include "downloadmanager.h"
+
+#include <QProcess>
+
+DownloadManager::DownloadManager(QObject *parent)
+    : QObject(parent)
+    , current_(nullptr)
+    , current_cancelled_(false)
+    , python_check_(nullptr)
+    , python_state_(PythonState::Unknown) {}
+
+void DownloadManager::enqueue(const DownloadRequest &request) {
+  queue_.append(request);
+  startNext();
+}
+
+void DownloadManager::cancelCurrent() {
+  if (!current_)
+    return;
+  current_cancelled_ = true;
+  current_->cancel();
+}
+
+void DownloadManager::cancelAll() {
+  const QList<DownloadRequest> dropped = queue_;
+  queue_.clear();
+  for (const DownloadRequest &request : dropped)
+    emit jobCancelled(request);
+  if (current_) {
+    cancelCurrent();
+  } else if (python_check_) {
+    python_check_->kill(); // 检查结果回来时队列已空
+  }
+}
+
+void DownloadManager::startNext() {
+  if (isBusy())
+    return;
+  if (queue_.isEmpty()) {
+    emit idle();
+    return;
+  }
+  if (python_state_ != PythonState::Ready) {
+    checkPython();
+    return;
+  }
+  current_request_ = queue_.takeFirst();
+  current_cancelled_ = false;
+  current_ = new BatchDownloader(this);
+  connect(current_, &BatchDownloader::progress, this, &DownloadManager::jobProgress);
+  connect(current_, &BatchDownloader::finished, this, &DownloadManager::onJobFinished);
+  emit jobStarted(current_request_, int(queue_.size()));
+  if (!current_->start(current_request_))
+    onJobFinished(false, "无效的下载时间范围", 0);
+}
+
+void DownloadManager::checkPython() {
+  python_state_ = PythonState::Checking;
+  python_check_ = new QProcess(this);
+  connect(python_check_,
+          &QProcess::finished,
+          this,
+          [this](int exit_code, QProcess::ExitStatus status) {
+            onPythonChecked(status == QProcess::NormalExit && exit_code == 0);
+          });
+  connect(python_check_, &QProcess::errorOccurred, this, [this](QProcess::ProcessError error) {
+    if (error == QProcess::FailedToStart)
+      onPythonChecked(false);
+  });
+  python_check_->start("python", {"--version"});
+}
+
+void DownloadManager::onPythonChecked(bool ok) {
+  if (!python_check_)
+    return;
+  python_check_->disconnect(this);
+  python_check_->deleteLater();
+  python_check_ = nullptr;
+  if (ok) {
+    python_state_ = PythonState::Ready;
+  } else {
+    // 下次入队时重新检查，用户可能在此期间安装了Python
+    python_state_ = PythonState::Unknown;
+    const QList<DownloadRequest> failed = queue_;
+    queue_.clear();
+    for (const DownloadRequest &request : failed)
+      emit jobFinished(request, false, "未找到Python环境，请先安装Python 3.7+", 0);
+  }
+  startNext();
+}
+
+void DownloadManager::onJobFinished(bool success, const QString &message, qint64 rows) {
+  current_->disconnect(this);
+  current_->deleteLater();
+  current_ = nullptr;
+  if (current_cancelled_)
+    emit jobCancelled(current_request_);
+  else
+    emit jobFinished(current_request_, success, message, rows);
+  startNext();
+}
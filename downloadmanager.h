@@ -0,0 +1,50 @@
+#ifndef DOWNLOADMANAGER_H
+#define DOWNLOADMANAGER_H
+
+#include "batchdownloader.h"
+
+#include <QList>
+#include <QObject>
+
+class QProcess;
+
+// 下载队列：任务依次交给BatchDownloader执行，界面线程只处理信号，
+// 首个任务开始前异步检查一次Python环境
+class DownloadManager : public QObject {
+  Q_OBJECT
+
+public:
+  explicit DownloadManager(QObject* parent = nullptr);
+
+  void enqueue(const DownloadRequest& request);
+  void cancelCurrent(); // 取消正在下载的任务，队列中的任务继续
+  void cancelAll();
+
+  bool isBusy() const { return current_ != nullptr || python_check_ != nullptr; }
+  int queuedCount() const { return int(queue_.size()); }
+  const DownloadRequest& currentRequest() const { return current_request_; }
+
+signals:
+  void jobStarted(const DownloadRequest& request, int queued);
+  void jobProgress(qint64 fetched_bars, qint64 total_bars);
+  void jobFinished(const DownloadRequest& request, bool success, const QString& message, qint64 rows);
+  void jobCancelled(const DownloadRequest& request);
+  void idle(); // 队列清空
+
+private:
+  enum class PythonState { Unknown, Checking, Ready };
+
+  void startNext();
+  void checkPython();
+  void onPythonChecked(bool ok);
+  void onJobFinished(bool success, const QString& message, qint64 rows);
+
+  QList<DownloadRequest> queue_;
+  DownloadRequest current_request_;
+  BatchDownloader* current_;
+  bool current_cancelled_;
+  QProcess* python_check_;
+  PythonState python_state_;
+};
+
+#endif // DOWNLOADMANAGER_H
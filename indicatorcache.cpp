@@ -0,0 +1,91 @@
+#include "indicatorcache.h"
+
+#include "profiler.h"
+
+#include <QMutexLocker>
+
+namespace {
+
+template<typename T>
+std::shared_ptr<const void> share(T value) {
+  return std::make_shared<const T>(std::move(value));
+}
+
+} // namespace
+
+IndicatorCache::IndicatorCache(const QVector<KLineData> &bars)
+    : hits_(0)
+    , misses_(0) {
+  const qsizetype count = bars.size();
+  open_.resize(count);
+  high_.resize(count);
+  low_.resize(count);
+  close_.resize(count);
+  volume_.resize(count);
+  for (qsizetype i = 0; i < count; i++) {
+    const KLineData &bar = bars[i];
+    open_[i] = bar.open;
+    high_[i] = bar.high;
+    low_[i] = bar.low;
+    close_[i] = bar.close;
+    volume_[i] = bar.volume;
+  }
+}
+
+std::shared_ptr<const void> IndicatorCache::lookup(
+    const QString &key, const std::function<std::shared_ptr<const void>()> &compute) {
+  std::shared_ptr<Entry> entry;
+  {
+    QMutexLocker locker(&mutex_);
+    std::shared_ptr<Entry> &slot = entries_[key];
+    if (!slot)
+      slot = std::make_shared<Entry>();
+    entry = slot;
+  }
+  // 计算在锁外进行，不同指标可以并行计算
+  bool computed = false;
+  std::call_once(entry->once, [&] {
+    ProfileScope scope("indicator.compute");
+    entry->value = compute();
+    computed = true;
+  });
+  (computed ? misses_ : hits_)++;
+  return entry->value;
+}
+
+IndicatorCache::Series IndicatorCache::sma(int period) {
+  return std::static_pointer_cast<const QVector<double>>(lookup(QString("sma/%1").arg(period), [&] {
+    return share(Indicators::sma(close(), size(), period));
+  }));
+}
+
+IndicatorCache::Series IndicatorCache::ema(int period) {
+  return std::static_pointer_cast<const QVector<double>>(lookup(QString("ema/%1").arg(period), [&] {
+    return share(Indicators::ema(close(), size(), period));
+  }));
+}
+
+IndicatorCache::Series IndicatorCache::rsi(int period) {
+  return std::static_pointer_cast<const QVector<double>>(lookup(QString("rsi/%1").arg(period), [&] {
+    return share(Indicators::rsi(close(), size(), period));
+  }));
+}
+
+IndicatorCache::Series IndicatorCache::atr(int period) {
+  return std::static_pointer_cast<const QVector<double>>(lookup(QString("atr/%1").arg(period), [&] {
+    return share(Indicators::atr(high(), low(), close(), size(), period));
+  }));
+}
+
+std::shared_ptr<const Indicators::Bands> IndicatorCache::bollinger(int period, double width) {
+  QString key = QString("bollinger/%1/%2").arg(period).arg(width, 0, 'g', 17);
+  return std::static_pointer_cast<const Indicators::Bands>(lookup(key, [&] {
+    return share(Indicators::bollinger(close(), size(), period, width));
+  }));
+}
+
+IndicatorCache::Series IndicatorCache::vwap(int period) {
+  return std::static_pointer_cast<const QVector<double>>(lookup(QString("vwap/%1").arg(period), [&] {
+    return share(Indicators::vwap(high(), low(), close(), volume(), size(), period));
+  }));
+}
@@ -0,0 +1,63 @@
+#ifndef INDICATORCACHE_H
+#define INDICATORCACHE_H
+
+#include "indicators.h"
+#include "klinedata.h"
+
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+// 一份K线数据上的指标缓存：构造时把K线拆成连续的列，各指标按（名称, 参数）
+// 只计算一次，之后返回同一份只读结果。可被多个线程同时使用，
+// 同一指标并发请求时只有一个线程计算，其余等待结果。数据变化后应整体丢弃
+class IndicatorCache {
+public:
+  using Series = std::shared_ptr<const QVector<double>>;
+
+  explicit IndicatorCache(const QVector<KLineData>& bars);
+
+  qsizetype size() const { return close_.size(); }
+  const double* open() const { return open_.constData(); }
+  const double* high() const { return high_.constData(); }
+  const double* low() const { return low_.constData(); }
+  const double* close() const { return close_.constData(); }
+  const double* volume() const { return volume_.constData(); }
+
+  Series sma(int period);
+  Series ema(int period);
+  Series rsi(int period);
+  Series atr(int period);
+  std::shared_ptr<const Indicators::Bands> bollinger(int period, double width);
+  Series vwap(int period);
+
+  qint64 hits() const { return hits_; }
+  qint64 misses() const { return misses_; }
+
+private:
+  struct Entry {
+    std::once_flag once;
+    std::shared_ptr<const void> value;
+  };
+
+  std::shared_ptr<const void> lookup(const QString& key,
+                                     const std::function<std::shared_ptr<const void>()>& compute);
+
+  QVector<double> open_;
+  QVector<double> high_;
+  QVector<double> low_;
+  QVector<double> close_;
+  QVector<double> volume_;
+  QMutex mutex_;
+  QHash<QString, std::shared_ptr<Entry>> entries_;
+  std::atomic<qint64> hits_;
+  std::atomic<qint64> misses_;
+};
+
+#endif // INDICATORCACHE_H
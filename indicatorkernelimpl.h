@@ -0,0 +1,159 @@
+#ifndef INDICATORKERNELIMPL_H
+#define INDICATORKERNELIMPL_H
+
+// 只由各指令集的实现文件包含。模板和向量类型全部放在匿名命名空间中，
+// 保证以不同编译选项生成的实例互不合并，这里也不调用任何标准库内联函数
+
+#include "indicatorkernels.h"
+
+namespace {
+
+// Vec需提供：kWidth、load、store、set1、add、sub、mul、div、max、sqrt、abs，
+// 以及尾部逐个处理时使用的scalarSqrt
+template<typename Vec>
+struct KernelImpl {
+  using V = typename Vec::Type;
+
+  static void windowMean(const double *prefix,
+                         qsizetype count,
+                         int period,
+                         double offset,
+                         double *out) {
+    const V inv = Vec::set1(1.0 / period);
+    const V shift = Vec::set1(offset);
+    qsizetype i = period - 1;
+    for (; i + Vec::kWidth <= count; i += Vec::kWidth) {
+      V sum = Vec::sub(Vec::load(prefix + i + 1), Vec::load(prefix + i + 1 - period));
+      Vec::store(out + i, Vec::add(Vec::mul(sum, inv), shift));
+    }
+    for (; i < count; i++)
+      out[i] = (prefix[i + 1] - prefix[i + 1 - period]) * (1.0 / period) + offset;
+  }
+
+  static void windowBand(const double *prefix,
+                         const double *prefix_sq,
+                         qsizetype count,
+                         int period,
+                         double offset,
+                         double width,
+                         double *middle,
+                         double *upper,
+                         double *lower) {
+    const V inv = Vec::set1(1.0 / period);
+    const V shift = Vec::set1(offset);
+    const V k = Vec::set1(width);
+    const V zero = Vec::set1(0.0);
+    qsizetype i = period - 1;
+    for (; i + Vec::kWidth <= count; i += Vec::kWidth) {
+      V mean = Vec::mul(Vec::sub(Vec::load(prefix + i + 1), Vec::load(prefix + i + 1 - period)), inv);
+      V sq = Vec::mul(Vec::sub(Vec::load(prefix_sq + i + 1), Vec::load(prefix_sq + i + 1 - period)),
+                      inv);
+      V var = Vec::max(Vec::sub(sq, Vec::mul(mean, mean)), zero);
+      V band = Vec::mul(Vec::sqrt(var), k);
+      V mid = Vec::add(mean, shift);
+      Vec::store(middle + i, mid);
+      Vec::store(upper + i, Vec::add(mid, band));
+      Vec::store(lower + i, Vec::sub(mid, band));
+    }
+    using S = ScalarOps;
+    for (; i < count; i++) {
+      double mean = (prefix[i + 1] - prefix[i + 1 - period]) * (1.0 / period);
+      double sq = (prefix_sq[i + 1] - prefix_sq[i + 1 - period]) * (1.0 / period);
+      double band = Vec::scalarSqrt(S::max(sq - mean * mean, 0.0)) * width;
+      middle[i] = mean + offset;
+      upper[i] = middle[i] + band;
+      lower[i] = middle[i] - band;
+    }
+  }
+
+  static void windowRatio(const double *num_prefix,
+                          const double *den_prefix,
+                          qsizetype count,
+                          int period,
+                          double *out) {
+    qsizetype i = period - 1;
+    for (; i + Vec::kWidth <= count; i += Vec::kWidth) {
+      V num = Vec::sub(Vec::load(num_prefix + i + 1), Vec::load(num_prefix + i + 1 - period));
+      V den = Vec::sub(Vec::load(den_prefix + i + 1), Vec::load(den_prefix + i + 1 - period));
+      Vec::store(out + i, Vec::div(num, den));
+    }
+    for (; i < count; i++) {
+      out[i] = (num_prefix[i + 1] - num_prefix[i + 1 - period])
+               / (den_prefix[i + 1] - den_prefix[i + 1 - period]);
+    }
+  }
+
+  static void trueRange(const double *high,
+                        const double *low,
+                        const double *close,
+                        qsizetype count,
+                        double *out) {
+    if (count == 0)
+      return;
+    out[0] = high[0] - low[0];
+    qsizetype i = 1;
+    for (; i + Vec::kWidth <= count; i += Vec::kWidth) {
+      V h = Vec::load(high + i);
+      V l = Vec::load(low + i);
+      V prev = Vec::load(close + i - 1);
+      V range = Vec::max(Vec::sub(h, l), Vec::abs(Vec::sub(h, prev)));
+      Vec::store(out + i, Vec::max(range, Vec::abs(Vec::sub(l, prev))));
+    }
+    using S = ScalarOps;
+    for (; i < count; i++) {
+      double range = S::max(high[i] - low[i], S::abs(high[i] - close[i - 1]));
+      out[i] = S::max(range, S::abs(low[i] - close[i - 1]));
+    }
+  }
+
+  static void gainsLosses(const double *close, qsizetype count, double *gains, double *losses) {
+    if (count == 0)
+      return;
+    gains[0] = losses[0] = 0.0;
+    const V zero = Vec::set1(0.0);
+    qsizetype i = 1;
+    for (; i + Vec::kWidth <= count; i += Vec::kWidth) {
+      V diff = Vec::sub(Vec::load(close + i), Vec::load(close + i - 1));
+      Vec::store(gains + i, Vec::max(diff, zero));
+      Vec::store(losses + i, Vec::max(Vec::sub(zero, diff), zero));
+    }
+    for (; i < count; i++) {
+      double diff = close[i] - close[i - 1];
+      gains[i] = diff > 0.0 ? diff : 0.0;
+      losses[i] = diff < 0.0 ? -diff : 0.0;
+    }
+  }
+
+  static void typicalVolume(const double *high,
+                            const double *low,
+                            const double *close,
+                            const double *volume,
+                            qsizetype count,
+                            double *out) {
+    const V third = Vec::set1(1.0 / 3.0);
+    qsizetype i = 0;
+    for (; i + Vec::kWidth <= count; i += Vec::kWidth) {
+      V sum = Vec::add(Vec::add(Vec::load(high + i), Vec::load(low + i)), Vec::load(close + i));
+      Vec::store(out + i, Vec::mul(Vec::mul(sum, third), Vec::load(volume + i)));
+    }
+    for (; i < count; i++)
+      out[i] = (high[i] + low[i] + close[i]) * (1.0 / 3.0) * volume[i];
+  }
+
+  static const IndicatorKernels &table(const char *name) {
+    static const IndicatorKernels kernels
+        = {name, windowMean, windowBand, windowRatio, trueRange, gainsLosses, typicalVolume};
+    return kernels;
+  }
+
+private:
+  // 尾部逐个处理时使用的标量运算
+  struct ScalarOps {
+    static double max(double a, double b) { return a > b ? a : b; }
+    static double abs(double a) { return a < 0.0 ? -a : a; }
+  };
+};
+
+} // namespace
+
+#endif // INDICATORKERNELIMPL_H
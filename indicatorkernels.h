@@ -0,0 +1,52 @@
+#ifndef INDICATORKERNELS_H
+#define INDICATORKERNELS_H
+
+#include <QtGlobal>
+
+// 指标库内部使用：可向量化的核心循环，每种指令集各编译一份，运行时按CPU选择。
+// 前缀和数组 prefix[0] = 0，prefix[i + 1] = sum(values[0..i] - offset)，
+// 减去offset（首个值）可以避免价格平方累加时的精度损失
+struct IndicatorKernels {
+  const char* name;
+  // out[i] = 窗口[i - period + 1, i]的均值，i从period - 1开始
+  void (*window_mean)(const double* prefix, qsizetype count, int period, double offset, double* out);
+  // 窗口均值与总体标准差，输出 middle 和 middle ± width * std
+  void (*window_band)(const double* prefix,
+                      const double* prefix_sq,
+                      qsizetype count,
+                      int period,
+                      double offset,
+                      double width,
+                      double* middle,
+                      double* upper,
+                      double* lower);
+  // 两个前缀和的窗口比值，如成交量加权均价
+  void (*window_ratio)(const double* num_prefix,
+                       const double* den_prefix,
+                       qsizetype count,
+                       int period,
+                       double* out);
+  // 真实波幅，out[0] = high - low
+  void (*true_range)(const double* high,
+                     const double* low,
+                     const double* close,
+                     qsizetype count,
+                     double* out);
+  // 相邻收盘价的涨幅和跌幅（均为非负），下标0为0
+  void (*gains_losses)(const double* close, qsizetype count, double* gains, double* losses);
+  // 典型价格乘成交量 (high + low + close) / 3 * volume
+  void (*typical_volume)(const double* high,
+                         const double* low,
+                         const double* close,
+                         const double* volume,
+                         qsizetype count,
+                         double* out);
+};
+
+const IndicatorKernels& scalarIndicatorKernels();
+#ifdef QTBACKTESTER_X86_KERNELS
+const IndicatorKernels& avx2IndicatorKernels();   // indicatorsavx2.cpp，以AVX2编译
+const IndicatorKernels& avx512IndicatorKernels(); // indicatorsavx512.cpp，以AVX-512F编译
+#endif
+
+#endif // INDICATORKERNELS_H
@@ -0,0 +1,292 @@
+#include "indicators.h"
+#include "indicatorkernelimpl.h"
+
+#include <QByteArray>
+
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#if defined(QTBACKTESTER_X86_KERNELS) && defined(_MSC_VER)
+#include <immintrin.h>
+#include <intrin.h>
+#endif
+
+namespace {
+
+struct ScalarVec {
+  using Type = double;
+  static constexpr int kWidth = 1;
+
+  static Type load(const double *p) { return *p; }
+  static void store(double *p, Type v) { *p = v; }
+  static Type set1(double v) { return v; }
+  static Type add(Type a, Type b) { return a + b; }
+  static Type sub(Type a, Type b) { return a - b; }
+  static Type mul(Type a, Type b) { return a * b; }
+  static Type div(Type a, Type b) { return a / b; }
+  static Type max(Type a, Type b) { return a > b ? a : b; }
+  static Type sqrt(Type a) { return std::sqrt(a); }
+  static Type abs(Type a) { return std::abs(a); }
+  static double scalarSqrt(double a) { return std::sqrt(a); }
+};
+
+constexpr double kNaN = std::numeric_limits<double>::quiet_NaN();
+// 前缀和分块计算的每块输出数，块越短相减时的抵消越小，每块多算period - 1个前缀
+constexpr qsizetype kPrefixBlock = 2048;
+
+Indicators::Isa probeIsa() {
+#ifdef QTBACKTESTER_X86_KERNELS
+#ifdef _MSC_VER
+  int info[4];
+  __cpuid(info, 0);
+  if (info[0] < 7)
+    return Indicators::Isa::Scalar;
+  __cpuid(info, 1);
+  bool osxsave = (info[2] & (1 << 27)) != 0;
+  bool avx = (info[2] & (1 << 28)) != 0;
+  if (!osxsave || !avx)
+    return Indicators::Isa::Scalar;
+  // 操作系统需保存YMM（位1、2）和ZMM（位5~7）状态
+  unsigned long long xcr0 = _xgetbv(0);
+  __cpuidex(info, 7, 0);
+  bool avx2 = (info[1] & (1 << 5)) != 0 && (xcr0 & 0x6) == 0x6;
+  bool avx512 = (info[1] & (1 << 16)) != 0 && (xcr0 & 0xe6) == 0xe6;
+#else
+  __builtin_cpu_init();
+  bool avx2 = __builtin_cpu_supports("avx2");
+  bool avx512 = __builtin_cpu_supports("avx512f");
+#endif
+  if (avx512)
+    return Indicators::Isa::Avx512;
+  if (avx2)
+    return Indicators::Isa::Avx2;
+#endif
+  return Indicators::Isa::Scalar;
+}
+
+Indicators::Isa initialIsa() {
+  Indicators::Isa isa = Indicators::detectedIsa();
+  // 环境变量QTBACKTESTER_SIMD=scalar/avx2可以压低使用的指令集，便于排查结果差异
+  const QByteArray name = qgetenv("QTBACKTESTER_SIMD").toLower();
+  if (name == "scalar")
+    return Indicators::Isa::Scalar;
+  if (name == "avx2" && isa == Indicators::Isa::Avx512)
+    return Indicators::Isa::Avx2;
+  return isa;
+}
+
+std::atomic<int> &activeIsaStorage() {
+  static std::atomic<int> isa{int(initialIsa())};
+  return isa;
+}
+
+const IndicatorKernels &kernels() {
+  switch (Indicators::activeIsa()) {
+#ifdef QTBACKTESTER_X86_KERNELS
+  case Indicators::Isa::Avx512:
+    return avx512IndicatorKernels();
+  case Indicators::Isa::Avx2:
+    return avx2IndicatorKernels();
+#endif
+  default:
+    return scalarIndicatorKernels();
+  }
+}
+
+// prefix[i + 1] = sum(values[0..i] - offset)，squares非空时同时累加平方
+void prefixSums(const double *values,
+                qsizetype count,
+                double offset,
+                std::vector<double> &prefix,
+                std::vector<double> *squares = nullptr) {
+  prefix.resize(count + 1);
+  prefix[0] = 0.0;
+  if (squares) {
+    squares->resize(count + 1);
+    (*squares)[0] = 0.0;
+  }
+  double sum = 0.0;
+  double sum_sq = 0.0;
+  for (qsizetype i = 0; i < count; i++) {
+    double value = values[i] - offset;
+    sum += value;
+    prefix[i + 1] = sum;
+    if (squares) {
+      sum_sq += value * value;
+      (*squares)[i + 1] = sum_sq;
+    }
+  }
+}
+
+// 整段的前缀和在数据远离起点（价格漂移）或累加值远大于窗口和（成交量累积）后，
+// 窗口两端相减会严重抵消。按块输出，每块从第一个窗口的起点begin重新累加length个值，
+// 误差只与块内的数据有关。fn(begin, length)的输出写到begin起的位置
+template<typename Fn>
+void forEachPrefixBlock(qsizetype count, int period, Fn &&fn) {
+  const qsizetype block = qMax<qsizetype>(kPrefixBlock, qsizetype(period) * 4);
+  for (qsizetype first = period - 1; first < count; first += block) {
+    const qsizetype begin = first - (period - 1);
+    fn(begin, qMin(count, first + block) - begin);
+  }
+}
+
+// Wilder平滑：首值为前period个的均值，之后 avg = (avg * (period - 1) + x) / period
+void wilderSmooth(const double *values, qsizetype first, qsizetype count, int period, double *out) {
+  if (count - first < period)
+    return;
+  double sum = 0.0;
+  for (qsizetype i = first; i < first + period; i++)
+    sum += values[i];
+  double avg = sum / period;
+  out[first + period - 1] = avg;
+  for (qsizetype i = first + period; i < count; i++) {
+    avg = (avg * (period - 1) + values[i]) / period;
+    out[i] = avg;
+  }
+}
+
+} // namespace
+
+const IndicatorKernels &scalarIndicatorKernels() {
+  return KernelImpl<ScalarVec>::table("Scalar");
+}
+
+Indicators::Isa Indicators::detectedIsa() {
+  static const Isa isa = probeIsa();
+  return isa;
+}
+
+Indicators::Isa Indicators::activeIsa() {
+  return Isa(activeIsaStorage().load(std::memory_order_relaxed));
+}
+
+void Indicators::setActiveIsa(Isa isa) {
+  if (int(isa) > int(detectedIsa()))
+    isa = detectedIsa();
+  activeIsaStorage().store(int(isa), std::memory_order_relaxed);
+}
+
+QString Indicators::isaName(Isa isa) {
+  switch (isa) {
+  case Isa::Avx512:
+    return "AVX-512";
+  case Isa::Avx2:
+    return "AVX2";
+  default:
+    return "Scalar";
+  }
+}
+
+QVector<double> Indicators::sma(const double *values, qsizetype count, int period) {
+  QVector<double> out(count, kNaN);
+  if (period < 1 || count < period)
+    return out;
+  const IndicatorKernels &k = kernels();
+  std::vector<double> prefix;
+  forEachPrefixBlock(count, period, [&](qsizetype begin, qsizetype length) {
+    prefixSums(values + begin, length, values[begin], prefix);
+    k.window_mean(prefix.data(), length, period, values[begin], out.data() + begin);
+  });
+  return out;
+}
+
+QVector<double> Indicators::ema(const double *values, qsizetype count, int period) {
+  QVector<double> out(count, kNaN);
+  if (period < 1 || count < period)
+    return out;
+  // 以前period个的SMA为起点
+  double sum = 0.0;
+  for (qsizetype i = 0; i < period; i++)
+    sum += values[i];
+  double value = sum / period;
+  const double alpha = 2.0 / (period + 1);
+  out[period - 1] = value;
+  for (qsizetype i = period; i < count; i++) {
+    value += alpha * (values[i] - value);
+    out[i] = value;
+  }
+  return out;
+}
+
+QVector<double> Indicators::rsi(const double *close, qsizetype count, int period) {
+  QVector<double> out(count, kNaN);
+  if (period < 1 || count <= period)
+    return out;
+  std::vector<double> gains(count);
+  std::vector<double> losses(count);
+  kernels().gains_losses(close, count, gains.data(), losses.data());
+  // 第一根没有涨跌，从下标1开始平滑
+  std::vector<double> avg_gain(count, kNaN);
+  std::vector<double> avg_loss(count, kNaN);
+  wilderSmooth(gains.data(), 1, count, period, avg_gain.data());
+  wilderSmooth(losses.data(), 1, count, period, avg_loss.data());
+  for (qsizetype i = period; i < count; i++) {
+    double total = avg_gain[i] + avg_loss[i];
+    out[i] = total > 0.0 ? 100.0 * avg_gain[i] / total : 50.0;
+  }
+  return out;
+}
+
+QVector<double> Indicators::atr(const double *high,
+                                const double *low,
+                                const double *close,
+                                qsizetype count,
+                                int period) {
+  QVector<double> out(count, kNaN);
+  if (period < 1 || count < period)
+    return out;
+  std::vector<double> ranges(count);
+  kernels().true_range(high, low, close, count, ranges.data());
+  wilderSmooth(ranges.data(), 0, count, period, out.data());
+  return out;
+}
+
+Indicators::Bands Indicators::bollinger(const double *close, qsizetype count, int period, double width) {
+  Bands bands;
+  bands.middle = QVector<double>(count, kNaN);
+  bands.upper = QVector<double>(count, kNaN);
+  bands.lower = QVector<double>(count, kNaN);
+  if (period < 1 || count < period)
+    return bands;
+  // 以块内第一个值为基准累加，平方和相减时的抵消只与块内的价格漂移有关
+  const IndicatorKernels &k = kernels();
+  std::vector<double> prefix;
+  std::vector<double> squares;
+  forEachPrefixBlock(count, period, [&](qsizetype begin, qsizetype length) {
+    prefixSums(close + begin, length, close[begin], prefix, &squares);
+    k.window_band(prefix.data(),
+                  squares.data(),
+                  length,
+                  period,
+                  close[begin],
+                  width,
+                  bands.middle.data() + begin,
+                  bands.upper.data() + begin,
+                  bands.lower.data() + begin);
+  });
+  return bands;
+}
+
+QVector<double> Indicators::vwap(const double *high,
+                                 const double *low,
+                                 const double *close,
+                                 const double *volume,
+                                 qsizetype count,
+                                 int period) {
+  QVector<double> out(count, kNaN);
+  if (period < 1 || count < period)
+    return out;
+  const IndicatorKernels &k = kernels();
+  std::vector<double> weighted(count);
+  k.typical_volume(high, low, close, volume, count, weighted.data());
+  std::vector<double> num_prefix;
+  std::vector<double> den_prefix;
+  forEachPrefixBlock(count, period, [&](qsizetype begin, qsizetype length) {
+    prefixSums(weighted.data() + begin, length, 0.0, num_prefix);
+    prefixSums(volume + begin, length, 0.0, den_prefix);
+    k.window_ratio(num_prefix.data(), den_prefix.data(), length, period, out.data() + begin);
+  });
+  return out;
+}
@@ -0,0 +1,46 @@
+#ifndef INDICATORS_H
+#define INDICATORS_H
+
+#include <QString>
+#include <QVector>
+
+// 技术指标库：输入为按时间升序的连续double列，输出与输入等长，
+// 窗口尚未填满的位置为NaN。滑动窗口类的计算用前缀和加向量化核心循环，
+// 按CPU支持的指令集在运行时选择 AVX-512 / AVX2 / 标量实现；
+// EMA和Wilder平滑是逐根递推的，保持标量
+class Indicators {
+public:
+  enum class Isa { Scalar, Avx2, Avx512 };
+
+  struct Bands {
+    QVector<double> middle;
+    QVector<double> upper;
+    QVector<double> lower;
+  };
+
+  static Isa detectedIsa(); // CPU支持的最高指令集
+  static Isa activeIsa();
+  // 强制使用某个实现，用于基准测试和结果对照；超出CPU能力时降到detectedIsa
+  static void setActiveIsa(Isa isa);
+  static QString isaName(Isa isa);
+
+  static QVector<double> sma(const double* values, qsizetype count, int period);
+  static QVector<double> ema(const double* values, qsizetype count, int period);
+  static QVector<double> rsi(const double* close, qsizetype count, int period);
+  static QVector<double> atr(const double* high,
+                             const double* low,
+                             const double* close,
+                             qsizetype count,
+                             int period);
+  // 布林带：中轨为SMA，上下轨为中轨 ± width 倍总体标准差
+  static Bands bollinger(const double* close, qsizetype count, int period, double width);
+  // 滚动成交量加权均价，价格取 (high + low + close) / 3
+  static QVector<double> vwap(const double* high,
+                              const double* low,
+                              const double* close,
+                              const double* volume,
+                              qsizetype count,
+                              int period);
+};
+
+#endif // INDICATORS_H
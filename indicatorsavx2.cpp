@@ -0,0 +1,29 @@
+// 本文件以AVX2编译（见CMakeLists.txt），只在CPU支持时由Indicators调用
+#include "indicatorkernelimpl.h"
+
+#include <immintrin.h>
+
+namespace {
+
+struct Avx2Vec {
+  using Type = __m256d;
+  static constexpr int kWidth = 4;
+
+  static Type load(const double *p) { return _mm256_loadu_pd(p); }
+  static void store(double *p, Type v) { _mm256_storeu_pd(p, v); }
+  static Type set1(double v) { return _mm256_set1_pd(v); }
+  static Type add(Type a, Type b) { return _mm256_add_pd(a, b); }
+  static Type sub(Type a, Type b) { return _mm256_sub_pd(a, b); }
+  static Type mul(Type a, Type b) { return _mm256_mul_pd(a, b); }
+  static Type div(Type a, Type b) { return _mm256_div_pd(a, b); }
+  static Type max(Type a, Type b) { return _mm256_max_pd(a, b); }
+  static Type sqrt(Type a) { return _mm256_sqrt_pd(a); }
+  static Type abs(Type a) { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a); }
+  static double scalarSqrt(double a) { return _mm_cvtsd_f64(_mm_sqrt_sd(_mm_setzero_pd(), _mm_set_sd(a))); }
+};
+
+} // namespace
+
+const IndicatorKernels &avx2IndicatorKernels() {
+  return KernelImpl<Avx2Vec>::table("AVX2");
+}
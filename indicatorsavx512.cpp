@@ -0,0 +1,29 @@
+// 本文件以AVX-512F编译（见CMakeLists.txt），只在CPU支持时由Indicators调用
+#include "indicatorkernelimpl.h"
+
+#include <immintrin.h>
+
+namespace {
+
+struct Avx512Vec {
+  using Type = __m512d;
+  static constexpr int kWidth = 8;
+
+  static Type load(const double *p) { return _mm512_loadu_pd(p); }
+  static void store(double *p, Type v) { _mm512_storeu_pd(p, v); }
+  static Type set1(double v) { return _mm512_set1_pd(v); }
+  static Type add(Type a, Type b) { return _mm512_add_pd(a, b); }
+  static Type sub(Type a, Type b) { return _mm512_sub_pd(a, b); }
+  static Type mul(Type a, Type b) { return _mm512_mul_pd(a, b); }
+  static Type div(Type a, Type b) { return _mm512_div_pd(a, b); }
+  static Type max(Type a, Type b) { return _mm512_max_pd(a, b); }
+  static Type sqrt(Type a) { return _mm512_sqrt_pd(a); }
+  static Type abs(Type a) { return _mm512_abs_pd(a); }
+  static double scalarSqrt(double a) { return _mm_cvtsd_f64(_mm_sqrt_sd(_mm_setzero_pd(), _mm_set_sd(a))); }
+};
+
+} // namespace
+
+const IndicatorKernels &avx512IndicatorKernels() {
+  return KernelImpl<Avx512Vec>::table("AVX-512");
+}
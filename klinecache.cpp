@@ -0,0 +1,223 @@
+#include "klinecache.h"
+
+#include <QDateTime>
+#include <QFileInfo>
+#include <QSaveFile>
+
+#include <cstring>
+#include <vector>
+
+namespace {
+
+constexpr char kMagic[8] = {'Q', 'B', 'K', 'L', 'C', 'A', 'C', 'H'};
+constexpr quint32 kVersion = 2;
+constexpr qint64 kAlignment = 64;
+constexpr int kColumnCount = 6;
+constexpr qsizetype kChunkSize = 1 << 16;
+constexpr qint64 kMinHeadroom = 4096; // 每列预留的空位，增量追加时原地写入
+
+// 文件头固定64字节，之后依次是 timestamp/open/high/low/close/volume 六列
+struct CacheHeader {
+  char magic[8];
+  quint32 version;
+  quint32 header_size;
+  qint64 csv_size;
+  qint64 csv_mtime;
+  qint64 count;
+  qint64 column_stride; // 每列占用的字节数（含预留空位和对齐填充）
+  qint64 capacity;      // 每列最多可容纳的K线数
+  qint64 reserved;
+};
+static_assert(sizeof(CacheHeader) == kAlignment, "CacheHeader must keep columns aligned");
+
+qint64 alignUp(qint64 bytes) {
+  return (bytes + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+// 从数组结构中抽出一列，分块写出并补齐到对齐边界
+template<typename T>
+bool writeColumn(QFileDevice &file,
+                 const QVector<KLineData> &data,
+                 qsizetype first,
+                 T KLineData::*field,
+                 qint64 stride) {
+  std::vector<T> chunk(qMin(kChunkSize, qMax<qsizetype>(1, data.size() - first)));
+  for (qsizetype begin = first; begin < data.size(); begin += kChunkSize) {
+    qsizetype n = qMin(kChunkSize, data.size() - begin);
+    for (qsizetype i = 0; i < n; i++) {
+      chunk[i] = data[begin + i].*field;
+    }
+    qint64 bytes = n * qint64(sizeof(T));
+    if (file.write(reinterpret_cast<const char *>(chunk.data()), bytes) != bytes)
+      return false;
+  }
+  if (stride < 0)
+    return true; // 追加时不补齐
+  qint64 padding = stride - data.size() * qint64(sizeof(T));
+  if (padding > 0) {
+    QByteArray zeros(padding, '\0');
+    return file.write(zeros) == padding;
+  }
+  return true;
+}
+
+} // namespace
+
+KLineCache::KLineCache()
+    : mapped_(nullptr) {}
+
+KLineCache::~KLineCache() {
+  close();
+}
+
+QString KLineCache::cachePath(const QString &csv_path) {
+  return csv_path + ".klc";
+}
+
+bool KLineCache::write(const QString &csv_path, const QVector<KLineData> &data) {
+  QFileInfo info(csv_path);
+  if (!info.exists())
+    return false;
+  CacheHeader header{};
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.header_size = sizeof(CacheHeader);
+  header.csv_size = info.size();
+  header.csv_mtime = info.lastModified().toMSecsSinceEpoch();
+  header.count = data.size();
+  header.capacity = data.size() + qMax(data.size() / 16, kMinHeadroom);
+  header.column_stride = alignUp(header.capacity * qint64(sizeof(double)));
+
+  // QSaveFile保证中途失败时不会留下半个缓存文件
+  QSaveFile file(cachePath(csv_path));
+  if (!file.open(QIODevice::WriteOnly))
+    return false;
+  if (file.write(reinterpret_cast<const char *>(&header), sizeof(header)) != qint64(sizeof(header)))
+    return false;
+  const qint64 stride = header.column_stride;
+  bool ok = writeColumn(file, data, 0, &KLineData::timestamp, stride)
+            && writeColumn(file, data, 0, &KLineData::open, stride)
+            && writeColumn(file, data, 0, &KLineData::high, stride)
+            && writeColumn(file, data, 0, &KLineData::low, stride)
+            && writeColumn(file, data, 0, &KLineData::close, stride)
+            && writeColumn(file, data, 0, &KLineData::volume, stride);
+  if (!ok) {
+    file.cancelWriting();
+    return false;
+  }
+  return file.commit();
+}
+
+bool KLineCache::append(const QString &csv_path,
+                        qint64 previous_csv_size,
+                        const QVector<KLineData> &data,
+                        qsizetype first_new) {
+  QFileInfo info(csv_path);
+  QFile file(cachePath(csv_path));
+  CacheHeader header;
+  bool valid = info.exists() && file.open(QIODevice::ReadWrite)
+               && file.read(reinterpret_cast<char *>(&header), sizeof(header))
+                      == qint64(sizeof(header))
+               && std::memcmp(header.magic, kMagic, sizeof(kMagic)) == 0
+               && header.version == kVersion && header.header_size == sizeof(CacheHeader)
+               && header.csv_size == previous_csv_size && header.count == first_new
+               && header.capacity >= data.size()
+               && header.column_stride >= header.capacity * qint64(sizeof(double));
+  if (!valid) {
+    // 缓存与追加前的CSV不一致或空位不够，整体重写
+    file.close();
+    return write(csv_path, data);
+  }
+
+  // 先写入各列的新数据，最后更新文件头；中途失败时文件头仍是旧的，缓存会因CSV大小不符而失效
+  const qint64 stride = header.column_stride;
+  auto seekColumn = [&](int column) {
+    return file.seek(header.header_size + stride * column + first_new * qint64(sizeof(double)));
+  };
+  bool ok = seekColumn(0) && writeColumn(file, data, first_new, &KLineData::timestamp, -1)
+            && seekColumn(1) && writeColumn(file, data, first_new, &KLineData::open, -1)
+            && seekColumn(2) && writeColumn(file, data, first_new, &KLineData::high, -1)
+            && seekColumn(3) && writeColumn(file, data, first_new, &KLineData::low, -1)
+            && seekColumn(4) && writeColumn(file, data, first_new, &KLineData::close, -1)
+            && seekColumn(5) && writeColumn(file, data, first_new, &KLineData::volume, -1);
+  if (!ok)
+    return false;
+  header.count = data.size();
+  header.csv_size = info.size();
+  header.csv_mtime = info.lastModified().toMSecsSinceEpoch();
+  return file.seek(0)
+         && file.write(reinterpret_cast<const char *>(&header), sizeof(header))
+                == qint64(sizeof(header))
+         && file.flush();
+}
+
+bool KLineCache::open(const QString &csv_path) {
+  close();
+  QFileInfo csv(csv_path);
+  file_.setFileName(cachePath(csv_path));
+  if (!csv.exists() || !file_.open(QIODevice::ReadOnly))
+    return false;
+  const qint64 file_size = file_.size();
+  uchar *mapped = file_size >= qint64(sizeof(CacheHeader)) ? file_.map(0, file_size) : nullptr;
+  if (!mapped) {
+    file_.close();
+    return false;
+  }
+  CacheHeader header;
+  std::memcpy(&header, mapped, sizeof(header));
+  bool valid = std::memcmp(header.magic, kMagic, sizeof(kMagic)) == 0
+               && header.version == kVersion && header.header_size == sizeof(CacheHeader)
+               && header.csv_size == csv.size()
+               && header.csv_mtime == csv.lastModified().toMSecsSinceEpoch() && header.count >= 0
+               && header.capacity >= header.count
+               && header.column_stride >= header.capacity * qint64(sizeof(double))
+               && file_size >= qint64(sizeof(CacheHeader)) + header.column_stride * kColumnCount;
+  if (!valid) {
+    file_.unmap(mapped);
+    file_.close();
+    return false;
+  }
+
+  mapped_ = mapped;
+  const uchar *base = mapped + sizeof(CacheHeader);
+  const qint64 stride = header.column_stride;
+  columns_.size = header.count;
+  columns_.timestamp = reinterpret_cast<const qint64 *>(base);
+  columns_.open = reinterpret_cast<const double *>(base + stride);
+  columns_.high = reinterpret_cast<const double *>(base + stride * 2);
+  columns_.low = reinterpret_cast<const double *>(base + stride * 3);
+  columns_.close = reinterpret_cast<const double *>(base + stride * 4);
+  columns_.volume = reinterpret_cast<const double *>(base + stride * 5);
+  return true;
+}
+
+void KLineCache::close() {
+  if (mapped_) {
+    file_.unmap(mapped_);
+    mapped_ = nullptr;
+  }
+  if (file_.isOpen())
+    file_.close();
+  columns_ = KLineColumns();
+}
+
+void KLineCache::toKLineData(QVector<KLineData> &out) const {
+  toKLineData(0, columns_.size, out);
+}
+
+void KLineCache::toKLineData(qsizetype first, qsizetype count, QVector<KLineData> &out) const {
+  first = qBound<qsizetype>(0, first, columns_.size);
+  count = qBound<qsizetype>(0, count, columns_.size - first);
+  out.clear();
+  out.resize(count);
+  KLineData *dst = out.data();
+  for (qsizetype i = 0; i < count; i++) {
+    const qsizetype j = first + i;
+    dst[i].timestamp = columns_.timestamp[j];
+    dst[i].open = columns_.open[j];
+    dst[i].high = columns_.high[j];
+    dst[i].low = columns_.low[j];
+    dst[i].close = columns_.close[j];
+    dst[i].volume = columns_.volume[j];
+  }
+}
@@ -0,0 +1,51 @@
+#ifndef KLINECACHE_H
+#define KLINECACHE_H
+
+#include "klinedata.h"
+
+#include <QFile>
+#include <QString>
+#include <QVector>
+
+// 列式视图：每一列都是连续且64字节对齐的数组
+struct KLineColumns {
+  qsizetype size = 0;
+  const qint64* timestamp = nullptr;
+  const double* open = nullptr;
+  const double* high = nullptr;
+  const double* low = nullptr;
+  const double* close = nullptr;
+  const double* volume = nullptr;
+};
+
+// CSV旁的二进制缓存(<csv>.klc)，CSV的大小和修改时间不变时直接映射使用。
+// 每列末尾留有空位，增量更新时可以原地追加；映射中的缓存需先close()再追加
+class KLineCache {
+public:
+  KLineCache();
+  ~KLineCache();
+
+  static QString cachePath(const QString& csv_path);
+  // 按列写出缓存，记录CSV当前的大小和修改时间
+  static bool write(const QString& csv_path, const QVector<KLineData>& data);
+  // CSV末尾追加K线后同步缓存：缓存与追加前的CSV一致且空位足够时只写入新增部分，
+  // 否则整体重写。data为追加后的全部K线，first_new为第一根新K线的下标
+  static bool append(const QString& csv_path,
+                     qint64 previous_csv_size,
+                     const QVector<KLineData>& data,
+                     qsizetype first_new);
+
+  bool open(const QString& csv_path); // 缓存存在且与CSV匹配时映射成功
+  void close();
+  bool isOpen() const { return mapped_ != nullptr; }
+  const KLineColumns& columns() const { return columns_; }
+  void toKLineData(QVector<KLineData>& out) const;
+  void toKLineData(qsizetype first, qsizetype count, QVector<KLineData>& out) const; // 从first起取count根
+
+private:
+  QFile file_;
+  uchar* mapped_;
+  KLineColumns columns_;
+};
+
+#endif // KLINECACHE_H
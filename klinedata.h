@@ -0,0 +1,23 @@
+#ifndef KLINEDATA_H
+#define KLINEDATA_H
+
+#include <QtGlobal>
+
+struct KLineData {
+  qint64 timestamp;
+  double open;
+  double high;
+  double low;
+  double close;
+  double volume;
+};
+
+enum class SignalType { Buy, Sell };
+
+struct TradeSignal {
+  qint64 timestamp;
+  double price;
+  SignalType type;
+};
+
+#endif // KLINEDATA_H
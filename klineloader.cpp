@@ -0,0 +1,251 @@
+#include "klineloader.h"
+#include "profiler.h"
+
+#include <QByteArray>
+#include <QDebug>
+#include <QFile>
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <limits>
+#include <string_view>
+
+namespace {
+
+// 后台加载时每解析这么多字节检查一次取消并报告进度
+constexpr qsizetype kParseChunkBytes = 8 << 20;
+// 预估行长时取样的字节数
+constexpr qsizetype kSampleBytes = 64 << 10;
+
+inline bool isBlank(char c) {
+  return c == ' ' || c == '\t';
+}
+
+// 去掉字段首尾空白
+inline void trimField(const char *&begin, const char *&end) {
+  while (begin < end && isBlank(*begin))
+    ++begin;
+  while (end > begin && isBlank(end[-1]))
+    --end;
+  if (begin < end && *begin == '+')
+    ++begin;
+}
+
+inline const char *findComma(const char *p, const char *end) {
+  const void *comma = std::memchr(p, ',', end - p);
+  return comma ? static_cast<const char *>(comma) : end;
+}
+
+// 整个字段都能被解析才算成功，与QString::toLongLong/toDouble的行为一致
+template<typename T>
+inline bool parseNumber(const char *begin, const char *end, T &value) {
+  trimField(begin, end);
+  auto [ptr, ec] = std::from_chars(begin, end, value);
+  return ec == std::errc() && ptr == end;
+}
+
+// 解析一行，至少需要6个字段；多余的字段（如datetime）直接忽略
+bool parseLine(const char *p, const char *end, KLineData &d) {
+  const char *field_end = findComma(p, end);
+  if (field_end == end || !parseNumber(p, field_end, d.timestamp))
+    return false;
+  double *values[] = {&d.open, &d.high, &d.low, &d.close, &d.volume};
+  for (int i = 0; i < 5; i++) {
+    p = field_end + 1;
+    field_end = findComma(p, end);
+    if (field_end == end && i < 4)
+      return false;
+    if (!parseNumber(p, field_end, *values[i]))
+      *values[i] = 0.0; // 与旧实现toDouble失败时返回0保持一致
+  }
+  return true;
+}
+
+inline const char *findLineEnd(const char *p, const char *end) {
+  const void *eol = std::memchr(p, '\n', end - p);
+  return eol ? static_cast<const char *>(eol) : end;
+}
+
+} // namespace
+
+bool KLineLoader::parseRows(const char *p, const char *end, QVector<KLineData> &out) {
+  // 按换行数一次性预留，解析过程中不再扩容
+  out.reserve(out.size() + std::count(p, end, '\n') + 1);
+  bool ascending = true;
+  qint64 last_timestamp = std::numeric_limits<qint64>::min();
+  KLineData d;
+  while (p < end) {
+    const char *eol = findLineEnd(p, end);
+    const char *line_end = (eol > p && eol[-1] == '\r') ? eol - 1 : eol;
+    if (parseLine(p, line_end, d)) {
+      ascending = ascending && d.timestamp >= last_timestamp;
+      last_timestamp = d.timestamp;
+      out.append(d);
+    }
+    p = eol + 1;
+  }
+  return ascending;
+}
+
+bool KLineLoader::loadCsv(const QString &file_path,
+                          QVector<KLineData> &out,
+                          const std::atomic<bool> *cancelled,
+                          const std::function<void(int)> &progress) {
+  ProfileScope scope("csv.load");
+  out.clear();
+  QFile file(file_path);
+  if (!file.open(QIODevice::ReadOnly)) {
+    qDebug() << "无法打开文件:" << file_path;
+    return false;
+  }
+  const qint64 size = file.size();
+  if (size <= 0)
+    return false;
+  if (uchar *mapped = file.map(0, size)) {
+    const char *begin = reinterpret_cast<const char *>(mapped);
+    bool ok = parseCsv(begin, begin + size, out, cancelled, progress);
+    file.unmap(mapped);
+    return ok;
+  }
+  // 某些文件系统不支持映射，退回一次性读入
+  QByteArray bytes = file.readAll();
+  return parseCsv(bytes.constData(), bytes.constData() + bytes.size(), out, cancelled, progress);
+}
+
+bool KLineLoader::parseCsv(const char *begin,
+                           const char *end,
+                           QVector<KLineData> &out,
+                           const std::atomic<bool> *cancelled,
+                           const std::function<void(int)> &progress) {
+  out.clear();
+  const char *p = begin;
+  if (end - p >= 3 && std::memcmp(p, "\xEF\xBB\xBF", 3) == 0)
+    p += 3;
+  const char *header_end = findLineEnd(p, end);
+  if (std::string_view(p, header_end - p).find("timestamp") == std::string_view::npos) {
+    qDebug() << "CSV文件缺少表头";
+    return false;
+  }
+  p = header_end < end ? header_end + 1 : end;
+  const char *const rows = p;
+  bool ascending = true;
+  {
+    ProfileScope scope("csv.parse");
+    // 按开头一段的平均行长预留，分块解析时基本不再扩容
+    const qsizetype sample = qMin<qsizetype>(end - p, kSampleBytes);
+    const qsizetype sample_lines = std::count(p, p + sample, '\n') + 1;
+    out.reserve(qsizetype(double(end - p) * sample_lines / qMax<qsizetype>(sample, 1)) + 16);
+    while (p < end) {
+      const char *chunk_end = end - p > kParseChunkBytes ? findLineEnd(p + kParseChunkBytes, end) : end;
+      if (chunk_end < end)
+        ++chunk_end;
+      const qsizetype first = out.size();
+      // 预估偏小时按倍数扩容，避免parseRows每块按精确数量重新分配
+      const qsizetype lines = std::count(p, chunk_end, '\n') + 1;
+      if (out.capacity() < first + lines)
+        out.reserve(qMax(out.capacity() * 2, first + lines));
+      ascending = parseRows(p, chunk_end, out) && ascending;
+      if (first > 0 && first < out.size() && out[first].timestamp < out[first - 1].timestamp)
+        ascending = false;
+      p = chunk_end;
+      if (cancelled && cancelled->load(std::memory_order_relaxed)) {
+        out.clear();
+        return false;
+      }
+      if (progress)
+        progress(int((p - rows) * 1000 / qMax<qint64>(end - rows, 1)));
+    }
+  }
+  // 下载脚本输出已是升序，此时跳过排序
+  if (!ascending) {
+    ProfileScope scope("csv.sort");
+    std::sort(out.begin(), out.end(), [](const KLineData &a, const KLineData &b) {
+      return a.timestamp < b.timestamp;
+    });
+  }
+  return !out.isEmpty();
+}
+
+bool KLineLoader::loadCsvTail(const QString &file_path, qint64 offset, QVector<KLineData> &out) {
+  QFile file(file_path);
+  if (!file.open(QIODevice::ReadOnly))
+    return false;
+  const qint64 size = file.size() - offset;
+  if (offset < 0 || size < 0)
+    return false;
+  if (size == 0)
+    return true;
+  if (uchar *mapped = file.map(offset, size)) {
+    const char *begin = reinterpret_cast<const char *>(mapped);
+    parseRows(begin, begin + size, out);
+    file.unmap(mapped);
+    return true;
+  }
+  if (!file.seek(offset))
+    return false;
+  QByteArray bytes = file.readAll();
+  parseRows(bytes.constData(), bytes.constData() + bytes.size(), out);
+  return true;
+}
+
+bool KLineLoader::loadCsvLast(const QString &file_path, qsizetype count, QVector<KLineData> &out) {
+  out.clear();
+  QFile file(file_path);
+  if (!file.open(QIODevice::ReadOnly) || count <= 0)
+    return false;
+  const qint64 size = file.size();
+  // 按每行约128字节估算读取量，行数不够时加倍重读，直到读到文件开头
+  qint64 window = qMax<qint64>(count * 128, 4096);
+  for (;;) {
+    const qint64 offset = qMax<qint64>(0, size - window);
+    if (!file.seek(offset))
+      return false;
+    const QByteArray bytes = file.read(size - offset);
+    const char *p = bytes.constData();
+    const char *end = p + bytes.size();
+    if (offset > 0) {
+      // 第一行可能不完整，跳过；从文件开头读时表头解析失败会被忽略
+      p = findLineEnd(p, end);
+      if (p < end)
+        ++p;
+    }
+    out.clear();
+    if (!parseRows(p, end, out)) {
+      std::sort(out.begin(), out.end(), [](const KLineData &a, const KLineData &b) {
+        return a.timestamp < b.timestamp;
+      });
+    }
+    if (out.size() >= count || offset == 0)
+      break;
+    window *= 2;
+  }
+  if (out.size() > count)
+    out.remove(0, out.size() - count);
+  return !out.isEmpty();
+}
+
+bool KLineLoader::readLastTimestamp(const QString &file_path, qint64 &timestamp) {
+  QFile file(file_path);
+  if (!file.open(QIODevice::ReadOnly))
+    return false;
+  // 一行K线不超过几百字节，4KB足够包含最后一个完整行
+  const qint64 tail = qMin<qint64>(file.size(), 4096);
+  if (!file.seek(file.size() - tail))
+    return false;
+  QByteArray bytes = file.read(tail);
+  const char *begin = bytes.constData();
+  const char *end = begin + bytes.size();
+  while (end > begin && (end[-1] == '\n' || end[-1] == '\r'))
+    --end;
+  const char *line = end;
+  while (line > begin && line[-1] != '\n')
+    --line;
+  if (line == begin && tail < file.size())
+    return false; // 没有找到完整的一行
+  KLineData d;
+  if (!parseLine(line, end, d))
+    return false;
+  timestamp = d.timestamp;
+  return true;
+}
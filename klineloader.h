@@ -0,0 +1,37 @@
+#ifndef KLINELOADER_H
+#define KLINELOADER_H
+
+#include "klinedata.h"
+
+#include <QString>
+#include <QVector>
+
+#include <atomic>
+#include <functional>
+
+// CSV K线加载器：整文件映射到内存，用std::from_chars原地解析，不产生逐行的QString
+class KLineLoader {
+public:
+  // 读取 timestamp,open,high,low,close,volume[,...] 格式的CSV，结果按时间升序。
+  // 按块解析，每块之后检查cancelled，置位时返回false；progress为已解析的千分比，在调用线程中回调
+  static bool loadCsv(const QString& file_path,
+                      QVector<KLineData>& out,
+                      const std::atomic<bool>* cancelled = nullptr,
+                      const std::function<void(int)>& progress = {});
+  // 解析已在内存中的CSV文本（含表头）
+  static bool parseCsv(const char* begin,
+                       const char* end,
+                       QVector<KLineData>& out,
+                       const std::atomic<bool>* cancelled = nullptr,
+                       const std::function<void(int)>& progress = {});
+  // 解析不含表头的数据行并追加到out，返回追加部分是否保持升序
+  static bool parseRows(const char* begin, const char* end, QVector<KLineData>& out);
+  // 从offset处（某一行的开头）读到文件末尾，只解析数据行，结果追加到out之后
+  static bool loadCsvTail(const QString& file_path, qint64 offset, QVector<KLineData>& out);
+  // 只读文件末尾，取最后count根K线（升序），读取量与文件大小无关
+  static bool loadCsvLast(const QString& file_path, qsizetype count, QVector<KLineData>& out);
+  // 只读文件末尾一小块，取最后一行的时间戳
+  static bool readLastTimestamp(const QString& file_path, qint64& timestamp);
+};
+
+#endif // KLINELOADER_H
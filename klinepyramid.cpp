@@ -0,0 +1,210 @@
+#include "klinepyramid.h"
+
+#include <algorithm>
+#include <iterator>
+#include <limits>
+
+namespace {
+
+struct Timeframe {
+  const char *name;
+  qint64 msecs;
+};
+
+// 金字塔的标准周期，每一级都是上一级的整数倍
+constexpr Timeframe kTimeframes[] = {{"1m", 60000LL},
+                                     {"5m", 300000LL},
+                                     {"15m", 900000LL},
+                                     {"1h", 3600000LL},
+                                     {"4h", 14400000LL},
+                                     {"1d", 86400000LL}};
+
+inline qint64 bucketStart(qint64 timestamp, qint64 msecs) {
+  qint64 rem = timestamp % msecs;
+  return timestamp - (rem < 0 ? rem + msecs : rem);
+}
+
+} // namespace
+
+qint64 KLinePyramid::timeframeMsecs(const QString &name) {
+  for (const Timeframe &timeframe : kTimeframes) {
+    if (name == QLatin1String(timeframe.name))
+      return timeframe.msecs;
+  }
+  return 0;
+}
+
+bool KLinePyramid::parseInterval(const QString &text, qint64 &msecs) {
+  static const struct {
+    QChar unit;
+    qint64 msecs;
+  } kUnits[] = {{'s', 1000LL}, {'m', 60000LL}, {'h', 3600000LL}, {'d', 86400000LL}};
+  if (text.size() < 2)
+    return false;
+  bool ok = false;
+  const qint64 count = text.left(text.size() - 1).toLongLong(&ok);
+  if (!ok || count <= 0)
+    return false;
+  for (const auto &unit : kUnits) {
+    if (text.back() == unit.unit) {
+      msecs = count * unit.msecs;
+      return true;
+    }
+  }
+  return false;
+}
+
+qint64 KLinePyramid::detectInterval(const QVector<KLineData> &bars) {
+  qint64 interval = std::numeric_limits<qint64>::max();
+  for (qsizetype i = 1; i < bars.size(); i++) {
+    qint64 diff = bars[i].timestamp - bars[i - 1].timestamp;
+    if (diff > 0 && diff < interval)
+      interval = diff;
+  }
+  return interval == std::numeric_limits<qint64>::max() ? 0 : interval;
+}
+
+void KLinePyramid::aggregate(const KLineData *bars,
+                             qsizetype count,
+                             qint64 msecs,
+                             QVector<KLineData> &out) {
+  if (count == 0)
+    return;
+  // 合并后的数量无法精确预知，按首尾时间跨度估算一次预留
+  qint64 span = bars[count - 1].timestamp - bars[0].timestamp;
+  out.reserve(out.size() + qMin<qint64>(count, span / msecs + 2));
+  KLineData current = bars[0];
+  current.timestamp = bucketStart(bars[0].timestamp, msecs);
+  for (qsizetype i = 1; i < count; i++) {
+    const KLineData &bar = bars[i];
+    const qint64 bucket = bucketStart(bar.timestamp, msecs);
+    if (bucket != current.timestamp) {
+      out.append(current);
+      current = bar;
+      current.timestamp = bucket;
+      continue;
+    }
+    current.high = qMax(current.high, bar.high);
+    current.low = qMin(current.low, bar.low);
+    current.close = bar.close;
+    current.volume += bar.volume;
+  }
+  out.append(current);
+}
+
+void KLinePyramid::build(const QVector<KLineData> &base,
+                         const std::atomic<bool> *cancelled,
+                         qint64 max_msecs) {
+  auto stopped = [&] {
+    if (!cancelled || !cancelled->load(std::memory_order_relaxed))
+      return false;
+    levels_.clear();
+    return true;
+  };
+  levels_.clear();
+  if (base.isEmpty())
+    return;
+  const qint64 interval = detectInterval(base);
+  Level root;
+  root.name = "原始";
+  root.msecs = interval > 0 ? interval : kTimeframes[std::size(kTimeframes) - 1].msecs;
+  for (const Timeframe &timeframe : kTimeframes) {
+    if (timeframe.msecs == root.msecs)
+      root.name = timeframe.name;
+  }
+  root.bars = base; // 隐式共享，不复制
+  levels_.append(root);
+
+  for (const Timeframe &timeframe : kTimeframes) {
+    if (max_msecs >= 0 && timeframe.msecs > max_msecs)
+      break;
+    if (timeframe.msecs <= root.msecs || timeframe.msecs % root.msecs != 0)
+      continue;
+    // 从能整除的最近一层继续合并，数据量逐层缩小
+    const Level *source = &levels_[0];
+    for (const Level &level : std::as_const(levels_)) {
+      if (timeframe.msecs % level.msecs == 0)
+        source = &level;
+    }
+    Level level;
+    level.name = timeframe.name;
+    level.msecs = timeframe.msecs;
+    aggregate(source->bars.constData(), source->bars.size(), timeframe.msecs, level.bars);
+    levels_.append(level);
+    if (stopped())
+      return;
+  }
+  for (qsizetype i = 0; i < levels_.size(); i++) {
+    if (stopped())
+      return;
+    levels_[i].index.build(levels_[i].bars);
+  }
+  stopped();
+}
+
+void KLinePyramid::append(const QVector<KLineData> &base, qsizetype first_new) {
+  if (levels_.isEmpty() || first_new <= 0) {
+    build(base);
+    return;
+  }
+  // 新K线的间隔比原始层的周期还小（如建时只有一根K线，周期是按默认值取的），各层的划分都变了，整体重建
+  for (qsizetype i = first_new; i < base.size(); i++) {
+    const qint64 diff = base[i].timestamp - base[i - 1].timestamp;
+    if (diff > 0 && diff < levels_[0].msecs) {
+      build(base);
+      return;
+    }
+  }
+  for (qsizetype i = 0; i < levels_.size(); i++) {
+    Level &level = levels_[i];
+    level.indicators_.reset();
+    if (i == 0) {
+      level.bars = base;
+      appendIndex(level, qMin(first_new, level.index.size()));
+      continue;
+    }
+    const Level *source = &levels_[0];
+    for (qsizetype j = 0; j < i; j++) {
+      if (level.msecs % levels_[j].msecs == 0)
+        source = &levels_[j];
+    }
+    // 最后一个桶可能不完整，去掉后从它的起点开始重新合并
+    qint64 from = level.bars.isEmpty() ? std::numeric_limits<qint64>::min()
+                                       : level.bars.last().timestamp;
+    if (!level.bars.isEmpty())
+      level.bars.removeLast();
+    const KLineData *begin = source->bars.constData();
+    const KLineData *end = begin + source->bars.size();
+    const KLineData *it = std::lower_bound(begin, end, from, [](const KLineData &bar, qint64 value) {
+      return bar.timestamp < value;
+    });
+    const qsizetype kept = level.bars.size();
+    aggregate(it, end - it, level.msecs, level.bars);
+    appendIndex(level, kept);
+  }
+}
+
+void KLinePyramid::appendIndex(Level &level, qsizetype kept) {
+  level.index.truncate(kept);
+  for (qsizetype i = level.index.size(); i < level.bars.size(); i++)
+    level.index.append(level.bars[i]);
+}
+
+std::shared_ptr<IndicatorCache> KLinePyramid::Level::indicators() const {
+  std::shared_ptr<IndicatorCache> cache = std::atomic_load(&indicators_);
+  if (cache)
+    return cache;
+  // 并发的首次请求可能各建一份，只保留先存入的那份
+  auto created = std::make_shared<IndicatorCache>(bars);
+  if (std::atomic_compare_exchange_strong(&indicators_, &cache, created))
+    return created;
+  return cache;
+}
+
+int KLinePyramid::findLevel(const QString &name) const {
+  for (qsizetype i = 0; i < levels_.size(); i++) {
+    if (levels_[i].name == name)
+      return int(i);
+  }
+  return -1;
+}
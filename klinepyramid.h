@@ -0,0 +1,69 @@
+#ifndef KLINEPYRAMID_H
+#define KLINEPYRAMID_H
+
+#include "indicatorcache.h"
+#include "klinedata.h"
+#include "rangeindex.h"
+
+#include <QString>
+#include <QVector>
+
+#include <atomic>
+#include <memory>
+
+// 多周期K线金字塔：第0层为原始数据，之后按 1m→5m→15m→1h→4h→1d 逐层合并
+// （开盘取首根、收盘取末根、最高/最低取极值、成交量求和），每层附带区间最值索引。
+// 加载时由上一层整体合并一次，之后切换周期、缩放和回测都直接使用内存中的结果
+class KLinePyramid {
+public:
+  struct Level {
+    QString name; // 周期名称，如"1h"；原始数据不是标准周期时为"原始"
+    qint64 msecs = 0;
+    QVector<KLineData> bars;
+    RangeIndex index; // 最低价/最高价的区间最值
+
+    // 本层的指标缓存，第一次用到时才把K线拆成列；数据变化后丢弃，下次使用时重建。
+    // 可在多个线程中同时调用，但不能与修改本层数据的操作同时进行
+    std::shared_ptr<IndicatorCache> indicators() const;
+
+  private:
+    friend class KLinePyramid;
+    mutable std::shared_ptr<IndicatorCache> indicators_;
+  };
+
+  // 标准周期名称（如"1h"）对应的毫秒数，不是标准周期时返回0
+  static qint64 timeframeMsecs(const QString& name);
+  // 解析"30s"、"1m"、"4h"、"1d"这类周期（数量任意），失败返回false
+  static bool parseInterval(const QString& text, qint64& msecs);
+  // 相邻K线的最小正间隔，作为原始数据的周期
+  static qint64 detectInterval(const QVector<KLineData>& bars);
+  // 把按时间升序的K线合并到msecs周期，桶起点按UTC对齐
+  static void aggregate(const KLineData* bars,
+                        qsizetype count,
+                        qint64 msecs,
+                        QVector<KLineData>& out);
+
+  // cancelled置位后在层与层之间停下并清空，供后台加载中途取消。
+  // max_msecs不小于0时只建周期不超过它的层（原始数据层总是建），只用一个周期时省去其余各层
+  void build(const QVector<KLineData>& base,
+             const std::atomic<bool>* cancelled = nullptr,
+             qint64 max_msecs = -1);
+  // base末尾追加了K线（first_new起）后只重算各层最后一个桶及之后的部分，
+  // 区间最值索引只替换和追加这些K线，指标缓存丢弃后按需重建。
+  // first_new起也可以是改写过的旧K线（未收盘的最后一根更新）；新K线的间隔小于原始层周期时整体重建
+  void append(const QVector<KLineData>& base, qsizetype first_new);
+  void clear() { levels_.clear(); }
+
+  int levelCount() const { return int(levels_.size()); }
+  const Level& level(int index) const { return levels_[index]; }
+  const QVector<KLineData>& bars(int index) const { return levels_[index].bars; }
+  int findLevel(const QString& name) const; // 找不到时返回-1
+
+private:
+  // 索引只保留前kept根，之后的K线（新合并或替换的最后一桶）逐根追加
+  static void appendIndex(Level& level, qsizetype kept);
+
+  QVector<Level> levels_;
+};
+
+#endif // KLINEPYRAMID_H
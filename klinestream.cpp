@@ -0,0 +1,189 @@
+#include "klinestream.h"
+#include "klineloader.h"
+#include "profiler.h"
+
+#include <QByteArray>
+#include <QFile>
+#include <QMutexLocker>
+#include <QThread>
+
+#include <cstring>
+#include <limits>
+
+KLineStream::KLineStream(qint64 block_bytes)
+    : block_bytes_(qMax<qint64>(block_bytes, 4096))
+    , read_index_(0)
+    , write_index_(0)
+    , current_(nullptr)
+    , finished_(false)
+    , thread_(nullptr)
+    , stopping_(false)
+    , file_size_(0)
+    , bytes_consumed_(0)
+    , skipped_rows_(0) {}
+
+KLineStream::~KLineStream() {
+  close();
+}
+
+bool KLineStream::open(const QString &csv_path) {
+  close();
+  QFile probe(csv_path);
+  if (!probe.open(QIODevice::ReadOnly)) {
+    error_ = "无法打开文件: " + csv_path;
+    return false;
+  }
+  file_size_ = probe.size();
+  probe.close();
+  error_.clear();
+  bytes_consumed_ = 0;
+  skipped_rows_ = 0;
+  read_index_ = write_index_ = 0;
+  current_ = nullptr;
+  finished_ = false;
+  for (Block &block : blocks_) {
+    block.full = false;
+    block.last = false;
+  }
+  stopping_ = false;
+  thread_ = QThread::create([this, csv_path] { readLoop(csv_path); });
+  thread_->start();
+  return true;
+}
+
+void KLineStream::close() {
+  if (!thread_)
+    return;
+  {
+    QMutexLocker locker(&mutex_);
+    stopping_ = true;
+    block_free_.wakeAll();
+  }
+  thread_->wait();
+  delete thread_;
+  thread_ = nullptr;
+}
+
+const QVector<KLineData> *KLineStream::next() {
+  if (!thread_ || finished_)
+    return nullptr;
+  QMutexLocker locker(&mutex_);
+  if (current_) {
+    // 上一块用完，归还给后台线程
+    bool was_last = current_->last;
+    current_->full = false;
+    current_->bars.clear();
+    current_ = nullptr;
+    block_free_.wakeAll();
+    if (was_last) {
+      finished_ = true;
+      return nullptr;
+    }
+  }
+  Block &block = blocks_[read_index_];
+  if (!block.full) {
+    // 等待说明读盘跟不上回测
+    ProfileScope scope("stream.wait");
+    while (!block.full)
+      block_ready_.wait(&mutex_);
+  }
+  read_index_ ^= 1;
+  bytes_consumed_ = block.end_offset;
+  current_ = &block;
+  if (block.bars.isEmpty() && block.last) {
+    current_->full = false;
+    current_ = nullptr;
+    finished_ = true;
+    return nullptr;
+  }
+  return &block.bars;
+}
+
+KLineStream::Block *KLineStream::acquireFree() {
+  QMutexLocker locker(&mutex_);
+  Block *block = &blocks_[write_index_];
+  while (block->full && !stopping_)
+    block_free_.wait(&mutex_);
+  if (stopping_)
+    return nullptr;
+  write_index_ ^= 1;
+  return block;
+}
+
+void KLineStream::publish(Block *block, bool last) {
+  QMutexLocker locker(&mutex_);
+  block->last = last;
+  block->full = true;
+  block_ready_.wakeAll();
+}
+
+void KLineStream::readLoop(const QString &csv_path) {
+  QFile file(csv_path);
+  Block *block = acquireFree();
+  if (!block)
+    return;
+  if (!file.open(QIODevice::ReadOnly)) {
+    QMutexLocker locker(&mutex_);
+    error_ = "无法打开文件: " + csv_path;
+    locker.unlock();
+    publish(block, true);
+    return;
+  }
+  QByteArray buffer;       // 本次读入的数据，开头是上一块剩下的半行
+  qint64 offset = 0;       // buffer开头对应的文件位置
+  bool header_done = false;
+  qint64 last_timestamp = std::numeric_limits<qint64>::min();
+  while (block) {
+    QByteArray chunk = file.read(block_bytes_);
+    const bool at_end = chunk.isEmpty() || file.atEnd();
+    buffer.append(chunk);
+    const char *begin = buffer.constData();
+    const char *end = begin + buffer.size();
+    // 只解析到最后一个完整行，剩下的半行留给下一块
+    const char *parse_end = end;
+    if (!at_end) {
+      const char *p = end;
+      while (p > begin && p[-1] != '\n')
+        --p;
+      parse_end = p;
+    }
+    const char *p = begin;
+    if (!header_done && parse_end > begin) {
+      if (parse_end - p >= 3 && std::memcmp(p, "\xEF\xBB\xBF", 3) == 0)
+        p += 3;
+      const void *eol = std::memchr(p, '\n', parse_end - p);
+      const char *header_end = eol ? static_cast<const char *>(eol) : parse_end;
+      if (!QByteArray(p, header_end - p).contains("timestamp")) {
+        QMutexLocker locker(&mutex_);
+        error_ = "CSV文件缺少表头: " + csv_path;
+        locker.unlock();
+        publish(block, true);
+        return;
+      }
+      p = eol ? header_end + 1 : parse_end;
+      header_done = true;
+    }
+    KLineLoader::parseRows(p, parse_end, block->bars);
+    // 原地去掉不递增的行，保证输出严格升序
+    qsizetype kept = 0;
+    KLineData *bars = block->bars.data();
+    for (qsizetype i = 0; i < block->bars.size(); i++) {
+      if (bars[i].timestamp <= last_timestamp)
+        continue;
+      last_timestamp = bars[i].timestamp;
+      bars[kept++] = bars[i];
+    }
+    if (kept < block->bars.size()) {
+      skipped_rows_ += block->bars.size() - kept;
+      block->bars.resize(kept);
+    }
+    const qint64 consumed = parse_end - begin;
+    offset += consumed;
+    block->end_offset = offset;
+    buffer.remove(0, consumed);
+    publish(block, at_end);
+    if (at_end)
+      return;
+    block = acquireFree();
+  }
+}
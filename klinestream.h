@@ -0,0 +1,65 @@
+#ifndef KLINESTREAM_H
+#define KLINESTREAM_H
+
+#include "klinedata.h"
+
+#include <QMutex>
+#include <QString>
+#include <QVector>
+#include <QWaitCondition>
+
+#include <atomic>
+
+class QThread;
+
+// 分块读取CSV：后台线程按固定字节数读入并解析，两块缓冲轮流使用，
+// 调用方处理当前块时下一块已在读取。内存占用只与块大小有关，与文件大小无关。
+// 文件须按时间升序，时间戳不大于上一根的行被丢弃并计数
+class KLineStream {
+public:
+  static constexpr qint64 kDefaultBlockBytes = 8 << 20;
+
+  explicit KLineStream(qint64 block_bytes = kDefaultBlockBytes);
+  ~KLineStream();
+
+  bool open(const QString& csv_path);
+  void close();
+  // 返回下一块K线，nullptr表示结束或出错；返回的块在下一次调用前有效
+  const QVector<KLineData>* next();
+
+  bool hasError() const { return !error_.isEmpty(); }
+  const QString& errorString() const { return error_; }
+  qint64 fileSize() const { return file_size_; }
+  qint64 bytesConsumed() const { return bytes_consumed_; } // 已交给调用方的块对应的字节数
+  qint64 skippedRows() const { return skipped_rows_; }
+
+private:
+  struct Block {
+    QVector<KLineData> bars;
+    qint64 end_offset = 0; // 该块最后一行之后的文件位置
+    bool full = false;
+    bool last = false;
+  };
+
+  void readLoop(const QString& csv_path); // 在后台线程执行
+  Block* acquireFree();                   // 后台线程等待一块空闲缓冲
+  void publish(Block* block, bool last);
+
+  const qint64 block_bytes_;
+  Block blocks_[2];
+  int read_index_;  // 调用方下一次取的块
+  int write_index_; // 后台线程下一次填的块
+  Block* current_;  // 已交给调用方的块，下一次next()时归还
+  bool finished_;   // 最后一块已归还，之后的next()直接返回nullptr
+  QMutex mutex_;
+  QWaitCondition block_ready_;
+  QWaitCondition block_free_;
+  QThread* thread_;
+  std::atomic<bool> stopping_;
+  QString error_;
+  qint64 file_size_;
+  qint64 bytes_consumed_;
+  std::atomic<qint64> skipped_rows_;
+};
+
+#endif // KLINESTREAM_H
@@ -0,0 +1,330 @@
+#include "livefeed.h"
+
+#include "klineloader.h"
+#include "klinestream.h"
+#include "profiler.h"
+
+#include <QFileInfo>
+#include <QTcpSocket>
+#include <QThread>
+
+#include <cmath>
+#include <limits>
+
+namespace {
+
+constexpr int kConnectTimeoutMs = 3000;
+constexpr int kPollMs = 100;             // 等待数据时检查停止标志的间隔
+constexpr qint64 kMaxSleepNs = 10000000; // 回放等待时每次最多睡10毫秒，便于及时停止
+
+// 等待另一端线程：先自旋，再让出时间片，最后短暂睡眠。
+// 有数据时延迟只有自旋的开销，空闲时不占满CPU
+class Backoff {
+public:
+  void wait() {
+    if (spins_ < 64) {
+      spins_++;
+    } else if (spins_ < 1024) {
+      spins_++;
+      QThread::yieldCurrentThread();
+    } else {
+      QThread::usleep(100);
+    }
+  }
+  void reset() { spins_ = 0; }
+
+private:
+  int spins_ = 0;
+};
+
+BacktestConfig withoutEquityCurve(BacktestConfig config) {
+  config.record_equity_curve = false; // 实时运行时间不定，权益由界面按结果自己记录
+  return config;
+}
+
+} // namespace
+
+bool LiveFeedConfig::parseSource(const QString &text, LiveFeedConfig &config, QString &error) {
+  static const QString kTcpPrefix = QStringLiteral("tcp://");
+  if (!text.startsWith(kTcpPrefix)) {
+    if (!QFileInfo::exists(text)) {
+      error = "回放文件不存在: " + text;
+      return false;
+    }
+    config.source = Source::Replay;
+    config.file_path = text;
+    return true;
+  }
+  const QString address = text.mid(kTcpPrefix.size());
+  const qsizetype colon = address.lastIndexOf(':');
+  bool ok = false;
+  const uint port = colon > 0 ? address.mid(colon + 1).toUInt(&ok) : 0;
+  if (!ok || port == 0 || port > 65535) {
+    error = "行情服务地址应为 tcp://host:port: " + text;
+    return false;
+  }
+  config.source = Source::Socket;
+  config.host = address.left(colon);
+  config.port = quint16(port);
+  return true;
+}
+
+LatencyStats::LatencyStats()
+    : buckets_(kMaxMicros + 1, 0)
+    , count_(0)
+    , total_ns_(0)
+    , last_ns_(0)
+    , max_ns_(0) {}
+
+void LatencyStats::add(qint64 ns) {
+  buckets_[qBound<qint64>(0, ns / 1000, kMaxMicros)]++;
+  count_++;
+  total_ns_ += ns;
+  last_ns_ = ns;
+  max_ns_ = qMax(max_ns_, ns);
+}
+
+void LatencyStats::clear() {
+  buckets_.fill(0);
+  count_ = 0;
+  total_ns_ = 0;
+  last_ns_ = 0;
+  max_ns_ = 0;
+}
+
+qint64 LatencyStats::percentileNs(double fraction) const {
+  if (count_ == 0)
+    return 0;
+  const qint64 rank = qMax<qint64>(1, qint64(std::ceil(qBound(0.0, fraction, 1.0) * count_)));
+  qint64 seen = 0;
+  for (int i = 0; i < kMaxMicros; i++) {
+    seen += buckets_[i];
+    if (seen >= rank)
+      return qMin(max_ns_, qint64(i + 1) * 1000); // 取该档上限
+  }
+  return max_ns_;
+}
+
+LiveFeed::LiveFeed(const LiveFeedConfig &config)
+    : config_(config)
+    , input_(kQueueSize)
+    , output_(kQueueSize)
+    , engine_(withoutEquityCurve(config.backtest))
+    , strategy_(config.fast_period, config.slow_period)
+    , total_trades_(0)
+    , last_timestamp_(std::numeric_limits<qint64>::min())
+    , reader_thread_(nullptr)
+    , engine_thread_(nullptr)
+    , stopping_(false)
+    , source_done_(false)
+    , finished_(false)
+    , notify_pending_(false)
+    , received_(0)
+    , skipped_(0) {
+  engine_.reset(0);
+}
+
+LiveFeed::~LiveFeed() {
+  stop();
+}
+
+bool LiveFeed::start(const std::function<void()> &notify, QString &error) {
+  if (reader_thread_) {
+    error = "实时行情已经启动";
+    return false;
+  }
+  if (config_.source == LiveFeedConfig::Source::Replay && !QFileInfo::exists(config_.file_path)) {
+    error = "回放文件不存在: " + config_.file_path;
+    return false;
+  }
+  notify_ = notify ? notify : [] {};
+  engine_thread_ = QThread::create([this] { runEngine(); });
+  reader_thread_ = QThread::create([this] {
+    Profiler::setThreadName("实时行情");
+    if (config_.source == LiveFeedConfig::Source::Replay)
+      readReplay();
+    else
+      readSocket();
+    // 最后一根K线入队之后才置位，引擎线程看到后把队列取空即可结束
+    source_done_.store(true, std::memory_order_release);
+  });
+  engine_thread_->start();
+  reader_thread_->start();
+  return true;
+}
+
+void LiveFeed::stop() {
+  stopping_ = true;
+  for (QThread **thread : {&reader_thread_, &engine_thread_}) {
+    if (*thread) {
+      (*thread)->wait();
+      delete *thread;
+      *thread = nullptr;
+    }
+  }
+}
+
+qsizetype LiveFeed::takeUpdates(QVector<LiveUpdate> &out) {
+  // 先清除标志再取：之后入队的结果一定会再通知一次，不会漏掉
+  notify_pending_.store(false);
+  out.clear();
+  LiveUpdate update;
+  while (output_.tryPop(update))
+    out.append(update);
+  return out.size();
+}
+
+QString LiveFeed::errorString() const {
+  QMutexLocker locker(&mutex_);
+  return error_;
+}
+
+BacktestResult LiveFeed::finish() {
+  return engine_.finish();
+}
+
+void LiveFeed::setError(const QString &error) {
+  QMutexLocker locker(&mutex_);
+  error_ = error;
+}
+
+bool LiveFeed::publish(const KLineData &bar, qint64 received_ns) {
+  if (bar.timestamp <= last_timestamp_) {
+    skipped_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+  }
+  last_timestamp_ = bar.timestamp;
+  LiveBar item;
+  item.bar = bar;
+  item.received_ns = received_ns;
+  Backoff backoff;
+  while (!input_.tryPush(item)) {
+    if (stopping_.load(std::memory_order_relaxed))
+      return false;
+    backoff.wait();
+  }
+  const qint64 received = received_.fetch_add(1, std::memory_order_relaxed) + 1;
+  return config_.max_bars <= 0 || received < config_.max_bars;
+}
+
+bool LiveFeed::sleepUntil(qint64 due_ns) {
+  for (qint64 now = Profiler::now(); now < due_ns; now = Profiler::now()) {
+    if (stopping_.load(std::memory_order_relaxed))
+      return false;
+    QThread::usleep(qMin(due_ns - now, kMaxSleepNs) / 1000);
+  }
+  return !stopping_.load(std::memory_order_relaxed);
+}
+
+void LiveFeed::readReplay() {
+  // 分块流式读取，回放大文件时内存只有两块K线
+  KLineStream stream;
+  if (!stream.open(config_.file_path)) {
+    setError(stream.errorString());
+    return;
+  }
+  bool started = false;
+  qint64 first_timestamp = 0;
+  qint64 start_ns = 0;
+  while (const QVector<KLineData> *block = stream.next()) {
+    for (const KLineData &bar : *block) {
+      if (config_.speed > 0.0) {
+        if (!started) {
+          started = true;
+          first_timestamp = bar.timestamp;
+          start_ns = Profiler::now();
+        }
+        // 按K线时间的间隔换算成实际等待时间，与前面处理的快慢无关，不累积误差
+        const double offset_ns = double(bar.timestamp - first_timestamp) * 1e6 / config_.speed;
+        if (!sleepUntil(start_ns + qint64(offset_ns)))
+          return;
+      }
+      if (!publish(bar, Profiler::now()))
+        return;
+    }
+  }
+  if (stream.hasError())
+    setError(stream.errorString());
+}
+
+void LiveFeed::readSocket() {
+  QTcpSocket socket;
+  socket.connectToHost(config_.host, config_.port);
+  if (!socket.waitForConnected(kConnectTimeoutMs)) {
+    setError(QString("无法连接行情服务 %1:%2: %3")
+                 .arg(config_.host)
+                 .arg(config_.port)
+                 .arg(socket.errorString()));
+    return;
+  }
+  QByteArray pending; // 尚未收到换行的半行
+  QVector<KLineData> bars;
+  while (!stopping_.load(std::memory_order_relaxed)) {
+    if (socket.bytesAvailable() == 0 && !socket.waitForReadyRead(kPollMs)) {
+      if (socket.state() != QAbstractSocket::ConnectedState)
+        break; // 服务端关闭了连接
+      continue;
+    }
+    const qint64 received_ns = Profiler::now();
+    pending += socket.readAll();
+    const qsizetype end = pending.lastIndexOf('\n');
+    if (end < 0)
+      continue;
+    // 与CSV文件相同的行格式，表头等无法解析的行被跳过
+    bars.clear();
+    KLineLoader::parseRows(pending.constData(), pending.constData() + end + 1, bars);
+    pending.remove(0, end + 1);
+    for (const KLineData &bar : std::as_const(bars)) {
+      if (!publish(bar, received_ns))
+        return;
+    }
+  }
+}
+
+void LiveFeed::runEngine() {
+  Profiler::setThreadName("实时引擎");
+  Backoff backoff;
+  LiveBar item;
+  while (!stopping_.load(std::memory_order_relaxed)) {
+    const bool done = source_done_.load(std::memory_order_acquire);
+    if (!input_.tryPop(item)) {
+      if (done)
+        break; // 数据源结束之后队列已空
+      backoff.wait();
+      continue;
+    }
+    backoff.reset();
+
+    // 均线是固定窗口的滚动和，每根K线只更新一次，与已处理的K线数无关
+    const double position = engine_.position();
+    const BarAction action = strategy_.onBar(item.bar);
+    engine_.onBar(item.bar, action);
+    LiveUpdate update;
+    update.bar = item.bar;
+    if (engine_.position() != position) {
+      const bool buy = position == 0.0;
+      update.fill = buy ? BarAction::Buy : BarAction::Sell;
+      update.price = item.bar.close
+                     * (buy ? 1.0 + config_.backtest.slippage : 1.0 - config_.backtest.slippage);
+      if (!buy)
+        total_trades_++;
+    }
+    update.equity = engine_.cash() + engine_.position() * item.bar.close;
+    update.total_trades = total_trades_;
+    const qint64 now = Profiler::now();
+    update.latency_ns = now - item.received_ns;
+    if (Profiler::isEnabled())
+      Profiler::record("live.signal", item.received_ns, now);
+
+    while (!output_.tryPush(update)) {
+      if (stopping_.load(std::memory_order_relaxed))
+        return;
+      backoff.wait();
+    }
+    backoff.reset();
+    if (!notify_pending_.exchange(true))
+      notify_();
+  }
+  finished_.store(true, std::memory_order_release);
+  notify_();
+}
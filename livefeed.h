@@ -0,0 +1,129 @@
+#ifndef LIVEFEED_H
+#define LIVEFEED_H
+
+#include "backtestengine.h"
+#include "builtinstrategies.h"
+#include "klinedata.h"
+#include "spscring.h"
+
+#include <QMutex>
+#include <QString>
+#include <QVector>
+
+#include <atomic>
+#include <functional>
+
+class QThread;
+
+struct LiveFeedConfig {
+  enum class Source { Replay, Socket };
+
+  Source source = Source::Replay;
+  QString file_path; // 回放的CSV
+  double speed = 0.0; // 回放速度：K线时间与实际时间之比，如60为1分钟K线每秒一根；<=0为不等待
+  QString host;       // 本地行情服务，逐行发送 timestamp,open,high,low,close,volume
+  quint16 port = 0;
+  qint64 max_bars = 0; // 收到这么多根后当作数据源结束，0为不限
+  int fast_period = 10;
+  int slow_period = 30;
+  BacktestConfig backtest;
+
+  // "tcp://host:port"为行情服务，其余视为回放的CSV路径
+  static bool parseSource(const QString& text, LiveFeedConfig& config, QString& error);
+};
+
+// 引擎线程处理完一根K线后交给界面的结果
+struct LiveUpdate {
+  KLineData bar;
+  BarAction fill = BarAction::Hold; // 这根K线收盘时实际成交的方向，没有成交为Hold
+  double price = 0.0;               // 成交价（含滑点）
+  double equity = 0.0;
+  int total_trades = 0;
+  qint64 latency_ns = 0; // 从收到K线到信号撮合完成
+};
+
+// 延迟分布：1微秒一档的直方图，超过上限的计入最后一档，分位数精确到1微秒
+class LatencyStats {
+public:
+  static constexpr int kMaxMicros = 10000;
+
+  LatencyStats();
+
+  void add(qint64 ns);
+  void clear();
+
+  qint64 count() const { return count_; }
+  qint64 lastNs() const { return last_ns_; }
+  qint64 maxNs() const { return max_ns_; }
+  double averageNs() const { return count_ > 0 ? double(total_ns_) / count_ : 0.0; }
+  qint64 percentileNs(double fraction) const; // fraction为0~1
+
+private:
+  QVector<qint64> buckets_;
+  qint64 count_;
+  qint64 total_ns_;
+  qint64 last_ns_;
+  qint64 max_ns_;
+};
+
+// 实时模式：I/O线程从数据源（按速度回放的CSV，或本地行情服务的TCP连接）读K线，
+// 经无锁环形队列交给引擎线程；引擎线程逐根更新策略的滚动指标并撮合，每根O(1)，
+// 结果经第二个环形队列交给界面。队列满时上游等待，不丢K线。
+// 有新结果而界面自上次取过之后还没被通知时，在引擎线程中调用notify，界面随后用takeUpdates一次取完
+class LiveFeed {
+public:
+  static constexpr qsizetype kQueueSize = 1 << 14;
+
+  explicit LiveFeed(const LiveFeedConfig& config);
+  ~LiveFeed();
+
+  LiveFeed(const LiveFeed&) = delete;
+  LiveFeed& operator=(const LiveFeed&) = delete;
+
+  bool start(const std::function<void()>& notify, QString& error);
+  void stop(); // 停止两个线程，队列中尚未处理的K线丢弃
+  // 取出目前所有的结果，out先清空；只能在同一个线程中调用
+  qsizetype takeUpdates(QVector<LiveUpdate>& out);
+
+  const LiveFeedConfig& config() const { return config_; }
+  bool isFinished() const { return finished_.load(std::memory_order_acquire); } // 数据源已结束且都已处理
+  QString errorString() const;
+  qint64 receivedBars() const { return received_.load(std::memory_order_relaxed); }
+  qint64 skippedBars() const { return skipped_.load(std::memory_order_relaxed); } // 时间戳不递增被丢弃的
+  // stop之后调用，包含整个实时过程的成交和统计
+  BacktestResult finish();
+
+private:
+  struct LiveBar {
+    KLineData bar;
+    qint64 received_ns = 0; // 收到（回放时为放出）这根K线的时间
+  };
+
+  void readReplay();
+  void readSocket();
+  bool publish(const KLineData& bar, qint64 received_ns); // 返回false时停止读取
+  bool sleepUntil(qint64 due_ns);
+  void runEngine();
+  void setError(const QString& error);
+
+  LiveFeedConfig config_;
+  std::function<void()> notify_;
+  SpscRing<LiveBar> input_;     // I/O线程 -> 引擎线程
+  SpscRing<LiveUpdate> output_; // 引擎线程 -> 界面
+  BacktestEngine engine_;       // 以下只在引擎线程中使用
+  MovingAverageCross strategy_;
+  int total_trades_;
+  qint64 last_timestamp_; // 只在I/O线程中使用
+  QThread* reader_thread_;
+  QThread* engine_thread_;
+  std::atomic<bool> stopping_;
+  std::atomic<bool> source_done_;
+  std::atomic<bool> finished_;
+  std::atomic<bool> notify_pending_;
+  std::atomic<qint64> received_;
+  std::atomic<qint64> skipped_;
+  mutable QMutex mutex_;
+  QString error_;
+};
+
+#endif // LIVEFEED_H
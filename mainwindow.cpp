@@ -1,30 +1,70 @@
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
 
+#include "builtinstrategies.h"
 #include "downloaddialog.h"
+#include "downloadmanager.h"
+#include "montecarlodialog.h"
+#include "profiler.h"
+#include "profilerpanel.h"
+#include "sweepdialog.h"
+#include "walkforwarddialog.h"
 
 #include <QCandlestickSeries>
-#include <QCandlestickSet>
 #include <QChart>
 #include <QChartView>
+#include <QComboBox>
 #include <QDateTime>
 #include <QDateTimeAxis>
 #include <QDebug>
 #include <QDir>
 #include <QFile>
 #include <QFileDialog>
+#include <QHBoxLayout>
+#include <QLabel>
 #include <QMessageBox>
-#include <QProcess>
+#include <QPointF>
+#include <QProgressBar>
 #include <QProgressDialog>
+#include <QPushButton>
 #include <QScatterSeries>
+#include <QSignalBlocker>
 #include <QSlider>
-#include <QTextStream>
+#include <QThread>
+#include <QTimeZone>
+#include <QToolButton>
 #include <QValueAxis>
+#include <QWheelEvent>
+
+#include <algorithm>
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
     , ui(new Ui::MainWindow)
-    , progress_dialog_(nullptr)
+    , load_progress_(nullptr)
+    , download_progress_(nullptr)
+    , download_manager_(nullptr)
+    , strategy_worker_(nullptr)
+    , pending_level_(0)
+    , pending_bars_(0)
+    , portfolio_progress_(nullptr)
+    , portfolio_thread_(nullptr)
+    , portfolio_cancelled_(false)
+    , profiler_panel_(nullptr)
+    , profiler_label_(nullptr)
+    , load_thread_(nullptr)
+    , load_cancelled_(false)
+    , load_generation_(0)
+    , preview_ms_(-1)
+    , backtest_thread_(nullptr)
+    , backtest_generation_(0)
+    , pending_append_offset_(-1)
+    , catalog_thread_(nullptr)
+    , catalog_again_(false)
+    , live_view_(false)
+    , live_button_(nullptr)
+    , live_speed_combo_(nullptr)
+    , live_label_(nullptr)
     , price_chart_(nullptr)
     , chart_view_(nullptr)
     , candle_series_(nullptr)
@@ -33,35 +73,165 @@ MainWindow::MainWindow(QWidget *parent)
     , axis_x_(nullptr)
     , axis_y_(nullptr)
     , scroll_bar_(nullptr)
-    , visible_count_(60) {
+    , timeframe_combo_(nullptr)
+    , session_(std::make_shared<BacktestSession>())
+    , result_level_(-1)
+    , display_level_(0)
+    , auto_level_(true)
+    , visible_count_(kDefaultVisibleCount) {
   ui->setupUi(this);
   initializeApplication();
 }
 
 MainWindow::~MainWindow() {
+  live_feed_.reset(); // 行情线程会向窗口投递通知，先停掉
+  cancelLoading();
+  if (catalog_thread_) {
+    catalog_thread_->wait();
+    delete catalog_thread_;
+  }
+  if (backtest_thread_) {
+    backtest_thread_->wait();
+    delete backtest_thread_;
+  }
+  if (portfolio_thread_) {
+    portfolio_cancelled_ = true;
+    portfolio_thread_->wait();
+    delete portfolio_thread_;
+  }
   candle_series_->clear();
-  current_kline_data_.clear();
   signals_.clear();
   delete ui;
 }
 
 void MainWindow::onDataFileSelected(int index) {
   if (index >= 0 && index < all_data_files_.size()) {
+    if (live_view_)
+      stopLive();
     current_data_file_ = all_data_files_[index];
-    showProgress(QString("正在加载: %1").arg(QFileInfo(current_data_file_).fileName()));
-    if (loadKLineData(current_data_file_)) {
-      clearProgress();
-      buildChartBasic();
-      setChartRange(0);
-      statusBar()->showMessage(QString("已加载: %1 (%2条数据)")
-                                   .arg(QFileInfo(current_data_file_).fileName())
-                                   .arg(current_data_file_.size()),
-                               3000);
-    } else {
-      clearProgress();
-      showError("加载数据文件失败");
+    clearBacktestResult();
+    startLoading(current_data_file_);
+  }
+}
+
+void MainWindow::startLoading(const QString &file_path) {
+  cancelLoading();
+  const int generation = ++load_generation_;
+  backtest_generation_++; // 正在运行的回测结果属于旧数据
+  pending_append_offset_ = -1;
+  load_cancelled_ = false;
+  preview_ms_ = -1;
+  load_progress_->setValue(0);
+  load_progress_->show();
+  statusBar()->showMessage(QString("正在加载: %1").arg(QFileInfo(file_path).fileName()));
+  // 预览只读文件末尾一段，与文件大小无关，先画出来；完整数据在同一线程接着加载
+  load_thread_ = QThread::create([this, file_path, generation] {
+    Profiler::setThreadName("加载");
+    QElapsedTimer timer;
+    timer.start();
+    auto preview = std::make_shared<BacktestSession>();
+    if (preview->loadPreview(file_path, kPreviewBars)) {
+      const qint64 preview_ms = timer.elapsed();
+      QMetaObject::invokeMethod(
+          this,
+          [this, generation, preview, preview_ms] {
+            if (generation != load_generation_ || preview_ms_ >= 0)
+              return;
+            preview_ms_ = preview_ms;
+            setSession(preview);
+          },
+          Qt::QueuedConnection);
     }
+    auto session = std::make_shared<BacktestSession>();
+    const bool ok = session->load(file_path, &load_cancelled_, [this, generation](int permille) {
+      QMetaObject::invokeMethod(
+          this,
+          [this, generation, permille] { onLoadProgress(generation, permille); },
+          Qt::QueuedConnection);
+    });
+    const qint64 elapsed_ms = timer.elapsed();
+    QMetaObject::invokeMethod(
+        this,
+        [this, generation, ok, session, elapsed_ms] {
+          finishLoading(generation, ok, session, elapsed_ms);
+        },
+        Qt::QueuedConnection);
+  });
+  load_thread_->start();
+}
+
+void MainWindow::cancelLoading() {
+  if (!load_thread_)
+    return;
+  // 解析和建金字塔都会分段检查取消标志，这里的等待很短；已投递的结果按generation丢弃
+  load_cancelled_ = true;
+  load_thread_->wait();
+  delete load_thread_;
+  load_thread_ = nullptr;
+  load_generation_++;
+  load_progress_->hide();
+}
+
+void MainWindow::onLoadProgress(int generation, int permille) {
+  if (generation != load_generation_)
+    return;
+  load_progress_->setValue(permille);
+}
+
+void MainWindow::finishLoading(int generation,
+                               bool ok,
+                               const std::shared_ptr<BacktestSession> &session,
+                               qint64 elapsed_ms) {
+  if (generation != load_generation_)
+    return;
+  load_thread_->wait();
+  delete load_thread_;
+  load_thread_ = nullptr;
+  load_progress_->hide();
+  if (!ok) {
+    setSession(std::make_shared<BacktestSession>());
+    showError("加载数据文件失败");
+    return;
   }
+  setSession(session);
+  syncStrategyBars();
+  QString message = QString("已加载: %1 (%2条数据, %3毫秒)")
+                        .arg(QFileInfo(session_->filePath()).fileName())
+                        .arg(session_->bars().size())
+                        .arg(elapsed_ms);
+  if (preview_ms_ >= 0)
+    message += QString("，首屏%1毫秒").arg(preview_ms_);
+  statusBar()->showMessage(message, 5000);
+}
+
+void MainWindow::setSession(const std::shared_ptr<BacktestSession> &session) {
+  if (live_view_) {
+    session_ = session; // 图表正显示实时K线，退出实时模式时再按新数据重建
+    return;
+  }
+  // 预览换成完整数据时保持周期、缩放和位置；原来停在最右端时跟随到最新
+  const bool keep_view = session_->isPreview() && session_->pyramid().levelCount() > 0
+                         && session_->filePath() == session->filePath();
+  qint64 anchor = session->isEmpty() ? 0 : session->bars().last().timestamp;
+  const bool auto_level = auto_level_;
+  const int visible = visible_count_;
+  const QString level_name = keep_view ? session_->pyramid().level(display_level_).name : QString();
+  if (keep_view && scroll_bar_->value() < scroll_bar_->maximum()) {
+    const QVector<KLineData> &bars = chartBars();
+    anchor = bars[qMin(scroll_bar_->value() + visible_count_ / 2, int(bars.size()) - 1)].timestamp;
+  }
+  session_ = session;
+  buildChartBasic(anchor);
+  const int level = session_->pyramid().findLevel(level_name);
+  if (!keep_view || level < 0)
+    return;
+  auto_level_ = auto_level;
+  visible_count_ = visible;
+  {
+    QSignalBlocker blocker(timeframe_combo_);
+    timeframe_combo_->setCurrentIndex(auto_level_ ? 0 : level + 1);
+  }
+  showLevel(level, anchor);
 }
 
 void MainWindow::onDownloadDataClicked() {
@@ -69,28 +239,102 @@ void MainWindow::onDownloadDataClicked() {
   if (dialog.exec() != QDialog::Accepted) {
     return; // 用户取消
   }
-  showProgress("正在配置下载参数...");
-  QString exchange = dialog.getExchange();
-  QString symbol = dialog.getSymbol();
-  QString timeframe = dialog.getTimeframe();
-  QDateTime startTime = dialog.getStartTime();
-  QDateTime endTime = dialog.getEndTime();
-  QString outputPath = dialog.getOutputPath();
-  if (!checkPythonEnvironment()) {
-    clearProgress();
-    return;
-  }
-  int estimatedBars = calculateEstimatedBars(startTime, endTime, timeframe);
-  bool needBatchDownload = (estimatedBars > 1000);
-  showProgress(QString("下载数据量为：%1条").arg(estimatedBars));
-  if (needBatchDownload) {
-    // TODO: 实现分批下载
-    // executeBatchDownload(exchange, symbol, timeframe, startTime, estimatedBars, outputPath);
-    showError("暂不支持超过1000条！");
-  } else {
-    executeSingleDownload(exchange, symbol, timeframe, startTime, estimatedBars, outputPath);
+  DownloadRequest request;
+  request.exchange = dialog.getExchange();
+  request.symbol = dialog.getSymbol();
+  request.timeframe = dialog.getTimeframe();
+  request.start_time = dialog.getStartTime();
+  request.end_time = dialog.getEndTime();
+  request.output_path = dialog.getOutputPath();
+  // 设置该环境变量后改从本地模拟服务下载（scripts/mockohlcvserver.py）
+  request.mock_server = qEnvironmentVariable("QTBACKTESTER_MOCK_SERVER");
+  int estimatedBars = calculateEstimatedBars(request.start_time, request.end_time, request.timeframe);
+  // 下载全程异步，正在下载时新任务排队等待
+  QString message = QString("下载数据量约为：%1条").arg(estimatedBars);
+  if (download_manager_->isBusy()) {
+    message += QString("，已加入下载队列，前面还有 %1 个任务")
+                   .arg(download_manager_->queuedCount() + 1);
+  }
+  statusBar()->showMessage(message, 3000);
+  download_manager_->enqueue(request);
+}
+
+void MainWindow::onUpdateDataClicked() {
+  if (current_data_file_.isEmpty() || !QFile::exists(current_data_file_)) {
+    showError("请先选择数据文件");
+    return;
+  }
+  DownloadRequest request;
+  QString error;
+  if (!BacktestSession::makeUpdateRequest(current_data_file_,
+                                          QDateTime::currentDateTime(),
+                                          request,
+                                          error)) {
+    showError(error);
+    return;
   }
-  clearProgress();
+  if (request.start_time > request.end_time) {
+    statusBar()->showMessage("数据已是最新", 3000);
+    return;
+  }
+  statusBar()->showMessage(QString("正在更新，缺少约%1条数据")
+                               .arg(calculateEstimatedBars(request.start_time,
+                                                           request.end_time,
+                                                           request.timeframe)),
+                           3000);
+  download_manager_->enqueue(request);
+}
+
+void MainWindow::onDownloadStarted(const DownloadRequest &request, int queued) {
+  download_label_
+      = QString("正在下载 %1 %2 %3").arg(request.exchange, request.symbol, request.timeframe);
+  if (queued > 0)
+    download_label_ += QString("（队列中还有 %1 个任务）").arg(queued);
+  download_progress_->setRange(0, 0); // 首个进度到达前显示忙碌状态
+  download_progress_->setLabelText(download_label_);
+  download_progress_->show();
+}
+
+void MainWindow::onDownloadProgress(qint64 fetched_bars, qint64 total_bars) {
+  // 进度条只接受int，按千分比显示
+  download_progress_->setRange(0, 1000);
+  download_progress_->setValue(total_bars > 0 ? int(fetched_bars * 1000 / total_bars) : 0);
+  download_progress_->setLabelText(
+      QString("%1\n%2 / %3 条").arg(download_label_).arg(fetched_bars).arg(total_bars));
+}
+
+void MainWindow::onDownloadFinished(const DownloadRequest &request,
+                                    bool success,
+                                    const QString &message,
+                                    qint64 rows) {
+  if (!success) {
+    showError(QString("下载失败 %1 %2: %3").arg(request.symbol, request.timeframe, message));
+    return;
+  }
+  if (request.append_offset >= 0) {
+    QString file_name = QFileInfo(request.output_path).fileName();
+    if (rows == 0) {
+      statusBar()->showMessage(QString("%1 已是最新").arg(file_name), 3000);
+      return;
+    }
+    // 更新的是当前文件时只合并新增部分，其他文件下次加载时重建缓存
+    if (request.output_path == current_data_file_)
+      appendKLineData(request.append_offset);
+    if (isInDataDirectory(request.output_path))
+      refreshCatalog();
+    statusBar()->showMessage(QString("已更新: %1 (新增%2条)").arg(file_name).arg(rows), 5000);
+    return;
+  }
+  addDataFileToComboBox(request.output_path, false);
+  statusBar()->showMessage(QString("下载完成: %1 (%2条数据)")
+                               .arg(QFileInfo(request.output_path).fileName())
+                               .arg(rows),
+                           5000);
+}
+
+void MainWindow::onDownloadCancelled(const DownloadRequest &request) {
+  statusBar()->showMessage(QString("已取消下载: %1 %2").arg(request.symbol, request.timeframe),
+                           3000);
 }
 
 void MainWindow::onAddFileClicked() {
@@ -116,22 +360,449 @@ void MainWindow::onScrollChanged(int value) {
   setChartRange(value);
 }
 
+void MainWindow::onStartBacktestClicked() {
+  if (!checkSessionReady())
+    return;
+  BacktestConfig config;
+  if (!readBacktestConfig(config))
+    return;
+  QString strategy = all_strategy_files_.value(ui->strategyComboBox->currentIndex());
+  backtest_timer_.start();
+  const int level = backtestLevel();
+  const std::shared_ptr<StrategyPlugin> plugin = strategy_plugins_.value(strategy);
+  if (strategy == kMaCrossStrategyId || plugin) {
+    startNativeBacktest(level, config, plugin);
+    return;
+  }
+  // Python策略交给常驻进程计算信号，返回后再由引擎撮合
+  if (strategy_worker_->isBusy()) {
+    showError("上一次策略仍在运行");
+    return;
+  }
+  if (!strategy_worker_->run(strategy)) {
+    showError("无法启动Python策略进程，请检查Python和numpy是否已安装");
+    return;
+  }
+  pending_config_ = config;
+  pending_level_ = level;
+  pending_session_ = session_;
+  pending_bars_ = session_->pyramid().bars(level).size();
+  ui->startBacktestButton->setEnabled(false);
+  statusBar()->showMessage("正在运行策略...");
+}
+
+void MainWindow::startNativeBacktest(int level,
+                                     const BacktestConfig &config,
+                                     const std::shared_ptr<StrategyPlugin> &plugin) {
+  const int generation = ++backtest_generation_;
+  std::shared_ptr<BacktestSession> session = session_;
+  ui->startBacktestButton->setEnabled(false);
+  statusBar()->showMessage("正在回测...");
+  // 线程持有会话的引用，期间换了数据文件也不会释放；追加数据推迟到回测结束后再合并
+  backtest_thread_ = QThread::create([this, generation, session, level, config, plugin] {
+    Profiler::setThreadName("回测");
+    QElapsedTimer timer;
+    timer.start();
+    BacktestResult result = plugin ? session->runPlugin(level, config, *plugin)
+                                   : session->runMaCross(level, config, 10, 30);
+    const qint64 elapsed_ms = timer.elapsed();
+    QMetaObject::invokeMethod(
+        this,
+        [this, generation, session, result, config, level, elapsed_ms] {
+          finishNativeBacktest(generation, session, result, config, level, elapsed_ms);
+        },
+        Qt::QueuedConnection);
+  });
+  backtest_thread_->start();
+}
+
+void MainWindow::finishNativeBacktest(int generation,
+                                      const std::shared_ptr<BacktestSession> &session,
+                                      const BacktestResult &result,
+                                      const BacktestConfig &config,
+                                      int level,
+                                      qint64 elapsed_ms) {
+  backtest_thread_->wait();
+  delete backtest_thread_;
+  backtest_thread_ = nullptr;
+  ui->startBacktestButton->setEnabled(true);
+  if (generation != backtest_generation_ || session != session_ || live_view_)
+    statusBar()->showMessage("数据在回测期间发生了变化，已丢弃该次结果", 5000);
+  else
+    finishBacktest(result, config, level, elapsed_ms);
+  if (pending_append_offset_ >= 0) {
+    const qint64 offset = pending_append_offset_;
+    pending_append_offset_ = -1;
+    appendKLineData(offset);
+  }
+}
+
+void MainWindow::onSweepClicked() {
+  if (!checkSessionReady())
+    return;
+  BacktestConfig defaults;
+  if (!readBacktestConfig(defaults))
+    return;
+  SweepDialog dialog(backtestBars(), backtestIndicators(), defaults, this);
+  dialog.exec();
+}
+
+void MainWindow::onWalkForwardClicked() {
+  if (!checkSessionReady())
+    return;
+  BacktestConfig defaults;
+  if (!readBacktestConfig(defaults))
+    return;
+  WalkForwardDialog dialog(backtestBars(), backtestIndicators(), defaults, this);
+  dialog.exec();
+}
+
+void MainWindow::onMonteCarloClicked() {
+  if (!checkSessionReady())
+    return;
+  if (result_level_ < 0 || result_level_ >= session_->pyramid().levelCount() || signals_.isEmpty()) {
+    showError("请先运行一次有成交的回测");
+    return;
+  }
+  MonteCarloDialog dialog(session_->pyramid().bars(result_level_), signals_, result_config_, this);
+  dialog.exec();
+}
+
+void MainWindow::onPortfolioClicked() {
+  if (portfolio_thread_)
+    return;
+  QStringList files = QFileDialog::getOpenFileNames(this,
+                                                    "选择组合回测的数据文件",
+                                                    getDataDirectory(),
+                                                    "CSV Files (*.csv);;All Files (*)");
+  if (files.isEmpty())
+    return;
+  PortfolioConfig config;
+  if (!readBacktestConfig(config.base))
+    return;
+  config.base.record_equity_curve = false;
+  portfolio_cancelled_ = false;
+  portfolio_progress_->setRange(0, 1000);
+  portfolio_progress_->setValue(0);
+  portfolio_progress_->setLabelText(QString("正在回测 %1 个品种...").arg(files.size()));
+  portfolio_progress_->show();
+  ui->portfolioButton->setEnabled(false);
+  // 各品种按列式缓存逐根读取，不整体加载，后台线程跑完后回到界面线程显示
+  portfolio_thread_ = QThread::create([this, files, config] {
+    QElapsedTimer timer;
+    timer.start();
+    PortfolioBacktest portfolio;
+    PortfolioResult result;
+    QString error;
+    bool ok = portfolio.open(files, error);
+    if (ok) {
+      result = portfolio.run(config, &portfolio_cancelled_, [this](int permille) {
+        QMetaObject::invokeMethod(
+            this,
+            [this, permille] { portfolio_progress_->setValue(permille); },
+            Qt::QueuedConnection);
+      });
+    }
+    const qint64 elapsed_ms = timer.elapsed();
+    QMetaObject::invokeMethod(
+        this,
+        [this, ok, error, result, elapsed_ms] { finishPortfolio(ok, error, result, elapsed_ms); },
+        Qt::QueuedConnection);
+  });
+  portfolio_thread_->start();
+}
+
+void MainWindow::finishPortfolio(bool ok,
+                                 const QString &error,
+                                 const PortfolioResult &result,
+                                 qint64 elapsed_ms) {
+  portfolio_thread_->wait();
+  delete portfolio_thread_;
+  portfolio_thread_ = nullptr;
+  portfolio_progress_->reset();
+  portfolio_progress_->hide();
+  ui->portfolioButton->setEnabled(true);
+  if (!ok) {
+    showError(error);
+    return;
+  }
+  if (result.cancelled) {
+    statusBar()->showMessage("已取消组合回测", 3000);
+    return;
+  }
+  // 汇总指标显示在回测结果区，图表上的买卖点属于单个品种，清空
+  BacktestResult summary;
+  summary.initial_capital = result.initial_capital;
+  summary.final_capital = result.final_capital;
+  summary.total_trades = result.total_trades;
+  summary.winning_trades = result.winning_trades;
+  summary.win_rate = result.win_rate;
+  summary.max_drawdown = result.max_drawdown;
+  showBacktestResult(summary);
+  QString details;
+  for (const PortfolioSymbolResult &symbol : result.symbols) {
+    details += QString("%1: %2条K线, %3笔交易, 盈亏 %4\n")
+                   .arg(symbol.name)
+                   .arg(symbol.bars)
+                   .arg(symbol.total_trades)
+                   .arg(symbol.realized_pnl, 0, 'f', 2);
+  }
+  QMessageBox box(this);
+  box.setWindowTitle("组合回测");
+  box.setIcon(QMessageBox::Information);
+  box.setText(QString("%1 个品种, %2 个时间点, 最终资金 %3, 最大回撤 %4%")
+                  .arg(result.symbols.size())
+                  .arg(result.steps)
+                  .arg(result.final_capital, 0, 'f', 2)
+                  .arg(result.max_drawdown * 100.0, 0, 'f', 2));
+  box.setDetailedText(details);
+  box.exec();
+  statusBar()->showMessage(QString("组合回测完成: %1条K线, 耗时%2毫秒")
+                               .arg(result.total_bars)
+                               .arg(elapsed_ms),
+                           5000);
+}
+
+void MainWindow::onLiveClicked(bool checked) {
+  if (checked)
+    startLive();
+  else
+    stopLive();
+}
+
+void MainWindow::startLive() {
+  live_button_->setChecked(false); // 启动成功后再置为选中
+  LiveFeedConfig config;
+  if (!readBacktestConfig(config.backtest))
+    return;
+  // 设置该环境变量后连接本地行情服务，否则回放当前数据文件
+  const QString source = qEnvironmentVariable("QTBACKTESTER_LIVE_FEED");
+  if (source.isEmpty() && current_data_file_.isEmpty()) {
+    showError("请先选择数据文件");
+    return;
+  }
+  QString error;
+  if (!LiveFeedConfig::parseSource(source.isEmpty() ? current_data_file_ : source, config, error)) {
+    showError(error);
+    return;
+  }
+  config.speed = live_speed_combo_->currentData().toDouble();
+  auto feed = std::make_unique<LiveFeed>(config);
+  // 界面取完上一批之前引擎线程不会再投递，界面忙时多根K线合并成一批处理
+  const bool started = feed->start(
+      [this] { QMetaObject::invokeMethod(this, [this] { onLiveUpdates(); }, Qt::QueuedConnection); },
+      error);
+  if (!started) {
+    showError(error);
+    return;
+  }
+  live_feed_ = std::move(feed);
+  live_view_ = true;
+  live_button_->setChecked(true);
+  live_button_->setText("退出实时");
+  live_speed_combo_->setEnabled(false);
+  timeframe_combo_->setEnabled(false);
+
+  // 实时K线单独一层，周期由前两根K线确定；只显示原始周期，缩放只改可见数量
+  live_level_ = KLinePyramid::Level();
+  live_level_.name = "实时";
+  live_level_.bars.reserve(kLiveReserveBars);
+  live_latency_.clear();
+  live_label_->clear();
+  clearBacktestResult();
+  ui->initialCapitalValueLabel->setText(QString::number(config.backtest.initial_capital, 'f', 2));
+  auto_level_ = false;
+  display_level_ = 0;
+  visible_count_ = kDefaultVisibleCount;
+  axis_x_->setFormat("MM-dd HH:mm");
+  candle_window_.setData(&live_level_.bars);
+  candle_window_.clear();
+  {
+    QSignalBlocker blocker(scroll_bar_);
+    scroll_bar_->setRange(0, 0);
+    scroll_bar_->setPageStep(visible_count_);
+  }
+  if (config.source == LiveFeedConfig::Source::Replay) {
+    statusBar()->showMessage(QString("实时回放: %1 (%2)")
+                                 .arg(QFileInfo(config.file_path).fileName(),
+                                      live_speed_combo_->currentText()));
+  } else {
+    statusBar()->showMessage(QString("正在接收行情: %1:%2").arg(config.host).arg(config.port));
+  }
+}
+
+void MainWindow::onLiveUpdates() {
+  if (!live_feed_)
+    return; // 已退出实时模式，残留的通知
+  ProfileScope scope("live.chart");
+  // 先读结束标志再取结果，结束前的结果一定都能取到
+  const bool finished = live_feed_->isFinished();
+  if (live_feed_->takeUpdates(live_updates_) > 0) {
+    QVector<KLineData> &bars = live_level_.bars;
+    const bool at_end = scroll_bar_->value() >= scroll_bar_->maximum();
+    for (const LiveUpdate &update : std::as_const(live_updates_)) {
+      bars.append(update.bar);
+      live_level_.index.append(update.bar);
+      live_latency_.add(update.latency_ns);
+      if (update.fill == BarAction::Buy)
+        buy_series_->append(update.bar.timestamp, update.price);
+      else if (update.fill == BarAction::Sell)
+        sell_series_->append(update.bar.timestamp, update.price);
+    }
+    if (live_level_.msecs == 0 && bars.size() >= 2)
+      live_level_.msecs = bars[1].timestamp - bars[0].timestamp;
+    const LiveUpdate &last = live_updates_.last();
+    ui->finalCapitalValueLabel->setText(QString::number(last.equity, 'f', 2));
+    ui->totalTradesValueLabel->setText(QString::number(last.total_trades));
+
+    // 已载入的K线对象不动：停在最右端时窗口随新K线右移，只给移入的槽位填值
+    const int max_index = qMax(0, int(bars.size()) - visible_count_);
+    {
+      QSignalBlocker blocker(scroll_bar_);
+      scroll_bar_->setRange(0, max_index);
+      if (at_end)
+        scroll_bar_->setValue(max_index);
+    }
+    setChartRange(scroll_bar_->value());
+    live_label_->setText(QString("信号延迟 %1 微秒（平均 %2，P99 %3）")
+                             .arg(live_latency_.lastNs() / 1000.0, 0, 'f', 1)
+                             .arg(live_latency_.averageNs() / 1000.0, 0, 'f', 1)
+                             .arg(live_latency_.percentileNs(0.99) / 1000.0, 0, 'f', 1));
+  }
+  if (finished)
+    finishLive();
+}
+
+void MainWindow::finishLive() {
+  live_feed_->stop();
+  const QString error = live_feed_->errorString();
+  const qint64 received = live_feed_->receivedBars();
+  BacktestResult result = live_feed_->finish();
+  live_feed_.reset();
+  BacktestEngine::analyzeExcursions(result,
+                                    live_level_.bars.constData(),
+                                    live_level_.bars.size(),
+                                    live_level_.index);
+  showBacktestResult(result);
+  result_level_ = -1; // 实时K线退出后不再保留，无法重抽样
+  if (!error.isEmpty()) {
+    showError("实时行情中断: " + error);
+    return;
+  }
+  statusBar()->showMessage(QString("实时行情结束: %1根K线").arg(received), 5000);
+}
+
+void MainWindow::stopLive() {
+  if (live_feed_)
+    finishLive();
+  live_view_ = false;
+  live_level_ = KLinePyramid::Level();
+  live_label_->clear();
+  live_speed_combo_->setEnabled(true);
+  timeframe_combo_->setEnabled(true);
+  live_button_->setChecked(false);
+  live_button_->setText("实时");
+  // 回到当前数据文件，实时过程的结果和买卖点保留在结果区
+  buildChartBasic(session_->isEmpty() ? 0 : session_->bars().last().timestamp);
+}
+
+void MainWindow::onStrategySignalsReady(const StrategySignals &result) {
+  ui->startBacktestButton->setEnabled(true);
+  if (live_view_ || session_->isPreview() || pending_session_.lock() != session_
+      || pending_level_ >= session_->pyramid().levelCount()
+      || session_->pyramid().bars(pending_level_).size() != pending_bars_) {
+    // 运行期间数据已经更换、追加或进入了实时模式，信号的K线下标不再对应当前数据
+    statusBar()->showMessage("数据在策略运行期间发生了变化，已丢弃该次结果", 5000);
+    return;
+  }
+  BacktestResult backtest = session_->replaySignals(pending_level_, pending_config_, result);
+  finishBacktest(backtest, pending_config_, pending_level_, backtest_timer_.elapsed());
+}
+
+void MainWindow::onStrategyFailed(const QString &message) {
+  ui->startBacktestButton->setEnabled(true);
+  showError("策略运行失败: " + message);
+}
+
 void MainWindow::initializeApplication() {
-  // 初始化进度对话框
-  progress_dialog_ = new QProgressDialog(this);
-  progress_dialog_->setCancelButton(nullptr);
-  progress_dialog_->setWindowModality(Qt::WindowModal);
-  progress_dialog_->setMinimumDuration(0); // 立即显示
-  progress_dialog_->setAutoClose(false);   // 不要自动关闭
-  progress_dialog_->setAutoReset(false);   // 不要自动重置
-  progress_dialog_->reset();               // 初始隐藏
+  // 策略进程提前启动，首次回测时解释器和numpy已经加载完毕
+  strategy_worker_ = new StrategyWorker(this);
+  connect(strategy_worker_,
+          &StrategyWorker::finished,
+          this,
+          &MainWindow::onStrategySignalsReady);
+  connect(strategy_worker_, &StrategyWorker::failed, this, &MainWindow::onStrategyFailed);
+  strategy_worker_->start();
+  download_manager_ = new DownloadManager(this);
+  connect(download_manager_, &DownloadManager::jobStarted, this, &MainWindow::onDownloadStarted);
+  connect(download_manager_, &DownloadManager::jobProgress, this, &MainWindow::onDownloadProgress);
+  connect(download_manager_, &DownloadManager::jobFinished, this, &MainWindow::onDownloadFinished);
+  connect(download_manager_,
+          &DownloadManager::jobCancelled,
+          this,
+          &MainWindow::onDownloadCancelled);
+  connect(download_manager_, &DownloadManager::idle, this, [this] {
+    download_progress_->reset();
+    download_progress_->hide();
+  });
+  // 下载进度单独一个非模态对话框，下载期间界面照常可用
+  download_progress_ = new QProgressDialog(this);
+  download_progress_->setWindowTitle("下载数据");
+  download_progress_->setCancelButtonText("取消");
+  download_progress_->setWindowModality(Qt::NonModal);
+  download_progress_->setMinimumDuration(0);
+  download_progress_->setAutoClose(false);
+  download_progress_->setAutoReset(false);
+  download_progress_->reset();
+  connect(download_progress_, &QProgressDialog::canceled, this, [this] {
+    download_manager_->cancelCurrent();
+  });
+  portfolio_progress_ = new QProgressDialog(this);
+  portfolio_progress_->setWindowTitle("组合回测");
+  portfolio_progress_->setCancelButtonText("取消");
+  portfolio_progress_->setWindowModality(Qt::WindowModal);
+  portfolio_progress_->setMinimumDuration(0);
+  portfolio_progress_->setAutoClose(false);
+  portfolio_progress_->setAutoReset(false);
+  portfolio_progress_->reset();
+  connect(portfolio_progress_, &QProgressDialog::canceled, this, [this] {
+    portfolio_cancelled_ = true;
+  });
+  // 性能面板停靠在底部，默认隐藏，通过状态栏右侧的按钮打开
+  Profiler::setThreadName("界面");
+  profiler_panel_ = new ProfilerPanel(this);
+  addDockWidget(Qt::BottomDockWidgetArea, profiler_panel_);
+  profiler_panel_->hide();
+  profiler_label_ = new QLabel(this);
+  // 加载在后台进行，进度放在状态栏，不阻塞界面
+  load_progress_ = new QProgressBar(this);
+  load_progress_->setRange(0, 1000);
+  load_progress_->setMaximumWidth(160);
+  load_progress_->setTextVisible(false);
+  load_progress_->hide();
+  statusBar()->addPermanentWidget(load_progress_);
+  auto *profiler_button = new QToolButton(this);
+  profiler_button->setDefaultAction(profiler_panel_->toggleViewAction());
+  profiler_button->setText("性能");
+  statusBar()->addPermanentWidget(profiler_label_);
+  statusBar()->addPermanentWidget(profiler_button);
+  connect(profiler_panel_, &ProfilerPanel::summaryChanged, profiler_label_, &QLabel::setText);
   // 连接信号槽
   connect(ui->dataFileComboBox,
           QOverload<int>::of(&QComboBox::currentIndexChanged),
           this,
           &MainWindow::onDataFileSelected);
   connect(ui->downloadDataButton, &QPushButton::clicked, this, &MainWindow::onDownloadDataClicked);
+  connect(ui->updateDataButton, &QPushButton::clicked, this, &MainWindow::onUpdateDataClicked);
   connect(ui->addFileButton, &QPushButton::clicked, this, &MainWindow::onAddFileClicked);
+  connect(ui->startBacktestButton,
+          &QPushButton::clicked,
+          this,
+          &MainWindow::onStartBacktestClicked);
+  connect(ui->sweepButton, &QPushButton::clicked, this, &MainWindow::onSweepClicked);
+  connect(ui->walkForwardButton, &QPushButton::clicked, this, &MainWindow::onWalkForwardClicked);
+  connect(ui->portfolioButton, &QPushButton::clicked, this, &MainWindow::onPortfolioClicked);
+  connect(ui->monteCarloButton, &QPushButton::clicked, this, &MainWindow::onMonteCarloClicked);
 
   initializeDataFiles();
   initializeStrategies();
@@ -141,22 +812,102 @@ void MainWindow::initializeApplication() {
 }
 
 void MainWindow::initializeDataFiles() {
-  QString dataDir = getDataDirectory();
-  QDir directory(dataDir);
+  // 先按上次保存的索引列出数据集，不扫描目录也不打开CSV；目录的变化由后台刷新补上
+  catalog_.open(getDataDirectory());
+  populateDataFiles(QString());
+  refreshCatalog();
+}
+
+void MainWindow::refreshCatalog(const QString &select_path) {
+  if (!select_path.isEmpty())
+    catalog_select_ = select_path;
+  if (catalog_thread_) {
+    catalog_again_ = true;
+    return;
+  }
+  catalog_again_ = false;
+  // 在副本上刷新：只重新扫描变化的文件，合并重复数据，写回索引
+  catalog_thread_ = QThread::create([this, catalog = catalog_]() mutable {
+    QString error;
+    bool changed = false;
+    bool ok = catalog.refresh(changed, error) && (!changed || catalog.save(error));
+    QMetaObject::invokeMethod(
+        this,
+        [this, ok, error, changed, catalog] { finishCatalogRefresh(ok, error, changed, catalog); },
+        Qt::QueuedConnection);
+  });
+  catalog_thread_->start();
+}
+
+void MainWindow::finishCatalogRefresh(bool ok,
+                                      const QString &error,
+                                      bool changed,
+                                      const DatasetCatalog &catalog) {
+  catalog_thread_->wait();
+  delete catalog_thread_;
+  catalog_thread_ = nullptr;
+  if (!ok) {
+    statusBar()->showMessage("更新数据索引失败: " + error, 5000);
+  } else if (changed || !catalog_select_.isEmpty()) {
+    catalog_ = catalog;
+    const QString select = catalog_select_;
+    catalog_select_.clear();
+    // 当前文件被合并进规范存储，或者要选中刚下载的文件时，切换并加载
+    if (populateDataFiles(select))
+      onDataFileSelected(ui->dataFileComboBox->currentIndex());
+    statusBar()->showMessage(QString("数据索引已更新: %1 个数据集").arg(catalog_.datasets().size()),
+                             3000);
+  }
+  if (catalog_again_)
+    refreshCatalog();
+}
+
+bool MainWindow::populateDataFiles(const QString &select_path) {
+  QSignalBlocker blocker(ui->dataFileComboBox);
+  // 数据目录之外手动添加的文件不在索引中，保留在列表最前面
+  QStringList external;
+  for (const QString &path : std::as_const(all_data_files_)) {
+    if (!isInDataDirectory(path))
+      external.append(path);
+  }
   ui->dataFileComboBox->clear();
   all_data_files_.clear();
-  QStringList filters;
-  filters << "*.csv";
-  QFileInfoList fileList = directory.entryInfoList(filters, QDir::Files, QDir::Time);
-  for (const QFileInfo &fileInfo : std::as_const(fileList)) {
-    QString fileName = fileInfo.fileName();
-    ui->dataFileComboBox->addItem(fileName);
-    all_data_files_.append(fileInfo.absoluteFilePath());
+  for (const QString &path : std::as_const(external)) {
+    ui->dataFileComboBox->addItem(QFileInfo(path).fileName());
+    all_data_files_.append(path);
+  }
+  const QVector<DatasetEntry> datasets = catalog_.datasets();
+  for (const DatasetEntry &entry : datasets) {
+    QString tooltip = QString("%1条K线\n%2 ~ %3")
+                          .arg(entry.rows)
+                          .arg(QDateTime::fromMSecsSinceEpoch(entry.first_timestamp, QTimeZone::utc())
+                                   .toString("yyyy-MM-dd HH:mm"),
+                               QDateTime::fromMSecsSinceEpoch(entry.last_timestamp, QTimeZone::utc())
+                                   .toString("yyyy-MM-dd HH:mm"));
+    if (entry.hasSource())
+      tooltip.prepend(QString("%1 %2 %3\n").arg(entry.exchange, entry.symbol, entry.timeframe));
+    if (!entry.sources.isEmpty())
+      tooltip += "\n合并自: " + entry.sources.join(", ");
+    ui->dataFileComboBox->addItem(entry.file_name);
+    ui->dataFileComboBox->setItemData(ui->dataFileComboBox->count() - 1, tooltip, Qt::ToolTipRole);
+    all_data_files_.append(catalog_.filePath(entry));
   }
-  if (fileList.isEmpty()) {
+  if (all_data_files_.isEmpty()) {
     ui->dataFileComboBox->addItem("暂无数据文件，请先下载数据");
+    return false;
   }
-  statusBar()->showMessage(QString("已加载 %1 个数据文件").arg(fileList.size()), 3000);
+  const QString target = catalog_.canonicalPath(select_path.isEmpty() ? current_data_file_
+                                                                      : select_path);
+  const int index = qMax(0, int(all_data_files_.indexOf(target)));
+  ui->dataFileComboBox->setCurrentIndex(index);
+  return all_data_files_[index] != current_data_file_;
+}
+
+bool MainWindow::isInDataDirectory(const QString &file_path) {
+  const QString directory = QFileInfo(file_path).absolutePath();
+  const QString data_dir = getDataDirectory();
+  return directory == QDir(data_dir).absolutePath()
+         || directory == QDir(DatasetCatalog::storeDirectory(data_dir)).absolutePath();
 }
 
 void MainWindow::initializeStrategies() {
@@ -164,18 +915,32 @@ void MainWindow::initializeStrategies() {
   QDir directory(strategiesDir);
   ui->strategyComboBox->clear();
   all_strategy_files_.clear();
-  QStringList filters;
-  filters << "*.py";
-  QFileInfoList fileList = directory.entryInfoList(filters, QDir::Files, QDir::Name);
+  strategy_plugins_.clear();
+  QFileInfoList fileList = directory.entryInfoList(QDir::Files, QDir::Name);
   for (const QFileInfo &fileInfo : std::as_const(fileList)) {
     QString fileName = fileInfo.fileName();
-    ui->strategyComboBox->addItem(fileName);
-    all_strategy_files_.append(fileInfo.absoluteFilePath());
-  }
-  if (fileList.isEmpty()) {
-    // TODO: 可以在这里创建默认策略文件
-    ui->strategyComboBox->addItem("暂无策略文件");
+    if (fileInfo.suffix() == "py") {
+      ui->strategyComboBox->addItem(fileName);
+      all_strategy_files_.append(fileInfo.absoluteFilePath());
+      continue;
+    }
+    if (!StrategyPlugin::isPluginFile(fileName))
+      continue;
+    // C++策略插件，加载后以插件自带的名称显示
+    auto plugin = std::make_shared<StrategyPlugin>();
+    QString error;
+    if (!plugin->load(fileInfo.absoluteFilePath(), error)) {
+      qDebug() << error;
+      continue;
+    }
+    ui->strategyComboBox->addItem(plugin->name() + " (C++)");
+    ui->strategyComboBox->setItemData(ui->strategyComboBox->count() - 1, plugin->description(), Qt::ToolTipRole);
+    all_strategy_files_.append(plugin->filePath());
+    strategy_plugins_.insert(plugin->filePath(), plugin);
   }
+  // 内置策略始终可用，排在文件策略之后
+  ui->strategyComboBox->addItem("均线交叉 MA10/MA30 (内置)");
+  all_strategy_files_.append(kMaCrossStrategyId);
 }
 
 void MainWindow::initializeChart() {
@@ -189,6 +954,7 @@ void MainWindow::initializeChart() {
   candle_series_->setDecreasingColor(Qt::green);
   candle_series_->setBodyWidth(0.8);
   price_chart_->addSeries(candle_series_);
+  candle_window_.setSeries(candle_series_);
 
   // 信号散点
   buy_series_ = new QScatterSeries();
@@ -225,13 +991,127 @@ void MainWindow::initializeChart() {
   chart_view_ = new QChartView(price_chart_);
   chart_view_->setRenderHints(QPainter::Antialiasing);
 
+  chart_view_->viewport()->installEventFilter(this); // 滚轮缩放
+
   scroll_bar_ = new QSlider(Qt::Horizontal);
   connect(scroll_bar_, &QSlider::valueChanged, this, &MainWindow::onScrollChanged);
 
+  // 周期选择：自动时随缩放切换，选定周期后回测也使用该周期
+  auto *timeframe_layout = new QHBoxLayout();
+  timeframe_layout->addWidget(new QLabel("周期:"));
+  timeframe_combo_ = new QComboBox();
+  timeframe_combo_->setToolTip("自动：随滚轮缩放切换显示周期，回测使用原始周期");
+  timeframe_layout->addWidget(timeframe_combo_);
+  // 实时模式：按所选速度回放当前数据文件；设置QTBACKTESTER_LIVE_FEED=tcp://host:port时
+  // 改为连接本地行情服务（scripts/mockohlcvserver.py --feed-port）
+  timeframe_layout->addSpacing(16);
+  timeframe_layout->addWidget(new QLabel("回放速度:"));
+  live_speed_combo_ = new QComboBox();
+  live_speed_combo_->addItem("1x", 1.0);
+  live_speed_combo_->addItem("60x", 60.0);
+  live_speed_combo_->addItem("600x", 600.0);
+  live_speed_combo_->addItem("3600x", 3600.0);
+  live_speed_combo_->addItem("最快", 0.0);
+  live_speed_combo_->setCurrentIndex(1);
+  live_speed_combo_->setToolTip("K线时间与实际时间之比，60x时1分钟K线每秒一根");
+  timeframe_layout->addWidget(live_speed_combo_);
+  live_button_ = new QPushButton("实时");
+  live_button_->setCheckable(true);
+  live_button_->setToolTip("逐根接收K线，内置均线策略随每根K线增量计算并撮合");
+  timeframe_layout->addWidget(live_button_);
+  connect(live_button_, &QPushButton::clicked, this, &MainWindow::onLiveClicked);
+  timeframe_layout->addStretch();
+  live_label_ = new QLabel();
+  timeframe_layout->addWidget(live_label_);
+  connect(timeframe_combo_,
+          QOverload<int>::of(&QComboBox::currentIndexChanged),
+          this,
+          &MainWindow::onTimeframeChanged);
+
+  ui->chartLayout->addLayout(timeframe_layout);
   ui->chartLayout->addWidget(chart_view_);
   ui->chartLayout->addWidget(scroll_bar_);
 }
 
+bool MainWindow::readBacktestConfig(BacktestConfig &config) {
+  bool capital_ok = false;
+  bool commission_ok = false;
+  bool slippage_ok = false;
+  config.initial_capital = ui->initialCapitalLineEdit->text().toDouble(&capital_ok);
+  config.commission = ui->commissionLineEdit->text().toDouble(&commission_ok);
+  config.slippage = ui->slippageLineEdit->text().toDouble(&slippage_ok);
+  if (!capital_ok || config.initial_capital <= 0.0) {
+    showError("初始资金必须是正数");
+    return false;
+  }
+  if (!commission_ok || config.commission < 0.0 || config.commission >= 1.0) {
+    showError("手续费必须在0到1之间");
+    return false;
+  }
+  if (!slippage_ok || config.slippage < 0.0 || config.slippage >= 1.0) {
+    showError("滑点必须在0到1之间");
+    return false;
+  }
+  return true;
+}
+
+void MainWindow::finishBacktest(const BacktestResult &result,
+                                const BacktestConfig &config,
+                                int level,
+                                qint64 elapsed_ms) {
+  const KLinePyramid::Level &data = session_->pyramid().level(level);
+  showBacktestResult(result);
+  result_level_ = level;
+  result_config_ = config;
+  QString message = QString("回测完成: %1 %2条K线, 耗时%3毫秒")
+                        .arg(data.name)
+                        .arg(data.bars.size())
+                        .arg(elapsed_ms);
+  const Profiler::AllocationCounting counting = Profiler::allocationCounting();
+  if (counting != Profiler::AllocationCounting::None) {
+    message += QString(", 逐K线循环内%1%2次")
+                   .arg(counting == Profiler::AllocationCounting::Malloc ? "堆分配" : "operator new")
+                   .arg(result.loop_allocations);
+  }
+  statusBar()->showMessage(message, 5000);
+}
+
+void MainWindow::showBacktestResult(const BacktestResult &result) {
+  signals_ = result.trade_signals;
+  ui->initialCapitalValueLabel->setText(QString::number(result.initial_capital, 'f', 2));
+  ui->finalCapitalValueLabel->setText(QString::number(result.final_capital, 'f', 2));
+  ui->totalTradesValueLabel->setText(QString::number(result.total_trades));
+  ui->winRateValueLabel->setText(QString::number(result.win_rate * 100.0, 'f', 2) + "%");
+  ui->maxDrawdownValueLabel->setText(QString::number(result.max_drawdown * 100.0, 'f', 2) + "%");
+  ui->maxAdverseValueLabel->setText(QString::number(result.max_adverse_excursion * 100.0, 'f', 2)
+                                    + "%");
+
+  QList<QPointF> buy_points;
+  QList<QPointF> sell_points;
+  for (const TradeSignal &signal : std::as_const(signals_)) {
+    QPointF point(signal.timestamp, signal.price);
+    if (signal.type == SignalType::Buy)
+      buy_points.append(point);
+    else
+      sell_points.append(point);
+  }
+  // 一次性替换，避免逐点append触发重绘
+  buy_series_->replace(buy_points);
+  sell_series_->replace(sell_points);
+}
+
+void MainWindow::clearBacktestResult() {
+  signals_.clear();
+  result_level_ = -1;
+  buy_series_->clear();
+  sell_series_->clear();
+  ui->finalCapitalValueLabel->setText("0.00");
+  ui->totalTradesValueLabel->setText("0");
+  ui->winRateValueLabel->setText("0.00%");
+  ui->maxDrawdownValueLabel->setText("0.00%");
+  ui->maxAdverseValueLabel->setText("0.00%");
+}
+
 void MainWindow::showError(const QString &message) {
   // 状态栏显示更长时间
   statusBar()->showMessage("错误: " + message, 10000); // 10秒
@@ -244,18 +1124,20 @@ void MainWindow::showError(const QString &message) {
   msgBox.exec();
 }
 
-void MainWindow::showProgress(const QString &message) {
-  statusBar()->showMessage(message, 3000);
-  progress_dialog_->setLabelText(message);
-  progress_dialog_->show();
-  QApplication::processEvents(); // 处理事件循环，确保UI更新
-}
-
-void MainWindow::clearProgress() {
-  statusBar()->clearMessage();
-  if (progress_dialog_) {
-    progress_dialog_->hide();
+bool MainWindow::checkSessionReady() {
+  if (live_view_) {
+    showError("请先退出实时模式");
+    return false;
+  }
+  if (load_thread_ || session_->isPreview()) {
+    showError("数据仍在加载，请稍候");
+    return false;
   }
+  if (session_->isEmpty()) {
+    showError("请先加载数据文件");
+    return false;
+  }
+  return true;
 }
 
 QString MainWindow::getDataDirectory() {
@@ -301,6 +1183,11 @@ void MainWindow::addDataFileToComboBox(const QString &file_path, bool userAdded)
     showError(QString("文件不存在: %1").arg(file_path));
     return;
   }
+  // 数据目录中的文件由索引管理，刷新后选中它（已合并时选中合并存储）
+  if (isInDataDirectory(file_path)) {
+    refreshCatalog(file_path);
+    return;
+  }
   int empty_index = ui->dataFileComboBox->findText("暂无数据文件，请先下载数据");
   if (empty_index >= 0) {
     ui->dataFileComboBox->removeItem(empty_index);
@@ -330,17 +1217,6 @@ void MainWindow::addDataFileToComboBox(const QString &file_path, bool userAdded)
   }
 }
 
-bool MainWindow::checkPythonEnvironment() {
-  showProgress("检查Python环境和依赖...");
-  QProcess process;
-  process.start("python", {"--version"});
-  if (!process.waitForFinished(5000) || process.exitCode() != 0) {
-    showError("未找到Python环境，请先安装Python 3.7+");
-    return false;
-  }
-  return true;
-}
-
 int MainWindow::calculateEstimatedBars(const QDateTime &start,
                                        const QDateTime &end,
                                        const QString &timeframe) {
@@ -355,144 +1231,196 @@ int MainWindow::calculateEstimatedBars(const QDateTime &start,
   return totalSeconds / secondsPerBarValue + 1;
 }
 
-bool MainWindow::downloadDataChunk(const QString &exchange,
-                                   const QString &symbol,
-                                   const QString &timeframe,
-                                   const QDateTime &startTime,
-                                   int estimatedBars,
-                                   const QString &outputPath) {
-  QDir appDir(QCoreApplication::applicationDirPath());
-  QString scriptPath = appDir.absoluteFilePath("scripts/downloaddata.py");
-  if (scriptPath.isEmpty()) {
-    showError("找不到Python脚本文件: downloaddata.py");
-    return false;
+void MainWindow::appendKLineData(qint64 offset) {
+  if (load_thread_ || session_->isPreview()) {
+    startLoading(current_data_file_); // 加载途中文件有变化，重新加载
+    return;
   }
-
-  QStringList scriptArgs;
-  scriptArgs << "--exchange" << exchange << "--symbol" << symbol << "--timeframe" << timeframe
-             << "--start" << startTime.toString("yyyy-MM-dd HH:mm:ss") << "--limit"
-             << QString::number(estimatedBars) << "--output" << outputPath << "--proxy"
-             << "http://127.0.0.1:7890";
-  QProcess process;
-  process.start("py", QStringList(scriptPath) + scriptArgs);
-  if (!process.waitForFinished(30000)) {
-    process.kill();
-    showError("下载超时");
-    return false;
+  if (backtest_thread_) {
+    // 回测线程正在读当前会话，不能原地修改；多次更新取最早的偏移，已有的K线按时间跳过
+    pending_append_offset_ = pending_append_offset_ < 0 ? offset : qMin(pending_append_offset_, offset);
+    return;
   }
-  if (process.exitCode() != 0) {
-    QString errorOutput = process.readAllStandardError();
-    showError("下载失败: " + errorOutput);
-    return false;
+  qsizetype added = session_->append(offset);
+  if (added < 0) {
+    showError("读取新增数据失败");
+    return;
   }
-  return true;
+  if (added == 0)
+    return;
+  syncStrategyBars();
+  if (live_view_)
+    return; // 退出实时模式时按新数据重建图表
+
+  // 图表只按可见区间重新填值，原来停在最右端时跟随到最新
+  const QVector<KLineData> &bars = chartBars();
+  candle_window_.setData(&bars);
+  bool at_end = scroll_bar_->value() >= scroll_bar_->maximum();
+  int maxIndex = qMax(0, int(bars.size()) - visible_count_);
+  scroll_bar_->setRange(0, maxIndex);
+  if (at_end)
+    scroll_bar_->setValue(maxIndex);
+  setChartRange(scroll_bar_->value());
 }
 
-void MainWindow::executeSingleDownload(const QString &exchange,
-                                       const QString &symbol,
-                                       const QString &timeframe,
-                                       const QDateTime &startTime,
-                                       int estimatedBars,
-                                       const QString &outputPath) {
-  showProgress("正在下载...");
-  if (downloadDataChunk(exchange, symbol, timeframe, startTime, estimatedBars, outputPath)) {
-    clearProgress();
-    addDataFileToComboBox(outputPath, false);
-    ui->dataFileComboBox->setCurrentIndex(0);
-    QMessageBox::information(this,
-                             "下载完成",
-                             QString("数据下载完成！\n"
-                                     "交易所: %1\n"
-                                     "交易对: %2\n"
-                                     "时间周期: %3\n"
-                                     "输出文件: %4")
-                                 .arg(exchange)
-                                 .arg(symbol)
-                                 .arg(timeframe)
-                                 .arg(outputPath));
-  } else {
-    clearProgress();
-    // 错误已经在downloadDataChunk中显示
+void MainWindow::buildChartBasic(qint64 anchor_ms) {
+  ProfileScope scope("chart.build");
+  // 多周期金字塔在加载时已经建好，之后缩放和切换周期不再读盘
+  const KLinePyramid &pyramid = session_->pyramid();
+  {
+    QSignalBlocker blocker(timeframe_combo_);
+    timeframe_combo_->clear();
+    timeframe_combo_->addItem("自动");
+    for (int i = 0; i < pyramid.levelCount(); i++)
+      timeframe_combo_->addItem(pyramid.level(i).name);
   }
+  auto_level_ = true;
+  visible_count_ = kDefaultVisibleCount;
+  if (pyramid.levelCount() == 0) {
+    candle_window_.setData(nullptr);
+    candle_window_.clear();
+    return;
+  }
+  scroll_bar_->setSingleStep(1);
+  showLevel(0, anchor_ms);
 }
 
-bool MainWindow::loadKLineData(const QString &filePath) {
-  QFile file(filePath);
-  if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-    qDebug() << "无法打开文件:" << filePath;
-    return false;
-  }
-  QTextStream in(&file);
-  current_kline_data_.clear();
-  QString header = in.readLine();
-  if (!header.contains("timestamp")) {
-    qDebug() << "CSV文件缺少表头";
-    return false;
+void MainWindow::showLevel(int level, qint64 anchor_ms) {
+  display_level_ = level;
+  const QVector<KLineData> &bars = chartBars();
+  candle_window_.setData(&bars);
+  bool intraday = chartLevel().msecs < 24 * 3600 * 1000;
+  axis_x_->setFormat(intraday ? "MM-dd HH:mm" : "yyyy-MM-dd");
+
+  // 以锚点时间为中心定位到新周期中的对应位置
+  auto it = std::lower_bound(bars.begin(),
+                             bars.end(),
+                             anchor_ms,
+                             [](const KLineData &bar, qint64 value) {
+                               return bar.timestamp < value;
+                             });
+  int maxIndex = qMax(0, int(bars.size()) - visible_count_);
+  int start = qBound(0, int(it - bars.begin()) - visible_count_ / 2, maxIndex);
+  {
+    QSignalBlocker blocker(scroll_bar_);
+    scroll_bar_->setRange(0, maxIndex);
+    scroll_bar_->setPageStep(visible_count_);
+    scroll_bar_->setValue(start);
   }
+  setChartRange(start);
+}
 
-  while (!in.atEnd()) {
-    QString line = in.readLine();
-    if (line.trimmed().isEmpty())
-      continue;
-    QStringList f = line.split(',');
-    if (f.size() < 6)
-      continue;
-    KLineData d;
-    bool ok;
-    d.timestamp = f[0].toLongLong(&ok);
-    if (!ok)
-      continue;
-    d.open = f[1].toDouble();
-    d.high = f[2].toDouble();
-    d.low = f[3].toDouble();
-    d.close = f[4].toDouble();
-    d.volume = f[5].toDouble();
-    current_kline_data_.append(d);
-  }
-  file.close();
-  std::sort(current_kline_data_.begin(), current_kline_data_.end(), [](auto &a, auto &b) {
-    return a.timestamp < b.timestamp;
-  });
-  return !current_kline_data_.isEmpty();
+void MainWindow::zoomChart(double factor) {
+  if (!hasChartData())
+    return;
+  const QVector<KLineData> &bars = chartBars();
+  qint64 anchor = bars[qMin(scroll_bar_->value() + visible_count_ / 2, int(bars.size()) - 1)]
+                      .timestamp;
+  int level = display_level_;
+  int visible = qBound(kMinVisibleCount, qRound(visible_count_ * factor), kMaxVisibleCount);
+  if (auto_level_) {
+    // 可见K线过多时换到更粗的周期，过少时换回更细的周期，时间跨度保持不变
+    while (visible > kCoarsenThreshold && level + 1 < session_->pyramid().levelCount()) {
+      qint64 ratio = session_->pyramid().level(level + 1).msecs / session_->pyramid().level(level).msecs;
+      visible = qMax(kMinVisibleCount, int(visible / ratio));
+      level++;
+    }
+    while (visible < kRefineThreshold && level > 0) {
+      qint64 ratio = session_->pyramid().level(level).msecs / session_->pyramid().level(level - 1).msecs;
+      visible = qMin(kMaxVisibleCount, int(visible * ratio));
+      level--;
+    }
+  }
+  visible_count_ = visible;
+  showLevel(level, anchor);
 }
 
-void MainWindow::buildChartBasic() {
-  candle_series_->clear();
-  if (current_kline_data_.isEmpty())
+void MainWindow::onTimeframeChanged(int index) {
+  if (live_view_ || session_->pyramid().levelCount() == 0 || index < 0)
     return;
-  for (auto &d : current_kline_data_) {
-    auto *set = new QCandlestickSet(d.open, d.high, d.low, d.close, d.timestamp);
-    candle_series_->append(set);
+  auto_level_ = index == 0;
+  if (auto_level_) {
+    zoomChart(1.0); // 按当前缩放重新选择周期
+  } else {
+    const QVector<KLineData> &bars = chartBars();
+    qint64 anchor = bars[qMin(scroll_bar_->value() + visible_count_ / 2, int(bars.size()) - 1)]
+                        .timestamp;
+    int level = index - 1;
+    // 换算可见数量，尽量保持相同的时间跨度
+    double ratio = double(session_->pyramid().level(display_level_).msecs) / session_->pyramid().level(level).msecs;
+    visible_count_ = qBound(kMinVisibleCount, qRound(visible_count_ * ratio), kMaxVisibleCount);
+    showLevel(level, anchor);
   }
+  syncStrategyBars();
+  statusBar()->showMessage(QString("回测周期: %1 (%2条K线)")
+                               .arg(session_->pyramid().level(backtestLevel()).name)
+                               .arg(backtestBars().size()),
+                           3000);
+}
 
-  int maxIndex = qMax(0, current_kline_data_.size() - visible_count_);
-  scroll_bar_->setRange(0, maxIndex);
-  scroll_bar_->setPageStep(visible_count_);
-  scroll_bar_->setSingleStep(1);
-  setChartRange(0);
+bool MainWindow::eventFilter(QObject *watched, QEvent *event) {
+  // 滚轮缩放K线图，每格缩放20%
+  if (event->type() == QEvent::Wheel && chart_view_ && watched == chart_view_->viewport()) {
+    int delta = static_cast<QWheelEvent *>(event)->angleDelta().y();
+    if (delta != 0)
+      zoomChart(delta > 0 ? 0.8 : 1.25);
+    return true;
+  }
+  return QMainWindow::eventFilter(watched, event);
+}
+
+const QVector<KLineData> &MainWindow::chartBars() const {
+  return chartLevel().bars;
+}
+
+const KLinePyramid::Level &MainWindow::chartLevel() const {
+  return live_view_ ? live_level_ : session_->pyramid().level(display_level_);
+}
+
+bool MainWindow::hasChartData() const {
+  return live_view_ ? !live_level_.bars.isEmpty() : session_->pyramid().levelCount() > 0;
+}
+
+int MainWindow::backtestLevel() const {
+  // 自动模式下按原始周期回测，选定周期后图表和回测使用同一层数据
+  return auto_level_ ? 0 : display_level_;
+}
+
+const QVector<KLineData> &MainWindow::backtestBars() const {
+  const KLinePyramid &pyramid = session_->pyramid();
+  return pyramid.levelCount() > 0 ? pyramid.bars(backtestLevel()) : session_->bars();
+}
+
+std::shared_ptr<IndicatorCache> MainWindow::backtestIndicators() const {
+  return session_->indicators(backtestLevel());
+}
+
+void MainWindow::syncStrategyBars() {
+  if (session_->isPreview())
+    return; // 完整数据加载完后再发
+  session_->sendBars(strategy_worker_, backtestLevel());
 }
 
 void MainWindow::setChartRange(int value) {
-  if (current_kline_data_.isEmpty())
+  ProfileScope scope("chart.setRange");
+  if (!hasChartData())
     return;
-  int maxStart = qMax(0, current_kline_data_.size() - visible_count_);
+  const KLinePyramid::Level &level = chartLevel();
+  const QVector<KLineData> &bars = level.bars;
+  int maxStart = qMax(0, int(bars.size()) - visible_count_);
   int start_index = qBound(0, value, maxStart);
-  int end_index = qMin(start_index + visible_count_, current_kline_data_.size());
+  int end_index = qMin(start_index + visible_count_, int(bars.size()));
+  candle_window_.showRange(start_index, visible_count_);
 
-  qint64 interval = (current_kline_data_.size() >= 2)
-                        ? (current_kline_data_[1].timestamp - current_kline_data_[0].timestamp)
-                        : (24 * 3600 * 1000);
-  qint64 start_ms = current_kline_data_[start_index].timestamp - interval / 2;
-  qint64 end_ms = current_kline_data_[end_index - 1].timestamp + interval / 2;
+  qint64 interval = level.msecs;
+  qint64 start_ms = bars[start_index].timestamp - interval / 2;
+  qint64 end_ms = bars[end_index - 1].timestamp + interval / 2;
   axis_x_->setRange(QDateTime::fromMSecsSinceEpoch(start_ms),
                     QDateTime::fromMSecsSinceEpoch(end_ms));
 
-  double min_p = current_kline_data_[start_index].low,
-         max_p = current_kline_data_[start_index].high;
-  for (int i = start_index + 1; i < end_index; i++) {
-    min_p = qMin(min_p, current_kline_data_[i].low);
-    max_p = qMax(max_p, current_kline_data_[i].high);
-  }
+  // 区间最值查询与可见数量无关，缩放到上千根K线时滚动也不需要逐根扫描
+  double min_p = level.index.min(start_index, end_index - 1);
+  double max_p = level.index.max(start_index, end_index - 1);
   double margin = (max_p - min_p) * 0.1;
   axis_y_->setRange(min_p - margin, max_p + margin);
 }
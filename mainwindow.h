@@ -1,9 +1,25 @@
 #ifndef MAINWINDOW_H
 #define MAINWINDOW_H
 
+#include "backtestengine.h"
+#include "backtestsession.h"
+#include "batchdownloader.h"
+#include "datasetcatalog.h"
+#include "klinedata.h"
+#include "livefeed.h"
+#include "portfoliobacktest.h"
+#include "strategyplugin.h"
+#include "strategyworker.h"
+#include "virtualcandleseries.h"
+
+#include <QElapsedTimer>
+#include <QHash>
 #include <QMainWindow>
 #include <QVector>
 
+#include <atomic>
+#include <memory>
+
 class QChart;
 class QChartView;
 class QCandlestickSeries;
@@ -11,24 +27,14 @@ class QScatterSeries;
 class QValueAxis;
 class QDateTimeAxis;
 class QSlider;
+class QProgressBar;
+class QPushButton;
 class QProgressDialog;
-
-struct KLineData {
-  qint64 timestamp;
-  double open;
-  double high;
-  double low;
-  double close;
-  double volume;
-};
-
-enum class SignalType { Buy, Sell };
-
-struct TradeSignal {
-  qint64 timestamp;
-  double price;
-  SignalType type;
-};
+class QComboBox;
+class QThread;
+class QLabel;
+class DownloadManager;
+class ProfilerPanel;
 
 QT_BEGIN_NAMESPACE
 namespace Ui {
@@ -46,10 +52,38 @@ public:
 private slots:
   void onDataFileSelected(int index); // dataFileComboBox选择变化
   void onDownloadDataClicked();       // downloadDataButton点击
+  void onUpdateDataClicked();         // updateDataButton点击，增量更新当前文件
   void onAddFileClicked();            // addFileButton点击
   void onScrollChanged(int value);
+  void onTimeframeChanged(int index); // 周期选择变化
+  void onStartBacktestClicked();      // startBacktestButton点击
+  void onSweepClicked();              // sweepButton点击
+  void onWalkForwardClicked();        // walkForwardButton点击，滚动优化
+  void onPortfolioClicked();          // portfolioButton点击，多品种组合回测
+  void onMonteCarloClicked();         // monteCarloButton点击，对最近一次回测做蒙特卡洛分析
+  void onLiveClicked(bool checked);   // 实时按钮，开始或退出实时模式
+  void onStrategySignalsReady(const StrategySignals& result);
+  void onStrategyFailed(const QString& message);
+  void onDownloadStarted(const DownloadRequest& request, int queued);
+  void onDownloadProgress(qint64 fetched_bars, qint64 total_bars);
+  void onDownloadFinished(const DownloadRequest& request,
+                          bool success,
+                          const QString& message,
+                          qint64 rows);
+  void onDownloadCancelled(const DownloadRequest& request);
+
+protected:
+  bool eventFilter(QObject* watched, QEvent* event) override; // 图表滚轮缩放
 
 private:
+  static constexpr int kDefaultVisibleCount = 60;
+  static constexpr int kMinVisibleCount = 20;
+  static constexpr int kMaxVisibleCount = 2000;
+  static constexpr int kCoarsenThreshold = 240; // 自动周期：可见K线超过此数换更粗的周期
+  static constexpr int kRefineThreshold = 40;   // 少于此数换回更细的周期
+  static constexpr int kPreviewBars = 2000;     // 后台加载时先显示的最新K线数
+  static constexpr int kLiveReserveBars = 1 << 16; // 实时模式预留的K线数，超出后按倍数扩容
+
   //初始化函数
   void initializeApplication();
   void initializeDataFiles();
@@ -57,9 +91,18 @@ private:
   void initializeChart();
 
   //辅助信息展示
-  void showError(const QString& message);    // 显示错误信息
-  void showProgress(const QString& message); // 显示进度信息
-  void clearProgress();                      // 清除进度显示
+  void showError(const QString& message); // 显示错误信息
+  bool checkSessionReady();               // 数据未加载或仍在加载时提示并返回false
+
+  //后台加载：先显示文件末尾的预览，完整数据加载完后替换；切换文件时取消上一次加载
+  void startLoading(const QString& file_path);
+  void cancelLoading();
+  void onLoadProgress(int generation, int permille);
+  void finishLoading(int generation,
+                     bool ok,
+                     const std::shared_ptr<BacktestSession>& session,
+                     qint64 elapsed_ms);
+  void setSession(const std::shared_ptr<BacktestSession>& session);
 
   //获取相关文件
   QString getDataDirectory();
@@ -68,50 +111,119 @@ private:
   QString getStrategiesFilePath(const QString& file_path);
 
   //图表展示相关
-  bool loadKLineData(const QString& file_path);
-  void buildChartBasic();
+  void appendKLineData(qint64 offset); // 合并增量更新追加的K线
+  void buildChartBasic(qint64 anchor_ms);
+  void showLevel(int level, qint64 anchor_ms); // 切换显示周期，以anchor_ms为中心
+  void zoomChart(double factor);
   void setChartRange(int value);
+  const QVector<KLineData>& chartBars() const;
+
+  //回测相关
+  bool readBacktestConfig(BacktestConfig& config);
+  int backtestLevel() const;
+  const QVector<KLineData>& backtestBars() const;
+  std::shared_ptr<IndicatorCache> backtestIndicators() const;
+  void syncStrategyBars(); // 回测周期变化后把对应的K线发给Python进程
+  // 内置均线策略和插件策略在后台线程回测，结束后回到界面线程显示；期间换了数据则丢弃结果
+  void startNativeBacktest(int level,
+                           const BacktestConfig& config,
+                           const std::shared_ptr<StrategyPlugin>& plugin); // plugin为空时跑均线交叉
+  void finishNativeBacktest(int generation,
+                            const std::shared_ptr<BacktestSession>& session,
+                            const BacktestResult& result,
+                            const BacktestConfig& config,
+                            int level,
+                            qint64 elapsed_ms);
+  void finishBacktest(const BacktestResult& result,
+                      const BacktestConfig& config,
+                      int level,
+                      qint64 elapsed_ms);
+  void showBacktestResult(const BacktestResult& result);
+  void clearBacktestResult();
+  void finishPortfolio(bool ok, const QString& error, const PortfolioResult& result, qint64 elapsed_ms);
+
+  //数据目录索引：启动时按上次的索引列出数据集，目录变化和重复数据的合并在后台刷新
+  void refreshCatalog(const QString& select_path = QString()); // 刷新后选中select_path所在的数据集
+  void finishCatalogRefresh(bool ok, const QString& error, bool changed, const DatasetCatalog& catalog);
+  bool populateDataFiles(const QString& select_path); // 重建数据文件列表，选中项变化时返回true
+  bool isInDataDirectory(const QString& file_path);
+
+  //实时模式：K线逐根到达，图表只追加新K线；数据源结束后保留图表和结果，直到退出实时模式
+  void startLive();
+  void stopLive();
+  void onLiveUpdates(); // 引擎线程有新结果时投递过来，一次取完
+  void finishLive(); // 停止行情线程并显示整个过程的回测结果
+  bool hasChartData() const;
+  const KLinePyramid::Level& chartLevel() const; // 图表当前显示的数据，实时模式下为实时K线
 
   //下载相关
   void addDataFileToComboBox(const QString& filePath, bool need_copied = true);
-  bool checkPythonEnvironment();
   int calculateEstimatedBars(const QDateTime& start,
                              const QDateTime& end,
                              const QString& timeframe); // 计算预估数据条数
-  bool downloadDataChunk(const QString& exchange,
-                         const QString& symbol,
-                         const QString& timeframe,
-                         const QDateTime& startTime,
-                         int estimatedBars,
-                         const QString& outputPath);
-  void executeSingleDownload(const QString& exchange,
-                             const QString& symbol,
-                             const QString& timeframe,
-                             const QDateTime& startTime,
-                             int estimatedBars,
-                             const QString& outputPath);
 
 private:
   Ui::MainWindow* ui;
-  QProgressDialog* progress_dialog_;
+  QProgressBar* load_progress_; // 状态栏中的加载进度，空闲时隐藏
+  QProgressDialog* download_progress_;
+  DownloadManager* download_manager_;
+  QString download_label_; // 当前下载任务的描述
+  StrategyWorker* strategy_worker_;
+  BacktestConfig pending_config_; // 等待Python策略返回时的回测参数
+  int pending_level_;             // 该次回测使用的周期
+  std::weak_ptr<BacktestSession> pending_session_; // 发出该次回测时的数据，返回时已更换则丢弃结果
+  qsizetype pending_bars_;                         // 发出时该周期的K线数，追加数据后信号下标不再对应
+  QElapsedTimer backtest_timer_;
+  QProgressDialog* portfolio_progress_;
+  QThread* portfolio_thread_; // 组合回测在后台线程运行
+  std::atomic<bool> portfolio_cancelled_;
+  ProfilerPanel* profiler_panel_;
+  QLabel* profiler_label_; // 状态栏右侧显示耗时最多的几个阶段
+  QThread* load_thread_;   // 数据文件在后台线程加载
+  std::atomic<bool> load_cancelled_;
+  int load_generation_; // 每次开始加载加一，丢弃已取消的加载投递回来的结果
+  qint64 preview_ms_;   // 本次加载显示预览所用的时间，-1表示还没有显示
+  QThread* backtest_thread_;      // 单次回测在后台线程运行
+  int backtest_generation_;       // 每次开始回测或加载加一，丢弃过期的回测结果
+  qint64 pending_append_offset_;  // 回测期间收到的追加数据的文件偏移，-1表示没有
+  DatasetCatalog catalog_;
+  QThread* catalog_thread_;
+  bool catalog_again_;     // 刷新期间又有文件变化，结束后再刷新一次
+  QString catalog_select_; // 刷新完成后要选中的文件
+  std::unique_ptr<LiveFeed> live_feed_; // 实时行情，数据源结束后释放
+  bool live_view_;                      // 图表显示实时K线
+  KLinePyramid::Level live_level_;      // 实时收到的K线和区间最值索引，逐根追加
+  QVector<LiveUpdate> live_updates_;    // 每次通知取出的结果，缓冲区复用
+  LatencyStats live_latency_;
+  QPushButton* live_button_;
+  QComboBox* live_speed_combo_;
+  QLabel* live_label_; // 图表上方显示信号延迟
 
   QChart* price_chart_;
   QChartView* chart_view_;
   QCandlestickSeries* candle_series_;
+  VirtualCandleSeries candle_window_; // 只把可见区间的K线放进candle_series_
   QScatterSeries* buy_series_;
   QScatterSeries* sell_series_;
   QDateTimeAxis* axis_x_;
   QValueAxis* axis_y_;
   QSlider* scroll_bar_;
+  QComboBox* timeframe_combo_;
 
-  QVector<KLineData> current_kline_data_;
+  // 当前数据文件的K线、列式缓存和多周期金字塔；加载线程建好后整体替换，不会为空
+  std::shared_ptr<BacktestSession> session_;
   QVector<TradeSignal> signals_;
+  int result_level_;             // signals_所在的金字塔层，-1表示没有可供分析的回测结果
+  BacktestConfig result_config_; // 产生signals_的回测参数
   QStringList all_data_files_;
   QString current_data_file_;
-  QStringList all_strategy_files_;
+  QStringList all_strategy_files_; // Python策略和C++插件为文件路径，内置策略为标识
+  QHash<QString, std::shared_ptr<StrategyPlugin>> strategy_plugins_; // 按文件路径索引已加载的插件
   QString current_strategy_file_;
 
-  int visible_count_;
+  int display_level_; // 图表当前显示的金字塔层
+  bool auto_level_;   // 自动按缩放选择周期
+  int visible_count_; // 图表可见的K线数（按当前显示周期计）
 };
 
 #endif // MAINWINDOW_H
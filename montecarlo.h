@@ -0,0 +1,117 @@
+#ifndef MONTECARLO_H
+#define MONTECARLO_H
+
+#include "backtestengine.h"
+#include "klinedata.h"
+#include "taskpool.h"
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QVector>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+class QTimer;
+
+struct MonteCarloSpec {
+  enum class Method {
+    TradeResample, // 已平仓交易的收益有放回地重抽，笔数不变
+    BlockBootstrap // 策略逐K线收益按固定长度的块循环重抽，保留块内的自相关（趋势、持仓期）
+  };
+
+  Method method = Method::TradeResample;
+  qsizetype simulations = 10000;
+  int block_length = 24; // 块长度（K线数），只用于BlockBootstrap
+  quint64 seed = 1;      // 种子相同则结果相同，与线程数无关
+  double confidence = 0.95;
+  BacktestConfig config; // 计算交易收益用的手续费
+};
+
+// 一个指标在所有模拟中的分布
+struct MonteCarloDistribution {
+  static constexpr int kHistogramBins = 40;
+
+  double mean = 0.0;
+  double minimum = 0.0;
+  double maximum = 0.0;
+  double median = 0.0;
+  double lower = 0.0; // 置信区间下限
+  double upper = 0.0; // 置信区间上限
+  QVector<qsizetype> histogram; // [minimum, maximum]等分为kHistogramBins档的次数
+};
+
+struct MonteCarloResult {
+  MonteCarloSpec spec;
+  qsizetype samples = 0;     // 每次模拟的交易数或K线数
+  qsizetype simulations = 0; // 实际完成的模拟次数
+  // 原始顺序下按同样口径计算的值；交易重抽时回撤按逐笔平仓计，小于逐K线的回撤
+  double original_return = 0.0;
+  double original_drawdown = 0.0;
+  double original_win_rate = 0.0;
+  MonteCarloDistribution total_return; // 0~1
+  MonteCarloDistribution max_drawdown; // 0~1
+  MonteCarloDistribution win_rate;     // 只在交易重抽时有意义
+  double loss_probability = 0.0;           // 总收益为负的比例
+  double worse_drawdown_probability = 0.0; // 回撤超过原始回撤的比例
+  bool cancelled = false;
+};
+
+// 蒙特卡洛稳健性分析：对一次回测的交易序列重抽样，或对逐K线收益做块自助法，
+// 得到收益、回撤和胜率的分布与置信区间。
+// 模拟按固定大小分块投入线程池，每块用自己的随机数流（由种子和块号决定），
+// 结果写入开始时一次分配好的数组的对应区间，模拟过程中不做堆分配也不加锁
+class MonteCarlo : public QObject {
+  Q_OBJECT
+
+public:
+  static constexpr qsizetype kMaxSimulations = 10000000;
+
+  explicit MonteCarlo(QObject* parent = nullptr);
+  ~MonteCarlo();
+
+  // 成对的买卖信号换算成每笔交易的收益（含手续费），未平仓的最后一笔不计
+  static QVector<double> tradeReturns(const QVector<TradeSignal>& trade_signals, const BacktestConfig& config);
+  // 按信号重放持仓，得到策略在每根K线上的收益，与回测引擎的权益曲线逐根一致
+  static QVector<double> barReturns(const KLineData* bars,
+                                    qsizetype count,
+                                    const QVector<TradeSignal>& trade_signals,
+                                    const BacktestConfig& config);
+
+  bool isRunning() const { return running_; }
+  int threadCount() const;
+  // bars为trade_signals所在周期的K线，只在开始时读取
+  bool start(const QVector<KLineData>& bars,
+             const QVector<TradeSignal>& trade_signals,
+             const MonteCarloSpec& spec);
+  void cancel();
+
+signals:
+  void progress(qsizetype finished_simulations, qsizetype total_simulations);
+  void finished(const MonteCarloResult& result, qint64 elapsed_ms);
+
+private slots:
+  void reportProgress();
+
+private:
+  void runChunk(qsizetype chunk);
+  void onChunkDone();
+  MonteCarloResult summarize();
+
+  MonteCarloSpec spec_;
+  QVector<double> growth_; // 每个样本的1+收益
+  // 每次模拟的结果，按模拟序号存放；各任务只写自己的区间，用std::vector避免QVector写入时的共享检查
+  std::vector<double> returns_;
+  std::vector<double> drawdowns_;
+  std::vector<double> win_rates_;
+  std::unique_ptr<TaskPool> pool_;
+  QTimer* progress_timer_;
+  QElapsedTimer elapsed_;
+  std::atomic<qsizetype> finished_simulations_;
+  std::atomic<qsizetype> remaining_chunks_;
+  std::atomic<bool> cancelled_;
+  bool running_;
+};
+
+#endif // MONTECARLO_H
@@ -0,0 +1,232 @@
+#include "montecarlodialog.h"
+#include "ui_montecarlodialog.h"
+
+#include <QChart>
+#include <QChartView>
+#include <QHeaderView>
+#include <QLineSeries>
+#include <QMessageBox>
+#include <QTableWidgetItem>
+#include <QValueAxis>
+
+#include <limits>
+
+namespace {
+
+enum Column {
+  OriginalColumn,
+  MeanColumn,
+  MedianColumn,
+  LowerColumn,
+  UpperColumn,
+  WorstColumn,
+  ColumnCount
+};
+
+enum Row { ReturnRow, DrawdownRow, WinRateRow, RowCount };
+
+QTableWidgetItem *numberItem(double value) {
+  auto *item = new QTableWidgetItem;
+  item->setData(Qt::DisplayRole, value);
+  return item;
+}
+
+double percent(double ratio) {
+  return qRound64(ratio * 10000.0) / 100.0;
+}
+
+} // namespace
+
+MonteCarloDialog::MonteCarloDialog(const QVector<KLineData> &bars,
+                                   const QVector<TradeSignal> &trade_signals,
+                                   const BacktestConfig &defaults,
+                                   QWidget *parent)
+    : QDialog(parent)
+    , ui(new Ui::MonteCarloDialog)
+    , monte_carlo_(new MonteCarlo(this))
+    , bars_(bars)
+    , trade_signals_(trade_signals)
+    , config_(defaults)
+    , trade_count_(MonteCarlo::tradeReturns(trade_signals, defaults).size()) {
+  ui->setupUi(this);
+  initializeApplication();
+}
+
+MonteCarloDialog::~MonteCarloDialog() {
+  delete ui;
+}
+
+void MonteCarloDialog::initializeApplication() {
+  ui->methodComboBox->addItem("交易重抽（逐笔有放回）");
+  ui->methodComboBox->addItem("收益块自助（逐K线）");
+  ui->simulationsSpinBox->setRange(100, int(MonteCarlo::kMaxSimulations));
+  ui->simulationsSpinBox->setSingleStep(10000);
+  ui->simulationsSpinBox->setValue(10000);
+  ui->blockLengthSpinBox->setRange(1, int(qMin<qsizetype>(qMax<qsizetype>(1, bars_.size()),
+                                                        std::numeric_limits<int>::max())));
+  ui->blockLengthSpinBox->setValue(24);
+  ui->confidenceSpinBox->setRange(50.0, 99.9);
+  ui->confidenceSpinBox->setDecimals(1);
+  ui->confidenceSpinBox->setValue(95.0);
+  ui->seedSpinBox->setRange(0, std::numeric_limits<int>::max());
+  ui->seedSpinBox->setValue(1);
+
+  ui->statsTable->setColumnCount(ColumnCount);
+  ui->statsTable->setRowCount(RowCount);
+  ui->statsTable->setHorizontalHeaderLabels({"原始", "均值", "中位数", "置信下限", "置信上限", "最差"});
+  ui->statsTable->setVerticalHeaderLabels({"总收益(%)", "最大回撤(%)", "胜率(%)"});
+  ui->statsTable->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
+
+  return_chart_ = createChart("总收益分布(%)");
+  drawdown_chart_ = createChart("最大回撤分布(%)");
+
+  connect(ui->methodComboBox, &QComboBox::currentIndexChanged, this, &MonteCarloDialog::onSettingsChanged);
+  connect(ui->simulationsSpinBox, &QSpinBox::valueChanged, this, &MonteCarloDialog::onSettingsChanged);
+  connect(ui->startButton, &QPushButton::clicked, this, &MonteCarloDialog::onStartClicked);
+  connect(ui->cancelButton, &QPushButton::clicked, this, &MonteCarloDialog::onCancelClicked);
+  connect(monte_carlo_, &MonteCarlo::progress, this, &MonteCarloDialog::onProgress);
+  connect(monte_carlo_, &MonteCarlo::finished, this, &MonteCarloDialog::onFinished);
+  onSettingsChanged();
+}
+
+MonteCarloDialog::DistributionChart MonteCarloDialog::createChart(const QString &title) {
+  DistributionChart chart;
+  chart.chart = new QChart();
+  chart.chart->setTitle(title);
+  chart.chart->legend()->setVisible(false);
+
+  chart.series = new QLineSeries();
+  chart.chart->addSeries(chart.series);
+
+  chart.axis_x = new QValueAxis();
+  chart.axis_y = new QValueAxis();
+  chart.axis_y->setTitleText("频率(%)");
+  chart.chart->addAxis(chart.axis_x, Qt::AlignBottom);
+  chart.chart->addAxis(chart.axis_y, Qt::AlignLeft);
+  chart.series->attachAxis(chart.axis_x);
+  chart.series->attachAxis(chart.axis_y);
+
+  auto *chart_view = new QChartView(chart.chart);
+  chart_view->setRenderHints(QPainter::Antialiasing);
+  ui->distributionChartLayout->addWidget(chart_view);
+  return chart;
+}
+
+MonteCarloSpec MonteCarloDialog::readSpec() const {
+  MonteCarloSpec spec;
+  spec.method = ui->methodComboBox->currentIndex() == 0 ? MonteCarloSpec::Method::TradeResample
+                                                        : MonteCarloSpec::Method::BlockBootstrap;
+  spec.simulations = ui->simulationsSpinBox->value();
+  spec.block_length = ui->blockLengthSpinBox->value();
+  spec.seed = quint64(ui->seedSpinBox->value());
+  spec.confidence = ui->confidenceSpinBox->value() / 100.0;
+  spec.config = config_;
+  return spec;
+}
+
+void MonteCarloDialog::onSettingsChanged() {
+  const MonteCarloSpec spec = readSpec();
+  const bool blocks = spec.method == MonteCarloSpec::Method::BlockBootstrap;
+  ui->blockLengthSpinBox->setEnabled(blocks);
+  ui->summaryLabel->setText(QString("样本: %1，模拟 %2 次，共 %3 步，线程数: %4")
+                                .arg(blocks ? QString("%1根K线").arg(bars_.size())
+                                            : QString("%1笔交易").arg(trade_count_))
+                                .arg(spec.simulations)
+                                .arg(spec.simulations * (blocks ? bars_.size() : trade_count_))
+                                .arg(monte_carlo_->threadCount()));
+}
+
+void MonteCarloDialog::onStartClicked() {
+  const MonteCarloSpec spec = readSpec();
+  if (spec.method == MonteCarloSpec::Method::TradeResample && trade_count_ == 0) {
+    QMessageBox::warning(this, "蒙特卡洛分析", "回测中没有已平仓的交易，可改用收益块自助");
+    return;
+  }
+  ui->progressBar->setRange(0, int(spec.simulations));
+  ui->progressBar->setValue(0);
+  if (!monte_carlo_->start(bars_, trade_signals_, spec)) {
+    QMessageBox::warning(this, "蒙特卡洛分析", "无法开始模拟，请检查回测结果和设置");
+    return;
+  }
+  ui->startButton->setEnabled(false);
+  ui->cancelButton->setEnabled(true);
+  ui->settingsGroupBox->setEnabled(false);
+}
+
+void MonteCarloDialog::onCancelClicked() {
+  monte_carlo_->cancel();
+  ui->cancelButton->setEnabled(false);
+}
+
+void MonteCarloDialog::onProgress(qsizetype finished_simulations, qsizetype total_simulations) {
+  ui->progressBar->setRange(0, int(total_simulations));
+  ui->progressBar->setValue(int(finished_simulations));
+}
+
+void MonteCarloDialog::onFinished(const MonteCarloResult &result, qint64 elapsed_ms) {
+  ui->startButton->setEnabled(true);
+  ui->cancelButton->setEnabled(false);
+  ui->settingsGroupBox->setEnabled(true);
+  const double seconds = qMax<qint64>(elapsed_ms, 1) / 1000.0;
+  if (result.cancelled) {
+    ui->summaryLabel->setText(
+        QString("已取消，完成 %1 次模拟，耗时 %2 秒").arg(result.simulations).arg(seconds, 0, 'f', 2));
+    return;
+  }
+  showStats(result);
+  showDistribution(return_chart_, result.total_return, result.simulations);
+  showDistribution(drawdown_chart_, result.max_drawdown, result.simulations);
+  ui->summaryLabel->setText(QString("%1 次模拟耗时 %2 秒；亏损概率 %3%，回撤超过原始的概率 %4%")
+                                .arg(result.simulations)
+                                .arg(seconds, 0, 'f', 2)
+                                .arg(percent(result.loss_probability))
+                                .arg(percent(result.worse_drawdown_probability)));
+}
+
+void MonteCarloDialog::showStats(const MonteCarloResult &result) {
+  QTableWidget *table = ui->statsTable;
+  const auto show_row = [&](int row, double original, const MonteCarloDistribution &distribution, double worst) {
+    table->setItem(row, OriginalColumn, numberItem(percent(original)));
+    table->setItem(row, MeanColumn, numberItem(percent(distribution.mean)));
+    table->setItem(row, MedianColumn, numberItem(percent(distribution.median)));
+    table->setItem(row, LowerColumn, numberItem(percent(distribution.lower)));
+    table->setItem(row, UpperColumn, numberItem(percent(distribution.upper)));
+    table->setItem(row, WorstColumn, numberItem(percent(worst)));
+  };
+  show_row(ReturnRow, result.original_return, result.total_return, result.total_return.minimum);
+  show_row(DrawdownRow, result.original_drawdown, result.max_drawdown, result.max_drawdown.maximum);
+  if (result.spec.method == MonteCarloSpec::Method::TradeResample) {
+    show_row(WinRateRow, result.original_win_rate, result.win_rate, result.win_rate.minimum);
+  } else {
+    // 块自助法只重排逐K线收益，不再有完整的交易
+    for (int column = 0; column < ColumnCount; column++)
+      table->setItem(WinRateRow, column, new QTableWidgetItem("-"));
+  }
+}
+
+void MonteCarloDialog::showDistribution(const DistributionChart &chart,
+                                        const MonteCarloDistribution &distribution,
+                                        qsizetype simulations) {
+  const int bins = int(distribution.histogram.size());
+  if (bins == 0 || simulations == 0)
+    return;
+  // 以每档中点为横坐标，纵坐标为落在该档的模拟所占比例
+  const double width = (distribution.maximum - distribution.minimum) / bins;
+  QList<QPointF> points;
+  points.reserve(bins);
+  double high = 0.0;
+  for (int bin = 0; bin < bins; bin++) {
+    const double frequency = 100.0 * double(distribution.histogram[bin]) / double(simulations);
+    high = qMax(high, frequency);
+    points.append(QPointF(percent(distribution.minimum + width * (bin + 0.5)), frequency));
+  }
+  chart.series->replace(points);
+  const double margin = qMax(percent(distribution.maximum - distribution.minimum) * 0.02, 0.01);
+  chart.axis_x->setRange(percent(distribution.minimum) - margin, percent(distribution.maximum) + margin);
+  chart.axis_y->setRange(0.0, qMax(high * 1.1, 1e-6));
+}
+
+void MonteCarloDialog::reject() {
+  monte_carlo_->cancel();
+  QDialog::reject();
+}
@@ -0,0 +1,64 @@
+#ifndef MONTECARLODIALOG_H
+#define MONTECARLODIALOG_H
+
+#include "montecarlo.h"
+
+#include <QDialog>
+
+class QChart;
+class QLineSeries;
+class QValueAxis;
+
+namespace Ui {
+class MonteCarloDialog;
+}
+
+class MonteCarloDialog : public QDialog {
+  Q_OBJECT
+
+public:
+  // bars为回测所在周期的K线，trade_signals和defaults来自最近一次回测
+  MonteCarloDialog(const QVector<KLineData>& bars,
+                   const QVector<TradeSignal>& trade_signals,
+                   const BacktestConfig& defaults,
+                   QWidget* parent = nullptr);
+  ~MonteCarloDialog();
+
+public slots:
+  void reject() override; // 关闭时停止正在进行的模拟
+
+private slots:
+  void onStartClicked();
+  void onCancelClicked();
+  void onSettingsChanged();
+  void onProgress(qsizetype finished_simulations, qsizetype total_simulations);
+  void onFinished(const MonteCarloResult& result, qint64 elapsed_ms);
+
+private:
+  struct DistributionChart {
+    QChart* chart = nullptr;
+    QLineSeries* series = nullptr;
+    QValueAxis* axis_x = nullptr;
+    QValueAxis* axis_y = nullptr;
+  };
+
+  void initializeApplication(); // 整体初始化
+  DistributionChart createChart(const QString& title);
+  MonteCarloSpec readSpec() const;
+  void showStats(const MonteCarloResult& result);
+  void showDistribution(const DistributionChart& chart,
+                        const MonteCarloDistribution& distribution,
+                        qsizetype simulations);
+
+private:
+  Ui::MonteCarloDialog* ui;
+  MonteCarlo* monte_carlo_;
+  QVector<KLineData> bars_;
+  QVector<TradeSignal> trade_signals_;
+  BacktestConfig config_;
+  qsizetype trade_count_; // 已平仓交易数
+  DistributionChart return_chart_;
+  DistributionChart drawdown_chart_;
+};
+
+#endif // MONTECARLODIALOG_H
@@ -0,0 +1,134 @@
+#ifndef NATIVESTRATEGY_H
+#define NATIVESTRATEGY_H
+
+#include "baraction.h"
+#include "klinedata.h"
+
+#include <QtGlobal>
+
+#include <array>
+
+// C++策略接口。策略是普通类，参数和指标都是模板实参：
+//   struct Params { static constexpr int kFast = 10; static constexpr int kSlow = 30; };
+//   using Strategy = CrossoverStrategy<Params, Sma>;
+// 周期是编译期常量，指标的缓冲区大小和取模都在编译时确定；每个策略单独实例化逐K线循环，
+// onBar可内联，循环中没有虚函数调用。程序内可直接交给BacktestEngine::run回测（见backtestengine.h）。
+//
+// 编译成共享库放在strategies/下即成为插件，与Python策略一起出现在策略下拉框中：
+//   QTBACKTESTER_STRATEGY_PLUGIN(Strategy, "名称", "说明")
+// 插件只需要本头文件，不链接核心库；与Python策略一样对整段K线一次给出逐K线动作，再由程序的引擎撮合
+
+// 固定周期的简单移动平均
+template<int Period>
+class Sma {
+  static_assert(Period > 0, "周期须为正");
+
+public:
+  void push(double value) {
+    sum_ += value - values_[next_];
+    values_[next_] = value;
+    next_ = next_ + 1 == Period ? 0 : next_ + 1;
+    if (count_ < Period)
+      count_++;
+  }
+  bool ready() const { return count_ == Period; }
+  double value() const { return sum_ / Period; }
+
+private:
+  std::array<double, Period> values_{};
+  double sum_ = 0.0;
+  int next_ = 0;
+  int count_ = 0;
+};
+
+// 固定周期的指数移动平均，前Period根K线用简单平均预热
+template<int Period>
+class Ema {
+  static_assert(Period > 0, "周期须为正");
+
+public:
+  void push(double value) {
+    if (count_ < Period) {
+      value_ += value / Period;
+      count_++;
+      return;
+    }
+    value_ += kAlpha * (value - value_);
+  }
+  bool ready() const { return count_ == Period; }
+  double value() const { return value_; }
+
+private:
+  static constexpr double kAlpha = 2.0 / (Period + 1);
+  double value_ = 0.0;
+  int count_ = 0;
+};
+
+// 均线交叉：快线上穿慢线买入，下穿卖出。
+// Params提供 static constexpr int kFast / kSlow，Average为均线模板（Sma、Ema或自定义）
+template<typename Params, template<int> class Average>
+class CrossoverStrategy {
+  static_assert(Params::kFast < Params::kSlow, "快线周期须小于慢线周期");
+
+public:
+  BarAction onBar(const KLineData& bar) {
+    fast_.push(bar.close);
+    slow_.push(bar.close);
+    if (!slow_.ready())
+      return BarAction::Hold;
+    double diff = fast_.value() - slow_.value();
+    BarAction action = BarAction::Hold;
+    if (has_prev_) {
+      if (prev_diff_ <= 0.0 && diff > 0.0)
+        action = BarAction::Buy;
+      else if (prev_diff_ >= 0.0 && diff < 0.0)
+        action = BarAction::Sell;
+    }
+    prev_diff_ = diff;
+    has_prev_ = true;
+    return action;
+  }
+
+private:
+  Average<Params::kFast> fast_;
+  Average<Params::kSlow> slow_;
+  double prev_diff_ = 0.0;
+  bool has_prev_ = false;
+};
+
+// 逐K线写出动作：1买入、-1卖出、0持有，与Python策略返回的数组含义相同
+template<typename Strategy>
+void generateActions(const KLineData* bars, qint64 count, qint8* actions) {
+  Strategy strategy;
+  for (qint64 i = 0; i < count; i++) {
+    const BarAction action = strategy.onBar(bars[i]);
+    actions[i] = action == BarAction::Buy ? 1 : action == BarAction::Sell ? -1 : 0;
+  }
+}
+
+// 插件接口，只用C类型，插件与程序可用不同的编译器构建
+inline constexpr quint32 kStrategyPluginAbi = 1;
+inline constexpr char kStrategyPluginSymbol[] = "qtbacktesterStrategyPlugin";
+
+extern "C" {
+struct StrategyPluginInfo {
+  quint32 abi_version; // kStrategyPluginAbi
+  quint32 bar_size;    // sizeof(KLineData)，防止插件与程序的K线布局不一致
+  const char* name;    // UTF-8，显示在策略下拉框中
+  const char* description;
+  void (*generate)(const KLineData* bars, qint64 count, qint8* actions);
+};
+typedef const StrategyPluginInfo* (*StrategyPluginEntry)();
+}
+
+#define QTBACKTESTER_STRATEGY_PLUGIN(Strategy, name, description)                   \
+  extern "C" Q_DECL_EXPORT const StrategyPluginInfo* qtbacktesterStrategyPlugin() { \
+    static const StrategyPluginInfo info = {kStrategyPluginAbi,                     \
+                                            quint32(sizeof(KLineData)),             \
+                                            name,                                   \
+                                            description,                            \
+                                            &generateActions<Strategy>};            \
+    return &info;                                                                   \
+  }
+
+#endif // NATIVESTRATEGY_H
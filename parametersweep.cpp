@@ -0,0 +1,171 @@
+#include "parametersweep.h"
+
+#include "builtinstrategies.h"
+#include "profiler.h"
+
+#include <QMutexLocker>
+#include <QTimer>
+
+#include <cmath>
+
+namespace {
+
+constexpr int kFlushIntervalMs = 100;
+
+} // namespace
+
+QVector<double> SweepRange::values() const {
+  QVector<double> result;
+  if (step <= 0.0 || to <= from) {
+    result.append(from);
+    return result;
+  }
+  // 按下标计算每个取值，避免累加步长带来的误差
+  qsizetype count = qsizetype(std::floor((to - from) / step + 1e-9)) + 1;
+  result.reserve(count);
+  for (qsizetype i = 0; i < count; i++) {
+    result.append(from + i * step);
+  }
+  return result;
+}
+
+QVector<int> SweepRange::periods() const {
+  QVector<int> result;
+  // values()升序，取整后相同的值相邻
+  for (double value : values()) {
+    if (result.isEmpty() || result.last() != int(value))
+      result.append(int(value));
+  }
+  return result;
+}
+
+ParameterSweep::ParameterSweep(QObject *parent)
+    : QObject(parent)
+    , flush_timer_(new QTimer(this))
+    , remaining_(0)
+    , cancelled_(false)
+    , running_(false) {
+  flush_timer_->setInterval(kFlushIntervalMs);
+  connect(flush_timer_, &QTimer::timeout, this, &ParameterSweep::flushResults);
+}
+
+ParameterSweep::~ParameterSweep() {
+  cancel();
+  // 先等线程池里的任务结束，它们还在访问本对象的成员
+  pool_.reset();
+}
+
+qsizetype ParameterSweep::combinationCount(const SweepSpec &spec) {
+  qsizetype pairs = 0;
+  const QVector<int> fast_values = spec.fast_period.periods();
+  const QVector<int> slow_values = spec.slow_period.periods();
+  for (int fast : fast_values) {
+    for (int slow : slow_values) {
+      if (fast >= 1 && fast < slow)
+        pairs++;
+    }
+  }
+  return pairs * spec.initial_capital.values().size() * spec.commission.values().size()
+         * spec.slippage.values().size();
+}
+
+int ParameterSweep::threadCount() const {
+  return pool_ ? pool_->threadCount() : int(std::thread::hardware_concurrency());
+}
+
+bool ParameterSweep::start(const QVector<KLineData> &bars,
+                           const SweepSpec &spec,
+                           std::shared_ptr<IndicatorCache> indicators) {
+  if (running_ || bars.isEmpty())
+    return false;
+  qsizetype total = combinationCount(spec);
+  if (total == 0)
+    return false;
+  if (!pool_)
+    pool_ = std::make_unique<TaskPool>();
+
+  bars_ = bars;
+  if (!indicators || indicators->size() != bars.size())
+    indicators = std::make_shared<IndicatorCache>(bars);
+  indicators_ = std::move(indicators);
+  cancelled_ = false;
+  remaining_ = total;
+  running_ = true;
+  elapsed_.start();
+  flush_timer_->start();
+
+  const QVector<int> fast_values = spec.fast_period.periods();
+  const QVector<int> slow_values = spec.slow_period.periods();
+  const QVector<double> capital_values = spec.initial_capital.values();
+  const QVector<double> commission_values = spec.commission.values();
+  const QVector<double> slippage_values = spec.slippage.values();
+  for (int fast : fast_values) {
+    for (int slow : slow_values) {
+      if (fast < 1 || fast >= slow)
+        continue;
+      for (double capital : capital_values) {
+        for (double commission : commission_values) {
+          for (double slippage : slippage_values) {
+            BacktestConfig config;
+            config.initial_capital = capital;
+            config.commission = commission;
+            config.slippage = slippage;
+            config.record_equity_curve = false;
+            config.record_trades = false;
+            pool_->submit([this, fast, slow, config] { runOne(fast, slow, config); });
+          }
+        }
+      }
+    }
+  }
+  return true;
+}
+
+void ParameterSweep::cancel() {
+  cancelled_ = true;
+}
+
+void ParameterSweep::runOne(int fast_period, int slow_period, const BacktestConfig &config) {
+  if (!cancelled_) {
+    BacktestResult backtest = runMaCross(config, bars_, *indicators_, fast_period, slow_period);
+    SweepResult result;
+    result.fast_period = fast_period;
+    result.slow_period = slow_period;
+    result.config = config;
+    result.final_capital = backtest.final_capital;
+    result.total_return = backtest.final_capital / config.initial_capital - 1.0;
+    result.total_trades = backtest.total_trades;
+    result.win_rate = backtest.win_rate;
+    result.max_drawdown = backtest.max_drawdown;
+    QMutexLocker locker(&results_mutex_);
+    pending_results_.append(result);
+  }
+  onTaskDone();
+}
+
+void ParameterSweep::onTaskDone() {
+  if (--remaining_ != 0)
+    return;
+  // 最后一个任务在工作线程中完成，结束通知投递回界面线程
+  QMetaObject::invokeMethod(
+      this,
+      [this] {
+        flush_timer_->stop();
+        flushResults();
+        running_ = false;
+        const qint64 end_ns = Profiler::now();
+        Profiler::record("sweep", end_ns - elapsed_.nsecsElapsed(), end_ns);
+        emit finished(elapsed_.elapsed());
+      },
+      Qt::QueuedConnection);
+}
+
+void ParameterSweep::flushResults() {
+  QVector<SweepResult> batch;
+  {
+    QMutexLocker locker(&results_mutex_);
+    batch.swap(pending_results_);
+  }
+  if (!batch.isEmpty())
+    emit resultsReady(batch);
+}
@@ -0,0 +1,92 @@
+#ifndef PARAMETERSWEEP_H
+#define PARAMETERSWEEP_H
+
+#include "backtestengine.h"
+#include "indicatorcache.h"
+#include "klinedata.h"
+#include "taskpool.h"
+
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QObject>
+#include <QVector>
+
+#include <atomic>
+#include <memory>
+
+class QTimer;
+
+// 闭区间 [from, to]，step<=0 时只取 from
+struct SweepRange {
+  double from = 0.0;
+  double to = 0.0;
+  double step = 0.0;
+
+  QVector<double> values() const;
+  // 作为均线周期使用时的取值：取整后去重，小数步长（如5:20:2.5）不会产生重复的周期
+  QVector<int> periods() const;
+};
+
+struct SweepSpec {
+  SweepRange fast_period;
+  SweepRange slow_period;
+  SweepRange initial_capital;
+  SweepRange commission;
+  SweepRange slippage;
+};
+
+struct SweepResult {
+  int fast_period = 0;
+  int slow_period = 0;
+  BacktestConfig config;
+  double final_capital = 0.0;
+  double total_return = 0.0; // 0~1
+  int total_trades = 0;
+  double win_rate = 0.0;
+  double max_drawdown = 0.0;
+};
+
+// 均线交叉策略的网格搜索：每个参数组合作为一个任务投入工作窃取线程池，
+// 所有任务只读同一份K线数据，均线从共享的指标缓存中取，每个周期只算一次，
+// 结果定时批量发回界面线程
+class ParameterSweep : public QObject {
+  Q_OBJECT
+
+public:
+  explicit ParameterSweep(QObject* parent = nullptr);
+  ~ParameterSweep();
+
+  static qsizetype combinationCount(const SweepSpec& spec);
+
+  bool isRunning() const { return running_; }
+  int threadCount() const;
+  // indicators为空时新建一份只供本次扫描使用的缓存
+  bool start(const QVector<KLineData>& bars,
+             const SweepSpec& spec,
+             std::shared_ptr<IndicatorCache> indicators = nullptr);
+  void cancel();
+
+signals:
+  void resultsReady(const QVector<SweepResult>& results);
+  void finished(qint64 elapsed_ms);
+
+private slots:
+  void flushResults();
+
+private:
+  void runOne(int fast_period, int slow_period, const BacktestConfig& config);
+  void onTaskDone();
+
+  QVector<KLineData> bars_; // 隐式共享的只读数据，各任务不复制
+  std::shared_ptr<IndicatorCache> indicators_;
+  std::unique_ptr<TaskPool> pool_;
+  QTimer* flush_timer_;
+  QMutex results_mutex_;
+  QVector<SweepResult> pending_results_;
+  QElapsedTimer elapsed_;
+  std::atomic<qsizetype> remaining_;
+  std::atomic<bool> cancelled_;
+  bool running_;
+};
+
+#endif // PARAMETERSWEEP_H
@@ -0,0 +1,188 @@
+#include "portfoliobacktest.h"
+
+#include "builtinstrategies.h"
+#include "klineloader.h"
+#include "profiler.h"
+
+#include <QFileInfo>
+
+#include <queue>
+
+namespace {
+
+constexpr qsizetype kProgressInterval = 1 << 16; // 每隔多少个时间点检查取消并报告进度
+
+struct Cursor {
+  qint64 timestamp;
+  int source;
+};
+
+// 小顶堆：时间早的先出，同一时间按品种顺序
+struct CursorLater {
+  bool operator()(const Cursor& a, const Cursor& b) const {
+    return a.timestamp != b.timestamp ? a.timestamp > b.timestamp : a.source > b.source;
+  }
+};
+
+struct Holding {
+  double quantity = 0.0;
+  double entry_cost = 0.0;
+  double last_close = 0.0;
+  qsizetype next = 0; // 下一根K线的下标
+};
+
+} // namespace
+
+bool PortfolioBacktest::open(const QStringList &csv_paths, QString &error) {
+  sources_.clear();
+  for (const QString &path : csv_paths) {
+    Source source;
+    source.name = QFileInfo(path).completeBaseName();
+    source.cache = std::make_unique<KLineCache>();
+    if (!source.cache->open(path)) {
+      // 每次只有一个品种整体在内存中，写出缓存后立即释放
+      QVector<KLineData> bars;
+      if (!KLineLoader::loadCsv(path, bars)) {
+        error = "无法加载数据文件: " + path;
+        return false;
+      }
+      if (!KLineCache::write(path, bars) || !source.cache->open(path)) {
+        error = "无法生成列式缓存: " + KLineCache::cachePath(path);
+        return false;
+      }
+    }
+    if (source.cache->columns().size == 0) {
+      error = "数据文件为空: " + path;
+      return false;
+    }
+    sources_.push_back(std::move(source));
+  }
+  if (sources_.empty()) {
+    error = "没有选择数据文件";
+    return false;
+  }
+  return true;
+}
+
+PortfolioResult PortfolioBacktest::run(const PortfolioConfig &config,
+                                       const std::atomic<bool> *cancelled,
+                                       const std::function<void(int)> &progress) const {
+  ProfileScope scope("portfolio.run");
+  const int count = int(sources_.size());
+  const BacktestConfig &base = config.base;
+  const double weight = config.max_weight > 0.0 ? qMin(1.0, config.max_weight)
+                                                : 1.0 / qMax(1, count);
+  PortfolioResult result;
+  result.initial_capital = base.initial_capital;
+  result.final_capital = base.initial_capital;
+  result.symbols.resize(count);
+
+  std::vector<MovingAverageCross> strategies;
+  strategies.reserve(count);
+  std::vector<Holding> holdings(count);
+  std::vector<Cursor> heap_storage;
+  heap_storage.reserve(count);
+  std::priority_queue<Cursor, std::vector<Cursor>, CursorLater> heap(CursorLater(),
+                                                                       std::move(heap_storage));
+  for (int i = 0; i < count; i++) {
+    const KLineColumns &columns = sources_[i].cache->columns();
+    strategies.emplace_back(config.fast_period, config.slow_period);
+    result.symbols[i].name = sources_[i].name;
+    result.symbols[i].bars = columns.size;
+    result.total_bars += columns.size;
+    heap.push({columns.timestamp[0], i});
+  }
+  if (count > 0)
+    result.first_timestamp = heap.top().timestamp;
+
+  double cash = base.initial_capital;
+  double holdings_value = 0.0; // 各品种持仓按最新收盘价的市值之和，随价格增量更新
+  double peak_equity = cash;
+  qsizetype processed_bars = 0;
+  std::vector<int> buys;
+  std::vector<int> sells;
+  buys.reserve(count);
+  sells.reserve(count);
+
+  while (!heap.empty()) {
+    const qint64 timestamp = heap.top().timestamp;
+    buys.clear();
+    sells.clear();
+    // 先取出这个时间点的所有品种，更新价格并询问策略
+    while (!heap.empty() && heap.top().timestamp == timestamp) {
+      const int i = heap.top().source;
+      heap.pop();
+      const KLineColumns &c = sources_[i].cache->columns();
+      Holding &holding = holdings[i];
+      const qsizetype k = holding.next++;
+      const KLineData bar{c.timestamp[k], c.open[k], c.high[k], c.low[k], c.close[k], c.volume[k]};
+      holdings_value += holding.quantity * (bar.close - holding.last_close);
+      holding.last_close = bar.close;
+      BarAction action = strategies[i].onBar(bar);
+      if (action == BarAction::Sell && holding.quantity > 0.0)
+        sells.push_back(i);
+      else if (action == BarAction::Buy && holding.quantity == 0.0)
+        buys.push_back(i);
+      if (holding.next < c.size)
+        heap.push({c.timestamp[holding.next], i});
+      processed_bars++;
+    }
+    // 先平仓释放现金，再按当前权益的固定比例开仓
+    for (int i : sells) {
+      Holding &holding = holdings[i];
+      double price = holding.last_close * (1.0 - base.slippage);
+      double proceeds = holding.quantity * price * (1.0 - base.commission);
+      PortfolioSymbolResult &symbol = result.symbols[i];
+      symbol.total_trades++;
+      if (proceeds > holding.entry_cost)
+        symbol.winning_trades++;
+      symbol.realized_pnl += proceeds - holding.entry_cost;
+      holdings_value -= holding.quantity * holding.last_close;
+      cash += proceeds;
+      holding.quantity = 0.0;
+      holding.entry_cost = 0.0;
+    }
+    const double equity_before_buys = cash + holdings_value;
+    for (int i : buys) {
+      Holding &holding = holdings[i];
+      double price = holding.last_close * (1.0 + base.slippage);
+      double spend = qMin(cash, equity_before_buys * weight);
+      if (price <= 0.0 || spend <= 0.0)
+        continue;
+      holding.quantity = spend / (price * (1.0 + base.commission));
+      holding.entry_cost = spend;
+      holdings_value += holding.quantity * holding.last_close;
+      cash -= spend;
+    }
+    const double equity = cash + holdings_value;
+    if (equity > peak_equity) {
+      peak_equity = equity;
+    } else if (peak_equity > 0.0) {
+      result.max_drawdown = qMax(result.max_drawdown, (peak_equity - equity) / peak_equity);
+    }
+    result.last_timestamp = timestamp;
+    if (++result.steps % kProgressInterval == 0) {
+      if (cancelled && cancelled->load(std::memory_order_relaxed)) {
+        result.cancelled = true;
+        break;
+      }
+      if (progress)
+        progress(int(processed_bars * 1000 / qMax<qsizetype>(1, result.total_bars)));
+    }
+  }
+
+  // 按最终价格重新计值，避免增量更新累积的舍入误差
+  double final_value = cash;
+  for (const Holding &holding : holdings)
+    final_value += holding.quantity * holding.last_close;
+  result.final_capital = final_value;
+  for (const PortfolioSymbolResult &symbol : std::as_const(result.symbols)) {
+    result.total_trades += symbol.total_trades;
+    result.winning_trades += symbol.winning_trades;
+  }
+  result.win_rate = result.total_trades > 0 ? double(result.winning_trades) / result.total_trades
+                                            : 0.0;
+  if (progress && !result.cancelled)
+    progress(1000);
+  return result;
+}
@@ -0,0 +1,69 @@
+#ifndef PORTFOLIOBACKTEST_H
+#define PORTFOLIOBACKTEST_H
+
+#include "backtestengine.h"
+#include "klinecache.h"
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+struct PortfolioConfig {
+  BacktestConfig base; // 共用的初始资金、手续费和滑点
+  int fast_period = 10;
+  int slow_period = 30;
+  double max_weight = 0.0; // 单个品种开仓时最多占用的权益比例，<=0时为1/品种数
+};
+
+struct PortfolioSymbolResult {
+  QString name;
+  qsizetype bars = 0;
+  int total_trades = 0;
+  int winning_trades = 0;
+  double realized_pnl = 0.0; // 已平仓交易的盈亏（含手续费）
+};
+
+struct PortfolioResult {
+  double initial_capital = 0.0;
+  double final_capital = 0.0; // 未平仓部分按各自最后收盘价计值
+  int total_trades = 0;
+  int winning_trades = 0;
+  double win_rate = 0.0;     // 0~1
+  double max_drawdown = 0.0; // 0~1，按每个时间点的组合权益计算
+  qint64 first_timestamp = 0;
+  qint64 last_timestamp = 0;
+  qsizetype steps = 0;      // 合并后的时间点数
+  qsizetype total_bars = 0; // 所有品种的K线总数
+  bool cancelled = false;
+  QVector<PortfolioSymbolResult> symbols;
+};
+
+// 多品种组合回测：各品种的K线直接读映射的列式缓存，不整体加载到内存，
+// 按时间戳做k路堆合并，同一时间点的所有品种先更新价格和策略，再先卖后买，
+// 所有品种共用一份现金。每个品种运行一份均线交叉策略，内存只随品种数增长
+class PortfolioBacktest {
+public:
+  // 打开各数据文件的列式缓存，没有或已过期时先从CSV生成
+  bool open(const QStringList& csv_paths, QString& error);
+  int symbolCount() const { return int(sources_.size()); }
+
+  // progress为千分比，在调用线程中定期回调；cancelled置位后尽快返回，结果标记为已取消
+  PortfolioResult run(const PortfolioConfig& config,
+                      const std::atomic<bool>* cancelled = nullptr,
+                      const std::function<void(int)>& progress = {}) const;
+
+private:
+  struct Source {
+    QString name;
+    std::unique_ptr<KLineCache> cache;
+  };
+
+  std::vector<Source> sources_;
+};
+
+#endif // PORTFOLIOBACKTEST_H
@@ -0,0 +1,267 @@
+#include "profiler.h"
+
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSaveFile>
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+namespace {
+
+constexpr quint64 kBufferEvents = 8192; // 每个线程保留最近的事件数
+
+// 环形缓冲区的一格。字段都是原子量，读取方复制时即使正被覆盖也不是数据竞争，
+// 被覆盖的部分由序号校验丢弃
+struct Slot {
+  std::atomic<const char *> name{nullptr};
+  std::atomic<qint64> start_ns{0};
+  std::atomic<qint64> duration_ns{0};
+  std::atomic<qint64> allocations{0};
+  std::atomic<double> value{0.0};
+  std::atomic<bool> counter{false};
+};
+
+struct ThreadBuffer {
+  int thread = 0;
+  QString name;                    // 由registry的锁保护
+  std::atomic<quint64> writing{0}; // 正在写入的事件序号加一，先于写入发布
+  std::atomic<quint64> head{0};    // 已写完的事件总数，只由所属线程递增
+  quint64 cleared = 0;             // 由registry的锁保护，之前的事件不再读取
+  Slot ring[kBufferEvents];
+};
+
+struct Registry {
+  QMutex mutex;
+  std::vector<std::unique_ptr<ThreadBuffer>> buffers; // 线程退出后保留，事件仍可导出
+};
+
+// 有意不析构：进程退出时可能还有线程在记录
+Registry &registry() {
+  static Registry *instance = new Registry;
+  return *instance;
+}
+
+std::chrono::steady_clock::time_point origin() {
+  static const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  return start;
+}
+
+thread_local ThreadBuffer *tls_buffer = nullptr;
+
+ThreadBuffer &threadBuffer() {
+  if (!tls_buffer) {
+    auto buffer = std::make_unique<ThreadBuffer>();
+    Registry &r = registry();
+    QMutexLocker locker(&r.mutex);
+    buffer->thread = int(r.buffers.size()) + 1;
+    tls_buffer = buffer.get();
+    r.buffers.push_back(std::move(buffer));
+  }
+  return *tls_buffer;
+}
+
+void append(const Profiler::Event &event) {
+  ThreadBuffer &buffer = threadBuffer();
+  const quint64 head = buffer.head.load(std::memory_order_relaxed);
+  buffer.writing.store(head + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  Slot &slot = buffer.ring[head % kBufferEvents];
+  slot.name.store(event.name, std::memory_order_relaxed);
+  slot.start_ns.store(event.start_ns, std::memory_order_relaxed);
+  slot.duration_ns.store(event.duration_ns, std::memory_order_relaxed);
+  slot.allocations.store(event.allocations, std::memory_order_relaxed);
+  slot.value.store(event.value, std::memory_order_relaxed);
+  slot.counter.store(event.counter, std::memory_order_relaxed);
+  buffer.head.store(head + 1, std::memory_order_release);
+}
+
+} // namespace
+
+// 本线程的分配次数，由allocationcounter.cpp替换的分配函数累加，没有链接它时保持为0。
+// malloc可能在动态链接器初始化期间被调用，glibc上须是不经__tls_get_addr的静态TLS
+#ifdef __GLIBC__
+__attribute__((tls_model("initial-exec")))
+#endif
+thread_local qint64 profiler_thread_allocations = 0;
+
+std::atomic<bool> Profiler::enabled_{!qgetenv("QTBACKTESTER_PROFILE").isEmpty()};
+
+void Profiler::setEnabled(bool enabled) {
+  origin();
+  enabled_.store(enabled, std::memory_order_relaxed);
+}
+
+qint64 Profiler::now() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now()
+                                                              - origin())
+      .count();
+}
+
+std::atomic<Profiler::AllocationCounting> Profiler::allocation_counting_{AllocationCounting::None};
+
+qint64 Profiler::allocationCount() {
+  return profiler_thread_allocations;
+}
+
+Profiler::AllocationCounting Profiler::allocationCounting() {
+  return allocation_counting_.load(std::memory_order_relaxed);
+}
+
+void Profiler::setAllocationCounting(AllocationCounting counting) {
+  allocation_counting_.store(counting, std::memory_order_relaxed);
+}
+
+void Profiler::record(const char *name, qint64 start_ns, qint64 end_ns, qint64 allocations) {
+  if (!isEnabled())
+    return;
+  Event event;
+  event.name = name;
+  event.start_ns = start_ns;
+  event.duration_ns = end_ns - start_ns;
+  event.allocations = allocations;
+  append(event);
+}
+
+void Profiler::counter(const char *name, double value) {
+  if (!isEnabled())
+    return;
+  Event event;
+  event.name = name;
+  event.start_ns = now();
+  event.value = value;
+  event.counter = true;
+  append(event);
+}
+
+void Profiler::setThreadName(const QString &name) {
+  ThreadBuffer &buffer = threadBuffer();
+  QMutexLocker locker(&registry().mutex);
+  buffer.name = name;
+}
+
+QVector<Profiler::Event> Profiler::events() {
+  QVector<Event> result;
+  Registry &r = registry();
+  QMutexLocker locker(&r.mutex);
+  for (const std::unique_ptr<ThreadBuffer> &buffer : r.buffers) {
+    const quint64 head = buffer->head.load(std::memory_order_acquire);
+    const quint64 first = std::max(buffer->cleared, head > kBufferEvents ? head - kBufferEvents : 0);
+    const qsizetype copied_from = result.size();
+    for (quint64 seq = first; seq < head; seq++) {
+      const Slot &slot = buffer->ring[seq % kBufferEvents];
+      Event event;
+      event.name = slot.name.load(std::memory_order_relaxed);
+      event.start_ns = slot.start_ns.load(std::memory_order_relaxed);
+      event.duration_ns = slot.duration_ns.load(std::memory_order_relaxed);
+      event.allocations = slot.allocations.load(std::memory_order_relaxed);
+      event.value = slot.value.load(std::memory_order_relaxed);
+      event.counter = slot.counter.load(std::memory_order_relaxed);
+      event.thread = buffer->thread;
+      result.append(event);
+    }
+    // 复制期间写入方可能已绕回覆盖了最旧的几格，序号不大于 writing - 1 - kBufferEvents 的丢弃
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const quint64 writing = buffer->writing.load(std::memory_order_relaxed);
+    if (writing > kBufferEvents && writing - kBufferEvents > first) {
+      const qsizetype torn = qsizetype(qMin(writing - kBufferEvents, head) - first);
+      result.remove(copied_from, torn);
+    }
+  }
+  std::sort(result.begin(), result.end(), [](const Event &a, const Event &b) {
+    return a.start_ns < b.start_ns;
+  });
+  return result;
+}
+
+QVector<Profiler::Stat> Profiler::statistics() {
+  const QVector<Event> all = events();
+  QHash<QString, Stat> by_name;
+  for (const Event &event : all) {
+    if (event.counter)
+      continue;
+    Stat &stat = by_name[QString::fromUtf8(event.name)];
+    stat.count++;
+    stat.total_ns += event.duration_ns;
+    stat.max_ns = qMax(stat.max_ns, event.duration_ns);
+    stat.last_ns = event.duration_ns;
+    stat.allocations += event.allocations;
+  }
+  QVector<Stat> result;
+  result.reserve(by_name.size());
+  for (auto it = by_name.begin(); it != by_name.end(); ++it) {
+    Stat stat = it.value();
+    stat.name = it.key();
+    result.append(stat);
+  }
+  std::sort(result.begin(), result.end(), [](const Stat &a, const Stat &b) {
+    return a.total_ns > b.total_ns;
+  });
+  return result;
+}
+
+void Profiler::clear() {
+  Registry &r = registry();
+  QMutexLocker locker(&r.mutex);
+  for (const std::unique_ptr<ThreadBuffer> &buffer : r.buffers)
+    buffer->cleared = buffer->head.load(std::memory_order_acquire);
+}
+
+bool Profiler::writeChromeTrace(const QString &path, QString &error) {
+  const QVector<Event> all = events();
+  QJsonArray trace;
+  QJsonObject process;
+  process["name"] = "process_name";
+  process["ph"] = "M";
+  process["pid"] = 1;
+  process["args"] = QJsonObject{{"name", "qtbacktester"}};
+  trace.append(process);
+  {
+    Registry &r = registry();
+    QMutexLocker locker(&r.mutex);
+    for (const std::unique_ptr<ThreadBuffer> &buffer : r.buffers) {
+      QJsonObject thread;
+      thread["name"] = "thread_name";
+      thread["ph"] = "M";
+      thread["pid"] = 1;
+      thread["tid"] = buffer->thread;
+      const QString name = buffer->name.isEmpty() ? QString("线程%1").arg(buffer->thread)
+                                                  : buffer->name;
+      thread["args"] = QJsonObject{{"name", name}};
+      trace.append(thread);
+    }
+  }
+  for (const Event &event : all) {
+    QJsonObject item;
+    item["name"] = QString::fromUtf8(event.name);
+    item["pid"] = 1;
+    item["tid"] = event.thread;
+    item["ts"] = event.start_ns / 1000.0; // 微秒
+    if (event.counter) {
+      item["ph"] = "C";
+      item["args"] = QJsonObject{{"value", event.value}};
+    } else {
+      item["ph"] = "X";
+      item["dur"] = event.duration_ns / 1000.0;
+      item["args"] = QJsonObject{{"allocations", event.allocations}};
+    }
+    trace.append(item);
+  }
+  QJsonObject root;
+  root["traceEvents"] = trace;
+  root["displayTimeUnit"] = "ms";
+
+  QSaveFile file(path);
+  const QByteArray data = QJsonDocument(root).toJson(QJsonDocument::Compact);
+  if (!file.open(QIODevice::WriteOnly) || file.write(data) != data.size() || !file.commit()) {
+    error = "无法写入文件: " + path;
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,86 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <QString>
+#include <QVector>
+
+#include <atomic>
+
+// 轻量的耗时与分配统计。每个线程写自己的环形缓冲区，写入不加锁，满了覆盖最旧的事件；
+// 读取方取快照时丢弃可能正被覆盖的部分。关闭时ProfileScope只多一次原子读和分支。
+// 事件名必须是字符串字面量之类生命周期覆盖整个进程的字符串，只保存指针。
+// 环境变量QTBACKTESTER_PROFILE非空时启动即开启
+class Profiler {
+public:
+  struct Event {
+    const char* name = nullptr;
+    qint64 start_ns = 0;    // 相对进程启动
+    qint64 duration_ns = 0; // 计数器事件为0
+    qint64 allocations = 0; // 期间本线程的堆分配次数，口径见allocationCount
+    double value = 0.0;     // 计数器的取值
+    bool counter = false;
+    int thread = 0; // 快照时填写，线程按首次记录的顺序编号
+  };
+
+  struct Stat {
+    QString name;
+    qint64 count = 0;
+    qint64 total_ns = 0;
+    qint64 max_ns = 0;
+    qint64 last_ns = 0;
+    qint64 allocations = 0;
+  };
+
+  static bool isEnabled() { return enabled_.load(std::memory_order_relaxed); }
+  static void setEnabled(bool enabled);
+
+  static qint64 now(); // 单调时钟，纳秒
+  // 分配计数的口径。替换分配函数的allocationcounter.cpp只由基准程序，以及打开
+  // QTBACKTESTER_COUNT_ALLOCATIONS的界面和命令行链接；默认构建使用标准分配器，不计数
+  enum class AllocationCounting {
+    None,
+    OperatorNew, // 只统计operator new
+    Malloc,      // glibc上统计malloc/calloc/realloc，包括Qt容器经QArrayData直接调用的malloc
+  };
+
+  // 当前线程累计的堆分配次数，不受开关影响，口径见allocationCounting
+  static qint64 allocationCount();
+  static AllocationCounting allocationCounting();
+  static void setAllocationCounting(AllocationCounting counting); // 由allocationcounter.cpp在启动时调用
+  static void record(const char* name, qint64 start_ns, qint64 end_ns, qint64 allocations = 0);
+  static void counter(const char* name, double value);
+  static void setThreadName(const QString& name); // 用于trace中的线程名
+
+  static QVector<Event> events(); // 上次clear之后的事件，按开始时间排序
+  static QVector<Stat> statistics(); // 按名称汇总，按总耗时降序
+  static void clear();
+  // 导出Chrome trace-event格式，可在chrome://tracing或Perfetto中打开
+  static bool writeChromeTrace(const QString& path, QString& error);
+
+private:
+  static std::atomic<bool> enabled_;
+  static std::atomic<AllocationCounting> allocation_counting_;
+};
+
+// 作用域计时：构造时开始，析构时记录一个事件
+class ProfileScope {
+public:
+  explicit ProfileScope(const char* name)
+      : name_(Profiler::isEnabled() ? name : nullptr)
+      , start_ns_(name_ ? Profiler::now() : 0)
+      , allocations_(name_ ? Profiler::allocationCount() : 0) {}
+  ~ProfileScope() {
+    if (name_)
+      Profiler::record(name_, start_ns_, Profiler::now(), Profiler::allocationCount() - allocations_);
+  }
+
+  ProfileScope(const ProfileScope&) = delete;
+  ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+  const char* name_;
+  qint64 start_ns_;
+  qint64 allocations_;
+};
+
+#endif // PROFILER_H
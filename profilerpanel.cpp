@@ -0,0 +1,155 @@
+#include "profilerpanel.h"
+
+#include "profiler.h"
+
+#include <QCheckBox>
+#include <QFileDialog>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QMessageBox>
+#include <QPushButton>
+#include <QTableWidget>
+#include <QTimer>
+#include <QVBoxLayout>
+
+namespace {
+
+constexpr int kRefreshIntervalMs = 500;
+constexpr int kSummaryPhases = 3; // 状态栏显示总耗时最多的几个阶段
+
+enum Column {
+  NameColumn,
+  CountColumn,
+  TotalColumn,
+  AverageColumn,
+  MaxColumn,
+  LastColumn,
+  AllocationsColumn,
+  ColumnCount
+};
+
+QTableWidgetItem *numberItem(double value) {
+  auto *item = new QTableWidgetItem;
+  item->setData(Qt::DisplayRole, value);
+  return item;
+}
+
+double milliseconds(qint64 ns) {
+  return qRound64(ns / 1e4) / 100.0;
+}
+
+} // namespace
+
+ProfilerPanel::ProfilerPanel(QWidget *parent)
+    : QDockWidget("性能统计", parent)
+    , enabled_check_(nullptr)
+    , table_(nullptr)
+    , summary_label_(nullptr)
+    , refresh_timer_(new QTimer(this)) {
+  setObjectName("profilerPanel");
+  initializeApplication();
+}
+
+void ProfilerPanel::initializeApplication() {
+  auto *content = new QWidget(this);
+  auto *layout = new QVBoxLayout(content);
+  auto *tool_layout = new QHBoxLayout();
+  enabled_check_ = new QCheckBox("采集");
+  enabled_check_->setToolTip("关闭时计时点只有一次原子读的开销");
+  enabled_check_->setChecked(Profiler::isEnabled());
+  auto *clear_button = new QPushButton("清空");
+  auto *export_button = new QPushButton("导出Trace...");
+  export_button->setToolTip("导出Chrome trace-event JSON，可在Perfetto中打开");
+  summary_label_ = new QLabel();
+  tool_layout->addWidget(enabled_check_);
+  tool_layout->addWidget(clear_button);
+  tool_layout->addWidget(export_button);
+  tool_layout->addWidget(summary_label_, 1);
+  layout->addLayout(tool_layout);
+
+  table_ = new QTableWidget(content);
+  table_->setColumnCount(ColumnCount);
+  table_->setHorizontalHeaderLabels(
+      {"阶段",
+       "次数",
+       "总耗时(ms)",
+       "平均(ms)",
+       "最大(ms)",
+       "最近(ms)",
+       Profiler::allocationCounting() == Profiler::AllocationCounting::Malloc ? "分配次数"
+                                                                              : "operator new次数"});
+  // 默认构建不统计分配，这一列恒为0
+  table_->setColumnHidden(AllocationsColumn,
+                          Profiler::allocationCounting() == Profiler::AllocationCounting::None);
+  table_->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
+  table_->verticalHeader()->setVisible(false);
+  table_->setEditTriggers(QAbstractItemView::NoEditTriggers);
+  table_->setSelectionBehavior(QAbstractItemView::SelectRows);
+  layout->addWidget(table_);
+  setWidget(content);
+
+  connect(enabled_check_, &QCheckBox::toggled, this, &ProfilerPanel::onEnabledToggled);
+  connect(clear_button, &QPushButton::clicked, this, &ProfilerPanel::onClearClicked);
+  connect(export_button, &QPushButton::clicked, this, &ProfilerPanel::onExportClicked);
+  refresh_timer_->setInterval(kRefreshIntervalMs);
+  // 没有开启采集时事件不再变化，不必定时汇总
+  connect(refresh_timer_, &QTimer::timeout, this, [this] {
+    if (Profiler::isEnabled())
+      refresh();
+  });
+  refresh_timer_->start();
+  connect(this, &QDockWidget::visibilityChanged, this, [this](bool visible) {
+    if (visible)
+      refresh();
+  });
+}
+
+void ProfilerPanel::onEnabledToggled(bool enabled) {
+  Profiler::setEnabled(enabled);
+  refresh();
+}
+
+void ProfilerPanel::onClearClicked() {
+  Profiler::clear();
+  refresh();
+}
+
+void ProfilerPanel::onExportClicked() {
+  QString path = QFileDialog::getSaveFileName(this,
+                                              "导出Trace",
+                                              "qtbacktester_trace.json",
+                                              "Trace JSON (*.json)");
+  if (path.isEmpty())
+    return;
+  QString error;
+  if (!Profiler::writeChromeTrace(path, error))
+    QMessageBox::warning(this, "导出Trace", error);
+}
+
+void ProfilerPanel::refresh() {
+  const QVector<Profiler::Stat> stats = Profiler::statistics();
+  QString summary;
+  for (int i = 0; i < qMin(int(stats.size()), kSummaryPhases); i++) {
+    if (!summary.isEmpty())
+      summary += "  ";
+    summary += QString("%1 %2ms").arg(stats[i].name).arg(milliseconds(stats[i].last_ns));
+  }
+  summary_label_->setText(summary);
+  emit summaryChanged(Profiler::isEnabled() ? summary : QString());
+  if (!isVisible())
+    return; // 面板隐藏时只更新状态栏
+  table_->setSortingEnabled(false);
+  table_->setRowCount(int(stats.size()));
+  for (int row = 0; row < int(stats.size()); row++) {
+    const Profiler::Stat &stat = stats[row];
+    table_->setItem(row, NameColumn, new QTableWidgetItem(stat.name));
+    table_->setItem(row, CountColumn, numberItem(double(stat.count)));
+    table_->setItem(row, TotalColumn, numberItem(milliseconds(stat.total_ns)));
+    table_->setItem(row, AverageColumn, numberItem(milliseconds(stat.total_ns / stat.count)));
+    table_->setItem(row, MaxColumn, numberItem(milliseconds(stat.max_ns)));
+    table_->setItem(row, LastColumn, numberItem(milliseconds(stat.last_ns)));
+    table_->setItem(row, AllocationsColumn, numberItem(double(stat.allocations)));
+  }
+  table_->setSortingEnabled(true);
+}
@@ -0,0 +1,36 @@
+#ifndef PROFILERPANEL_H
+#define PROFILERPANEL_H
+
+#include <QDockWidget>
+
+class QCheckBox;
+class QLabel;
+class QTableWidget;
+class QTimer;
+
+// 性能面板：定时汇总Profiler的事件，按阶段显示次数、耗时和分配次数，可导出Chrome trace
+class ProfilerPanel : public QDockWidget {
+  Q_OBJECT
+
+public:
+  explicit ProfilerPanel(QWidget* parent = nullptr);
+
+signals:
+  void summaryChanged(const QString& text); // 状态栏上的简要信息
+
+private slots:
+  void onEnabledToggled(bool enabled);
+  void onClearClicked();
+  void onExportClicked();
+  void refresh();
+
+private:
+  void initializeApplication(); // 整体初始化
+
+  QCheckBox* enabled_check_;
+  QTableWidget* table_;
+  QLabel* summary_label_;
+  QTimer* refresh_timer_;
+};
+
+#endif // PROFILERPANEL_H
@@ -0,0 +1,162 @@
+#include "rangeindex.h"
+
+#include <QtAlgorithms>
+
+#include <algorithm>
+
+namespace {
+
+// floor(log2(n))，n >= 1
+inline int floorLog2(quint64 n) {
+  return 63 - int(qCountLeadingZeroBits(n));
+}
+
+} // namespace
+
+template<typename Compare>
+void RangeIndex::Table<Compare>::build(const double *data, qsizetype count) {
+  values.resize(count);
+  levels.clear();
+  if (count == 0)
+    return;
+  std::copy(data, data + count, values.begin());
+
+  const qsizetype blocks = (count + kBlockSize - 1) / kBlockSize;
+  QVector<double> base(blocks);
+  for (qsizetype b = 0; b < blocks; b++) {
+    const qsizetype begin = b * kBlockSize;
+    const qsizetype end = qMin(count, begin + kBlockSize);
+    double best = data[begin];
+    for (qsizetype i = begin + 1; i < end; i++)
+      best = Compare::pick(best, data[i]);
+    base[b] = best;
+  }
+  levels.append(base);
+  for (qsizetype width = 2; width <= blocks; width *= 2) {
+    const QVector<double> &prev = levels.last();
+    QVector<double> level(blocks - width + 1);
+    const qsizetype half = width / 2;
+    for (qsizetype b = 0; b < level.size(); b++)
+      level[b] = Compare::pick(prev[b], prev[b + half]);
+    levels.append(level);
+  }
+}
+
+template<typename Compare>
+void RangeIndex::Table<Compare>::append(double value) {
+  values.append(value);
+  const qsizetype last = values.size() - 1;
+  const qsizetype block = last / kBlockSize;
+  if (levels.isEmpty())
+    levels.append(QVector<double>());
+  QVector<double> &base = levels[0];
+  if (block == base.size())
+    base.append(value);
+  else
+    base[block] = Compare::pick(base[block], value);
+  // 第k层只有从block - 2^k + 1开始的那一项包含最后一块；块数刚好到2^k时多出一层
+  const qsizetype blocks = block + 1;
+  for (qsizetype k = 1; (qsizetype(1) << k) <= blocks; k++) {
+    if (k == levels.size())
+      levels.append(QVector<double>());
+    const qsizetype width = qsizetype(1) << k;
+    const qsizetype first = block - width + 1;
+    const QVector<double> &prev = levels[k - 1];
+    const double best = Compare::pick(prev[first], prev[first + width / 2]);
+    QVector<double> &level = levels[k];
+    if (first == level.size())
+      level.append(best);
+    else
+      level[first] = best;
+  }
+}
+
+template<typename Compare>
+void RangeIndex::Table<Compare>::truncate(qsizetype count) {
+  if (count >= values.size())
+    return;
+  const qsizetype start = count / kBlockSize * kBlockSize; // 保留部分最后一块的起点
+  double tail[kBlockSize];
+  const qsizetype tail_count = count - start;
+  std::copy(values.constBegin() + start, values.constBegin() + count, tail);
+  values.resize(start);
+  // 第k层只保留完全落在前blocks块内的项，没有剩余项的层及更高层整层去掉
+  const qsizetype blocks = start / kBlockSize;
+  for (qsizetype k = 0; k < levels.size(); k++) {
+    const qsizetype entries = blocks - (qsizetype(1) << k) + 1;
+    if (entries <= 0) {
+      levels.resize(k);
+      break;
+    }
+    levels[k].resize(entries);
+  }
+  for (qsizetype i = 0; i < tail_count; i++)
+    append(tail[i]);
+}
+
+template<typename Compare>
+double RangeIndex::Table<Compare>::query(qsizetype first, qsizetype last) const {
+  const double *data = values.constData();
+  const qsizetype first_block = first / kBlockSize;
+  const qsizetype last_block = last / kBlockSize;
+  double best = data[first];
+  if (first_block == last_block) {
+    for (qsizetype i = first + 1; i <= last; i++)
+      best = Compare::pick(best, data[i]);
+    return best;
+  }
+  // 两端不完整的块逐个扫描
+  const qsizetype head_end = (first_block + 1) * kBlockSize;
+  for (qsizetype i = first + 1; i < head_end; i++)
+    best = Compare::pick(best, data[i]);
+  for (qsizetype i = last_block * kBlockSize; i <= last; i++)
+    best = Compare::pick(best, data[i]);
+  // 中间的整块用两段可重叠的2^k块覆盖
+  const qsizetype inner_first = first_block + 1;
+  const qsizetype inner_last = last_block - 1;
+  if (inner_first <= inner_last) {
+    const int k = floorLog2(quint64(inner_last - inner_first + 1));
+    const QVector<double> &level = levels[k];
+    best = Compare::pick(best, level[inner_first]);
+    best = Compare::pick(best, level[inner_last - (qsizetype(1) << k) + 1]);
+  }
+  return best;
+}
+
+void RangeIndex::build(const double *min_values, const double *max_values, qsizetype count) {
+  min_.build(min_values, count);
+  max_.build(max_values, count);
+}
+
+void RangeIndex::build(const QVector<KLineData> &bars) {
+  QVector<double> low(bars.size());
+  QVector<double> high(bars.size());
+  for (qsizetype i = 0; i < bars.size(); i++) {
+    low[i] = bars[i].low;
+    high[i] = bars[i].high;
+  }
+  build(low.constData(), high.constData(), bars.size());
+}
+
+void RangeIndex::append(double min_value, double max_value) {
+  min_.append(min_value);
+  max_.append(max_value);
+}
+
+void RangeIndex::truncate(qsizetype count) {
+  min_.truncate(count);
+  max_.truncate(count);
+}
+
+double RangeIndex::min(qsizetype first, qsizetype last) const {
+  return min_.query(first, last);
+}
+
+double RangeIndex::max(qsizetype first, qsizetype last) const {
+  return max_.query(first, last);
+}
+
+void RangeIndex::clear() {
+  min_ = Table<Less>();
+  max_ = Table<Greater>();
+}
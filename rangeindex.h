@@ -0,0 +1,55 @@
+#ifndef RANGEINDEX_H
+#define RANGEINDEX_H
+
+#include "klinedata.h"
+
+#include <QVector>
+
+// 区间最值索引（分块稀疏表）：数据按kBlockSize分块，块内最值建稀疏表，
+// 查询时整块部分O(1)取表，两端不完整的块直接扫描（最多2*kBlockSize个元素）。
+// 额外内存约为数据量的1.5倍，建表O(n)；末尾追加用append，O(log n)，
+// 替换末尾的元素先truncate再append，其他修改需重新build
+class RangeIndex {
+public:
+  static constexpr qsizetype kBlockSize = 32;
+
+  // min_values和max_values分别建最小值、最大值表，可以是同一列（如权益曲线）
+  void build(const double* min_values, const double* max_values, qsizetype count);
+  void build(const QVector<KLineData>& bars); // 最低价求最小值，最高价求最大值
+  // 在末尾追加一个元素，只更新包含最后一块的各层表项
+  void append(double min_value, double max_value);
+  void append(const KLineData& bar) { append(bar.low, bar.high); }
+  // 只保留前count个元素：丢掉最后一块之后的表项，再把该块保留的部分重新追加，O(kBlockSize * log n)
+  void truncate(qsizetype count);
+  void clear();
+
+  qsizetype size() const { return min_.values.size(); }
+  bool isEmpty() const { return min_.values.isEmpty(); }
+  // 闭区间[first, last]，调用方保证 0 <= first <= last < size()
+  double min(qsizetype first, qsizetype last) const;
+  double max(qsizetype first, qsizetype last) const;
+
+private:
+  template<typename Compare>
+  struct Table {
+    QVector<double> values;
+    QVector<QVector<double>> levels; // levels[k][b] 为从第b块开始连续2^k块的最值
+
+    void build(const double* data, qsizetype count);
+    void append(double value);
+    void truncate(qsizetype count);
+    double query(qsizetype first, qsizetype last) const;
+  };
+
+  struct Less {
+    static double pick(double a, double b) { return b < a ? b : a; }
+  };
+  struct Greater {
+    static double pick(double a, double b) { return b > a ? b : a; }
+  };
+
+  Table<Less> min_;
+  Table<Greater> max_;
+};
+
+#endif // RANGEINDEX_H
@@ -1,11 +1,22 @@
 #!/usr/bin/env python3
-import ccxt
 import pandas as pd
 import argparse
+import json
 import sys
 import os
+import urllib.error
+import urllib.parse
+import urllib.request
 from datetime import datetime
-import requests  # 用于测试网络连接
+
+try:
+  import ccxt
+  import requests  # 用于测试网络连接
+except ImportError:  # 只使用 --mock-server 时可以不安装
+  ccxt = None
+
+EXIT_RATE_LIMITED = 75  # 被限频时的退出码，调用方据此退避重试；不用2，argparse和找不到脚本时都返回2
+EXIT_NO_DATA = 76       # 该时间段没有数据（如上市之前），分批下载时视为空窗口
 
 def test_proxy(proxy_url):
   """测试代理是否工作正常"""
@@ -20,24 +31,61 @@ def test_proxy(proxy_url):
   except:
     return False
 
+def fetch_mock(server, symbol, timeframe, since, limit):
+  """从本地模拟服务(scripts/mockohlcvserver.py)获取K线"""
+  query = urllib.parse.urlencode({'symbol': symbol, 'timeframe': timeframe, 'since': since, 'limit': limit})
+  try:
+    with urllib.request.urlopen(f"{server.rstrip('/')}/ohlcv?{query}", timeout=30) as response:
+      return json.loads(response.read().decode('utf-8'))
+  except urllib.error.HTTPError as e:
+    if e.code == 429:
+      print("模拟服务限频", file=sys.stderr)
+      sys.exit(EXIT_RATE_LIMITED)
+    raise
+
+def report_progress(fetched):
+  """输出机器可读的进度行，下载器逐行解析，需要立即刷新"""
+  print(f"PROGRESS {fetched}", flush=True)
+
 def main():
   parser = argparse.ArgumentParser(description='下载加密货币K线数据')
   parser.add_argument('--exchange', required=True)
   parser.add_argument('--symbol', required=True)
   parser.add_argument('--timeframe', required=True)
-  parser.add_argument('--start', required=True)
+  parser.add_argument('--start', help='起始时间 yyyy-MM-dd HH:mm:ss')
+  parser.add_argument('--since-ms', type=int, help='起始时间戳（毫秒，UTC），优先于--start')
   parser.add_argument('--limit', type=int, required=True)
   parser.add_argument('--output', required=True)
   parser.add_argument('--proxy', default='http://127.0.0.1:7890', help='代理服务器地址，例如 http://127.0.0.1:7890')
+  parser.add_argument('--skip-proxy-test', action='store_true', help='分批下载时跳过每个窗口的代理测试')
+  parser.add_argument('--mock-server', help='使用本地模拟服务代替交易所，例如 http://127.0.0.1:8765')
 
   args = parser.parse_args()
+  if args.since_ms is None and args.start is None:
+    parser.error('需要 --start 或 --since-ms')
+
+  if args.since_ms is not None:
+    since = args.since_ms
+  else:
+    since = int(datetime.strptime(args.start, '%Y-%m-%d %H:%M:%S').timestamp() * 1000)
+
+  if args.mock_server:
+    ohlcv = fetch_mock(args.mock_server, args.symbol, args.timeframe, since, args.limit)
+    report_progress(len(ohlcv))
+    save(ohlcv, args.output)
+    return
+
+  if ccxt is None:
+    print("未安装ccxt，请先执行 pip install ccxt requests", file=sys.stderr)
+    sys.exit(1)
 
   try:
     # 测试代理连接
-    print(f"测试代理连接: {args.proxy}")
-    if not test_proxy(args.proxy):
-      print(f"警告: 代理 {args.proxy} 可能无法正常工作，尝试直接连接")
-      # 不退出，尝试直接连接
+    if not args.skip_proxy_test:
+      print(f"测试代理连接: {args.proxy}")
+      if not test_proxy(args.proxy):
+        print(f"警告: 代理 {args.proxy} 可能无法正常工作，尝试直接连接")
+        # 不退出，尝试直接连接
 
     # 创建交易所实例，设置代理
     exchange_config = {
@@ -54,26 +102,17 @@ def main():
 
     exchange = getattr(ccxt, args.exchange)(exchange_config)
 
-    since = int(datetime.strptime(args.start, '%Y-%m-%d %H:%M:%S').timestamp() * 1000)
-
     print(f"开始下载数据: {args.exchange}, {args.symbol}, {args.timeframe}")
-    print(f"时间范围: {args.start}, 数量: {args.limit}")
+    print(f"时间范围: {args.start or since}, 数量: {args.limit}")
 
     # 使用limit参数，而不是结束时间
     ohlcv = exchange.fetch_ohlcv(args.symbol, args.timeframe, since=since, limit=args.limit)
+    report_progress(len(ohlcv))
+    save(ohlcv, args.output)
 
-    if not ohlcv:
-      print("没有获取到数据")
-      sys.exit(1)
-
-    df = pd.DataFrame(ohlcv, columns=['timestamp', 'open', 'high', 'low', 'close', 'volume'])
-    df['datetime'] = pd.to_datetime(df['timestamp'], unit='ms')
-    df = df.sort_values('timestamp')  # 确保数据按时间升序排列
-    os.makedirs(os.path.dirname(args.output) if os.path.dirname(args.output) else '.', exist_ok=True)
-    df.to_csv(args.output, index=False)
-    print(f"成功下载 {len(df)} 条数据")
-    print(f"数据已保存到: {args.output}")
-
+  except (ccxt.RateLimitExceeded, ccxt.DDoSProtection) as e:
+    print(f"交易所限频: {str(e)}", file=sys.stderr)
+    sys.exit(EXIT_RATE_LIMITED)
   except ccxt.NetworkError as e:
     print(f"网络错误: {str(e)}", file=sys.stderr)
     print("请检查网络连接和代理设置", file=sys.stderr)
@@ -87,5 +126,18 @@ def main():
     traceback.print_exc()
     sys.exit(1)
 
+def save(ohlcv, output):
+  if not ohlcv:
+    print("没有获取到数据", file=sys.stderr)
+    sys.exit(EXIT_NO_DATA)
+
+  df = pd.DataFrame(ohlcv, columns=['timestamp', 'open', 'high', 'low', 'close', 'volume'])
+  df['datetime'] = pd.to_datetime(df['timestamp'], unit='ms')
+  df = df.sort_values('timestamp')  # 确保数据按时间升序排列
+  os.makedirs(os.path.dirname(output) if os.path.dirname(output) else '.', exist_ok=True)
+  df.to_csv(output, index=False)
+  print(f"成功下载 {len(df)} 条数据")
+  print(f"数据已保存到: {output}")
+
 if __name__ == "__main__":
   main()
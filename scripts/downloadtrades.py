@@ -0,0 +1,112 @@
+#!/usr/bin/env python3
+"""下载逐笔成交，输出 timestamp,price,amount,side 的CSV，供 qtbacktester_cli --ticks 使用。
+
+按时间分页调用ccxt的fetch_trades，边下载边追加写入，内存与成交数量无关。
+同一毫秒内的成交可能跨页，按成交id去重。
+"""
+import argparse
+import csv
+import json
+import os
+import sys
+import urllib.error
+import urllib.parse
+import urllib.request
+from datetime import datetime
+
+try:
+  import ccxt
+except ImportError:  # 只使用 --mock-server 时可以不安装
+  ccxt = None
+
+EXIT_RATE_LIMITED = 75  # 与downloaddata.py一致
+EXIT_NO_DATA = 76
+PAGE_LIMIT = 1000
+
+
+def fetch_mock(server, symbol, since, limit):
+  """从本地模拟服务(scripts/mockohlcvserver.py)获取逐笔成交"""
+  query = urllib.parse.urlencode({'symbol': symbol, 'since': since, 'limit': limit})
+  try:
+    with urllib.request.urlopen(f"{server.rstrip('/')}/trades?{query}", timeout=30) as response:
+      return json.loads(response.read().decode('utf-8'))
+  except urllib.error.HTTPError as e:
+    if e.code == 429:
+      print("模拟服务限频", file=sys.stderr)
+      sys.exit(EXIT_RATE_LIMITED)
+    raise
+
+
+def make_exchange(name, proxy):
+  config = {'timeout': 30000, 'enableRateLimit': True}
+  if proxy and proxy != 'direct':
+    config['proxies'] = {'http': proxy, 'https': proxy}
+  return getattr(ccxt, name)(config)
+
+
+def download(fetch, since, end_ms, max_trades, output):
+  """逐页下载并写入output，返回写入的成交数"""
+  written = 0
+  seen = set()  # 最后一毫秒内已写入的成交id
+  os.makedirs(os.path.dirname(output) if os.path.dirname(output) else '.', exist_ok=True)
+  with open(output, 'w', newline='') as f:
+    writer = csv.writer(f)
+    writer.writerow(['timestamp', 'price', 'amount', 'side'])
+    while max_trades <= 0 or written < max_trades:
+      trades = fetch(since)
+      fresh = [t for t in trades if t['id'] not in seen and (end_ms is None or t['timestamp'] < end_ms)]
+      if not fresh:
+        break
+      for t in fresh:
+        writer.writerow([t['timestamp'], t['price'], t['amount'], t['side']])
+      written += len(fresh)
+      print(f"PROGRESS {written}", flush=True)
+      last = fresh[-1]['timestamp']
+      seen = {t['id'] for t in fresh if t['timestamp'] == last}
+      since = last  # 从最后一毫秒重新取，靠seen去重；没有新成交时结束
+  return written
+
+
+def main():
+  parser = argparse.ArgumentParser(description='下载加密货币逐笔成交数据')
+  parser.add_argument('--exchange', default='binance')
+  parser.add_argument('--symbol', required=True)
+  parser.add_argument('--start', help='起始时间 yyyy-MM-dd HH:mm:ss')
+  parser.add_argument('--since-ms', type=int, help='起始时间戳（毫秒，UTC），优先于--start')
+  parser.add_argument('--end-ms', type=int, help='结束时间戳（毫秒，UTC，不含）')
+  parser.add_argument('--limit', type=int, default=0, help='最多下载的成交数，0为不限制')
+  parser.add_argument('--output', required=True)
+  parser.add_argument('--proxy', default='http://127.0.0.1:7890', help='代理服务器地址，direct为不使用代理')
+  parser.add_argument('--mock-server', help='使用本地模拟服务代替交易所，例如 http://127.0.0.1:8765')
+  args = parser.parse_args()
+  if args.since_ms is None and args.start is None:
+    parser.error('需要 --start 或 --since-ms')
+  since = args.since_ms if args.since_ms is not None else int(
+      datetime.strptime(args.start, '%Y-%m-%d %H:%M:%S').timestamp() * 1000)
+
+  if args.mock_server:
+    fetch = lambda s: fetch_mock(args.mock_server, args.symbol, s, PAGE_LIMIT)
+  else:
+    if ccxt is None:
+      print("未安装ccxt，请先执行 pip install ccxt", file=sys.stderr)
+      sys.exit(1)
+    exchange = make_exchange(args.exchange, args.proxy)
+    fetch = lambda s: exchange.fetch_trades(args.symbol, since=s, limit=PAGE_LIMIT)
+
+  try:
+    written = download(fetch, since, args.end_ms, args.limit, args.output)
+  except Exception as e:
+    if ccxt is not None and isinstance(e, (ccxt.RateLimitExceeded, ccxt.DDoSProtection)):
+      print(f"交易所限频: {str(e)}", file=sys.stderr)
+      sys.exit(EXIT_RATE_LIMITED)
+    print(f"下载失败: {str(e)}", file=sys.stderr)
+    sys.exit(1)
+  if written == 0:
+    print("没有获取到数据", file=sys.stderr)
+    sys.exit(EXIT_NO_DATA)
+  print(f"成功下载 {written} 笔成交")
+  print(f"数据已保存到: {args.output}")
+
+
+if __name__ == "__main__":
+  main()
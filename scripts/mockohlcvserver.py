@@ -0,0 +1,157 @@
+#!/usr/bin/env python3
+"""本地模拟K线服务，用于离线测试下载流程。
+
+GET /ohlcv?symbol=BTC/USDT&timeframe=1m&since=<毫秒>&limit=<条数>
+返回 [[timestamp, open, high, low, close, volume], ...]，与ccxt的fetch_ohlcv格式相同。
+价格只由K线序号决定，不同窗口重叠部分的数据完全一致，便于校验拼接结果。
+
+GET /trades?symbol=BTC/USDT&since=<毫秒>&limit=<条数>
+返回 [{id, timestamp, price, amount, side}, ...]，与ccxt的fetch_trades的字段相同。
+每TRADE_STEP_MS毫秒TRADES_PER_STEP笔成交，同样只由序号决定。
+超过 --rate-limit 每秒请求数时返回429。
+
+--feed-port 另开一个TCP行情端口，代替交易所的实时推送：连接后先发 --feed-history 根历史K线，
+之后每 --feed-interval 秒推送一根，每行 timestamp,open,high,low,close,volume，与数据文件格式相同。
+"""
+import argparse
+import json
+import math
+import socketserver
+import threading
+import time
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+from urllib.parse import parse_qs, urlparse
+
+TIMEFRAMES = {'1m': 60, '5m': 300, '15m': 900, '1h': 3600, '4h': 14400, '1d': 86400}
+TRADE_STEP_MS = 250
+TRADES_PER_STEP = 2  # 同一毫秒多笔成交，用于测试分页去重
+
+
+def make_bar(ts, step_ms):
+  k = ts // step_ms
+  base = 30000.0 * math.exp(0.3 * math.sin(k / 5000.0) + 0.05 * math.sin(k / 97.0))
+  close = base * (1.0 + 0.002 * math.sin(k * 1.7))
+  open_ = base * (1.0 + 0.002 * math.sin((k - 1) * 1.7))
+  high = max(open_, close) * (1.0 + 0.001 * (1.0 + math.sin(k * 0.31)))
+  low = min(open_, close) * (1.0 - 0.001 * (1.0 + math.cos(k * 0.29)))
+  volume = 10.0 + 5.0 * (1.0 + math.sin(k * 0.11))
+  return [ts, round(open_, 2), round(high, 2), round(low, 2), round(close, 2), round(volume, 5)]
+
+
+def make_trade(k):
+  ts = k // TRADES_PER_STEP * TRADE_STEP_MS
+  price = 30000.0 * math.exp(0.3 * math.sin(k / 400000.0)) * (1.0 + 0.0005 * math.sin(k * 0.37))
+  amount = 0.001 + 0.05 * (1.0 + math.sin(k * 0.13))
+  side = 'buy' if math.sin(k * 0.71) >= 0 else 'sell'
+  return {'id': str(k), 'timestamp': ts, 'price': round(price, 2), 'amount': round(amount, 5), 'side': side}
+
+
+class RateLimiter:
+  def __init__(self, per_second):
+    self.per_second = per_second
+    self.lock = threading.Lock()
+    self.window = 0
+    self.count = 0
+
+  def allow(self):
+    if self.per_second <= 0:
+      return True
+    with self.lock:
+      now = int(time.time())
+      if now != self.window:
+        self.window = now
+        self.count = 0
+      self.count += 1
+      return self.count <= self.per_second
+
+
+def make_handler(limiter, latency):
+  class Handler(BaseHTTPRequestHandler):
+    def do_GET(self):
+      url = urlparse(self.path)
+      if url.path not in ('/ohlcv', '/trades'):
+        self.send_error(404)
+        return
+      if not limiter.allow():
+        self.send_response(429)
+        self.send_header('Retry-After', '1')
+        self.end_headers()
+        return
+      query = {k: v[0] for k, v in parse_qs(url.query).items()}
+      if url.path == '/trades':
+        self.reply(self.trades(query))
+        return
+      step_ms = TIMEFRAMES.get(query.get('timeframe', '1d'), 86400) * 1000
+      since = int(query.get('since', 0))
+      limit = min(int(query.get('limit', 1000)), 1000)
+      first = (since + step_ms - 1) // step_ms * step_ms
+      now = int(time.time() * 1000)
+      bars = [make_bar(first + i * step_ms, step_ms) for i in range(limit) if first + i * step_ms <= now]
+      self.reply(bars)
+
+    def trades(self, query):
+      since = int(query.get('since', 0))
+      limit = min(int(query.get('limit', 1000)), 1000)
+      first = (since + TRADE_STEP_MS - 1) // TRADE_STEP_MS * TRADES_PER_STEP
+      now = int(time.time() * 1000)
+      return [t for t in (make_trade(first + i) for i in range(limit)) if t['timestamp'] <= now]
+
+    def reply(self, payload):
+      if latency > 0:
+        time.sleep(latency)
+      body = json.dumps(payload).encode('utf-8')
+      self.send_response(200)
+      self.send_header('Content-Type', 'application/json')
+      self.send_header('Content-Length', str(len(body)))
+      self.end_headers()
+      self.wfile.write(body)
+
+    def log_message(self, format, *args):
+      pass
+
+  return Handler
+
+
+def make_feed_handler(step_ms, history, interval):
+  class FeedHandler(socketserver.BaseRequestHandler):
+    def handle(self):
+      now = int(time.time() * 1000) // step_ms * step_ms
+      ts = now - history * step_ms
+      try:
+        self.request.sendall(b'timestamp,open,high,low,close,volume\n')
+        while True:
+          if ts > now:
+            time.sleep(interval)
+          self.request.sendall((','.join(str(v) for v in make_bar(ts, step_ms)) + '\n').encode('ascii'))
+          ts += step_ms
+      except OSError:
+        pass  # 客户端断开
+
+  return FeedHandler
+
+
+def main():
+  parser = argparse.ArgumentParser(description='本地模拟K线和逐笔成交服务')
+  parser.add_argument('--port', type=int, default=8765)
+  parser.add_argument('--rate-limit', type=int, default=0, help='每秒允许的请求数，0为不限制')
+  parser.add_argument('--latency', type=float, default=0.05, help='每个请求的模拟延迟（秒）')
+  parser.add_argument('--feed-port', type=int, default=0, help='实时行情的TCP端口，0为不开启')
+  parser.add_argument('--feed-timeframe', default='1m', choices=sorted(TIMEFRAMES))
+  parser.add_argument('--feed-interval', type=float, default=1.0, help='实时行情每根K线的推送间隔（秒）')
+  parser.add_argument('--feed-history', type=int, default=200, help='连接后先推送的历史K线数')
+  args = parser.parse_args()
+  if args.feed_port > 0:
+    socketserver.ThreadingTCPServer.daemon_threads = True
+    feed = socketserver.ThreadingTCPServer(
+        ('127.0.0.1', args.feed_port),
+        make_feed_handler(TIMEFRAMES[args.feed_timeframe] * 1000, args.feed_history, args.feed_interval))
+    threading.Thread(target=feed.serve_forever, daemon=True).start()
+    print(f'模拟实时行情: tcp://127.0.0.1:{args.feed_port}', flush=True)
+  server = ThreadingHTTPServer(('127.0.0.1', args.port),
+                               make_handler(RateLimiter(args.rate_limit), args.latency))
+  print(f'模拟K线服务: http://127.0.0.1:{args.port}', flush=True)
+  server.serve_forever()
+
+
+if __name__ == '__main__':
+  main()
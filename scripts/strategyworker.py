@@ -0,0 +1,137 @@
+#!/usr/bin/env python3
+"""常驻策略进程：由主程序启动后一直保持运行，通过stdin/stdout交换二进制消息。
+
+消息格式（小端）：magic(u32) + type(u32) + payload长度(u64) + payload
+  LOAD_COLUMNS: u64条数 + timestamp(int64列) + open/high/low/close/volume(float64列)
+  LOAD_CACHE:   .klc列式缓存文件路径(utf8)，直接np.memmap映射，不经过管道
+  RUN:          策略文件路径(utf8)
+  RESULT:       u64信号数 + K线下标(int64列) + 方向(int8列，1买入/-1卖出)
+  ERROR:        错误信息(utf8)
+
+策略文件需提供 generate_signals(bars)，bars为列名到numpy数组的字典，
+返回与K线等长的数组：1买入，-1卖出，0不动作。
+"""
+import importlib.util
+import os
+import struct
+import sys
+import traceback
+
+import numpy as np
+
+MAGIC = 0x57534251  # 'QBSW'
+LOAD_COLUMNS = 1
+LOAD_CACHE = 2
+RUN = 3
+RESULT = 4
+ERROR = 5
+
+HEADER = struct.Struct('<IIQ')
+CACHE_HEADER = struct.Struct('<8sIIqqqq16x')
+CACHE_MAGIC = b'QBKLCACH'
+COLUMNS = ('timestamp', 'open', 'high', 'low', 'close', 'volume')
+
+
+def read_exact(stream, size):
+  chunks = []
+  while size > 0:
+    chunk = stream.read(size)
+    if not chunk:
+      return None
+    chunks.append(chunk)
+    size -= len(chunk)
+  return b''.join(chunks)
+
+
+class Worker:
+  def __init__(self, out):
+    self.out = out
+    self.bars = None
+    self.load_error = '尚未加载K线数据'
+    self.modules = {}  # 路径 -> (修改时间, 模块)，策略文件未变化时不重新导入
+
+  def send(self, kind, payload):
+    self.out.write(HEADER.pack(MAGIC, kind, len(payload)))
+    self.out.write(payload)
+    self.out.flush()
+
+  def load_columns(self, payload):
+    count = struct.unpack_from('<Q', payload)[0]
+    offset = 8
+    bars = {}
+    for name in COLUMNS:
+      dtype = '<i8' if name == 'timestamp' else '<f8'
+      bars[name] = np.frombuffer(payload, dtype=dtype, count=count, offset=offset)
+      offset += count * 8
+    self.bars = bars
+
+  def load_cache(self, payload):
+    path = payload.decode('utf-8')
+    raw = np.memmap(path, dtype=np.uint8, mode='r')
+    magic, version, header_size, _, _, count, stride = CACHE_HEADER.unpack_from(raw)
+    if magic != CACHE_MAGIC or version != 1:
+      raise ValueError(f'无法识别的缓存文件: {path}')
+    bars = {}
+    for i, name in enumerate(COLUMNS):
+      dtype = '<i8' if name == 'timestamp' else '<f8'
+      bars[name] = np.frombuffer(raw, dtype=dtype, count=count, offset=header_size + i * stride)
+    self.bars = bars
+
+  def strategy(self, path):
+    mtime = os.path.getmtime(path)
+    cached = self.modules.get(path)
+    if cached and cached[0] == mtime:
+      return cached[1]
+    spec = importlib.util.spec_from_file_location(os.path.splitext(os.path.basename(path))[0], path)
+    module = importlib.util.module_from_spec(spec)
+    spec.loader.exec_module(module)
+    self.modules[path] = (mtime, module)
+    return module
+
+  def run(self, payload):
+    if self.bars is None:
+      raise RuntimeError(self.load_error)
+    module = self.strategy(payload.decode('utf-8'))
+    signals = np.asarray(module.generate_signals(self.bars))
+    count = len(self.bars['close'])
+    if signals.shape != (count,):
+      raise ValueError(f'generate_signals返回长度{signals.shape}，应为{count}')
+    index = np.flatnonzero(signals).astype('<i8')
+    side = np.sign(signals[index]).astype(np.int8)
+    self.send(RESULT, struct.pack('<Q', len(index)) + index.tobytes() + side.tobytes())
+
+  def serve(self, stream):
+    handlers = {LOAD_COLUMNS: self.load_columns, LOAD_CACHE: self.load_cache, RUN: self.run}
+    while True:
+      header = read_exact(stream, HEADER.size)
+      if header is None:
+        return
+      magic, kind, size = HEADER.unpack(header)
+      if magic != MAGIC:
+        print('协议错误，退出', file=sys.stderr)
+        return
+      payload = read_exact(stream, size) if size else b''
+      if payload is None:
+        return
+      try:
+        handlers[kind](payload)
+      except Exception as e:
+        traceback.print_exc()
+        message = f'{type(e).__name__}: {e}'
+        if kind == RUN:
+          self.send(ERROR, message.encode('utf-8'))
+        else:
+          # 加载消息没有应答，错误留到下一次RUN时返回
+          self.bars = None
+          self.load_error = message
+
+
+def main():
+  out = sys.stdout.buffer
+  # 策略中的print输出到stderr，避免破坏二进制协议
+  sys.stdout = sys.stderr
+  Worker(out).serve(sys.stdin.buffer)
+
+
+if __name__ == '__main__':
+  main()
@@ -0,0 +1,88 @@
+#ifndef SPSCRING_H
+#define SPSCRING_H
+
+#include <QtGlobal>
+
+#include <atomic>
+#include <memory>
+
+// 单生产者单消费者的无锁环形队列：容量为2的幂，缓冲区在构造时一次分配。
+// 读写位置各占一条缓存行，生产者只写tail_、消费者只写head_，互不争用；
+// 各自缓存对方位置的副本，只在看起来满/空时才重新读取对方的原子变量。
+// T须可平凡复制，满时tryPush返回false，由调用方决定等待还是丢弃
+template<typename T>
+class SpscRing {
+public:
+  explicit SpscRing(qsizetype capacity);
+
+  SpscRing(const SpscRing&) = delete;
+  SpscRing& operator=(const SpscRing&) = delete;
+
+  bool tryPush(const T& value); // 只能在生产者线程调用
+  bool tryPop(T& value);        // 只能在消费者线程调用
+  qsizetype capacity() const { return mask_ + 1; }
+  qsizetype size() const; // 任意线程可调用，结果只是近似值
+
+private:
+  static constexpr size_t kCacheLine = 64;
+
+  const qsizetype mask_;
+  const std::unique_ptr<T[]> slots_;
+  alignas(kCacheLine) std::atomic<qsizetype> head_; // 下一个要读的位置，消费者写
+  qsizetype cached_tail_;                           // 消费者看到的tail_
+  alignas(kCacheLine) std::atomic<qsizetype> tail_; // 下一个要写的位置，生产者写
+  qsizetype cached_head_;                           // 生产者看到的head_
+};
+
+namespace SpscRingDetail {
+
+inline qsizetype roundUpPowerOfTwo(qsizetype n) {
+  qsizetype size = 2;
+  while (size < n)
+    size *= 2;
+  return size;
+}
+
+} // namespace SpscRingDetail
+
+template<typename T>
+SpscRing<T>::SpscRing(qsizetype capacity)
+    : mask_(SpscRingDetail::roundUpPowerOfTwo(capacity) - 1)
+    , slots_(new T[mask_ + 1])
+    , head_(0)
+    , cached_tail_(0)
+    , tail_(0)
+    , cached_head_(0) {}
+
+template<typename T>
+bool SpscRing<T>::tryPush(const T& value) {
+  const qsizetype tail = tail_.load(std::memory_order_relaxed);
+  if (tail - cached_head_ > mask_) {
+    cached_head_ = head_.load(std::memory_order_acquire);
+    if (tail - cached_head_ > mask_)
+      return false;
+  }
+  slots_[tail & mask_] = value;
+  tail_.store(tail + 1, std::memory_order_release);
+  return true;
+}
+
+template<typename T>
+bool SpscRing<T>::tryPop(T& value) {
+  const qsizetype head = head_.load(std::memory_order_relaxed);
+  if (head == cached_tail_) {
+    cached_tail_ = tail_.load(std::memory_order_acquire);
+    if (head == cached_tail_)
+      return false;
+  }
+  value = slots_[head & mask_];
+  head_.store(head + 1, std::memory_order_release);
+  return true;
+}
+
+template<typename T>
+qsizetype SpscRing<T>::size() const {
+  return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+}
+
+#endif // SPSCRING_H
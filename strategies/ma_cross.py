@@ -0,0 +1,24 @@
+"""均线交叉示例策略：快线上穿慢线买入，下穿卖出。"""
+import numpy as np
+
+FAST = 10
+SLOW = 30
+
+
+def moving_average(values, period):
+  result = np.full(len(values), np.nan)
+  if len(values) >= period:
+    csum = np.cumsum(values, dtype=np.float64)
+    result[period - 1:] = (csum[period - 1:] - np.concatenate(([0.0], csum[:-period]))) / period
+  return result
+
+
+def generate_signals(bars):
+  close = bars['close']
+  diff = moving_average(close, FAST) - moving_average(close, SLOW)
+  prev = np.roll(diff, 1)
+  prev[0] = np.nan
+  signals = np.zeros(len(close), dtype=np.int8)
+  signals[(prev <= 0) & (diff > 0)] = 1
+  signals[(prev >= 0) & (diff < 0)] = -1
+  return signals
@@ -0,0 +1,16 @@
+// 均线交叉示例C++策略插件，规则与ma_cross.py相同：快线上穿慢线买入，下穿卖出。
+// 构建后为strategies/ma_cross.so（Windows为ma_cross.dll），程序启动时加载
+#include "nativestrategy.h"
+
+namespace {
+
+struct MaCrossParams {
+  static constexpr int kFast = 10;
+  static constexpr int kSlow = 30;
+};
+
+using MaCross = CrossoverStrategy<MaCrossParams, Sma>;
+
+} // namespace
+
+QTBACKTESTER_STRATEGY_PLUGIN(MaCross, "均线交叉 MA10/MA30", "快线上穿慢线买入，下穿卖出（C++插件）")
@@ -0,0 +1,51 @@
+#include "strategyplugin.h"
+
+#include "profiler.h"
+
+#include <QFileInfo>
+
+bool StrategyPlugin::isPluginFile(const QString &file_path) {
+  return QLibrary::isLibrary(file_path);
+}
+
+bool StrategyPlugin::load(const QString &file_path, QString &error) {
+  file_path_ = QFileInfo(file_path).absoluteFilePath();
+  library_.setFileName(file_path_);
+  if (!library_.load()) {
+    error = QString("无法加载策略插件 %1: %2").arg(file_path_, library_.errorString());
+    return false;
+  }
+  auto entry = reinterpret_cast<StrategyPluginEntry>(library_.resolve(kStrategyPluginSymbol));
+  if (!entry) {
+    error = QString("%1 不是策略插件（缺少 %2）").arg(file_path_, kStrategyPluginSymbol);
+    return false;
+  }
+  const StrategyPluginInfo *info = entry();
+  if (!info || info->abi_version != kStrategyPluginAbi || !info->generate) {
+    error = QString("策略插件 %1 的接口版本不匹配，请用当前的 nativestrategy.h 重新编译").arg(file_path_);
+    return false;
+  }
+  if (info->bar_size != sizeof(KLineData)) {
+    error = QString("策略插件 %1 的K线结构与程序不一致").arg(file_path_);
+    return false;
+  }
+  info_ = info;
+  return true;
+}
+
+QString StrategyPlugin::name() const {
+  if (!info_ || !info_->name)
+    return QFileInfo(file_path_).fileName();
+  return QString::fromUtf8(info_->name);
+}
+
+QString StrategyPlugin::description() const {
+  return info_ && info_->description ? QString::fromUtf8(info_->description) : QString();
+}
+
+void StrategyPlugin::generate(const KLineData *bars, qsizetype count, QVector<qint8> &actions) const {
+  ProfileScope scope("strategy.plugin");
+  actions.resize(count);
+  if (count > 0)
+    info_->generate(bars, qint64(count), actions.data());
+}
@@ -0,0 +1,36 @@
+#ifndef STRATEGYPLUGIN_H
+#define STRATEGYPLUGIN_H
+
+#include "nativestrategy.h"
+
+#include <QLibrary>
+#include <QString>
+#include <QVector>
+
+// strategies/下的C++策略插件（共享库，见nativestrategy.h）。
+// 加载后一直保留到进程退出，不卸载，避免回测进行中函数指针失效
+class StrategyPlugin {
+public:
+  StrategyPlugin() = default;
+  StrategyPlugin(const StrategyPlugin&) = delete;
+  StrategyPlugin& operator=(const StrategyPlugin&) = delete;
+
+  // 按文件后缀判断是否为当前平台的共享库(.so/.dll/.dylib)
+  static bool isPluginFile(const QString& file_path);
+
+  bool load(const QString& file_path, QString& error);
+  bool isLoaded() const { return info_ != nullptr; }
+  const QString& filePath() const { return file_path_; }
+  QString name() const;
+  QString description() const;
+
+  // 对整段K线给出逐K线动作，actions调整为count个
+  void generate(const KLineData* bars, qsizetype count, QVector<qint8>& actions) const;
+
+private:
+  QLibrary library_;
+  QString file_path_;
+  const StrategyPluginInfo* info_ = nullptr;
+};
+
+#endif // STRATEGYPLUGIN_H
@@ -0,0 +1,180 @@
+#include "strategyworker.h"
+
+#include "profiler.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QDir>
+#include <QtEndian>
+
+#include <cstring>
+
+namespace {
+
+// 与scripts/strategyworker.py中的定义保持一致
+constexpr quint32 kMagic = 0x57534251; // 'QBSW'
+constexpr quint32 kLoadColumns = 1;
+constexpr quint32 kLoadCache = 2;
+constexpr quint32 kRun = 3;
+constexpr quint32 kResult = 4;
+constexpr quint32 kError = 5;
+constexpr qsizetype kHeaderSize = 16;
+
+template<typename T>
+void appendColumn(char *&out, const QVector<KLineData> &bars, T KLineData::*field) {
+  for (const KLineData &bar : bars) {
+    T value = qToLittleEndian(bar.*field);
+    std::memcpy(out, &value, sizeof(T));
+    out += sizeof(T);
+  }
+}
+
+} // namespace
+
+StrategyWorker::StrategyWorker(QObject *parent)
+    : QObject(parent)
+    , process_(new QProcess(this))
+    , bars_sent_(false)
+    , busy_(false)
+    , run_start_ns_(0) {
+  connect(process_, &QProcess::readyReadStandardOutput, this, &StrategyWorker::onReadyReadOutput);
+  connect(process_, &QProcess::readyReadStandardError, this, &StrategyWorker::onReadyReadError);
+  connect(process_, &QProcess::finished, this, &StrategyWorker::onProcessFinished);
+}
+
+StrategyWorker::~StrategyWorker() {
+  if (process_->state() != QProcess::NotRunning) {
+    // 关闭stdin后worker读到EOF会自行退出
+    process_->closeWriteChannel();
+    if (!process_->waitForFinished(1000))
+      process_->kill();
+  }
+}
+
+bool StrategyWorker::start() {
+  if (process_->state() != QProcess::NotRunning)
+    return true;
+  QDir appDir(QCoreApplication::applicationDirPath());
+  QString scriptPath = appDir.absoluteFilePath("scripts/strategyworker.py");
+  buffer_.clear();
+  bars_sent_ = false;
+  process_->start("python", {"-u", scriptPath});
+  if (!process_->waitForStarted(3000)) {
+    qDebug() << "无法启动策略进程:" << process_->errorString();
+    return false;
+  }
+  return true;
+}
+
+void StrategyWorker::setBars(const QVector<KLineData> &bars, const QString &cache_path) {
+  bars_ = bars;
+  cache_path_ = cache_path;
+  bars_sent_ = false;
+}
+
+bool StrategyWorker::run(const QString &strategy_path) {
+  if (busy_)
+    return false;
+  run_start_ns_ = Profiler::now();
+  if (!start())
+    return false;
+  if (!bars_sent_)
+    sendBars();
+  busy_ = true;
+  sendMessage(kRun, strategy_path.toUtf8());
+  return true;
+}
+
+void StrategyWorker::sendMessage(quint32 type, const QByteArray &payload) {
+  char header[kHeaderSize];
+  qToLittleEndian<quint32>(kMagic, header);
+  qToLittleEndian<quint32>(type, header + 4);
+  qToLittleEndian<quint64>(payload.size(), header + 8);
+  process_->write(header, kHeaderSize);
+  process_->write(payload);
+}
+
+void StrategyWorker::sendBars() {
+  ProfileScope scope("python.sendBars");
+  if (!cache_path_.isEmpty()) {
+    sendMessage(kLoadCache, cache_path_.toUtf8());
+  } else {
+    // 没有缓存文件时按列写入管道，Python端用np.frombuffer零拷贝读取
+    QByteArray payload(8 + bars_.size() * 48, Qt::Uninitialized);
+    char *out = payload.data();
+    qToLittleEndian<quint64>(bars_.size(), out);
+    out += 8;
+    appendColumn(out, bars_, &KLineData::timestamp);
+    appendColumn(out, bars_, &KLineData::open);
+    appendColumn(out, bars_, &KLineData::high);
+    appendColumn(out, bars_, &KLineData::low);
+    appendColumn(out, bars_, &KLineData::close);
+    appendColumn(out, bars_, &KLineData::volume);
+    sendMessage(kLoadColumns, payload);
+  }
+  bars_sent_ = true;
+}
+
+void StrategyWorker::onReadyReadOutput() {
+  buffer_.append(process_->readAllStandardOutput());
+  while (buffer_.size() >= kHeaderSize) {
+    const char *data = buffer_.constData();
+    quint32 magic = qFromLittleEndian<quint32>(data);
+    quint32 type = qFromLittleEndian<quint32>(data + 4);
+    quint64 size = qFromLittleEndian<quint64>(data + 8);
+    if (magic != kMagic) {
+      process_->kill();
+      fail("策略进程返回了无法识别的数据");
+      return;
+    }
+    if (quint64(buffer_.size() - kHeaderSize) < size)
+      return;
+    QByteArray payload = buffer_.mid(kHeaderSize, size);
+    buffer_.remove(0, kHeaderSize + size);
+    handleMessage(type, payload);
+  }
+}
+
+void StrategyWorker::onReadyReadError() {
+  QByteArray output = process_->readAllStandardError();
+  qDebug().noquote() << "[strategy]" << QString::fromUtf8(output).trimmed();
+}
+
+void StrategyWorker::onProcessFinished(int exit_code, QProcess::ExitStatus exit_status) {
+  Q_UNUSED(exit_status)
+  buffer_.clear();
+  bars_sent_ = false;
+  fail(QString("策略进程意外退出 (退出码%1)").arg(exit_code));
+}
+
+void StrategyWorker::handleMessage(quint32 type, const QByteArray &payload) {
+  if (type == kError) {
+    fail(QString::fromUtf8(payload));
+    return;
+  }
+  if (type != kResult || payload.size() < 8) {
+    fail("策略进程返回了无法识别的消息");
+    return;
+  }
+  const char *data = payload.constData();
+  quint64 count = qFromLittleEndian<quint64>(data);
+  if (quint64(payload.size()) != 8 + count * 9) {
+    fail("策略信号长度不正确");
+    return;
+  }
+  StrategySignals result;
+  result.bar_index.resize(count);
+  result.side.resize(count);
+  qFromLittleEndian<qint64>(data + 8, count, result.bar_index.data());
+  std::memcpy(result.side.data(), data + 8 + count * 8, count);
+  busy_ = false;
+  Profiler::record("python.strategy", run_start_ns_, Profiler::now());
+  emit finished(result);
+}
+
+void StrategyWorker::fail(const QString &message) {
+  if (!busy_)
+    return;
+  busy_ = false;
+  emit failed(message);
+}
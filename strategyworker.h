@@ -0,0 +1,55 @@
+#ifndef STRATEGYWORKER_H
+#define STRATEGYWORKER_H
+
+#include "klinedata.h"
+
+#include <QByteArray>
+#include <QObject>
+#include <QProcess>
+#include <QVector>
+
+// Python策略返回的紧凑信号数组：第i个信号发生在第bar_index[i]根K线，side为1买入、-1卖出
+struct StrategySignals {
+  QVector<qint64> bar_index;
+  QVector<qint8> side;
+};
+
+// 常驻的Python策略进程(scripts/strategyworker.py)。
+// K线只在数据集变化后发送一次，有列式缓存时让Python直接映射缓存文件，之后每次回测只传策略路径
+class StrategyWorker : public QObject {
+  Q_OBJECT
+
+public:
+  explicit StrategyWorker(QObject* parent = nullptr);
+  ~StrategyWorker();
+
+  bool start(); // 启动并预热解释器
+  bool isBusy() const { return busy_; }
+  void setBars(const QVector<KLineData>& bars, const QString& cache_path);
+  bool run(const QString& strategy_path); // 异步运行，进程忙或无法启动时返回false
+
+signals:
+  void finished(const StrategySignals& result);
+  void failed(const QString& message);
+
+private slots:
+  void onReadyReadOutput();
+  void onReadyReadError();
+  void onProcessFinished(int exit_code, QProcess::ExitStatus exit_status);
+
+private:
+  void sendMessage(quint32 type, const QByteArray& payload);
+  void sendBars();
+  void handleMessage(quint32 type, const QByteArray& payload);
+  void fail(const QString& message);
+
+  QProcess* process_;
+  QByteArray buffer_;
+  QVector<KLineData> bars_;
+  QString cache_path_;
+  bool bars_sent_;
+  bool busy_;
+  qint64 run_start_ns_; // 本次运行的开始时间，用于统计Python端往返耗时
+};
+
+#endif // STRATEGYWORKER_H
@@ -0,0 +1,218 @@
+#include "sweepdialog.h"
+#include "ui_sweepdialog.h"
+
+#include <QHeaderView>
+#include <QMessageBox>
+#include <QTableWidgetItem>
+
+namespace {
+
+constexpr qsizetype kMaxCombinations = 1000000;
+
+enum Column {
+  FastColumn,
+  SlowColumn,
+  CapitalColumn,
+  CommissionColumn,
+  SlippageColumn,
+  FinalCapitalColumn,
+  ReturnColumn,
+  TradesColumn,
+  WinRateColumn,
+  DrawdownColumn,
+  ColumnCount
+};
+
+// 单元格存数值而不是文本，表头点击时按数值排序
+QTableWidgetItem *numberItem(double value) {
+  auto *item = new QTableWidgetItem;
+  item->setData(Qt::DisplayRole, value);
+  return item;
+}
+
+double percent(double ratio) {
+  return qRound64(ratio * 10000.0) / 100.0;
+}
+
+} // namespace
+
+SweepDialog::SweepDialog(const QVector<KLineData> &bars,
+                         std::shared_ptr<IndicatorCache> indicators,
+                         const BacktestConfig &defaults,
+                         QWidget *parent)
+    : QDialog(parent)
+    , ui(new Ui::SweepDialog)
+    , sweep_(new ParameterSweep(this))
+    , bars_(bars)
+    , indicators_(std::move(indicators))
+    , total_runs_(0)
+    , finished_runs_(0) {
+  ui->setupUi(this);
+  initializeApplication(defaults);
+}
+
+SweepDialog::~SweepDialog() {
+  delete ui;
+}
+
+void SweepDialog::initializeApplication(const BacktestConfig &defaults) {
+  // 均线周期
+  for (QSpinBox *box : {ui->fastFromSpinBox, ui->fastToSpinBox, ui->slowFromSpinBox, ui->slowToSpinBox}) {
+    box->setRange(1, 1000);
+  }
+  ui->fastStepSpinBox->setRange(0, 1000);
+  ui->slowStepSpinBox->setRange(0, 1000);
+  ui->fastFromSpinBox->setValue(5);
+  ui->fastToSpinBox->setValue(20);
+  ui->fastStepSpinBox->setValue(5);
+  ui->slowFromSpinBox->setValue(20);
+  ui->slowToSpinBox->setValue(60);
+  ui->slowStepSpinBox->setValue(10);
+  // 资金与成本，默认取主界面当前的取值，步长为0表示不扫描
+  for (QDoubleSpinBox *box : {ui->capitalFromSpinBox, ui->capitalToSpinBox, ui->capitalStepSpinBox}) {
+    box->setDecimals(2);
+    box->setRange(0.0, 1e9);
+  }
+  ui->capitalFromSpinBox->setValue(defaults.initial_capital);
+  ui->capitalToSpinBox->setValue(defaults.initial_capital);
+  for (QDoubleSpinBox *box : {ui->commissionFromSpinBox,
+                              ui->commissionToSpinBox,
+                              ui->commissionStepSpinBox,
+                              ui->slippageFromSpinBox,
+                              ui->slippageToSpinBox,
+                              ui->slippageStepSpinBox}) {
+    box->setDecimals(5);
+    box->setRange(0.0, 0.1);
+    box->setSingleStep(0.0001);
+  }
+  ui->commissionFromSpinBox->setValue(defaults.commission);
+  ui->commissionToSpinBox->setValue(defaults.commission);
+  ui->slippageFromSpinBox->setValue(defaults.slippage);
+  ui->slippageToSpinBox->setValue(defaults.slippage);
+
+  ui->resultsTable->setColumnCount(ColumnCount);
+  ui->resultsTable->setHorizontalHeaderLabels({"快线",
+                                               "慢线",
+                                               "初始资金",
+                                               "手续费",
+                                               "滑点",
+                                               "最终资金",
+                                               "收益率(%)",
+                                               "交易次数",
+                                               "胜率(%)",
+                                               "最大回撤(%)"});
+  ui->resultsTable->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
+  ui->resultsTable->verticalHeader()->setVisible(false);
+
+  const QList<QSpinBox *> spin_boxes = findChildren<QSpinBox *>();
+  for (QSpinBox *box : spin_boxes) {
+    connect(box, &QSpinBox::valueChanged, this, &SweepDialog::onRangeChanged);
+  }
+  const QList<QDoubleSpinBox *> double_spin_boxes = findChildren<QDoubleSpinBox *>();
+  for (QDoubleSpinBox *box : double_spin_boxes) {
+    connect(box, &QDoubleSpinBox::valueChanged, this, &SweepDialog::onRangeChanged);
+  }
+  connect(ui->startButton, &QPushButton::clicked, this, &SweepDialog::onStartClicked);
+  connect(ui->cancelButton, &QPushButton::clicked, this, &SweepDialog::onCancelClicked);
+  connect(sweep_, &ParameterSweep::resultsReady, this, &SweepDialog::onResultsReady);
+  connect(sweep_, &ParameterSweep::finished, this, &SweepDialog::onSweepFinished);
+  onRangeChanged();
+}
+
+SweepSpec SweepDialog::readSpec() const {
+  SweepSpec spec;
+  spec.fast_period = {double(ui->fastFromSpinBox->value()),
+                      double(ui->fastToSpinBox->value()),
+                      double(ui->fastStepSpinBox->value())};
+  spec.slow_period = {double(ui->slowFromSpinBox->value()),
+                      double(ui->slowToSpinBox->value()),
+                      double(ui->slowStepSpinBox->value())};
+  spec.initial_capital = {ui->capitalFromSpinBox->value(),
+                          ui->capitalToSpinBox->value(),
+                          ui->capitalStepSpinBox->value()};
+  spec.commission = {ui->commissionFromSpinBox->value(),
+                     ui->commissionToSpinBox->value(),
+                     ui->commissionStepSpinBox->value()};
+  spec.slippage = {ui->slippageFromSpinBox->value(),
+                   ui->slippageToSpinBox->value(),
+                   ui->slippageStepSpinBox->value()};
+  return spec;
+}
+
+void SweepDialog::onRangeChanged() {
+  qsizetype count = ParameterSweep::combinationCount(readSpec());
+  ui->combinationLabel->setText(QString("组合数: %1，线程数: %2，K线: %3条")
+                                    .arg(count)
+                                    .arg(sweep_->threadCount())
+                                    .arg(bars_.size()));
+}
+
+void SweepDialog::onStartClicked() {
+  SweepSpec spec = readSpec();
+  total_runs_ = ParameterSweep::combinationCount(spec);
+  if (total_runs_ == 0) {
+    QMessageBox::warning(this, "参数扫描", "没有有效的参数组合（快线周期需小于慢线周期）");
+    return;
+  }
+  if (total_runs_ > kMaxCombinations) {
+    QMessageBox::warning(this, "参数扫描", QString("组合数超过上限 %1").arg(kMaxCombinations));
+    return;
+  }
+  finished_runs_ = 0;
+  ui->resultsTable->setRowCount(0);
+  ui->progressBar->setRange(0, int(total_runs_));
+  ui->progressBar->setValue(0);
+  if (!sweep_->start(bars_, spec, indicators_))
+    return;
+  ui->startButton->setEnabled(false);
+  ui->cancelButton->setEnabled(true);
+  ui->rangeGroupBox->setEnabled(false);
+}
+
+void SweepDialog::onCancelClicked() {
+  sweep_->cancel();
+  ui->cancelButton->setEnabled(false);
+}
+
+void SweepDialog::onResultsReady(const QVector<SweepResult> &results) {
+  QTableWidget *table = ui->resultsTable;
+  // 批量插入期间关闭排序，插入完成后按当前排序列整体重排一次
+  table->setSortingEnabled(false);
+  int row = table->rowCount();
+  table->setRowCount(row + int(results.size()));
+  for (const SweepResult &result : results) {
+    table->setItem(row, FastColumn, numberItem(result.fast_period));
+    table->setItem(row, SlowColumn, numberItem(result.slow_period));
+    table->setItem(row, CapitalColumn, numberItem(result.config.initial_capital));
+    table->setItem(row, CommissionColumn, numberItem(result.config.commission));
+    table->setItem(row, SlippageColumn, numberItem(result.config.slippage));
+    table->setItem(row, FinalCapitalColumn, numberItem(qRound64(result.final_capital * 100.0) / 100.0));
+    table->setItem(row, ReturnColumn, numberItem(percent(result.total_return)));
+    table->setItem(row, TradesColumn, numberItem(result.total_trades));
+    table->setItem(row, WinRateColumn, numberItem(percent(result.win_rate)));
+    table->setItem(row, DrawdownColumn, numberItem(percent(result.max_drawdown)));
+    row++;
+  }
+  table->setSortingEnabled(true);
+  finished_runs_ += results.size();
+  ui->progressBar->setValue(int(finished_runs_));
+}
+
+void SweepDialog::onSweepFinished(qint64 elapsed_ms) {
+  ui->startButton->setEnabled(true);
+  ui->cancelButton->setEnabled(false);
+  ui->rangeGroupBox->setEnabled(true);
+  double seconds = qMax<qint64>(elapsed_ms, 1) / 1000.0;
+  ui->combinationLabel->setText(
+      QString("完成 %1/%2 组，耗时 %3 秒，%4 组/秒，%5 百万K线/秒")
+          .arg(finished_runs_)
+          .arg(total_runs_)
+          .arg(seconds, 0, 'f', 2)
+          .arg(finished_runs_ / seconds, 0, 'f', 1)
+          .arg(finished_runs_ * double(bars_.size()) / seconds / 1e6, 0, 'f', 1));
+}
+
+void SweepDialog::reject() {
+  sweep_->cancel();
+  QDialog::reject();
+}
@@ -0,0 +1,45 @@
+#ifndef SWEEPDIALOG_H
+#define SWEEPDIALOG_H
+
+#include "parametersweep.h"
+
+#include <QDialog>
+
+namespace Ui {
+class SweepDialog;
+}
+
+class SweepDialog : public QDialog {
+  Q_OBJECT
+
+public:
+  SweepDialog(const QVector<KLineData> &bars,
+              std::shared_ptr<IndicatorCache> indicators, // 与主界面共用，已算过的均线不再重复计算
+              const BacktestConfig &defaults,
+              QWidget *parent = nullptr);
+  ~SweepDialog();
+
+public slots:
+  void reject() override; // 关闭时停止正在进行的扫描
+
+private slots:
+  void onStartClicked();
+  void onCancelClicked();
+  void onRangeChanged();
+  void onResultsReady(const QVector<SweepResult> &results);
+  void onSweepFinished(qint64 elapsed_ms);
+
+private:
+  void initializeApplication(const BacktestConfig &defaults); // 整体初始化
+  SweepSpec readSpec() const;
+
+private:
+  Ui::SweepDialog *ui;
+  ParameterSweep *sweep_;
+  QVector<KLineData> bars_;
+  std::shared_ptr<IndicatorCache> indicators_;
+  qsizetype total_runs_;
+  qsizetype finished_runs_;
+};
+
+#endif // SWEEPDIALOG_H
@@ -0,0 +1,99 @@
+#include "taskpool.h"
+
+namespace {
+
+// 当前线程所属的线程池及其队列下标，用于把任务中再提交的子任务放回本地队列
+thread_local const TaskPool *tls_pool = nullptr;
+thread_local int tls_queue_index = -1;
+
+} // namespace
+
+TaskPool::TaskPool(int thread_count)
+    : pending_(0)
+    , queued_(0)
+    , next_queue_(0)
+    , stopping_(false) {
+  if (thread_count <= 0)
+    thread_count = int(std::thread::hardware_concurrency());
+  if (thread_count <= 0)
+    thread_count = 1;
+  for (int i = 0; i < thread_count; i++) {
+    queues_.push_back(std::make_unique<Queue>());
+  }
+  for (int i = 0; i < thread_count; i++) {
+    threads_.emplace_back([this, i] { workerLoop(i); });
+  }
+}
+
+TaskPool::~TaskPool() {
+  wait();
+  {
+    std::lock_guard<std::mutex> lock(wake_mutex_);
+    stopping_ = true;
+  }
+  wake_.notify_all();
+  for (std::thread &thread : threads_) {
+    thread.join();
+  }
+}
+
+void TaskPool::submit(std::function<void()> task) {
+  pending_++;
+  int index = tls_pool == this ? tls_queue_index : int(next_queue_++ % queues_.size());
+  {
+    std::lock_guard<std::mutex> lock(queues_[index]->mutex);
+    queues_[index]->tasks.push_back(std::move(task));
+  }
+  {
+    std::lock_guard<std::mutex> lock(wake_mutex_);
+    queued_++;
+  }
+  wake_.notify_one();
+}
+
+void TaskPool::wait() {
+  std::unique_lock<std::mutex> lock(wake_mutex_);
+  idle_.wait(lock, [this] { return pending_ == 0; });
+}
+
+void TaskPool::workerLoop(int index) {
+  tls_pool = this;
+  tls_queue_index = index;
+  std::function<void()> task;
+  while (true) {
+    if (takeTask(index, task)) {
+      task();
+      task = nullptr;
+      if (--pending_ == 0) {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        idle_.notify_all();
+      }
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(wake_mutex_);
+    wake_.wait(lock, [this] { return stopping_ || queued_ > 0; });
+    if (stopping_ && queued_ == 0)
+      return;
+  }
+}
+
+bool TaskPool::takeTask(int index, std::function<void()> &task) {
+  const int count = int(queues_.size());
+  // 本地队列后进先出，窃取时从其他队列头部取最早提交的任务
+  for (int k = 0; k < count; k++) {
+    Queue &queue = *queues_[(index + k) % count];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty())
+      continue;
+    if (k == 0) {
+      task = std::move(queue.tasks.back());
+      queue.tasks.pop_back();
+    } else {
+      task = std::move(queue.tasks.front());
+      queue.tasks.pop_front();
+    }
+    queued_--;
+    return true;
+  }
+  return false;
+}
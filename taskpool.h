@@ -0,0 +1,46 @@
+#ifndef TASKPOOL_H
+#define TASKPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// 工作窃取线程池：每个线程有自己的任务队列，本地队列空了就从其他线程的队列头部窃取
+class TaskPool {
+public:
+  explicit TaskPool(int thread_count = 0); // 0表示使用全部核心
+  ~TaskPool();
+
+  TaskPool(const TaskPool&) = delete;
+  TaskPool& operator=(const TaskPool&) = delete;
+
+  int threadCount() const { return int(threads_.size()); }
+  void submit(std::function<void()> task);
+  void wait(); // 阻塞到已提交的任务全部完成，不能在任务内部调用
+
+private:
+  struct Queue {
+    std::mutex mutex;
+    std::deque<std::function<void()>> tasks;
+  };
+
+  void workerLoop(int index);
+  bool takeTask(int index, std::function<void()>& task);
+
+  std::vector<std::unique_ptr<Queue>> queues_;
+  std::vector<std::thread> threads_;
+  std::mutex wake_mutex_;
+  std::condition_variable wake_;
+  std::condition_variable idle_;
+  std::atomic<long long> pending_; // 已提交但尚未执行完的任务数
+  std::atomic<long long> queued_;  // 仍在队列中等待执行的任务数
+  std::atomic<unsigned> next_queue_;
+  bool stopping_;
+};
+
+#endif // TASKPOOL_H
@@ -0,0 +1,95 @@
+#include "tickbacktest.h"
+
+namespace {
+
+// 剩余数量低于订单的这个比例时视为成交完毕，避免浮点误差留下零头
+constexpr double kFillTolerance = 1e-9;
+
+BacktestConfig withoutEquityCurve(BacktestConfig config) {
+  config.record_equity_curve = false;
+  return config;
+}
+
+} // namespace
+
+TickFillSimulator::TickFillSimulator(const BacktestConfig &config, const TickFillConfig &fill)
+    : engine_(withoutEquityCurve(config))
+    , fill_(fill)
+    , commission_(config.commission)
+    , pending_(BarAction::Hold)
+    , reference_price_(0.0)
+    , signal_time_(0)
+    , ready_time_(0)
+    , remaining_(0.0)
+    , quantity_(0.0)
+    , notional_(0.0)
+    , filled_orders_(0)
+    , slippage_sum_(0.0)
+    , max_slippage_(0.0)
+    , fill_ms_sum_(0.0) {
+  fill_.participation = qBound(1e-6, fill_.participation, 1.0);
+  fill_.latency_ms = qMax<qint64>(0, fill_.latency_ms);
+  engine_.reset(0);
+}
+
+void TickFillSimulator::onBar(const KLineData &bar, BarAction action, qint64 now) {
+  engine_.markToMarket(bar.close);
+  if (pending_ != BarAction::Hold)
+    return;
+  if (action == BarAction::Buy && engine_.position() == 0.0 && engine_.cash() > 0.0) {
+    // 按信号价估算可买数量，实际持仓在成交后按成交均价重新计算
+    remaining_ = engine_.cash() / (bar.close * (1.0 + commission_));
+  } else if (action == BarAction::Sell && engine_.position() > 0.0) {
+    remaining_ = engine_.position();
+  } else {
+    return;
+  }
+  pending_ = action;
+  reference_price_ = bar.close;
+  signal_time_ = now;
+  ready_time_ = now + fill_.latency_ms;
+  quantity_ = 0.0;
+  notional_ = 0.0;
+}
+
+void TickFillSimulator::fill(const TickData &tick) {
+  const double take = qMin(remaining_, tick.amount * fill_.participation);
+  if (take <= 0.0)
+    return;
+  quantity_ += take;
+  notional_ += take * tick.price;
+  remaining_ -= take;
+  if (remaining_ > (quantity_ + remaining_) * kFillTolerance)
+    return;
+
+  const double price = notional_ / quantity_;
+  double slippage;
+  if (pending_ == BarAction::Buy) {
+    engine_.buyAt(tick.timestamp, price);
+    slippage = (price - reference_price_) / reference_price_;
+  } else {
+    engine_.sellAt(tick.timestamp, price);
+    slippage = (reference_price_ - price) / reference_price_;
+  }
+  filled_orders_++;
+  slippage_sum_ += slippage;
+  max_slippage_ = qMax(max_slippage_, slippage);
+  fill_ms_sum_ += double(tick.timestamp - signal_time_);
+  pending_ = BarAction::Hold;
+}
+
+TickBacktestResult TickFillSimulator::finish(qint64 ticks, qint64 bars) {
+  TickBacktestResult result;
+  result.unfilled_orders = pending_ != BarAction::Hold ? 1 : 0;
+  pending_ = BarAction::Hold;
+  result.backtest = engine_.finish();
+  result.ticks = ticks;
+  result.bars = bars;
+  result.filled_orders = filled_orders_;
+  if (filled_orders_ > 0) {
+    result.average_slippage = slippage_sum_ / filled_orders_;
+    result.max_slippage = max_slippage_;
+    result.average_fill_ms = fill_ms_sum_ / filled_orders_;
+  }
+  return result;
+}
@@ -0,0 +1,107 @@
+#ifndef TICKBACKTEST_H
+#define TICKBACKTEST_H
+
+#include "backtestengine.h"
+#include "baraggregator.h"
+#include "tickdata.h"
+
+#include <QVector>
+
+struct TickFillConfig {
+  qint64 latency_ms = 0;      // 从K线确认收盘到订单开始成交的延迟
+  double participation = 1.0; // 每笔成交中订单最多能吃到的比例，(0, 1]
+};
+
+struct TickBacktestResult {
+  BacktestResult backtest; // 只有统计指标，不记录权益曲线
+  qint64 ticks = 0;
+  qint64 bars = 0;
+  int filled_orders = 0;
+  int unfilled_orders = 0;       // 数据结束时仍未成交完的订单，整单作废
+  double average_slippage = 0.0; // 成交均价相对信号K线收盘价的不利偏移（比例），可为负
+  double max_slippage = 0.0;
+  double average_fill_ms = 0.0;  // 从信号到成交完成的平均时间
+};
+
+// 用逐笔成交代替固定滑点撮合：策略在K线收盘时下市价单，订单从确认收盘的那一笔（加上延迟）起
+// 按成交顺序逐笔吃单，每笔最多吃到amount*participation，吃满后按成交均价和手续费记账。
+// 同一时间只有一张订单，挂单期间策略的新信号被忽略
+class TickFillSimulator {
+public:
+  TickFillSimulator(const BacktestConfig& config, const TickFillConfig& fill);
+
+  // now为确认bar收盘的那一笔成交的时间
+  void onBar(const KLineData& bar, BarAction action, qint64 now);
+  inline void onTick(const TickData& tick);
+  TickBacktestResult finish(qint64 ticks, qint64 bars);
+
+private:
+  void fill(const TickData& tick);
+
+  BacktestEngine engine_;
+  TickFillConfig fill_;
+  double commission_;
+  BarAction pending_; // Hold表示没有挂单
+  double reference_price_;
+  qint64 signal_time_;
+  qint64 ready_time_;
+  double remaining_; // 尚未成交的数量
+  double quantity_;  // 已成交的数量和金额
+  double notional_;
+  int filled_orders_;
+  double slippage_sum_;
+  double max_slippage_;
+  double fill_ms_sum_;
+};
+
+inline void TickFillSimulator::onTick(const TickData& tick) {
+  if (pending_ != BarAction::Hold && tick.timestamp >= ready_time_)
+    fill(tick);
+}
+
+class TickBacktest {
+public:
+  // 单次顺序读完逐笔数据：边合成K线边撮合，内存只有读取器的一块逐笔数据
+  template<typename Reader, typename Strategy>
+  static TickBacktestResult run(const BacktestConfig& config,
+                                const TickFillConfig& fill,
+                                Reader& reader,
+                                BarAggregator aggregator,
+                                Strategy& strategy);
+};
+
+template<typename Reader, typename Strategy>
+TickBacktestResult TickBacktest::run(const BacktestConfig& config,
+                                     const TickFillConfig& fill,
+                                     Reader& reader,
+                                     BarAggregator aggregator,
+                                     Strategy& strategy) {
+  TickFillSimulator simulator(config, fill);
+  aggregator.reset();
+  KLineData bar;
+  qint64 ticks = 0;
+  qint64 bars = 0;
+  qint64 last_timestamp = 0;
+  while (const QVector<TickData>* block = reader.next()) {
+    const TickData* data = block->constData();
+    const qsizetype count = block->size();
+    for (qsizetype i = 0; i < count; i++) {
+      // 先确认上一根K线收盘并下单，这一笔成交已可用于撮合
+      if (aggregator.add(data[i], bar)) {
+        bars++;
+        simulator.onBar(bar, strategy.onBar(bar), data[i].timestamp);
+      }
+      simulator.onTick(data[i]);
+    }
+    ticks += count;
+    if (count > 0)
+      last_timestamp = data[count - 1].timestamp;
+  }
+  if (aggregator.flush(bar)) {
+    bars++;
+    simulator.onBar(bar, strategy.onBar(bar), last_timestamp);
+  }
+  return simulator.finish(ticks, bars);
+}
+
+#endif // TICKBACKTEST_H
@@ -0,0 +1,14 @@
+#ifndef TICKDATA_H
+#define TICKDATA_H
+
+#include <QtGlobal>
+
+// 一笔成交（逐笔数据）
+struct TickData {
+  qint64 timestamp;
+  double price;
+  double amount;   // 成交数量
+  bool taker_buy;  // 主动买入为true，主动卖出为false
+};
+
+#endif // TICKDATA_H
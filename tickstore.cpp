@@ -0,0 +1,426 @@
+#include "tickstore.h"
+
+#include <QDateTime>
+#include <QFileInfo>
+
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <string_view>
+
+namespace {
+
+constexpr char kMagic[8] = {'Q', 'B', 'T', 'I', 'C', 'K', 'S', 'T'};
+constexpr quint32 kVersion = 1;
+constexpr int kMaxDecimals = 8;
+constexpr int kMaxTickBytes = 30; // 三个变长整数最多各10字节
+constexpr qint64 kCsvChunkBytes = 8 << 20;
+constexpr double kPow10[kMaxDecimals + 1] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8};
+
+// 文件头固定64字节，之后是连续的块
+struct StoreHeader {
+  char magic[8];
+  quint32 version;
+  quint32 header_size;
+  qint64 source_size;  // 源CSV的大小，没有源文件时为0
+  qint64 source_mtime;
+  qint64 count;
+  qint64 first_timestamp;
+  qint64 last_timestamp;
+  qint64 reserved;
+};
+static_assert(sizeof(StoreHeader) == 64, "StoreHeader layout changed");
+
+// 每块的首笔时间和价格作为差值的起点，块之间互不依赖
+struct BlockHeader {
+  quint32 count;
+  quint32 payload_bytes;
+  qint64 first_timestamp;
+  qint64 first_price; // 按price_decimals换算后的整数
+  quint8 price_decimals;
+  quint8 amount_decimals;
+  quint8 reserved[6];
+};
+static_assert(sizeof(BlockHeader) == 32, "BlockHeader layout changed");
+
+inline quint64 zigzag(qint64 value) {
+  return (quint64(value) << 1) ^ quint64(value >> 63);
+}
+
+inline qint64 unzigzag(quint64 value) {
+  return qint64(value >> 1) ^ -qint64(value & 1);
+}
+
+inline void putVarint(char *&out, quint64 value) {
+  while (value >= 0x80) {
+    *out++ = char(value | 0x80);
+    value >>= 7;
+  }
+  *out++ = char(value);
+}
+
+inline bool getVarint(const char *&p, const char *end, quint64 &value) {
+  value = 0;
+  for (int shift = 0; shift < 64 && p < end; shift += 7) {
+    const quint8 byte = quint8(*p++);
+    value |= quint64(byte & 0x7f) << shift;
+    if (!(byte & 0x80))
+      return true;
+  }
+  return false;
+}
+
+// value乘以10^d后是整数（相对误差1e-12以内）所需的最少小数位，超过kMaxDecimals时取kMaxDecimals
+int decimalsOf(double value) {
+  for (int d = 0; d < kMaxDecimals; d++) {
+    const double scaled = value * kPow10[d];
+    if (std::abs(scaled - std::round(scaled)) <= 1e-12 * qMax(1.0, std::abs(scaled)))
+      return d;
+  }
+  return kMaxDecimals;
+}
+
+inline qint64 toUnits(double value, int decimals) {
+  return std::llround(value * kPow10[decimals]);
+}
+
+bool readStoreHeader(QFile &file, StoreHeader &header) {
+  return file.read(reinterpret_cast<char *>(&header), sizeof(header)) == qint64(sizeof(header))
+         && std::memcmp(header.magic, kMagic, sizeof(kMagic)) == 0 && header.version == kVersion
+         && header.header_size == sizeof(StoreHeader) && header.count >= 0;
+}
+
+inline const char *findLineEnd(const char *p, const char *end) {
+  const void *eol = std::memchr(p, '\n', end - p);
+  return eol ? static_cast<const char *>(eol) : end;
+}
+
+// 取出下一个逗号之前的字段并去掉首尾空白，p移到逗号之后
+std::string_view nextField(const char *&p, const char *end) {
+  const void *comma = std::memchr(p, ',', end - p);
+  const char *field_end = comma ? static_cast<const char *>(comma) : end;
+  const char *begin = p;
+  const char *last = field_end;
+  while (begin < last && (*begin == ' ' || *begin == '\t'))
+    ++begin;
+  while (last > begin && (last[-1] == ' ' || last[-1] == '\t' || last[-1] == '\r'))
+    --last;
+  p = field_end < end ? field_end + 1 : end;
+  return std::string_view(begin, last - begin);
+}
+
+template<typename T>
+inline bool parseNumber(std::string_view field, T &value) {
+  auto [ptr, ec] = std::from_chars(field.data(), field.data() + field.size(), value);
+  return ec == std::errc() && ptr == field.data() + field.size();
+}
+
+// timestamp,price,amount,side；side也接受1/0
+bool parseTickLine(const char *p, const char *end, TickData &tick) {
+  if (!parseNumber(nextField(p, end), tick.timestamp) || !parseNumber(nextField(p, end), tick.price)
+      || !parseNumber(nextField(p, end), tick.amount))
+    return false;
+  const std::string_view side = nextField(p, end);
+  if (side == "buy" || side == "1")
+    tick.taker_buy = true;
+  else if (side == "sell" || side == "0")
+    tick.taker_buy = false;
+  else
+    return false;
+  return tick.price > 0.0 && tick.amount >= 0.0;
+}
+
+} // namespace
+
+TickWriter::TickWriter()
+    : count_(0)
+    , first_timestamp_(0)
+    , last_timestamp_(0)
+    , source_size_(0)
+    , source_mtime_(0) {}
+
+TickWriter::~TickWriter() {
+  cancel();
+}
+
+QString TickWriter::storePath(const QString &csv_path) {
+  return csv_path + ".qtk";
+}
+
+bool TickWriter::open(const QString &store_path, const QString &source_path) {
+  cancel();
+  error_.clear();
+  count_ = 0;
+  source_size_ = 0;
+  source_mtime_ = 0;
+  block_.clear();
+  block_.reserve(kBlockTicks);
+  payload_.resize(qsizetype(kBlockTicks) * kMaxTickBytes);
+  file_.setFileName(store_path);
+  if (!file_.open(QIODevice::WriteOnly)) {
+    error_ = "无法写入文件: " + store_path;
+    return false;
+  }
+  StoreHeader header{};
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.header_size = sizeof(StoreHeader);
+  if (!source_path.isEmpty()) {
+    QFileInfo info(source_path);
+    source_size_ = info.size();
+    source_mtime_ = info.lastModified().toMSecsSinceEpoch();
+  }
+  header.source_size = source_size_;
+  header.source_mtime = source_mtime_;
+  // 先写占位的文件头，commit时回写总笔数和时间范围
+  if (file_.write(reinterpret_cast<const char *>(&header), sizeof(header)) != qint64(sizeof(header))) {
+    error_ = "无法写入文件: " + store_path;
+    file_.cancelWriting();
+    return false;
+  }
+  return true;
+}
+
+void TickWriter::append(const TickData &tick) {
+  if (count_ == 0 && block_.isEmpty())
+    first_timestamp_ = tick.timestamp;
+  last_timestamp_ = tick.timestamp;
+  block_.append(tick);
+  if (block_.size() == kBlockTicks)
+    flushBlock();
+}
+
+bool TickWriter::flushBlock() {
+  if (block_.isEmpty() || !error_.isEmpty())
+    return error_.isEmpty();
+  int price_decimals = 0;
+  int amount_decimals = 0;
+  double max_price = 0.0;
+  double max_amount = 0.0;
+  for (const TickData &tick : std::as_const(block_)) {
+    price_decimals = qMax(price_decimals, decimalsOf(tick.price));
+    amount_decimals = qMax(amount_decimals, decimalsOf(tick.amount));
+    max_price = qMax(max_price, std::abs(tick.price));
+    max_amount = qMax(max_amount, std::abs(tick.amount));
+  }
+  // 换算后的整数须留在qint64范围内（数量还要左移一位放买卖方向）
+  while (price_decimals > 0 && max_price * kPow10[price_decimals] > 1e18)
+    price_decimals--;
+  while (amount_decimals > 0 && max_amount * kPow10[amount_decimals] > 1e18)
+    amount_decimals--;
+
+  BlockHeader header{};
+  header.count = quint32(block_.size());
+  header.first_timestamp = block_.first().timestamp;
+  header.first_price = toUnits(block_.first().price, price_decimals);
+  header.price_decimals = quint8(price_decimals);
+  header.amount_decimals = quint8(amount_decimals);
+  char *out = payload_.data();
+  qint64 prev_timestamp = header.first_timestamp;
+  qint64 prev_price = header.first_price;
+  for (const TickData &tick : std::as_const(block_)) {
+    const qint64 price = toUnits(tick.price, price_decimals);
+    const quint64 amount = quint64(toUnits(tick.amount, amount_decimals));
+    putVarint(out, zigzag(tick.timestamp - prev_timestamp));
+    putVarint(out, zigzag(price - prev_price));
+    putVarint(out, (amount << 1) | (tick.taker_buy ? 1 : 0));
+    prev_timestamp = tick.timestamp;
+    prev_price = price;
+  }
+  header.payload_bytes = quint32(out - payload_.constData());
+  if (file_.write(reinterpret_cast<const char *>(&header), sizeof(header)) != qint64(sizeof(header))
+      || file_.write(payload_.constData(), header.payload_bytes) != qint64(header.payload_bytes)) {
+    error_ = "写入失败: " + file_.fileName();
+    return false;
+  }
+  count_ += block_.size();
+  block_.clear();
+  return true;
+}
+
+bool TickWriter::commit() {
+  if (!flushBlock()) {
+    cancel();
+    return false;
+  }
+  StoreHeader header{};
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.header_size = sizeof(StoreHeader);
+  header.source_size = source_size_;
+  header.source_mtime = source_mtime_;
+  header.count = count_;
+  header.first_timestamp = count_ > 0 ? first_timestamp_ : 0;
+  header.last_timestamp = count_ > 0 ? last_timestamp_ : 0;
+  if (!file_.seek(0)
+      || file_.write(reinterpret_cast<const char *>(&header), sizeof(header)) != qint64(sizeof(header))
+      || !file_.commit()) {
+    error_ = "写入失败: " + file_.fileName();
+    cancel();
+    return false;
+  }
+  return true;
+}
+
+void TickWriter::cancel() {
+  if (file_.isOpen()) {
+    file_.cancelWriting();
+    file_.commit(); // 已取消时commit只关闭文件，不会替换目标
+  }
+  block_.clear();
+}
+
+bool TickWriter::convertCsv(const QString &csv_path, const QString &store_path, QString &error) {
+  QFile csv(csv_path);
+  if (!csv.open(QIODevice::ReadOnly)) {
+    error = "无法打开文件: " + csv_path;
+    return false;
+  }
+  TickWriter writer;
+  if (!writer.open(store_path, csv_path)) {
+    error = writer.errorString();
+    return false;
+  }
+  // 按段读入，段末不完整的一行留到下一段开头
+  QByteArray buffer;
+  qsizetype carry = 0;
+  bool header_checked = false;
+  bool at_end = false;
+  TickData tick;
+  while (!at_end) {
+    buffer.resize(carry + kCsvChunkBytes);
+    const qint64 read = csv.read(buffer.data() + carry, kCsvChunkBytes);
+    if (read < 0) {
+      error = "读取失败: " + csv_path;
+      return false;
+    }
+    at_end = read == 0;
+    const char *p = buffer.constData();
+    const char *end = p + carry + read;
+    const char *stop = end;
+    if (!at_end) {
+      // 只处理到最后一个换行
+      while (stop > p && stop[-1] != '\n')
+        --stop;
+    }
+    while (p < stop) {
+      const char *eol = findLineEnd(p, stop);
+      if (!header_checked) {
+        if (std::string_view(p, eol - p).find("timestamp") == std::string_view::npos) {
+          error = "CSV文件缺少表头: " + csv_path;
+          return false;
+        }
+        header_checked = true;
+      } else if (parseTickLine(p, eol, tick)) {
+        writer.append(tick);
+      }
+      p = eol + 1;
+    }
+    carry = end - stop;
+    std::memmove(buffer.data(), stop, carry);
+  }
+  if (writer.count() == 0) {
+    error = "CSV中没有有效的成交记录: " + csv_path;
+    return false;
+  }
+  if (!writer.commit()) {
+    error = writer.errorString();
+    return false;
+  }
+  return true;
+}
+
+TickReader::TickReader()
+    : count_(0)
+    , remaining_(0)
+    , first_timestamp_(0)
+    , last_timestamp_(0) {}
+
+bool TickReader::open(const QString &store_path) {
+  close();
+  error_.clear();
+  file_.setFileName(store_path);
+  StoreHeader header;
+  if (!file_.open(QIODevice::ReadOnly)) {
+    error_ = "无法打开文件: " + store_path;
+    return false;
+  }
+  if (!readStoreHeader(file_, header)) {
+    error_ = "不是有效的逐笔数据文件: " + store_path;
+    file_.close();
+    return false;
+  }
+  count_ = remaining_ = header.count;
+  first_timestamp_ = header.first_timestamp;
+  last_timestamp_ = header.last_timestamp;
+  ticks_.reserve(TickWriter::kBlockTicks);
+  return true;
+}
+
+void TickReader::close() {
+  file_.close();
+  count_ = remaining_ = 0;
+}
+
+const QVector<TickData> *TickReader::next() {
+  if (remaining_ <= 0 || !file_.isOpen() || hasError())
+    return nullptr;
+  BlockHeader header;
+  if (file_.read(reinterpret_cast<char *>(&header), sizeof(header)) != qint64(sizeof(header))
+      || header.count == 0 || header.count > quint32(TickWriter::kBlockTicks)
+      || header.count > remaining_ || header.payload_bytes > header.count * quint32(kMaxTickBytes)
+      || header.price_decimals > kMaxDecimals || header.amount_decimals > kMaxDecimals) {
+    error_ = "逐笔数据文件已损坏: " + file_.fileName();
+    return nullptr;
+  }
+  payload_.resize(header.payload_bytes);
+  if (file_.read(payload_.data(), header.payload_bytes) != qint64(header.payload_bytes)
+      || !decodeBlock(payload_.constData(),
+                      payload_.constData() + payload_.size(),
+                      header.count,
+                      header.first_timestamp,
+                      header.first_price,
+                      header.price_decimals,
+                      header.amount_decimals)) {
+    error_ = "逐笔数据文件已损坏: " + file_.fileName();
+    return nullptr;
+  }
+  remaining_ -= header.count;
+  return &ticks_;
+}
+
+bool TickReader::decodeBlock(const char *p,
+                             const char *end,
+                             quint32 count,
+                             qint64 timestamp,
+                             qint64 price,
+                             int price_decimals,
+                             int amount_decimals) {
+  ticks_.resize(count);
+  TickData *out = ticks_.data();
+  const double price_scale = kPow10[price_decimals];
+  const double amount_scale = kPow10[amount_decimals];
+  for (quint32 i = 0; i < count; i++) {
+    quint64 dt;
+    quint64 dp;
+    quint64 amount;
+    if (!getVarint(p, end, dt) || !getVarint(p, end, dp) || !getVarint(p, end, amount))
+      return false;
+    timestamp += unzigzag(dt);
+    price += unzigzag(dp);
+    out[i].timestamp = timestamp;
+    out[i].price = price / price_scale;
+    out[i].amount = qint64(amount >> 1) / amount_scale;
+    out[i].taker_buy = amount & 1;
+  }
+  return p == end;
+}
+
+bool TickReader::isUpToDate(const QString &store_path, const QString &csv_path) {
+  QFileInfo info(csv_path);
+  QFile file(store_path);
+  StoreHeader header;
+  return info.exists() && file.open(QIODevice::ReadOnly) && readStoreHeader(file, header)
+         && header.source_size == info.size()
+         && header.source_mtime == info.lastModified().toMSecsSinceEpoch();
+}
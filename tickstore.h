@@ -0,0 +1,82 @@
+#ifndef TICKSTORE_H
+#define TICKSTORE_H
+
+#include "tickdata.h"
+
+#include <QByteArray>
+#include <QFile>
+#include <QSaveFile>
+#include <QString>
+#include <QVector>
+
+// 逐笔成交的紧凑存储(.qtk)：按块保存，每块最多kBlockTicks笔。价格和数量按块内所需的最少小数位
+// 换成整数，时间戳和价格存与上一笔的差值，数量与买卖方向合成一个整数，都写成变长整数。
+// 常见的逐笔数据每笔约5~7字节（原始结构体24字节）。读写都只保留一块，内存与文件大小无关
+class TickWriter {
+public:
+  static constexpr int kBlockTicks = 65536;
+
+  TickWriter();
+  ~TickWriter();
+
+  // source_path非空时记录源CSV的大小和修改时间，供TickReader::isUpToDate判断是否需要重新转换
+  bool open(const QString& store_path, const QString& source_path = QString());
+  void append(const TickData& tick);
+  bool commit(); // 写出最后一块并更新文件头，失败时不留下文件
+  void cancel();
+
+  qint64 count() const { return count_ + block_.size(); }
+  const QString& errorString() const { return error_; }
+
+  // CSV（timestamp,price,amount,side，side为buy/sell）流式转换，每次只读入一段
+  static bool convertCsv(const QString& csv_path, const QString& store_path, QString& error);
+  // 与CSV配套的存储文件路径
+  static QString storePath(const QString& csv_path);
+
+private:
+  bool flushBlock();
+
+  QSaveFile file_;
+  QVector<TickData> block_;
+  QByteArray payload_;
+  qint64 count_;
+  qint64 first_timestamp_;
+  qint64 last_timestamp_;
+  qint64 source_size_;  // open时记下的源CSV信息，commit回写文件头时保留
+  qint64 source_mtime_;
+  QString error_;
+};
+
+class TickReader {
+public:
+  TickReader();
+
+  bool open(const QString& store_path);
+  void close();
+  // 返回下一块逐笔成交，nullptr表示结束或出错；返回的块在下一次调用前有效
+  const QVector<TickData>* next();
+
+  bool hasError() const { return !error_.isEmpty(); }
+  const QString& errorString() const { return error_; }
+  qint64 count() const { return count_; } // 文件中的总笔数
+  qint64 firstTimestamp() const { return first_timestamp_; }
+  qint64 lastTimestamp() const { return last_timestamp_; }
+
+  // 存储文件存在、格式正确，且记录的源CSV大小和修改时间与当前一致
+  static bool isUpToDate(const QString& store_path, const QString& csv_path);
+
+private:
+  bool decodeBlock(const char* p, const char* end, quint32 count, qint64 timestamp, qint64 price,
+                   int price_decimals, int amount_decimals);
+
+  QFile file_;
+  QByteArray payload_;
+  QVector<TickData> ticks_;
+  qint64 count_;
+  qint64 remaining_; // 尚未读出的笔数
+  qint64 first_timestamp_;
+  qint64 last_timestamp_;
+  QString error_;
+};
+
+#endif // TICKSTORE_H
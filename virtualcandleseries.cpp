@@ -0,0 +1,82 @@
+#include "virtualcandleseries.h"
+
+#include <QCandlestickSeries>
+#include <QCandlestickSet>
+
+VirtualCandleSeries::VirtualCandleSeries(int margin)
+    : series_(nullptr)
+    , data_(nullptr)
+    , begin_(0)
+    , end_(0)
+    , margin_(margin) {}
+
+void VirtualCandleSeries::setSeries(QCandlestickSeries *series) {
+  clear();
+  series_ = series;
+}
+
+void VirtualCandleSeries::setData(const QVector<KLineData> *data) {
+  data_ = data;
+  begin_ = end_ = 0;
+}
+
+void VirtualCandleSeries::clear() {
+  if (series_)
+    series_->clear(); // 由序列负责释放K线对象
+  pool_.clear();
+  begin_ = end_ = 0;
+}
+
+void VirtualCandleSeries::showRange(qsizetype start, qsizetype count) {
+  if (!series_ || !data_ || data_->isEmpty()) {
+    clear();
+    return;
+  }
+  const qsizetype size = data_->size();
+  start = qBound<qsizetype>(0, start, size - 1);
+  const qsizetype stop = qMin(size, start + count);
+  if (start >= begin_ && stop <= end_)
+    return; // 可见部分都已载入，滚动只改坐标轴
+
+  // 区间长度固定，靠近数据两端时整体平移而不是截短，避免反复调整对象池
+  const qsizetype length = qMin(size, (stop - start) + 2 * qsizetype(margin_));
+  const qsizetype begin = qBound<qsizetype>(0, start - margin_, size - length);
+  const qsizetype end = begin + length;
+  if (length != pool_.size()) {
+    // 可见数量变化时调整对象池，之后全部重新填值
+    resizePool(end - begin);
+    begin_ = end_ = 0;
+  }
+  // 槽位按下标取模，新旧区间重叠的K线原地不动，只改写移入的部分
+  for (qsizetype i = begin; i < end; i++) {
+    if (i < begin_ || i >= end_)
+      assign(i);
+  }
+  begin_ = begin;
+  end_ = end;
+}
+
+void VirtualCandleSeries::resizePool(qsizetype size) {
+  if (size > pool_.size()) {
+    QList<QCandlestickSet *> sets;
+    sets.reserve(size - pool_.size());
+    for (qsizetype i = pool_.size(); i < size; i++)
+      sets.append(new QCandlestickSet());
+    series_->append(sets);
+    pool_.append(sets);
+  } else if (size < pool_.size()) {
+    QList<QCandlestickSet *> extra = pool_.mid(size);
+    pool_.resize(size);
+    series_->remove(extra); // remove会删除对象
+  }
+}
+
+void VirtualCandleSeries::assign(qsizetype index) {
+  const KLineData &d = (*data_)[index];
+  QCandlestickSet *set = pool_[index % pool_.size()];
+  set->setTimestamp(d.timestamp);
+  set->setOpen(d.open);
+  set->setHigh(d.high);
+  set->setLow(d.low);
+  set->setClose(d.close);
+}
@@ -0,0 +1,39 @@
+#ifndef VIRTUALCANDLESERIES_H
+#define VIRTUALCANDLESERIES_H
+
+#include "klinedata.h"
+
+#include <QList>
+#include <QVector>
+
+class QCandlestickSeries;
+class QCandlestickSet;
+
+// 虚拟化K线序列：图表里只保留可见区间及前后预取范围内的K线对象，
+// 滚动时回收移出范围的QCandlestickSet重新填值，图表内存与数据量无关
+class VirtualCandleSeries {
+public:
+  explicit VirtualCandleSeries(int margin = 60);
+
+  void setSeries(QCandlestickSeries* series);
+  // 数据重新加载或追加后调用，已加载的区间作废，下次showRange时重新填充
+  void setData(const QVector<KLineData>* data);
+  // 确保[start, start + count)在图表中，必要时回收对象并预取前后margin根
+  void showRange(qsizetype start, qsizetype count);
+  void clear();
+
+  qsizetype loadedCount() const { return end_ - begin_; }
+
+private:
+  void resizePool(qsizetype size);
+  void assign(qsizetype index); // 把第index根K线写入它所在的槽位
+
+  QCandlestickSeries* series_;
+  const QVector<KLineData>* data_;
+  QList<QCandlestickSet*> pool_; // 环形槽位：第i根K线固定放在 pool_[i % pool_.size()]
+  qsizetype begin_;              // 当前已载入的K线区间 [begin_, end_)
+  qsizetype end_;
+  int margin_;
+};
+
+#endif // VIRTUALCANDLESERIES_H
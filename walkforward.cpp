@@ -0,0 +1,218 @@
+#include "walkforward.h"
+
+#include "builtinstrategies.h"
+#include "profiler.h"
+
+#include <QMutexLocker>
+#include <QTimer>
+
+namespace {
+
+constexpr int kProgressIntervalMs = 100;
+
+} // namespace
+
+WalkForward::WalkForward(QObject *parent)
+    : QObject(parent)
+    , progress_timer_(new QTimer(this))
+    , total_runs_(0)
+    , finished_runs_(0)
+    , remaining_folds_(0)
+    , cancelled_(false)
+    , running_(false) {
+  progress_timer_->setInterval(kProgressIntervalMs);
+  connect(progress_timer_, &QTimer::timeout, this, &WalkForward::reportProgress);
+}
+
+WalkForward::~WalkForward() {
+  cancel();
+  // 先等线程池里的任务结束，它们还在访问本对象的成员
+  pool_.reset();
+}
+
+QVector<WalkForwardFold> WalkForward::makeFolds(qsizetype bar_count, const WalkForwardSpec &spec) {
+  QVector<WalkForwardFold> folds;
+  if (spec.in_sample_bars <= 0 || spec.out_of_sample_bars <= 0)
+    return folds;
+  // 每折样本外紧接上一折的样本外，最后一折不足一个窗口时按剩余长度计
+  for (qsizetype begin = spec.in_sample_bars; begin < bar_count; begin += spec.out_of_sample_bars) {
+    WalkForwardFold fold;
+    fold.in_sample_begin = spec.anchored ? 0 : begin - spec.in_sample_bars;
+    fold.out_of_sample_begin = begin;
+    fold.out_of_sample_end = qMin(begin + spec.out_of_sample_bars, bar_count);
+    folds.append(fold);
+  }
+  return folds;
+}
+
+qsizetype WalkForward::runCount(qsizetype bar_count, const WalkForwardSpec &spec) {
+  SweepSpec sweep;
+  sweep.fast_period = spec.fast_period;
+  sweep.slow_period = spec.slow_period;
+  const qsizetype pairs = ParameterSweep::combinationCount(sweep);
+  return pairs == 0 ? 0 : makeFolds(bar_count, spec).size() * (pairs + 1);
+}
+
+int WalkForward::threadCount() const {
+  return pool_ ? pool_->threadCount() : int(std::thread::hardware_concurrency());
+}
+
+bool WalkForward::start(const QVector<KLineData> &bars,
+                        const WalkForwardSpec &spec,
+                        std::shared_ptr<IndicatorCache> indicators) {
+  if (running_ || bars.isEmpty())
+    return false;
+  folds_ = makeFolds(bars.size(), spec);
+  pairs_.clear();
+  const QVector<int> fast_values = spec.fast_period.periods();
+  const QVector<int> slow_values = spec.slow_period.periods();
+  for (int fast : fast_values) {
+    for (int slow : slow_values) {
+      if (fast >= 1 && fast < slow)
+        pairs_.append({fast, slow});
+    }
+  }
+  if (folds_.isEmpty() || pairs_.isEmpty())
+    return false;
+  if (!pool_)
+    pool_ = std::make_unique<TaskPool>();
+
+  bars_ = bars;
+  if (!indicators || indicators->size() != bars.size())
+    indicators = std::make_shared<IndicatorCache>(bars);
+  indicators_ = std::move(indicators);
+  spec_ = spec;
+  spec_.config.record_equity_curve = false;
+  spec_.config.record_trades = false; // 拼接只用权益曲线和交易次数
+  states_.clear();
+  for (qsizetype i = 0; i < folds_.size(); i++) {
+    states_.push_back(std::make_unique<FoldState>());
+    states_.back()->remaining = pairs_.size();
+  }
+  total_runs_ = folds_.size() * (pairs_.size() + 1);
+  finished_runs_ = 0;
+  remaining_folds_ = int(folds_.size());
+  cancelled_ = false;
+  running_ = true;
+  elapsed_.start();
+  progress_timer_->start();
+
+  // 按折的先后提交，前面的折先完成样本内，样本外任务可以尽早开始
+  for (int fold = 0; fold < int(folds_.size()); fold++) {
+    for (int pair = 0; pair < int(pairs_.size()); pair++) {
+      pool_->submit([this, fold, pair] { runInSample(fold, pair); });
+    }
+  }
+  return true;
+}
+
+void WalkForward::cancel() {
+  cancelled_ = true;
+}
+
+void WalkForward::runInSample(int fold, int pair) {
+  FoldState &state = *states_[fold];
+  if (!cancelled_) {
+    const WalkForwardFold &range = folds_[fold];
+    const BacktestResult backtest = runMaCross(spec_.config,
+                                               bars_,
+                                               *indicators_,
+                                               pairs_[pair].first,
+                                               pairs_[pair].second,
+                                               range.in_sample_begin,
+                                               range.out_of_sample_begin - range.in_sample_begin);
+    const double total_return = backtest.final_capital / spec_.config.initial_capital - 1.0;
+    QMutexLocker locker(&state.mutex);
+    if (state.best_pair < 0 || total_return > state.best_return
+        || (total_return == state.best_return && pair < state.best_pair)) {
+      state.best_pair = pair;
+      state.best_return = total_return;
+    }
+  }
+  finished_runs_++;
+  if (--state.remaining != 0)
+    return;
+  // 本折最后一个样本内任务，在当前工作线程的本地队列提交样本外任务
+  pool_->submit([this, fold] { runOutOfSample(fold); });
+}
+
+void WalkForward::runOutOfSample(int fold) {
+  FoldState &state = *states_[fold];
+  if (!cancelled_) {
+    WalkForwardFold &range = folds_[fold];
+    BacktestConfig config = spec_.config;
+    config.record_equity_curve = true;
+    range.fast_period = pairs_[state.best_pair].first;
+    range.slow_period = pairs_[state.best_pair].second;
+    range.in_sample_return = state.best_return;
+    state.out_of_sample = runMaCross(config,
+                                     bars_,
+                                     *indicators_,
+                                     range.fast_period,
+                                     range.slow_period,
+                                     range.out_of_sample_begin,
+                                     range.out_of_sample_end - range.out_of_sample_begin);
+    range.out_of_sample_return = state.out_of_sample.final_capital / config.initial_capital - 1.0;
+    range.out_of_sample_trades = state.out_of_sample.total_trades;
+    range.out_of_sample_drawdown = state.out_of_sample.max_drawdown;
+  }
+  finished_runs_++;
+  onFoldDone();
+}
+
+void WalkForward::onFoldDone() {
+  if (--remaining_folds_ != 0)
+    return;
+  // 最后一折在工作线程中完成，拼接后把结果投递回界面线程
+  WalkForwardResult result = stitch();
+  QMetaObject::invokeMethod(
+      this,
+      [this, result] {
+        progress_timer_->stop();
+        reportProgress();
+        running_ = false;
+        states_.clear();
+        const qint64 end_ns = Profiler::now();
+        Profiler::record("walkForward", end_ns - elapsed_.nsecsElapsed(), end_ns);
+        emit finished(result, elapsed_.elapsed());
+      },
+      Qt::QueuedConnection);
+}
+
+WalkForwardResult WalkForward::stitch() const {
+  WalkForwardResult result;
+  result.initial_capital = spec_.config.initial_capital;
+  result.final_capital = spec_.config.initial_capital;
+  result.runs = finished_runs_;
+  result.cancelled = cancelled_;
+  if (result.cancelled)
+    return result;
+  result.folds = folds_;
+  const qsizetype total = folds_.last().out_of_sample_end - folds_.first().out_of_sample_begin;
+  result.timestamps.reserve(total);
+  result.equity.reserve(total);
+  // 全仓进出的收益与本金成正比，把每折的权益按前一折的期末资金等比缩放即可首尾相接
+  double peak = result.initial_capital;
+  for (qsizetype i = 0; i < folds_.size(); i++) {
+    const WalkForwardFold &fold = folds_[i];
+    const BacktestResult &backtest = states_[i]->out_of_sample;
+    const double scale = result.final_capital / spec_.config.initial_capital;
+    for (qsizetype bar = 0; bar < backtest.equity_curve.size(); bar++) {
+      const double equity = backtest.equity_curve[bar] * scale;
+      result.timestamps.append(bars_[fold.out_of_sample_begin + bar].timestamp);
+      result.equity.append(equity);
+      if (equity > peak)
+        peak = equity;
+      else if (peak > 0.0)
+        result.max_drawdown = qMax(result.max_drawdown, (peak - equity) / peak);
+    }
+    result.final_capital = backtest.final_capital * scale;
+    result.total_trades += backtest.total_trades;
+  }
+  return result;
+}
+
+void WalkForward::reportProgress() {
+  if (running_)
+    emit progress(finished_runs_, total_runs_);
+}
@@ -0,0 +1,117 @@
+#ifndef WALKFORWARD_H
+#define WALKFORWARD_H
+
+#include "backtestengine.h"
+#include "indicatorcache.h"
+#include "klinedata.h"
+#include "parametersweep.h"
+#include "taskpool.h"
+
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QObject>
+#include <QPair>
+#include <QVector>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+class QTimer;
+
+struct WalkForwardSpec {
+  SweepRange fast_period;
+  SweepRange slow_period;
+  BacktestConfig config; // 资金与成本，不参与优化
+  qsizetype in_sample_bars = 0;
+  qsizetype out_of_sample_bars = 0;
+  bool anchored = false; // 为true时样本内始终从第一根K线开始（扩展窗口），否则为固定长度的滚动窗口
+};
+
+// 一折：在[in_sample_begin, out_of_sample_begin)上选出收益最高的参数，再在紧随其后的样本外区间上检验
+struct WalkForwardFold {
+  qsizetype in_sample_begin = 0;
+  qsizetype out_of_sample_begin = 0;
+  qsizetype out_of_sample_end = 0;
+  int fast_period = 0;
+  int slow_period = 0;
+  double in_sample_return = 0.0; // 0~1
+  double out_of_sample_return = 0.0;
+  int out_of_sample_trades = 0;
+  double out_of_sample_drawdown = 0.0;
+};
+
+struct WalkForwardResult {
+  QVector<WalkForwardFold> folds;
+  // 各折样本外权益首尾相接：后一折以前一折的期末资金起步，与K线一一对应
+  QVector<qint64> timestamps;
+  QVector<double> equity;
+  double initial_capital = 0.0;
+  double final_capital = 0.0;
+  double max_drawdown = 0.0; // 拼接后整条曲线的最大回撤
+  int total_trades = 0;
+  qsizetype runs = 0; // 实际完成的回测次数
+  bool cancelled = false;
+};
+
+// 滚动优化（walk-forward）：把K线切成相邻的样本内/样本外窗口，每折在样本内做均线交叉的网格搜索，
+// 用最优参数回测样本外区间，最后把各折样本外的权益拼成一条曲线。
+// 所有折的所有参数组合同时投入工作窃取线程池，某折的样本内任务全部完成后立即提交它的样本外任务；
+// 均线按整份数据计算一次，重叠的各折共用同一份指标缓存，分段回测只是从列的中间开始读
+class WalkForward : public QObject {
+  Q_OBJECT
+
+public:
+  explicit WalkForward(QObject* parent = nullptr);
+  ~WalkForward();
+
+  static QVector<WalkForwardFold> makeFolds(qsizetype bar_count, const WalkForwardSpec& spec);
+  // 总回测次数：每折的参数组合数加一次样本外回测
+  static qsizetype runCount(qsizetype bar_count, const WalkForwardSpec& spec);
+
+  bool isRunning() const { return running_; }
+  int threadCount() const;
+  // indicators为空或与数据不符时新建一份只供本次使用的缓存
+  bool start(const QVector<KLineData>& bars,
+             const WalkForwardSpec& spec,
+             std::shared_ptr<IndicatorCache> indicators = nullptr);
+  void cancel();
+
+signals:
+  void progress(qsizetype finished_runs, qsizetype total_runs);
+  void finished(const WalkForwardResult& result, qint64 elapsed_ms);
+
+private slots:
+  void reportProgress();
+
+private:
+  struct FoldState {
+    QMutex mutex;
+    int best_pair = -1; // 收益相同时取下标小的组合，结果与任务完成顺序无关
+    double best_return = 0.0;
+    std::atomic<qsizetype> remaining{0}; // 尚未完成的样本内任务数
+    BacktestResult out_of_sample;
+  };
+
+  void runInSample(int fold, int pair);
+  void runOutOfSample(int fold);
+  void onFoldDone();
+  WalkForwardResult stitch() const;
+
+  QVector<KLineData> bars_; // 隐式共享的只读数据，各任务不复制
+  std::shared_ptr<IndicatorCache> indicators_;
+  WalkForwardSpec spec_;
+  QVector<WalkForwardFold> folds_;
+  QVector<QPair<int, int>> pairs_; // 有效的（快线, 慢线）组合
+  std::vector<std::unique_ptr<FoldState>> states_;
+  std::unique_ptr<TaskPool> pool_;
+  QTimer* progress_timer_;
+  QElapsedTimer elapsed_;
+  qsizetype total_runs_;
+  std::atomic<qsizetype> finished_runs_;
+  std::atomic<int> remaining_folds_;
+  std::atomic<bool> cancelled_;
+  bool running_;
+};
+
+#endif // WALKFORWARD_H
@@ -0,0 +1,268 @@
+#include "walkforwarddialog.h"
+#include "ui_walkforwarddialog.h"
+
+#include <QChart>
+#include <QChartView>
+#include <QDateTime>
+#include <QDateTimeAxis>
+#include <QHeaderView>
+#include <QLineSeries>
+#include <QMessageBox>
+#include <QTableWidgetItem>
+#include <QValueAxis>
+
+#include <limits>
+
+namespace {
+
+constexpr qsizetype kMaxRuns = 10000000;
+constexpr qsizetype kMaxChartPoints = 4000; // 曲线按等间隔抽样，点数过多时图表绘制很慢
+
+enum Column {
+  InSampleColumn,
+  OutOfSampleColumn,
+  FastColumn,
+  SlowColumn,
+  InSampleReturnColumn,
+  OutOfSampleReturnColumn,
+  TradesColumn,
+  DrawdownColumn,
+  ColumnCount
+};
+
+QTableWidgetItem *numberItem(double value) {
+  auto *item = new QTableWidgetItem;
+  item->setData(Qt::DisplayRole, value);
+  return item;
+}
+
+QTableWidgetItem *textItem(const QString &text) {
+  return new QTableWidgetItem(text);
+}
+
+double percent(double ratio) {
+  return qRound64(ratio * 10000.0) / 100.0;
+}
+
+QString dateText(qint64 timestamp) {
+  return QDateTime::fromMSecsSinceEpoch(timestamp).toString("yyyy-MM-dd HH:mm");
+}
+
+} // namespace
+
+WalkForwardDialog::WalkForwardDialog(const QVector<KLineData> &bars,
+                                     std::shared_ptr<IndicatorCache> indicators,
+                                     const BacktestConfig &defaults,
+                                     QWidget *parent)
+    : QDialog(parent)
+    , ui(new Ui::WalkForwardDialog)
+    , walk_forward_(new WalkForward(this))
+    , bars_(bars)
+    , indicators_(std::move(indicators))
+    , config_(defaults)
+    , equity_chart_(nullptr)
+    , equity_series_(nullptr)
+    , axis_x_(nullptr)
+    , axis_y_(nullptr) {
+  ui->setupUi(this);
+  initializeApplication();
+}
+
+WalkForwardDialog::~WalkForwardDialog() {
+  delete ui;
+}
+
+void WalkForwardDialog::initializeApplication() {
+  for (QSpinBox *box : {ui->fastFromSpinBox, ui->fastToSpinBox, ui->slowFromSpinBox, ui->slowToSpinBox}) {
+    box->setRange(1, 1000);
+  }
+  ui->fastStepSpinBox->setRange(0, 1000);
+  ui->slowStepSpinBox->setRange(0, 1000);
+  ui->fastFromSpinBox->setValue(5);
+  ui->fastToSpinBox->setValue(20);
+  ui->fastStepSpinBox->setValue(5);
+  ui->slowFromSpinBox->setValue(20);
+  ui->slowToSpinBox->setValue(60);
+  ui->slowStepSpinBox->setValue(10);
+  // 默认切成约10折，样本内是样本外的4倍
+  const int bar_count = int(qMin<qsizetype>(bars_.size(), std::numeric_limits<int>::max()));
+  ui->inSampleSpinBox->setRange(1, qMax(1, bar_count));
+  ui->outOfSampleSpinBox->setRange(1, qMax(1, bar_count));
+  ui->outOfSampleSpinBox->setValue(qMax(1, bar_count / 14));
+  ui->inSampleSpinBox->setValue(qMax(1, bar_count / 14 * 4));
+
+  ui->foldsTable->setColumnCount(ColumnCount);
+  ui->foldsTable->setHorizontalHeaderLabels({"样本内",
+                                             "样本外",
+                                             "快线",
+                                             "慢线",
+                                             "样本内收益(%)",
+                                             "样本外收益(%)",
+                                             "交易次数",
+                                             "最大回撤(%)"});
+  ui->foldsTable->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
+  ui->foldsTable->verticalHeader()->setVisible(false);
+  initializeChart();
+
+  const QList<QSpinBox *> spin_boxes = findChildren<QSpinBox *>();
+  for (QSpinBox *box : spin_boxes) {
+    connect(box, &QSpinBox::valueChanged, this, &WalkForwardDialog::onRangeChanged);
+  }
+  connect(ui->anchoredCheckBox, &QCheckBox::toggled, this, &WalkForwardDialog::onRangeChanged);
+  connect(ui->startButton, &QPushButton::clicked, this, &WalkForwardDialog::onStartClicked);
+  connect(ui->cancelButton, &QPushButton::clicked, this, &WalkForwardDialog::onCancelClicked);
+  connect(walk_forward_, &WalkForward::progress, this, &WalkForwardDialog::onProgress);
+  connect(walk_forward_, &WalkForward::finished, this, &WalkForwardDialog::onFinished);
+  onRangeChanged();
+}
+
+void WalkForwardDialog::initializeChart() {
+  equity_chart_ = new QChart();
+  equity_chart_->setTitle("样本外权益（各折拼接）");
+  equity_chart_->legend()->setVisible(false);
+
+  equity_series_ = new QLineSeries();
+  equity_chart_->addSeries(equity_series_);
+
+  axis_x_ = new QDateTimeAxis();
+  axis_y_ = new QValueAxis();
+  axis_x_->setFormat("yyyy-MM-dd");
+  axis_y_->setTitleText("权益");
+  equity_chart_->addAxis(axis_x_, Qt::AlignBottom);
+  equity_chart_->addAxis(axis_y_, Qt::AlignLeft);
+  equity_series_->attachAxis(axis_x_);
+  equity_series_->attachAxis(axis_y_);
+
+  auto *chart_view = new QChartView(equity_chart_);
+  chart_view->setRenderHints(QPainter::Antialiasing);
+  ui->equityChartLayout->addWidget(chart_view);
+}
+
+WalkForwardSpec WalkForwardDialog::readSpec() const {
+  WalkForwardSpec spec;
+  spec.fast_period = {double(ui->fastFromSpinBox->value()),
+                      double(ui->fastToSpinBox->value()),
+                      double(ui->fastStepSpinBox->value())};
+  spec.slow_period = {double(ui->slowFromSpinBox->value()),
+                      double(ui->slowToSpinBox->value()),
+                      double(ui->slowStepSpinBox->value())};
+  spec.config = config_;
+  spec.in_sample_bars = ui->inSampleSpinBox->value();
+  spec.out_of_sample_bars = ui->outOfSampleSpinBox->value();
+  spec.anchored = ui->anchoredCheckBox->isChecked();
+  return spec;
+}
+
+void WalkForwardDialog::onRangeChanged() {
+  const WalkForwardSpec spec = readSpec();
+  ui->combinationLabel->setText(QString("折数: %1，回测次数: %2，线程数: %3，K线: %4条")
+                                    .arg(WalkForward::makeFolds(bars_.size(), spec).size())
+                                    .arg(WalkForward::runCount(bars_.size(), spec))
+                                    .arg(walk_forward_->threadCount())
+                                    .arg(bars_.size()));
+}
+
+void WalkForwardDialog::onStartClicked() {
+  const WalkForwardSpec spec = readSpec();
+  const qsizetype runs = WalkForward::runCount(bars_.size(), spec);
+  if (runs == 0) {
+    QMessageBox::warning(this,
+                         "滚动优化",
+                         "没有可用的折或参数组合（样本内需短于数据长度，快线周期需小于慢线周期）");
+    return;
+  }
+  if (runs > kMaxRuns) {
+    QMessageBox::warning(this, "滚动优化", QString("回测次数超过上限 %1").arg(kMaxRuns));
+    return;
+  }
+  ui->foldsTable->setRowCount(0);
+  equity_series_->clear();
+  ui->progressBar->setRange(0, int(runs));
+  ui->progressBar->setValue(0);
+  if (!walk_forward_->start(bars_, spec, indicators_))
+    return;
+  ui->startButton->setEnabled(false);
+  ui->cancelButton->setEnabled(true);
+  ui->rangeGroupBox->setEnabled(false);
+}
+
+void WalkForwardDialog::onCancelClicked() {
+  walk_forward_->cancel();
+  ui->cancelButton->setEnabled(false);
+}
+
+void WalkForwardDialog::onProgress(qsizetype finished_runs, qsizetype total_runs) {
+  ui->progressBar->setRange(0, int(total_runs));
+  ui->progressBar->setValue(int(finished_runs));
+}
+
+void WalkForwardDialog::onFinished(const WalkForwardResult &result, qint64 elapsed_ms) {
+  ui->startButton->setEnabled(true);
+  ui->cancelButton->setEnabled(false);
+  ui->rangeGroupBox->setEnabled(true);
+  const double seconds = qMax<qint64>(elapsed_ms, 1) / 1000.0;
+  if (result.cancelled) {
+    ui->combinationLabel->setText(
+        QString("已取消，完成 %1 次回测，耗时 %2 秒").arg(result.runs).arg(seconds, 0, 'f', 2));
+    return;
+  }
+  showFolds(result);
+  showEquity(result);
+  ui->combinationLabel->setText(
+      QString("%1 折，样本外收益 %2%，最大回撤 %3%，交易 %4 次；%5 次回测耗时 %6 秒")
+          .arg(result.folds.size())
+          .arg(percent(result.final_capital / result.initial_capital - 1.0))
+          .arg(percent(result.max_drawdown))
+          .arg(result.total_trades)
+          .arg(result.runs)
+          .arg(seconds, 0, 'f', 2));
+}
+
+void WalkForwardDialog::showFolds(const WalkForwardResult &result) {
+  QTableWidget *table = ui->foldsTable;
+  table->setRowCount(int(result.folds.size()));
+  for (int row = 0; row < int(result.folds.size()); row++) {
+    const WalkForwardFold &fold = result.folds[row];
+    table->setItem(row,
+                   InSampleColumn,
+                   textItem(dateText(bars_[fold.in_sample_begin].timestamp) + " ~ "
+                            + dateText(bars_[fold.out_of_sample_begin - 1].timestamp)));
+    table->setItem(row,
+                   OutOfSampleColumn,
+                   textItem(dateText(bars_[fold.out_of_sample_begin].timestamp) + " ~ "
+                            + dateText(bars_[fold.out_of_sample_end - 1].timestamp)));
+    table->setItem(row, FastColumn, numberItem(fold.fast_period));
+    table->setItem(row, SlowColumn, numberItem(fold.slow_period));
+    table->setItem(row, InSampleReturnColumn, numberItem(percent(fold.in_sample_return)));
+    table->setItem(row, OutOfSampleReturnColumn, numberItem(percent(fold.out_of_sample_return)));
+    table->setItem(row, TradesColumn, numberItem(fold.out_of_sample_trades));
+    table->setItem(row, DrawdownColumn, numberItem(percent(fold.out_of_sample_drawdown)));
+  }
+}
+
+void WalkForwardDialog::showEquity(const WalkForwardResult &result) {
+  const qsizetype count = result.equity.size();
+  if (count == 0)
+    return;
+  const qsizetype step = qMax<qsizetype>(1, count / kMaxChartPoints);
+  QList<QPointF> points;
+  points.reserve(count / step + 2);
+  double low = result.initial_capital;
+  double high = result.initial_capital;
+  for (qsizetype i = 0; i < count; i++) {
+    low = qMin(low, result.equity[i]);
+    high = qMax(high, result.equity[i]);
+    if (i % step == 0 || i == count - 1)
+      points.append(QPointF(result.timestamps[i], result.equity[i]));
+  }
+  equity_series_->replace(points);
+  axis_x_->setRange(QDateTime::fromMSecsSinceEpoch(result.timestamps.first()),
+                    QDateTime::fromMSecsSinceEpoch(result.timestamps.last()));
+  const double margin = qMax((high - low) * 0.05, 1e-6);
+  axis_y_->setRange(low - margin, high + margin);
+}
+
+void WalkForwardDialog::reject() {
+  walk_forward_->cancel();
+  QDialog::reject();
+}
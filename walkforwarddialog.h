@@ -0,0 +1,56 @@
+#ifndef WALKFORWARDDIALOG_H
+#define WALKFORWARDDIALOG_H
+
+#include "walkforward.h"
+
+#include <QDialog>
+
+class QChart;
+class QDateTimeAxis;
+class QLineSeries;
+class QValueAxis;
+
+namespace Ui {
+class WalkForwardDialog;
+}
+
+class WalkForwardDialog : public QDialog {
+  Q_OBJECT
+
+public:
+  WalkForwardDialog(const QVector<KLineData> &bars,
+                    std::shared_ptr<IndicatorCache> indicators, // 与主界面共用，已算过的均线不再重复计算
+                    const BacktestConfig &defaults,
+                    QWidget *parent = nullptr);
+  ~WalkForwardDialog();
+
+public slots:
+  void reject() override; // 关闭时停止正在进行的优化
+
+private slots:
+  void onStartClicked();
+  void onCancelClicked();
+  void onRangeChanged();
+  void onProgress(qsizetype finished_runs, qsizetype total_runs);
+  void onFinished(const WalkForwardResult &result, qint64 elapsed_ms);
+
+private:
+  void initializeApplication(); // 整体初始化
+  void initializeChart();
+  WalkForwardSpec readSpec() const;
+  void showFolds(const WalkForwardResult &result);
+  void showEquity(const WalkForwardResult &result);
+
+private:
+  Ui::WalkForwardDialog *ui;
+  WalkForward *walk_forward_;
+  QVector<KLineData> bars_;
+  std::shared_ptr<IndicatorCache> indicators_;
+  BacktestConfig config_;
+  QChart *equity_chart_;
+  QLineSeries *equity_series_;
+  QDateTimeAxis *axis_x_;
+  QValueAxis *axis_y_;
+};
+
+#endif // WALKFORWARDDIALOG_H